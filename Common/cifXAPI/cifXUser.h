@@ -205,6 +205,10 @@ typedef void* CIFXHANDLE;
 #define CIFX_IO_INPUT_AREA                    1
 #define CIFX_IO_OUTPUT_AREA                   2
 
+/* xChannelIOWriteMode definitions */
+#define CIFX_IO_WRITE_MODE_FULL               0 /* Every write transfers the complete data            */
+#define CIFX_IO_WRITE_MODE_DELTA              1 /* Only data changed since the last write is transferred */
+
 /* xChannelReset definitions */
 #define CIFX_SYSTEMSTART                      1
 #define CIFX_CHANNELINIT                      2
@@ -414,6 +418,21 @@ typedef __CIFx_PACKED_PRE struct CHANNEL_IO_INFORMATIONtag
   uint32_t ulIOMode;                     /*!< Exchange mode */
 } __CIFx_PACKED_POST CHANNEL_IO_INFORMATION;
 
+/*****************************************************************************/
+/*! Write statistics of an IO output area (xChannelIOWriteStats)            */
+/*****************************************************************************/
+typedef __CIFx_PACKED_PRE struct CIFX_IO_WRITE_STATS_Ttag
+{
+  uint64_t ullWrites;                    /*!< Writes done in delta mode */
+  uint64_t ullUnchanged;                 /*!< Writes without changed data (nothing transferred) */
+  uint64_t ullSpans;                     /*!< Transfers of changed data */
+  uint64_t ullResyncs;                   /*!< Reads of the DPM content (mode enabled, device reset) */
+  uint64_t ullBytesRequested;            /*!< Bytes passed by the writes */
+  uint64_t ullBytesSent;                 /*!< Bytes transferred, incl. unchanged bytes of merged spans */
+  uint64_t ullBytesSaved;                /*!< Bytes not transferred, as they were unchanged */
+  uint64_t ullFullWrites;                /*!< Writes sent complete, as the spans would have cost more */
+} __CIFx_PACKED_POST CIFX_IO_WRITE_STATS_T;
+
 /*****************************************************************************/
 /*! Memory Information structure                                             */
 /*****************************************************************************/
@@ -552,7 +571,15 @@ int32_t APIENTRY xChannelDMAState            ( CIFXHANDLE  hChannel, uint32_t ul
 int32_t APIENTRY xChannelIOInfo              ( CIFXHANDLE  hChannel, uint32_t ulCmd,        uint32_t ulAreaNumber, uint32_t ulSize, void* pvData);
 int32_t APIENTRY xChannelIORead              ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData, uint32_t ulTimeout);
 int32_t APIENTRY xChannelIOWrite             ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData, uint32_t ulTimeout);
+int32_t APIENTRY xChannelIOExchange          ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulInOffset,   uint32_t ulInLen,   void* pvInData,
+                                               uint32_t ulOutOffset, uint32_t ulOutLen, void* pvOutData, uint32_t ulTimeout);
 int32_t APIENTRY xChannelIOReadSendData      ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData);
+int32_t APIENTRY xChannelIOReadAcquire       ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, const void** ppvData, uint32_t ulTimeout);
+int32_t APIENTRY xChannelIOReadRelease       ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber);
+int32_t APIENTRY xChannelIOWriteAcquire      ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void** ppvData, uint32_t ulTimeout);
+int32_t APIENTRY xChannelIOWriteCommit       ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulTimeout);
+int32_t APIENTRY xChannelIOWriteMode         ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulMode,       uint32_t ulTimeout);
+int32_t APIENTRY xChannelIOWriteStats        ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, CIFX_IO_WRITE_STATS_T* ptStats, int fReset, uint32_t ulTimeout);
 
 int32_t APIENTRY xChannelControlBlock        ( CIFXHANDLE  hChannel, uint32_t ulCmd, uint32_t ulOffset, uint32_t ulDataLen, void* pvData);
 int32_t APIENTRY xChannelCommonStatusBlock   ( CIFXHANDLE  hChannel, uint32_t ulCmd, uint32_t ulOffset, uint32_t ulDataLen, void* pvData);
@@ -632,6 +659,8 @@ typedef int32_t (APIENTRY *PFN_XCHANNELDMASTATE)           ( CIFXHANDLE  hChanne
 typedef int32_t (APIENTRY *PFN_XCHANNELIOINFO)             ( CIFXHANDLE  hChannel, uint32_t ulCmd,        uint32_t ulAreaNumber, uint32_t ulSize,    void* pvData);
 typedef int32_t (APIENTRY *PFN_XCHANNELIOREAD)             ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData, uint32_t ulTimeout);
 typedef int32_t (APIENTRY *PFN_XCHANNELIOWRITE)            ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData, uint32_t ulTimeout);
+typedef int32_t (APIENTRY *PFN_XCHANNELIOEXCHANGE)         ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulInOffset,   uint32_t ulInLen,   void* pvInData,
+                                                             uint32_t ulOutOffset, uint32_t ulOutLen, void* pvOutData, uint32_t ulTimeout);
 typedef int32_t (APIENTRY *PFN_XCHANNELIOREADSENDDATA)     ( CIFXHANDLE  hChannel, uint32_t ulAreaNumber, uint32_t ulOffset,     uint32_t ulDataLen, void* pvData);
 
 typedef int32_t (APIENTRY *PFN_XCHANNELCONTROLBLOCK)       ( CIFXHANDLE  hChannel, uint32_t ulCmd, uint32_t ulOffset, uint32_t ulDataLen, void* pvData);
@@ -39,6 +39,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #include "EcsV4_Public.h"
 #include "rcX_Public.h"
 #include "cifXToolkit.h"
+#include "startup_graph.h"
 
 
 #define ECS_PRODUCTCODE_NXEB51_FEATURES                               0x00000038
@@ -55,9 +56,8 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
  *               |_|
  * http://www.network-science.de/ascii/  font stop
  ******************************************************************************/
-static uint32_t EcatSetConfigReq(APP_DATA_T *ptAppData, CIFX_PACKET *ptPkt, uint32_t ulId)
+static void EcatBuildSetConfigReq(APP_DATA_T *ptAppData, CIFX_PACKET *ptPkt)
 {
-  uint32_t lRet = RCX_S_OK;
   ECAT_SET_CONFIG_REQ_T* ptConfigReq = (ECAT_SET_CONFIG_REQ_T*)ptPkt;
   ECAT_SET_CONFIG_DEVICEINFO_T* ptDevInfo;
   ECAT_SET_CONFIG_COE_T* ptCoECfg;
@@ -106,7 +106,16 @@ static uint32_t EcatSetConfigReq(APP_DATA_T *ptAppData, CIFX_PACKET *ptPkt, uint
   strncpy( ptDevInfo->szNameIdx, "NXEB 51-CERT", sizeof(ptDevInfo->szNameIdx) );
   ptDevInfo->bNameIdxLength = strlen( ptDevInfo->szNameIdx );
 
-  lRet = Pkt_SendPacket(ptAppData->hChannel[0], (CIFX_PACKET*)ptConfigReq, ulId, TX_TIMEOUT);
+  (void)ptAppData;
+}
+
+static uint32_t EcatSetConfigReq(APP_DATA_T *ptAppData, CIFX_PACKET *ptPkt, uint32_t ulId)
+{
+  uint32_t lRet = RCX_S_OK;
+
+  EcatBuildSetConfigReq(ptAppData, ptPkt);
+
+  lRet = Pkt_SendPacket(ptAppData->hChannel[0], ptPkt, ulId, TX_TIMEOUT);
   return lRet;
 }
 
@@ -160,9 +169,395 @@ static int32_t Ecs_SetMacAddressCnf(RCX_SET_MAC_ADDR_CNF_T* ptSetMacAddressCnf)
  *
  * http://www.network-science.de/ascii/  font stop
  ******************************************************************************/
+/*****************************************************************************/
+/*! answer a link status change indication of the mailbox engine
+*   \param  ptEngine Mailbox engine the indication came in on
+*   \param  ptInd    Indication packet, turned into the response
+*   \param  pvArg    Application data
+*   \return !=0 to send the response                                         */
+/*****************************************************************************/
+static int Ecs_LinkStatusChangeInd(mbx_engine_t* ptEngine, CIFX_PACKET* ptInd, void* pvArg)
+{
+  (void)ptEngine;
+  (void)pvArg;
+
+  ptInd->tHeader.ulLen   = 0;
+  ptInd->tHeader.ulState = RCX_S_OK;
+
+  return 1;
+} /** Ecs_LinkStatusChangeInd */
+
+/*****************************************************************************/
+/*! answer an AL status changed indication of the mailbox engine
+*   \param  ptEngine Mailbox engine the indication came in on
+*   \param  ptInd    Indication packet, turned into the response
+*   \param  pvArg    Application data
+*   \return !=0 to send the response                                         */
+/*****************************************************************************/
+static int Ecs_AlStatusChangedInd(mbx_engine_t* ptEngine, CIFX_PACKET* ptInd, void* pvArg)
+{
+  (void)ptEngine;
+  (void)pvArg;
+
+  ptInd->tHeader.ulLen = sizeof(ECAT_ESM_ALSTATUS_CHANGED_RES_T) - sizeof(TLR_PACKET_HEADER_T);
+
+  return 1;
+} /** Ecs_AlStatusChangedInd */
+
+
+
+
+/*****************************************************************************/
+/** Registers the indications handled by the protocol at the mailbox engine.
+Other indications are answered with RCX_E_UNKNOWN_COMMAND by the engine      */
+/*****************************************************************************/
+int Protocol_RegisterIndications(APP_DATA_T *ptAppData)
+{
+  int iRet;
+
+  iRet = mbx_engine_register(&ptAppData->tMbx, RCX_LINK_STATUS_CHANGE_IND, Ecs_LinkStatusChangeInd, ptAppData);
+  if(0 == iRet)
+  {
+    iRet = mbx_engine_register(&ptAppData->tMbx, ECAT_ESM_ALSTATUS_CHANGED_IND, Ecs_AlStatusChangedInd, ptAppData);
+  }
+
+  return iRet;
+}
+
+
+/*****************************************************************************/
+/*! MAC address set, continue the startup with the application registration
+*   \param  ptPkt  Confirmation, reused for the next request
+*   \param  pvArg  Application data
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t Ecs_HandleSetMacAddressCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+  int32_t lRet = Ecs_SetMacAddressCnf((RCX_SET_MAC_ADDR_CNF_T*)ptPkt);
+
+  if(CIFX_NO_ERROR == lRet)
+  {
+    lRet = Sys_EmptyPacketReq(ptAppData->hChannel[0],
+                              ptPkt,
+                              ptAppData->ulSendPktCnt++,
+                              RCX_REGISTER_APP_REQ);
+  }
+  return lRet;
+} /** Ecs_HandleSetMacAddressCnf */
+
+/*****************************************************************************/
+/*! Application registered, continue the startup with the configuration
+*   \param  ptPkt  Confirmation, reused for the next request
+*   \param  pvArg  Application data
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t Ecs_HandleRegisterAppCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+  int32_t lRet = Sys_RegisterAppCnf(ptPkt);
+
+  if(CIFX_NO_ERROR == lRet)
+  {
+    lRet = EcatSetConfigReq(ptAppData,
+                            ptPkt,
+                            ptAppData->ulSendPktCnt++);
+  }
+  return lRet;
+} /** Ecs_HandleRegisterAppCnf */
+
+/*****************************************************************************/
+/*! Configuration set, continue the startup with the channel init
+*   \param  ptPkt  Confirmation, reused for the next request
+*   \param  pvArg  Application data
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t Ecs_HandleSetConfigCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+  int32_t lRet = ptPkt->tHeader.ulState;
+
+  if(CIFX_NO_ERROR == lRet)
+  {
+    lRet = Sys_EmptyPacketReq(ptAppData->hChannel[0],
+                              ptPkt,
+                              ptAppData->ulSendPktCnt++,
+                              RCX_CHANNEL_INIT_REQ);
+  }
+  return lRet;
+} /** Ecs_HandleSetConfigCnf */
+
+/*****************************************************************************/
+/*! Channel initialized, finish the startup with the start of communication
+*   \param  ptPkt  Confirmation, reused for the next request
+*   \param  pvArg  Application data
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t Ecs_HandleChannelInitCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+  int32_t lRet = ptPkt->tHeader.ulState;
+
+  if(CIFX_NO_ERROR == lRet)
+  {
+    lRet = Sys_StartStopCommReq(ptAppData->hChannel[0],
+                                ptPkt,
+                                ptAppData->ulSendPktCnt++,
+                                true);
+  }
+  return lRet;
+} /** Ecs_HandleChannelInitCnf */
+
+/*****************************************************************************/
+/*! Confirmation that only reports its status
+*   \param  ptPkt  Confirmation
+*   \param  pvArg  unused
+*   \return status of the confirmation                                       */
+/*****************************************************************************/
+static int32_t Ecs_HandleStatusCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+
+  return ptPkt->tHeader.ulState;
+} /** Ecs_HandleStatusCnf */
+
+/*****************************************************************************/
+/*! Firmware identification, printed by Sys_FirmwareIdentifyCnf()            */
+/*****************************************************************************/
+static int32_t Ecs_HandleFirmwareIdentifyCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+
+  return Sys_FirmwareIdentifyCnf(ptPkt);
+} /** Ecs_HandleFirmwareIdentifyCnf */
+
+/*****************************************************************************/
+/*! Hardware info, printed by Sys_HardwareInfoCnf()                          */
+/*****************************************************************************/
+static int32_t Ecs_HandleHardwareInfoCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+
+  return Sys_HardwareInfoCnf(ptPkt);
+} /** Ecs_HandleHardwareInfoCnf */
+
+/*****************************************************************************/
+/*! Link status change, answered by Sys_LinkStatusChangeInd()                */
+/*****************************************************************************/
+static int32_t Ecs_HandleLinkStatusChangeInd(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+
+  return Sys_LinkStatusChangeInd(ptAppData->hChannel[0], ptPkt);
+} /** Ecs_HandleLinkStatusChangeInd */
+
+/*****************************************************************************/
+/*! AL status changed, answered with the indication packet                   */
+/*****************************************************************************/
+static int32_t Ecs_HandleAlStatusChangedInd(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  APP_DATA_T* ptAppData = (APP_DATA_T*)pvArg;
+
+  ptPkt->tHeader.ulLen = sizeof(ECAT_ESM_ALSTATUS_CHANGED_RES_T) - sizeof(TLR_PACKET_HEADER_T);
+  return Pkt_ReturnPacket(ptAppData->hChannel[0], ptPkt, TX_TIMEOUT);
+} /** Ecs_HandleAlStatusChangedInd */
+
+/*****************************************************************************/
+/*! Packets handled by Protocol_PacketHandler(), add new commands here       */
+/*****************************************************************************/
+static const struct
+{
+  uint32_t        ulCmd;
+  pkt_dispatch_fn pfnHandler;
+} s_atEcsHandlers[] =
+{
+  { RCX_SET_MAC_ADDR_CNF,           Ecs_HandleSetMacAddressCnf    },
+  { RCX_REGISTER_APP_CNF,           Ecs_HandleRegisterAppCnf      },
+  { ECAT_SET_CONFIG_CNF,            Ecs_HandleSetConfigCnf        },
+  { RCX_CHANNEL_INIT_CNF,           Ecs_HandleChannelInitCnf      },
+  { RCX_START_STOP_COMM_CNF,        Ecs_HandleStatusCnf           },
+  { RCX_FIRMWARE_IDENTIFY_CNF,      Ecs_HandleFirmwareIdentifyCnf },
+  { RCX_HW_HARDWARE_INFO_CNF,       Ecs_HandleHardwareInfoCnf     },
+  { RCX_LINK_STATUS_CHANGE_IND,     Ecs_HandleLinkStatusChangeInd },
+  { ECAT_ESM_ALSTATUS_CHANGED_IND,  Ecs_HandleAlStatusChangedInd  },
+};
+
+
+/*****************************************************************************/
+/** Builds the dispatch table of Protocol_PacketHandler()                    */
+/*****************************************************************************/
+int Protocol_RegisterHandlers(APP_DATA_T *ptAppData)
+{
+  int iRet = 0;
+  uint32_t ulIdx;
+
+  pkt_dispatch_init(&ptAppData->tDispatch);
 
+  for(ulIdx = 0; (0 == iRet) && (ulIdx < sizeof(s_atEcsHandlers) / sizeof(s_atEcsHandlers[0])); ++ulIdx)
+  {
+    iRet = pkt_dispatch_register(&ptAppData->tDispatch,
+                                 s_atEcsHandlers[ulIdx].ulCmd,
+                                 s_atEcsHandlers[ulIdx].pfnHandler,
+                                 ptAppData);
+  }
+
+  return iRet;
+}
+
+
+/*****************************************************************************/
+/*! steps of the startup graph, index = bit in the dependency masks */
+enum
+{
+  ECS_STARTUP_SET_MAC_ADDR,
+  ECS_STARTUP_FIRMWARE_IDENTIFY,
+  ECS_STARTUP_HARDWARE_INFO,
+  ECS_STARTUP_REGISTER_APP,
+  ECS_STARTUP_SET_CONFIG,
+  ECS_STARTUP_CHANNEL_INIT,
+  ECS_STARTUP_START_COMM,
+};
+
+#define ECS_STARTUP_DEP(step)                                         (1u << (step))
+
+/** the channel init restarts the protocol stack with the new configuration */
+#define ECS_STARTUP_CHANNEL_INIT_TIMEOUT                              5000
+
+static int32_t Ecs_StartupSetMacAddressReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  uint8_t abMacAddr[6] = { 0x00, 0x02, 0xA2, 0x2F, 0x90, 0x58 };
 
+  (void)pvArg;
+  Sys_BuildSetMacAddressReq(ptPkt, &abMacAddr[0]);
+  return CIFX_NO_ERROR;
+}
 
+static int32_t Ecs_StartupSetMacAddressCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  return Ecs_SetMacAddressCnf((RCX_SET_MAC_ADDR_CNF_T*)ptPkt);
+}
+
+static int32_t Ecs_StartupFirmwareIdentifyReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  Sys_BuildFirmwareIdentifyReq(ptPkt, RCX_SYSTEM_CHANNEL);
+  return CIFX_NO_ERROR;
+}
+
+static int32_t Ecs_StartupFirmwareIdentifyCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  return Sys_FirmwareIdentifyCnf(ptPkt);
+}
+
+static int32_t Ecs_StartupHardwareInfoReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  Sys_BuildHardwareInfoReq(ptPkt);
+  return CIFX_NO_ERROR;
+}
+
+static int32_t Ecs_StartupHardwareInfoCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  return Sys_HardwareInfoCnf(ptPkt);
+}
+
+static int32_t Ecs_StartupRegisterAppReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  Sys_BuildEmptyPacketReq(ptPkt, RCX_REGISTER_APP_REQ);
+  return CIFX_NO_ERROR;
+}
+
+static int32_t Ecs_StartupRegisterAppCnf(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  return Sys_RegisterAppCnf(ptPkt);
+}
+
+static int32_t Ecs_StartupSetConfigReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  EcatBuildSetConfigReq((APP_DATA_T*)pvArg, ptPkt);
+  return CIFX_NO_ERROR;
+}
+
+static int32_t Ecs_StartupChannelInitReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  Sys_BuildEmptyPacketReq(ptPkt, RCX_CHANNEL_INIT_REQ);
+  return CIFX_NO_ERROR;
+}
+
+static int32_t Ecs_StartupStartCommReq(CIFX_PACKET* ptPkt, void* pvArg)
+{
+  (void)pvArg;
+  Sys_BuildStartStopCommReq(ptPkt, true);
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Startup sequence, the identification runs next to the configuration chain.
+*   Order must match the ECS_STARTUP_* enumeration                           */
+/*****************************************************************************/
+static const struct
+{
+  const char*      szName;
+  uint32_t         ulDeps;
+  startup_build_fn pfnReq;
+  startup_check_fn pfnCnf;
+  uint32_t         ulTimeout;
+  uint32_t         ulRetries;
+} s_atEcsStartup[] =
+{
+  { "SET_MAC_ADDR",      0,                                             Ecs_StartupSetMacAddressReq,    Ecs_StartupSetMacAddressCnf,    TX_TIMEOUT,                       2 },
+  { "FIRMWARE_IDENTIFY", 0,                                             Ecs_StartupFirmwareIdentifyReq, Ecs_StartupFirmwareIdentifyCnf, TX_TIMEOUT,                       2 },
+  { "HW_HARDWARE_INFO",  0,                                             Ecs_StartupHardwareInfoReq,     Ecs_StartupHardwareInfoCnf,     TX_TIMEOUT,                       2 },
+  { "REGISTER_APP",      ECS_STARTUP_DEP(ECS_STARTUP_SET_MAC_ADDR),     Ecs_StartupRegisterAppReq,      Ecs_StartupRegisterAppCnf,      TX_TIMEOUT,                       2 },
+  { "ECAT_SET_CONFIG",   ECS_STARTUP_DEP(ECS_STARTUP_REGISTER_APP),     Ecs_StartupSetConfigReq,        NULL,                           TX_TIMEOUT,                       2 },
+  { "CHANNEL_INIT",      ECS_STARTUP_DEP(ECS_STARTUP_SET_CONFIG),       Ecs_StartupChannelInitReq,      NULL,                           ECS_STARTUP_CHANNEL_INIT_TIMEOUT, 1 },
+  { "START_STOP_COMM",   ECS_STARTUP_DEP(ECS_STARTUP_CHANNEL_INIT),     Ecs_StartupStartCommReq,        NULL,                           TX_TIMEOUT,                       2 },
+};
+
+
+/*****************************************************************************/
+/** Runs the startup sequence on the mailbox engine and prints the time of
+each step. Replaces Protocol_SendFirstPacket() and the confirmations chained
+in Protocol_PacketHandler() when the engine owns the mailbox                 */
+/*****************************************************************************/
+int32_t Protocol_Startup(APP_DATA_T *ptAppData)
+{
+  static startup_graph_t s_tGraph;
+  int32_t lRet = CIFX_NO_ERROR;
+  uint32_t ulIdx;
+
+  startup_graph_init(&s_tGraph, ptAppData);
+
+  for(ulIdx = 0; ulIdx < sizeof(s_atEcsStartup) / sizeof(s_atEcsStartup[0]); ++ulIdx)
+  {
+    if(0 > startup_graph_add(&s_tGraph,
+                             s_atEcsStartup[ulIdx].szName,
+                             s_atEcsStartup[ulIdx].ulDeps,
+                             s_atEcsStartup[ulIdx].pfnReq,
+                             s_atEcsStartup[ulIdx].pfnCnf,
+                             s_atEcsStartup[ulIdx].ulTimeout,
+                             s_atEcsStartup[ulIdx].ulRetries))
+    {
+      lRet = CIFX_INVALID_PARAMETER;
+      break;
+    }
+  }
+
+  if(CIFX_NO_ERROR == lRet)
+  {
+    lRet = startup_graph_run(&s_tGraph, &ptAppData->tMbx);
+    startup_graph_print(&s_tGraph);
+  }
+
+  startup_graph_destroy(&s_tGraph);
+  return lRet;
+}
 
 
 /*****************************************************************************/
@@ -173,8 +568,18 @@ uint32_t Protocol_SendFirstPacket(APP_DATA_T *ptAppData)
 {
   uint32_t lRet = RCX_S_OK;
   uint8_t abMacAddr[6] = { 0x00, 0x02, 0xA2, 0x2F, 0x90, 0x58 };
-  lRet = Sys_SetMacAddressReq(ptAppData->hChannel[0], &ptAppData->tPkt, ptAppData->ulSendPktCnt++, &abMacAddr[0]);
+  CIFX_PACKET* ptPkt;
+
+  if(0 != Protocol_RegisterHandlers(ptAppData))
+    return CIFX_INVALID_PARAMETER;
 
+  ptPkt = Pkt_Alloc();
+  if(NULL == ptPkt)
+    return RCX_E_PACKET_OUT_OF_MEMORY;
+
+  lRet = Sys_SetMacAddressReq(ptAppData->hChannel[0], ptPkt, ptAppData->ulSendPktCnt++, &abMacAddr[0]);
+
+  Pkt_Release(ptPkt);
   return lRet;
 }
 
@@ -186,98 +591,36 @@ Startup sequence is finished if RCX_START_STOP_COMM_CNF came in.              */
 uint32_t Protocol_PacketHandler( APP_DATA_T *ptAppData )
 {
   int32_t lRet = CIFX_NO_ERROR;
+  /* received packet, reused for the next request or the response */
+  CIFX_PACKET* ptPkt = Pkt_Alloc();
+
+  if(NULL == ptPkt)
+    return RCX_E_PACKET_OUT_OF_MEMORY;
 
-  lRet = Pkt_ReceivePacket(ptAppData->hChannel[0],&ptAppData->tPkt,0);
+  lRet = Pkt_ReceivePacket(ptAppData->hChannel[0],ptPkt,0);
 
   if( CIFX_NO_ERROR == lRet )
   {
-    switch( ptAppData->tPkt.tHeader.ulCmd )
+    if( 0 != pkt_dispatch(&ptAppData->tDispatch, ptPkt, &lRet) )
     {
-    case RCX_SET_MAC_ADDR_CNF:
-      lRet = Ecs_SetMacAddressCnf((RCX_SET_MAC_ADDR_CNF_T*)&ptAppData->tPkt);
-      if(CIFX_NO_ERROR == lRet)
-      {
-        lRet = Sys_EmptyPacketReq(ptAppData->hChannel[0],
-                                  &ptAppData->tPkt,
-                                  ptAppData->ulSendPktCnt++,
-                                  RCX_REGISTER_APP_REQ);
-      }
-      break;
-
-    case RCX_REGISTER_APP_CNF:
-      lRet = Sys_RegisterAppCnf( &ptAppData->tPkt );
-      if(CIFX_NO_ERROR == lRet)
-      {
-        lRet = EcatSetConfigReq(ptAppData,
-                                &ptAppData->tPkt,
-                                ptAppData->ulSendPktCnt++);
-      }
-      break;
-
-    case ECAT_SET_CONFIG_CNF:
-      lRet = ptAppData->tPkt.tHeader.ulState;
-      if(CIFX_NO_ERROR == lRet)
+      if( (ptPkt->tHeader.ulCmd & 0x1) == 0 ) /* received an indication*/
       {
-        lRet = Sys_EmptyPacketReq(ptAppData->hChannel[0],
-                                  &ptAppData->tPkt,
-                                  ptAppData->ulSendPktCnt++,
-                                  RCX_CHANNEL_INIT_REQ);
-      }
-      break;
-
-    case RCX_CHANNEL_INIT_CNF:
-      lRet = ptAppData->tPkt.tHeader.ulState;
-      if(CIFX_NO_ERROR == lRet)
-      {
-        lRet = Sys_StartStopCommReq(ptAppData->hChannel[0],
-                                    &ptAppData->tPkt,
-                                    ptAppData->ulSendPktCnt++,
-                                    true);
-      }
-      break;
-
-    case RCX_START_STOP_COMM_CNF:
-      lRet = ptAppData->tPkt.tHeader.ulState;
-      break;
-
-    case RCX_FIRMWARE_IDENTIFY_CNF:
-      lRet = Sys_FirmwareIdentifyCnf(&ptAppData->tPkt);
-      break;
-
-    case RCX_HW_HARDWARE_INFO_CNF:
-      lRet = Sys_HardwareInfoCnf(&ptAppData->tPkt);
-      break;
-
-    case RCX_LINK_STATUS_CHANGE_IND:
-      lRet = Sys_LinkStatusChangeInd(ptAppData->hChannel[0], &ptAppData->tPkt);
-      break;
-
-    case ECAT_ESM_ALSTATUS_CHANGED_IND:
-      ptAppData->tPkt.tHeader.ulLen = sizeof(ECAT_ESM_ALSTATUS_CHANGED_RES_T) - sizeof(TLR_PACKET_HEADER_T);
-      lRet = Pkt_ReturnPacket(ptAppData->hChannel[0], &ptAppData->tPkt, TX_TIMEOUT);
-      break;
-
-    default:
-      if( (ptAppData->tPkt.tHeader.ulCmd & 0x1) == 0 ) /* received an indication*/
-      {
-        ptAppData->tPkt.tHeader.ulLen   = 0;
-        ptAppData->tPkt.tHeader.ulState = RCX_E_UNKNOWN_COMMAND;
-        lRet = Pkt_ReturnPacket(ptAppData->hChannel[0], &ptAppData->tPkt, TX_TIMEOUT);
+        ptPkt->tHeader.ulLen   = 0;
+        ptPkt->tHeader.ulState = RCX_E_UNKNOWN_COMMAND;
+        lRet = Pkt_ReturnPacket(ptAppData->hChannel[0], ptPkt, TX_TIMEOUT);
       }
       else{ /* received a confirmation */
 #ifndef DEMO_QUIET
-        printf("warning: unhandled confirmation packet: 0x%08x\r\n", (unsigned int)ptAppData->tPkt.tHeader.ulCmd);
+        printf("warning: unhandled confirmation packet: 0x%08x\r\n", (unsigned int)ptPkt->tHeader.ulCmd);
 #endif
       }
-      break;
-
-    } /*switch*/
-
+    }
   } /* CIFX_NO_ERROR xChannelGetPacket */
   else if( CIFX_DEV_GET_NO_PACKET == lRet )
   {
     lRet = CIFX_NO_ERROR;
   }
+
+  Pkt_Release(ptPkt);
   return lRet;
 }
-
@@ -27,10 +27,28 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #include "cifXErrors.h"
 #include "cifXHWFunctions.h"
 #include "OS_Includes.h"
+#ifdef GBCIFX_IRQ
+#include "OS_Spi.h"
+#include "OS_Irq.h"
+#endif
 
 #define NSEC_PER_SEC (1000U * 1000U * 1000U)
 
-#define USE_PTHREADS 0
+/* Real events and locks. The mailbox engine and the cyclic exchange thread call the toolkit
+   concurrently, only single threaded builds may turn them off (-DUSE_PTHREADS=0) */
+#ifndef USE_PTHREADS
+  #define USE_PTHREADS 1
+#endif
+
+/* In interrupt mode the DSR runs in its own thread and wakes the waiters through events */
+#if defined(GBCIFX_IRQ) && (USE_PTHREADS != 1)
+  #error "GBCIFX_IRQ requires USE_PTHREADS=1"
+#endif
+
+/* Asynchronous device start-up waits for its workers through events */
+#if defined(CIFX_TOOLKIT_ASYNC_ADD) && (USE_PTHREADS != 1)
+  #error "CIFX_TOOLKIT_ASYNC_ADD requires USE_PTHREADS=1"
+#endif
 
 //#error "Implement target system abstraction in this file"
 
@@ -137,6 +155,37 @@ uint32_t OS_GetMilliSecCounter(void)
     return (uint32_t)( SEC_TO_MSEC(now.tv_sec) + NSEC_TO_MSEC(now.tv_nsec));
 }
 
+#if defined(CIFX_TOOLKIT_STATS) || defined(CIFX_TOOLKIT_WAIT_POLICY)
+/*****************************************************************************/
+/*! Retrieve a nanosecond counter used for the timing statistics and the
+*   handshake wait policy
+*   \return Current CLOCK_MONOTONIC time in ns                               */
+/*****************************************************************************/
+uint64_t OS_GetNanoSecCounter(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+#endif
+
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+/*****************************************************************************/
+/*! Sleep until an absolute time of the nanosecond counter
+*   \param ullWakeTimeNs Wake-up time (OS_GetNanoSecCounter based)           */
+/*****************************************************************************/
+void OS_SleepUntilNs(uint64_t ullWakeTimeNs)
+{
+    struct timespec wake;
+    wake.tv_sec  = (time_t)(ullWakeTimeNs / 1000000000ULL);
+    wake.tv_nsec = (long)(ullWakeTimeNs % 1000000000ULL);
+
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL))
+        ;
+}
+#endif
+
 /*****************************************************************************/
 /*! Create an auto reset event
 *   \return handle to the created event                                      */
@@ -213,6 +262,7 @@ void OS_DeleteEvent(void* pvEvent)
 #else
     /*CloseHandle((HANDLE)pvEvent);*/
 	sem_destroy(pvEvent);
+	free(pvEvent);
 #endif
 
 }
@@ -275,6 +325,65 @@ uint32_t OS_WaitEvent(void* pvEvent, uint32_t ulTimeout)
 
 }
 
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+/* Thread created by OS_CreateThread */
+typedef struct OS_THREAD_Ttag
+{
+    pthread_t     tThread;
+    PFN_OS_THREAD pfnThread;
+    void*         pvArg;
+} OS_THREAD_T;
+
+static void* OS_ThreadEntry(void* pvThread)
+{
+    OS_THREAD_T* ptThread = (OS_THREAD_T*)pvThread;
+
+    ptThread->pfnThread(ptThread->pvArg);
+
+    return NULL;
+}
+
+/*****************************************************************************/
+/*! Create a worker thread
+*   \param pfnThread Thread function
+*   \param pvArg     Argument passed to the thread function
+*   \return Handle to the thread, NULL on error                              */
+/*****************************************************************************/
+void* OS_CreateThread(PFN_OS_THREAD pfnThread, void* pvArg)
+{
+    OS_THREAD_T* ptThread = calloc(1, sizeof(*ptThread));
+
+    if (ptThread)
+    {
+        ptThread->pfnThread = pfnThread;
+        ptThread->pvArg     = pvArg;
+
+        if (pthread_create(&ptThread->tThread, NULL, OS_ThreadEntry, ptThread) != 0)
+        {
+            USER_Trace(NULL, TRACE_LEVEL_ERROR, "OS_CreateThread failed");
+            free(ptThread);
+            ptThread = NULL;
+        }
+    }
+    return ptThread;
+}
+
+/*****************************************************************************/
+/*! Wait for the end of a worker thread and delete it
+*   \param pvThread Handle to the thread                                     */
+/*****************************************************************************/
+void OS_DeleteThread(void* pvThread)
+{
+    OS_THREAD_T* ptThread = (OS_THREAD_T*)pvThread;
+
+    if (ptThread)
+    {
+        pthread_join(ptThread->tThread, NULL);
+        free(ptThread);
+    }
+}
+#endif
+
 /*****************************************************************************/
 /*! Compare two ASCII string
 *   \param pszBuf1   First buffer
@@ -509,7 +618,7 @@ void OS_DeleteMutex(void* pvMutex)
 
 
 #else
-    assert(vpMutex != NULL);
+    assert(pvMutex != NULL);
     USER_Trace( NULL, TRACE_LEVEL_DEBUG,  "(%s=%p)", NV(pvMutex));
     pthread_mutex_destroy(pvMutex);
     free(pvMutex);
@@ -582,15 +691,153 @@ uint32_t OS_FileRead(void* pvFile, uint32_t ulOffset, uint32_t ulSize, void* pvB
 
     USER_Trace( NULL, TRACE_LEVEL_DEBUG, "%s ()", __func__);
 
-    if (ulOffset == (uint32_t) lseek(iFile, (int32_t) ulOffset, SEEK_SET))
+    /* positioned read, no seek per call. read() may return less than asked for, e.g. on a pipe or a signal */
+    while (ulRet < ulSize)
     {
-        ulRet = (uint32_t) read(iFile, pvBuffer, ulSize);
+        ssize_t iRead = pread(iFile, (uint8_t*) pvBuffer + ulRet, ulSize - ulRet, (off_t) ulOffset + ulRet);
+
+        if (iRead < 0 && EINTR == errno)
+            continue;
+        if (iRead <= 0)
+            break;
+        ulRet += (uint32_t) iRead;
     }
 
     return ulRet;
 
 }
 
+#ifdef CIFX_TOOLKIT_FILE_MAP
+/*****************************************************************************/
+/*! Map a file into memory instead of reading it into a buffer. The pages are
+*   read in by the kernel (read-ahead started here) while the toolkit hashes
+*   and transfers the data, and stay reclaimable page cache
+*   \param pvFile   Handle to the file being mapped
+*   \param ulSize   Length of the file
+*   \return writable private view of the file, NULL if it cannot be mapped   */
+/*****************************************************************************/
+void* OS_FileMap(void* pvFile, uint32_t ulSize)
+{
+    assert(pvFile != NULL);
+
+    int32_t iFile = (int32_t) pvFile;
+    void* pvData;
+
+    if (0 == ulSize)
+        return NULL;
+
+    pvData = mmap(NULL, ulSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, iFile, 0);
+    if (MAP_FAILED == pvData)
+    {
+        USER_Trace(NULL, TRACE_LEVEL_DEBUG, "OS_FileMap failed with %s", strerror(errno));
+        return NULL;
+    }
+
+    (void) madvise(pvData, ulSize, MADV_SEQUENTIAL);
+    (void) madvise(pvData, ulSize, MADV_WILLNEED);
+
+    return pvData;
+}
+
+/*****************************************************************************/
+/*! Release a view created by OS_FileMap
+*   \param pvData   Mapped file data
+*   \param ulSize   Length passed to OS_FileMap                              */
+/*****************************************************************************/
+void OS_FileUnmap(void* pvData, uint32_t ulSize)
+{
+    assert(pvData != NULL);
+
+    munmap(pvData, ulSize);
+}
+#endif
+
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+/*****************************************************************************/
+/*! Identity of an open file (size, modification time, inode and device), a
+*   file replaced or written in place gets a different identity
+*   \param pvFile   Handle to the file
+*   \param ptId     Returned identity
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t OS_FileGetId(void* pvFile, OS_FILE_ID_T* ptId)
+{
+    assert(pvFile != NULL);
+    assert(ptId != NULL);
+
+    int32_t iFile = (int32_t) pvFile;
+    struct stat tStat;
+
+    if (fstat(iFile, &tStat) == -1)
+        return CIFX_FILE_READ_ERROR;
+
+    ptId->ullSize = (uint64_t) tStat.st_size;
+    ptId->ullMTimeNs = (uint64_t) tStat.st_mtim.tv_sec * 1000000000ULL + (uint64_t) tStat.st_mtim.tv_nsec;
+    ptId->ullInode = (uint64_t) tStat.st_ino;
+    ptId->ullDevice = (uint64_t) tStat.st_dev;
+
+    return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Replace a file with the given data. The data is written to a temporary
+*   file that is renamed over the old one, a reader never sees a partly
+*   written file
+*   \param szFile   Full file name
+*   \param pvData   Data to write
+*   \param ulSize   Length of the data
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t OS_FileSave(char* szFile, void* pvData, uint32_t ulSize)
+{
+    assert(szFile != NULL);
+    assert(pvData != NULL);
+
+    char szTmpFile[CIFX_MAX_FILE_NAME_LENGTH + 4];
+    uint32_t ulWritten = 0;
+    int32_t iFile;
+
+    if ((size_t) OS_Strlen(szFile) + sizeof(".tmp") > sizeof(szTmpFile))
+        return CIFX_FILE_NAME_INVALID;
+    OS_Strncpy(szTmpFile, szFile, sizeof(szTmpFile));
+    strcat(szTmpFile, ".tmp");
+
+    iFile = open(szTmpFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (iFile == -1)
+    {
+        USER_Trace(NULL, TRACE_LEVEL_DEBUG, "OS_FileSave(%s) failed with %s", szTmpFile, strerror(errno));
+        return CIFX_FILE_OPEN_FAILED;
+    }
+
+    while (ulWritten < ulSize)
+    {
+        ssize_t iWritten = write(iFile, (uint8_t*) pvData + ulWritten, ulSize - ulWritten);
+
+        if (iWritten < 0 && EINTR == errno)
+            continue;
+        if (iWritten <= 0)
+            break;
+        ulWritten += (uint32_t) iWritten;
+    }
+
+    if (ulWritten != ulSize || fsync(iFile) != 0)
+    {
+        close(iFile);
+        unlink(szTmpFile);
+        return CIFX_FUNCTION_FAILED;
+    }
+    close(iFile);
+
+    if (rename(szTmpFile, szFile) != 0)
+    {
+        unlink(szTmpFile);
+        return CIFX_FILE_OPEN_FAILED;
+    }
+
+    return CIFX_NO_ERROR;
+}
+#endif
+
 /*****************************************************************************/
 /*! OS specific initialization (if needed), called during cifXTKitInit()     
 /*!  \return CIFX_NO_ERROR on success                                        */
@@ -676,10 +923,23 @@ int OS_UnmapUserPointer(void* phMapping, void* pvOSDependent)
 /*****************************************************************************/
 /*! This function enables the interrupts for the device physically
 *   \param pvOSDependent OS Dependent Variable passed during call to
-*                        cifXTKitAddDevice                                   */
+*                        cifXTKitAddDevice
+*   \return CIFX_NO_ERROR on success, the toolkit polls the device otherwise */
 /*****************************************************************************/
-void OS_EnableInterrupts(void* pvOSDependent)
+int32_t OS_EnableInterrupts(void* pvOSDependent)
 {
+#ifdef GBCIFX_IRQ
+    OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+    /* the DSR thread takes over, waiters block on the handshake bit events from now on */
+    if (NULL != ptSpiDevice->pvIrq)
+        return (int32_t)OS_IrqStart((OS_IRQ_DEVICE_T*)ptSpiDevice->pvIrq);
+
+    return CIFX_NO_ERROR;
+#else
+    UNREFERENCED_PARAMETER(pvOSDependent);
+    return CIFX_NO_ERROR;
+#endif
 }
 
 /*****************************************************************************/
@@ -689,6 +949,14 @@ void OS_EnableInterrupts(void* pvOSDependent)
 /*****************************************************************************/
 void OS_DisableInterrupts(void* pvOSDependent)
 {
+#ifdef GBCIFX_IRQ
+    OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+    if (NULL != ptSpiDevice->pvIrq)
+        OS_IrqStop((OS_IRQ_DEVICE_T*)ptSpiDevice->pvIrq);
+#else
+    UNREFERENCED_PARAMETER(pvOSDependent);
+#endif
 }
 
 #ifdef CIFX_TOOLKIT_TIME
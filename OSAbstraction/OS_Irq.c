@@ -0,0 +1,389 @@
+/**
+ ******************************************************************************
+ * @file           :  OS_Irq.c
+ * @brief          :  netX DIRQ handling in a DSR thread (interrupt mode)
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file OS_Irq.c
+*    Interrupt thread for serial DPM devices. The ISR and the DSR of the
+*    toolkit both need the SPI bus, so there is no split between interrupt
+*    and thread context: both run in one SCHED_FIFO thread, which wakes the
+*    waiters through the handshake bit events (ahHandshakeBitEvents).        */
+/*****************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "OS_Irq.h"
+#include "OS_Spi.h"
+#include "cifXToolkit.h"
+#include "cifXErrors.h"
+#include "user_message.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+/* Consumer name shown by gpioinfo */
+#define OS_IRQ_CONSUMER             "gbcifx-dirq"
+
+/* The line is edge triggered, it is serviced again while DIRQ stays asserted
+   (a new request between reading and acknowledging the handshake cells) */
+#define OS_IRQ_MAX_RELOOPS          8
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_OS_ABSTRACTION Operating System Abstraction
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Request the DIRQ line as input with edge events. The line is active low,
+*   so a rising edge event is the assertion of DIRQ.
+*   \param ptIrq Interrupt context
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static long IrqRequestLine(OS_IRQ_DEVICE_T* ptIrq)
+{
+  struct gpio_v2_line_request tReq;
+  int                         iChipFd;
+
+  if ((iChipFd = open(ptIrq->szChip, O_RDONLY | O_CLOEXEC)) < 0)
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open [%s] [%s]", ptIrq->szChip, strerror(errno));
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  memset(&tReq, 0, sizeof(tReq));
+  tReq.offsets[0]   = ptIrq->ulLine;
+  tReq.num_lines    = 1;
+  tReq.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_ACTIVE_LOW | GPIO_V2_LINE_FLAG_EDGE_RISING;
+  strncpy(tReq.consumer, OS_IRQ_CONSUMER, sizeof(tReq.consumer) - 1);
+
+  if (ioctl(iChipFd, GPIO_V2_GET_LINE_IOCTL, &tReq) < 0)
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to request line [%u] of [%s] [%s]",
+             ptIrq->ulLine, ptIrq->szChip, strerror(errno));
+    close(iChipFd);
+    return CIFX_FUNCTION_FAILED;
+  }
+  close(iChipFd);
+
+  /* events are drained completely after each wake-up */
+  (void)fcntl(tReq.fd, F_SETFL, fcntl(tReq.fd, F_GETFL) | O_NONBLOCK);
+  ptIrq->iFd = tReq.fd;
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Check the current level of the DIRQ line
+*   \param ptIrq Interrupt context
+*   \return !=0 if DIRQ is asserted                                          */
+/*****************************************************************************/
+static int IrqLineActive(OS_IRQ_DEVICE_T* ptIrq)
+{
+  struct gpio_v2_line_values tValues;
+
+  memset(&tValues, 0, sizeof(tValues));
+  tValues.mask = 1;
+
+  if (ioctl(ptIrq->iFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &tValues) < 0)
+    return 0;
+
+  return (0 != (tValues.bits & 1));
+}
+
+/*****************************************************************************/
+/*! Read all pending events of the interrupt source
+*   \param ptIrq Interrupt context
+*   \return Number of events, 0 if nothing was pending, -1 if the source
+*           was closed                                                       */
+/*****************************************************************************/
+static int IrqDrain(OS_IRQ_DEVICE_T* ptIrq)
+{
+  int iEvents = 0;
+
+  if (eOS_IRQ_SOURCE_GPIO == ptIrq->eSource)
+  {
+    struct gpio_v2_line_event atEvents[16];
+    ssize_t                   lRead;
+
+    while ((lRead = read(ptIrq->iFd, atEvents, sizeof(atEvents))) > 0)
+      iEvents += (int)(lRead / (ssize_t)sizeof(atEvents[0]));
+
+  } else
+  {
+    uint8_t abEvents[64];
+    ssize_t lRead = read(ptIrq->iFd, abEvents, sizeof(abEvents));
+
+    if (0 == lRead)
+      return -1;
+
+    if (lRead > 0)
+      iEvents = (int)lRead;
+  }
+
+  return iEvents;
+}
+
+/*****************************************************************************/
+/*! Run the toolkit's interrupt handling once
+*   \param ptIrq Interrupt context                                           */
+/*****************************************************************************/
+static void IrqService(OS_IRQ_DEVICE_T* ptIrq)
+{
+  PDEVICEINSTANCE ptDevInstance = (PDEVICEINSTANCE)ptIrq->pvDevInstance;
+
+  switch (cifXTKitISRHandler(ptDevInstance, 1))
+  {
+    case CIFX_TKIT_IRQ_DSR_REQUESTED:
+      cifXTKitDSRHandler(ptDevInstance);
+      ++ptIrq->ulDsrCalls;
+      break;
+
+    case CIFX_TKIT_IRQ_OTHERDEVICE:
+      ++ptIrq->ulOtherDevice;
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*****************************************************************************/
+/*! DSR thread, waits for interrupt events or the stop request
+*   \param pvArg Interrupt context
+*   \return NULL                                                             */
+/*****************************************************************************/
+static void* IrqThread(void* pvArg)
+{
+  OS_IRQ_DEVICE_T* ptIrq = (OS_IRQ_DEVICE_T*)pvArg;
+
+  /* the DSR serves handshakes the cyclic exchange waits for */
+  (void)OS_SpiSetThreadClass(eOS_SPI_CLASS_CYCLIC);
+
+  while (ptIrq->fRunning)
+  {
+    struct pollfd atPoll[2];
+    int           iEvents;
+    uint32_t      ulLoops = 0;
+
+    atPoll[0].fd     = ptIrq->iFd;
+    atPoll[0].events = POLLIN;
+    atPoll[1].fd     = ptIrq->iStopFd;
+    atPoll[1].events = POLLIN;
+
+    if (poll(atPoll, 2, -1) < 0)
+    {
+      if (EINTR == errno)
+        continue;
+
+      UM_ERROR(GBCIFX_UM_EN, "GBNETX: Waiting for DIRQ failed [%s]", strerror(errno));
+      break;
+    }
+
+    if (0 != atPoll[1].revents)
+      break;
+
+    if (0 == atPoll[0].revents)
+      continue;
+
+    if ((iEvents = IrqDrain(ptIrq)) < 0)
+    {
+      UM_ERROR(GBCIFX_UM_EN, "GBNETX: Interrupt source closed, DSR thread stops");
+      break;
+    }
+
+    if ((0 == iEvents) && !(atPoll[0].revents & POLLIN))
+    {
+      UM_ERROR(GBCIFX_UM_EN, "GBNETX: Interrupt source failed, DSR thread stops");
+      break;
+    }
+
+    ptIrq->ulEvents += (uint32_t)iEvents;
+
+    do
+    {
+      IrqService(ptIrq);
+    } while ( (eOS_IRQ_SOURCE_GPIO == ptIrq->eSource) &&
+              (++ulLoops < OS_IRQ_MAX_RELOOPS)      &&
+              IrqLineActive(ptIrq) );
+  }
+
+  ptIrq->fRunning = 0;
+  return NULL;
+}
+
+/*****************************************************************************/
+/*! Open the interrupt source. For eOS_IRQ_SOURCE_FD iFd must be set by the
+*   caller and stays owned by it.
+*   \param ptIrq Interrupt context
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+long OS_IrqInit(OS_IRQ_DEVICE_T* ptIrq)
+{
+  long lRet = CIFX_NO_ERROR;
+
+  if ((NULL == ptIrq) || (NULL == ptIrq->pvDevInstance))
+    return CIFX_INVALID_PARAMETER;
+
+  ptIrq->fRunning      = 0;
+  ptIrq->fJoinable     = 0;
+  ptIrq->ulEvents      = 0;
+  ptIrq->ulDsrCalls    = 0;
+  ptIrq->ulOtherDevice = 0;
+
+  if (eOS_IRQ_SOURCE_GPIO == ptIrq->eSource)
+  {
+    if (NULL == ptIrq->szChip)
+      return CIFX_INVALID_PARAMETER;
+
+    lRet = IrqRequestLine(ptIrq);
+
+  } else if (ptIrq->iFd < 0)
+  {
+    lRet = CIFX_INVALID_PARAMETER;
+  }
+
+  if (CIFX_NO_ERROR != lRet)
+    return lRet;
+
+  if ((ptIrq->iStopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0)
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create the DSR stop event [%s]", strerror(errno));
+    if (eOS_IRQ_SOURCE_GPIO == ptIrq->eSource)
+    {
+      close(ptIrq->iFd);
+      ptIrq->iFd = -1;
+    }
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Join the DSR thread after it was asked to stop or stopped on its own and
+*   reset the stop event, so a following start does not see the old request
+*   \param ptIrq Interrupt context                                           */
+/*****************************************************************************/
+static void IrqJoin(OS_IRQ_DEVICE_T* ptIrq)
+{
+  uint64_t ullStop;
+
+  pthread_join(ptIrq->tThread, NULL);
+  ptIrq->fJoinable = 0;
+
+  /* the eventfd is non-blocking, a single read resets its counter */
+  (void)read(ptIrq->iStopFd, &ullStop, sizeof(ullStop));
+}
+
+/*****************************************************************************/
+/*! Start the DSR thread (called by OS_EnableInterrupts)
+*   \param ptIrq Interrupt context
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+long OS_IrqStart(OS_IRQ_DEVICE_T* ptIrq)
+{
+  pthread_attr_t     tAttr;
+  struct sched_param tParam;
+  int                iRet;
+
+  if (ptIrq->fRunning)
+    return CIFX_NO_ERROR;
+
+  /* the previous thread stopped on its own (source closed or failed) */
+  if (ptIrq->fJoinable)
+    IrqJoin(ptIrq);
+
+  pthread_attr_init(&tAttr);
+  pthread_attr_setinheritsched(&tAttr, PTHREAD_EXPLICIT_SCHED);
+  pthread_attr_setschedpolicy(&tAttr, SCHED_FIFO);
+  memset(&tParam, 0, sizeof(tParam));
+  tParam.sched_priority = ptIrq->iPriority;
+  pthread_attr_setschedparam(&tAttr, &tParam);
+
+  if (ptIrq->iCpu >= 0)
+  {
+    cpu_set_t tCpuSet;
+
+    CPU_ZERO(&tCpuSet);
+    CPU_SET(ptIrq->iCpu, &tCpuSet);
+    pthread_attr_setaffinity_np(&tAttr, sizeof(tCpuSet), &tCpuSet);
+  }
+
+  ptIrq->fRunning = 1;
+  iRet = pthread_create(&ptIrq->tThread, &tAttr, IrqThread, ptIrq);
+  pthread_attr_destroy(&tAttr);
+
+  if (0 != iRet)
+  {
+    ptIrq->fRunning = 0;
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create DSR thread (SCHED_FIFO prio [%d], cpu [%d]) [%s]",
+             ptIrq->iPriority, ptIrq->iCpu, strerror(iRet));
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  ptIrq->fJoinable = 1;
+  UM_INFO(GBCIFX_UM_EN, "GBNETX: DSR thread started, SCHED_FIFO prio [%d], cpu [%d]", ptIrq->iPriority, ptIrq->iCpu);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Stop the DSR thread (called by OS_DisableInterrupts)
+*   \param ptIrq Interrupt context                                           */
+/*****************************************************************************/
+void OS_IrqStop(OS_IRQ_DEVICE_T* ptIrq)
+{
+  uint64_t ullStop = 1;
+
+  /* a thread that stopped on its own has cleared fRunning, but still has to be joined */
+  if (!ptIrq->fJoinable)
+    return;
+
+  ptIrq->fRunning = 0;
+  if (write(ptIrq->iStopFd, &ullStop, sizeof(ullStop)) != sizeof(ullStop))
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to signal the DSR thread [%s]", strerror(errno));
+
+  IrqJoin(ptIrq);
+}
+
+/*****************************************************************************/
+/*! Close the interrupt source
+*   \param ptIrq Interrupt context                                           */
+/*****************************************************************************/
+void OS_IrqDeinit(OS_IRQ_DEVICE_T* ptIrq)
+{
+  OS_IrqStop(ptIrq);
+
+  if (ptIrq->iStopFd >= 0)
+  {
+    close(ptIrq->iStopFd);
+    ptIrq->iStopFd = -1;
+  }
+
+  if ((eOS_IRQ_SOURCE_GPIO == ptIrq->eSource) && (ptIrq->iFd >= 0))
+  {
+    close(ptIrq->iFd);
+    ptIrq->iFd = -1;
+  }
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file           :  OS_Irq.h
+ * @brief          :  netX DIRQ handling in a DSR thread (interrupt mode)
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file OS_Irq.h
+*    Interrupt source for serial DPM devices. The DIRQ line of the netX is
+*    watched through the Linux GPIO character device (or any file
+*    descriptor, e.g. a pipe as fake interrupt source), each interrupt runs
+*    cifXTKitISRHandler/cifXTKitDSRHandler in a SCHED_FIFO thread.          */
+/*****************************************************************************/
+
+#ifndef OS_IRQ__H
+#define OS_IRQ__H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*****************************************************************************/
+/*! Where interrupts come from                                               */
+/*****************************************************************************/
+typedef enum OS_IRQ_SOURCE_Etag
+{
+  eOS_IRQ_SOURCE_GPIO,            /*!< gpio-cdev line events of szChip/ulLine (gpio-sim works as well) */
+  eOS_IRQ_SOURCE_FD               /*!< Every byte readable from iFd is one interrupt (pipe, socket)    */
+} OS_IRQ_SOURCE_E;
+
+/*****************************************************************************/
+/*! Interrupt context of a device, referenced by pvIrq of the SPI context    */
+/*****************************************************************************/
+typedef struct OS_IRQ_DEVICE_Ttag
+{
+  void*             pvDevInstance;  /*!< Device instance serviced by the DSR thread              */
+  OS_IRQ_SOURCE_E   eSource;        /*!< Interrupt source                                        */
+  const char*       szChip;         /*!< GPIO chip, e.g. "/dev/gpiochip0" (GPIO source only)    */
+  uint32_t          ulLine;         /*!< Line offset of the DIRQ signal (GPIO source only)       */
+  int               iFd;            /*!< Line request (GPIO source) or caller's descriptor (FD)  */
+  int               iStopFd;        /*!< eventfd waking the thread for OS_IrqStop               */
+  int               iPriority;      /*!< SCHED_FIFO priority of the DSR thread                   */
+  int               iCpu;           /*!< CPU the DSR thread is pinned to, -1 = no pinning        */
+  pthread_t         tThread;        /*!< DSR thread                                              */
+  volatile int      fRunning;       /*!< !=0 while the DSR thread is running                     */
+  int               fJoinable;      /*!< !=0 from OS_IrqStart until the DSR thread is joined     */
+  volatile uint32_t ulEvents;       /*!< Interrupt events received                               */
+  volatile uint32_t ulDsrCalls;     /*!< cifXTKitDSRHandler calls                                */
+  volatile uint32_t ulOtherDevice;  /*!< Events the ISR did not accept (DPM not accessible)      */
+} OS_IRQ_DEVICE_T;
+
+long OS_IrqInit  (OS_IRQ_DEVICE_T* ptIrq);
+long OS_IrqStart (OS_IRQ_DEVICE_T* ptIrq);
+void OS_IrqStop  (OS_IRQ_DEVICE_T* ptIrq);
+void OS_IrqDeinit(OS_IRQ_DEVICE_T* ptIrq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OS_IRQ__H */
@@ -12,6 +12,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
   Changes:
     Date        Description
     -----------------------------------------------------------------------------------
+    2026-10-17  Chip select GPIO per device, bus shared through OS_SpiBus.c
     2018-07-26  Added return value to OS_SpiInit()
     2014-08-27  created
 
@@ -24,6 +25,8 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 /*****************************************************************************/
 
 #include "OS_Spi.h"
+#include <string.h>
+#include "bcm2835.h"
 
 #ifdef CIFX_TOOLKIT_HWIF
 //  #error "Implement SPI target system abstraction in this file"
@@ -36,14 +39,21 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 
 
 /*****************************************************************************/
-/*! Initialize SPI components
-*   \param pvOSDependent OS Dependent parameter
-*   \return CIFX_NO_ERROR on success                                         */
+/*! Get the chip select GPIO of a device
+*   \param ptSpiDevice SPI device context
+*   \return GPIO number                                                      */
 /*****************************************************************************/
-long OS_SpiInit(void* pvOSDependent)
+static uint8_t SpiCsGpio(OS_SPI_DEVICE_T* ptSpiDevice)
 {
-  /* initialize SPI device */
+  return (uint8_t)((0 == ptSpiDevice->ulCsGpio) ? OS_SPI_DEFAULT_CS_GPIO : ptSpiDevice->ulCsGpio);
+}
 
+/*****************************************************************************/
+/*! Set up the SPI controller, shared by all chip selects of the bus
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static long SpiInitController(void)
+{
     if (bcm2835_init()){
 
     } else {
@@ -63,12 +73,8 @@ long OS_SpiInit(void* pvOSDependent)
             bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_16);
             UM_INFO(GBCIFX_UM_EN, "GBNETX: bcm2835_spi_setClockDivider set to 16");
 
-        // Disable management of CS pin
-
-        UM_INFO(GBCIFX_UM_EN, "GBNETX: Configuring CS pin");
+        // Disable management of CS pin, every device drives its own GPIO
         bcm2835_spi_chipSelect(BCM2835_SPI_CS_NONE);
-        bcm2835_gpio_fsel(RPI_CS_PIN, BCM2835_GPIO_FSEL_OUTP);
-        bcm2835_gpio_write(RPI_CS_PIN, HIGH);
 
         return CIFX_NO_ERROR;
 
@@ -80,15 +86,55 @@ long OS_SpiInit(void* pvOSDependent)
 
 }
 
+/*****************************************************************************/
+/*! Initialize SPI components. The controller is set up by the first device
+*   of a bus, every device configures its own chip select GPIO.
+*   \param pvOSDependent OS Dependent parameter
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+long OS_SpiInit(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+  OS_SPI_BUS_T*    ptBus;
+  long             lRet        = CIFX_NO_ERROR;
+
+  if (NULL == ptSpiDevice)
+    return CIFX_INVALID_PARAMETER;
+
+  /* dummy bytes clocked out on receive only / idle transfers */
+  memset(ptSpiDevice->abTxIdle, 0, sizeof(ptSpiDevice->abTxIdle));
+  ptBus = OS_SpiBusAttach(ptSpiDevice);
+
+  /* initialize SPI device, other devices may already use the bus */
+  OS_SpiLock(ptSpiDevice);
+
+  if (!ptBus->fHwReady)
+    lRet = SpiInitController();
+
+  if (CIFX_NO_ERROR == lRet)
+  {
+    ptBus->fHwReady = 1;
+
+    UM_INFO(GBCIFX_UM_EN, "GBNETX: Configuring CS pin [%u]", SpiCsGpio(ptSpiDevice));
+    bcm2835_gpio_fsel(SpiCsGpio(ptSpiDevice), BCM2835_GPIO_FSEL_OUTP);
+    bcm2835_gpio_write(SpiCsGpio(ptSpiDevice), HIGH);
+  }
+
+  OS_SpiUnlock(ptSpiDevice);
+
+  return lRet;
+}
+
 /*****************************************************************************/
 /*! Assert chip select
 *   \param pvOSDependent OS Dependent parameter to identify card             */
 /*****************************************************************************/
 void OS_SpiAssert(void* pvOSDependent)
 {
-  /* assert chip select */
-    bcm2835_gpio_write(RPI_CS_PIN, LOW);
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
 
+  /* assert chip select */
+  bcm2835_gpio_write(SpiCsGpio(ptSpiDevice), LOW);
 }
 
 /*****************************************************************************/
@@ -97,17 +143,22 @@ void OS_SpiAssert(void* pvOSDependent)
 /*****************************************************************************/
 void OS_SpiDeassert(void* pvOSDependent)
 {
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
   /* deassert chip select */
-    bcm2835_gpio_write(RPI_CS_PIN, HIGH);
+  bcm2835_gpio_write(SpiCsGpio(ptSpiDevice), HIGH);
 }
 
 /*****************************************************************************/
-/*! Lock the SPI bus
+/*! Lock the SPI bus for a transaction of the class of the calling thread
 *   \param pvOSDependent OS Dependent parameter                              */
 /*****************************************************************************/
 void OS_SpiLock(void* pvOSDependent)
 {
-  /* lock access to SPI device */
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* wait for the transaction boundary of the current bus owner */
+  OS_SpiBusAcquire(ptSpiDevice);
 }
 
 /*****************************************************************************/
@@ -116,7 +167,10 @@ void OS_SpiLock(void* pvOSDependent)
 /*****************************************************************************/
 void OS_SpiUnlock(void* pvOSDependent)
 {
-  /* unlock access to SPI device */
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* hand the bus over to the next waiting transaction */
+  OS_SpiBusRelease(ptSpiDevice);
 }
 
 /*****************************************************************************/
@@ -128,29 +182,56 @@ void OS_SpiUnlock(void* pvOSDependent)
 /*****************************************************************************/
 void OS_SpiTransfer(void* pvOSDependent, uint8_t* pbSend, uint8_t* pbRecv, uint32_t ulLen)
 {
-
-    if (pbRecv==NULL){
-        //transmit onlu
-        uint8_t *dummy_buffer_r = calloc(ulLen, sizeof(uint8_t));
-
-        bcm2835_spi_transfernb( pbSend,dummy_buffer_r, (uint32_t) ulLen);
-
-        free(dummy_buffer_r);
-    } else if (pbSend==NULL){
-        //receive only
-        uint8_t *dummy_buffer_t = calloc(ulLen, sizeof(uint8_t));
-
-        bcm2835_spi_transfernb( dummy_buffer_t,  pbRecv, (uint32_t) ulLen);
-        free(dummy_buffer_t);
-
-    } else {
-        // transmit and receive
-        bcm2835_spi_transfernb(pbSend, pbRecv, (uint32_t) ulLen);
-
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  if (NULL != pbSend)
+  {
+    if (NULL == pbRecv)
+    {
+      /* transmit only, received bytes are dropped by the library */
+      bcm2835_spi_writenb((char*)pbSend, ulLen);
+    } else
+    {
+      /* transmit and receive */
+      bcm2835_spi_transfernb((char*)pbSend, (char*)pbRecv, ulLen);
     }
-
-
+    return;
+  }
+
+  /* receive only or idle transfer, clock out zero bytes from the scratch buffer */
+  while (ulLen > 0)
+  {
+    uint32_t ulChunkLen = (ulLen > OS_SPI_SCRATCH_SIZE) ? OS_SPI_SCRATCH_SIZE : ulLen;
+
+    if (NULL == pbRecv)
+    {
+      bcm2835_spi_writenb((char*)ptSpiDevice->abTxIdle, ulChunkLen);
+    } else
+    {
+      bcm2835_spi_transfernb((char*)ptSpiDevice->abTxIdle, (char*)pbRecv, ulChunkLen);
+      pbRecv += ulChunkLen;
+    }
+    ulLen -= ulChunkLen;
+  }
 }
+/*****************************************************************************/
+/*! Transfer a complete chip select frame
+*   \param pvOSDependent OS Dependent parameter to identify card
+*   \param ptSegments    Segments of the frame
+*   \param ulSegments    Number of segments                                  */
+/*****************************************************************************/
+void OS_SpiTransferFrame(void* pvOSDependent, const OS_SPI_SEGMENT_T* ptSegments, uint32_t ulSegments)
+{
+  uint32_t ulIdx;
+
+  OS_SpiAssert(pvOSDependent);
+  for (ulIdx = 0; ulIdx < ulSegments; ulIdx++)
+  {
+    OS_SpiTransfer(pvOSDependent, ptSegments[ulIdx].pbSend, ptSegments[ulIdx].pbRecv, ptSegments[ulIdx].ulLen);
+  }
+  OS_SpiDeassert(pvOSDependent);
+}
+
 /*****************************************************************************/
 /*! \}                                                                       */
 /*****************************************************************************/
@@ -0,0 +1,358 @@
+/**
+ ******************************************************************************
+ * @file           :  OS_SPIDev.c
+ * @brief          :  SPI abstraction layer on top of the Linux spidev driver
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file OS_SPIDev.c
+*    SPI abstraction layer using /dev/spidevX.Y. Chip select is driven by the
+*    kernel, a complete chip select frame is handed over to the driver as one
+*    SPI_IOC_MESSAGE transaction.                                            */
+/*****************************************************************************/
+
+#include "OS_Spi.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+/* Default transfer buffer size of the spidev driver (module parameter "bufsiz") */
+#define SPIDEV_DEFAULT_BUFSIZ       4096
+#define SPIDEV_BUFSIZ_PARAM         "/sys/module/spidev/parameters/bufsiz"
+
+/* Transfers of one SPI_IOC_MESSAGE, segments may be split at the bufsiz limit */
+#define SPIDEV_MAX_XFERS            (2 * OS_SPI_MAX_SEGMENTS)
+
+/* spidev checks a message against bufsiz with every transfer rounded up to the DMA
+   alignment (ARCH_DMA_MINALIGN), separately for transmit and receive. 128 covers arm64 */
+#define SPIDEV_DMA_ALIGN            128
+#define SPIDEV_ALIGN(ulLen)         (((ulLen) + SPIDEV_DMA_ALIGN - 1) & ~(uint32_t)(SPIDEV_DMA_ALIGN - 1))
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_OS_ABSTRACTION Operating System Abstraction
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Read the maximum message length accepted by the spidev driver
+*   \return Maximum number of bytes per SPI_IOC_MESSAGE                      */
+/*****************************************************************************/
+static uint32_t SpiDevReadBufsiz(void)
+{
+  uint32_t ulBufsiz = SPIDEV_DEFAULT_BUFSIZ;
+  FILE*    hFile    = fopen(SPIDEV_BUFSIZ_PARAM, "r");
+
+  if (NULL != hFile)
+  {
+    unsigned int uiVal = 0;
+
+    if ((1 == fscanf(hFile, "%u", &uiVal)) && (uiVal >= SPIDEV_DMA_ALIGN))
+      ulBufsiz = uiVal;
+
+    fclose(hFile);
+  }
+
+  return ulBufsiz;
+}
+
+/*****************************************************************************/
+/*! Get the length of the next transfer of a segment
+*   \param ptSpiDevice SPI device context
+*   \param pbSend      Send buffer of the segment (may be NULL)
+*   \param pbRecv      Receive buffer of the segment (may be NULL)
+*   \param ulLen       Remaining length of the segment
+*   \param ulTxLen     Aligned transmit bytes already queued in the message
+*   \param ulRxLen     Aligned receive bytes already queued in the message
+*   \return Length of the transfer, 0 if the message is full                 */
+/*****************************************************************************/
+static uint32_t SpiDevChunkLen(OS_SPI_DEVICE_T* ptSpiDevice, uint8_t* pbSend, uint8_t* pbRecv,
+                               uint32_t ulLen, uint32_t ulTxLen, uint32_t ulRxLen)
+{
+  uint32_t ulMaxLen = ptSpiDevice->ulMaxMsgLen;
+
+  /* Idle transfers clock out the scratch buffer, which is transmit data as well */
+  if ((NULL == pbSend) && (NULL == pbRecv))
+  {
+    if (ulMaxLen > OS_SPI_SCRATCH_SIZE)
+      ulMaxLen = OS_SPI_SCRATCH_SIZE;
+    pbSend = ptSpiDevice->abTxIdle;
+  }
+
+  if ((NULL != pbSend) && (ulMaxLen > ptSpiDevice->ulMaxMsgLen - ulTxLen))
+    ulMaxLen = ptSpiDevice->ulMaxMsgLen - ulTxLen;
+  if ((NULL != pbRecv) && (ulMaxLen > ptSpiDevice->ulMaxMsgLen - ulRxLen))
+    ulMaxLen = ptSpiDevice->ulMaxMsgLen - ulRxLen;
+
+  /* The transfer is accounted rounded up, so it has to fit in whole aligned units */
+  ulMaxLen &= ~(uint32_t)(SPIDEV_DMA_ALIGN - 1);
+
+  return (ulLen > ulMaxLen) ? ulMaxLen : ulLen;
+}
+
+/*****************************************************************************/
+/*! Setup a spidev transfer
+*   \param ptSpiDevice SPI device context
+*   \param ptXfer      Transfer to setup
+*   \param pbSend      Send buffer (NULL to send zeros)
+*   \param pbRecv      Receive buffer (NULL to discard)
+*   \param ulLen       Length of the transfer                                */
+/*****************************************************************************/
+static void SpiDevSetupXfer(OS_SPI_DEVICE_T* ptSpiDevice, struct spi_ioc_transfer* ptXfer,
+                            uint8_t* pbSend, uint8_t* pbRecv, uint32_t ulLen)
+{
+  /* Without a send buffer the controller shifts out zeros, but a transfer without
+     any buffer is skipped by the SPI core. Idle transfers use the scratch buffer. */
+  if ((NULL == pbSend) && (NULL == pbRecv))
+    pbSend = ptSpiDevice->abTxIdle;
+
+  ptXfer->tx_buf = (uintptr_t)pbSend;
+  ptXfer->rx_buf = (uintptr_t)pbRecv;
+  ptXfer->len    = ulLen;
+}
+
+/*****************************************************************************/
+/*! Pass queued transfers to the driver as one message
+*   \param ptSpiDevice SPI device context
+*   \param ptXfers     Queued transfers
+*   \param ulXfers     Number of queued transfers
+*   \param fKeepCs     !=0 to keep chip select asserted after the message
+*   \return 0 on success, -1 if the driver failed the message (chip select
+*           is released then)                                                */
+/*****************************************************************************/
+static int SpiDevFlush(OS_SPI_DEVICE_T* ptSpiDevice, struct spi_ioc_transfer* ptXfers, uint32_t ulXfers, int fKeepCs)
+{
+  if (0 == ulXfers)
+  {
+    if (fKeepCs || !ptSpiDevice->fCsHeld)
+      return 0;
+
+    /* Chip select is still active from a previous message, a zero length transfer releases it */
+    memset(ptXfers, 0, sizeof(*ptXfers));
+    ulXfers = 1;
+  }
+
+  ptXfers[ulXfers - 1].cs_change = fKeepCs ? 1 : 0;
+
+  if (ioctl(ptSpiDevice->iFd, SPI_IOC_MESSAGE(ulXfers), ptXfers) < 0)
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: spidev transfer failed [%s]", strerror(errno));
+    ptSpiDevice->fCsHeld = 0;
+    return -1;
+  }
+
+  ptSpiDevice->fCsHeld = fKeepCs;
+  return 0;
+}
+
+/*****************************************************************************/
+/*! Initialize SPI components
+*   \param pvOSDependent OS Dependent parameter
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+long OS_SpiInit(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+  uint8_t          bMode       = SPI_MODE_0;
+  uint8_t          bBits       = 8;
+  uint32_t         ulSpeed;
+
+  if ((NULL == ptSpiDevice) || (NULL == ptSpiDevice->szDevice))
+    return CIFX_INVALID_PARAMETER;
+
+  memset(ptSpiDevice->abTxIdle, 0, sizeof(ptSpiDevice->abTxIdle));
+  (void)OS_SpiBusAttach(ptSpiDevice);
+  ptSpiDevice->fFrameOpen  = 0;
+  ptSpiDevice->fFrameError = 0;
+  ptSpiDevice->fCsHeld     = 0;
+
+  if ((ptSpiDevice->iFd = open(ptSpiDevice->szDevice, O_RDWR)) < 0)
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open [%s] [%s]", ptSpiDevice->szDevice, strerror(errno));
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  ulSpeed = ptSpiDevice->ulSpeedHz;
+
+  /* Mode 0 (CPOL = 0, CPHA = 0), MSB first, 8 bit words */
+  if ((ioctl(ptSpiDevice->iFd, SPI_IOC_WR_MODE, &bMode)           < 0) ||
+      (ioctl(ptSpiDevice->iFd, SPI_IOC_WR_BITS_PER_WORD, &bBits)  < 0) ||
+      (ioctl(ptSpiDevice->iFd, SPI_IOC_WR_MAX_SPEED_HZ, &ulSpeed) < 0) )
+  {
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to configure [%s] [%s]", ptSpiDevice->szDevice, strerror(errno));
+    close(ptSpiDevice->iFd);
+    ptSpiDevice->iFd = -1;
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  ptSpiDevice->ulMaxMsgLen = SpiDevReadBufsiz();
+
+  UM_INFO(GBCIFX_UM_EN, "GBNETX: Using [%s] at [%u] Hz, max. message length [%u]",
+          ptSpiDevice->szDevice, ulSpeed, ptSpiDevice->ulMaxMsgLen);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Assert chip select. The kernel asserts chip select with the first
+*   transfer, so this only opens the frame.
+*   \param pvOSDependent OS Dependent parameter to identify card             */
+/*****************************************************************************/
+void OS_SpiAssert(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  ptSpiDevice->fFrameOpen  = 1;
+  ptSpiDevice->fFrameError = 0;
+}
+
+/*****************************************************************************/
+/*! Deassert chip select
+*   \param pvOSDependent OS Dependent parameter to identify card             */
+/*****************************************************************************/
+void OS_SpiDeassert(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T*        ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+  struct spi_ioc_transfer tXfer;
+
+  ptSpiDevice->fFrameOpen  = 0;
+  ptSpiDevice->fFrameError = 0;
+  (void)SpiDevFlush(ptSpiDevice, &tXfer, 0, 0);
+}
+
+/*****************************************************************************/
+/*! Lock the SPI bus for a transaction of the class of the calling thread
+*   \param pvOSDependent OS Dependent parameter                              */
+/*****************************************************************************/
+void OS_SpiLock(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* wait for the transaction boundary of the current bus owner */
+  OS_SpiBusAcquire(ptSpiDevice);
+}
+
+/*****************************************************************************/
+/*! Unlock the SPI bus
+*   \param pvOSDependent OS Dependent parameter                              */
+/*****************************************************************************/
+void OS_SpiUnlock(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* hand the bus over to the next waiting transaction */
+  OS_SpiBusRelease(ptSpiDevice);
+}
+
+/*****************************************************************************/
+/*! Transfer byte stream via SPI. Inside an asserted frame every call is a
+*   message of its own which keeps chip select active afterwards, as the
+*   caller may evaluate the received data before continuing the frame. Once
+*   a message of the frame failed, the driver has released chip select and
+*   the rest of the frame is dropped, it would start a new frame otherwise.
+*   \param pvOSDependent OS Dependent parameter to identify card
+*   \param pbSend        Send buffer (NULL for polling)
+*   \param pbRecv        Receive buffer (NULL if discard)
+*   \param ulLen         Length of SPI transfer                              */
+/*****************************************************************************/
+void OS_SpiTransfer(void* pvOSDependent, uint8_t* pbSend, uint8_t* pbRecv, uint32_t ulLen)
+{
+  OS_SPI_DEVICE_T*        ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+  struct spi_ioc_transfer tXfer;
+
+  if (ptSpiDevice->fFrameError)
+    return;
+
+  while (ulLen > 0)
+  {
+    uint32_t ulChunkLen = SpiDevChunkLen(ptSpiDevice, pbSend, pbRecv, ulLen, 0, 0);
+
+    memset(&tXfer, 0, sizeof(tXfer));
+    SpiDevSetupXfer(ptSpiDevice, &tXfer, pbSend, pbRecv, ulChunkLen);
+
+    ulLen -= ulChunkLen;
+    if (0 != SpiDevFlush(ptSpiDevice, &tXfer, 1, ptSpiDevice->fFrameOpen || (ulLen > 0)))
+    {
+      ptSpiDevice->fFrameError = ptSpiDevice->fFrameOpen;
+      return;
+    }
+
+    if (NULL != pbSend)
+      pbSend += ulChunkLen;
+    if (NULL != pbRecv)
+      pbRecv += ulChunkLen;
+  }
+}
+
+/*****************************************************************************/
+/*! Transfer a complete chip select frame. All segments are passed to the
+*   driver in a single SPI_IOC_MESSAGE, unless the frame exceeds the driver
+*   buffer size. In that case it is split into several messages and chip
+*   select is kept active in between. If one of them fails, the rest of the
+*   frame is dropped.
+*   \param pvOSDependent OS Dependent parameter to identify card
+*   \param ptSegments    Segments of the frame
+*   \param ulSegments    Number of segments                                  */
+/*****************************************************************************/
+void OS_SpiTransferFrame(void* pvOSDependent, const OS_SPI_SEGMENT_T* ptSegments, uint32_t ulSegments)
+{
+  OS_SPI_DEVICE_T*        ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+  struct spi_ioc_transfer atXfers[SPIDEV_MAX_XFERS];
+  uint32_t                ulXfers     = 0;
+  uint32_t                ulTxLen     = 0;
+  uint32_t                ulRxLen     = 0;
+  uint32_t                ulIdx;
+
+  memset(atXfers, 0, sizeof(atXfers));
+
+  for (ulIdx = 0; ulIdx < ulSegments; ulIdx++)
+  {
+    uint32_t ulOffset = 0;
+
+    while (ulOffset < ptSegments[ulIdx].ulLen)
+    {
+      uint8_t* pbSend = (NULL == ptSegments[ulIdx].pbSend) ? NULL : ptSegments[ulIdx].pbSend + ulOffset;
+      uint8_t* pbRecv = (NULL == ptSegments[ulIdx].pbRecv) ? NULL : ptSegments[ulIdx].pbRecv + ulOffset;
+      uint32_t ulChunkLen = SpiDevChunkLen(ptSpiDevice, pbSend, pbRecv, ptSegments[ulIdx].ulLen - ulOffset,
+                                           ulTxLen, ulRxLen);
+
+      if ((0 == ulChunkLen) || (ulXfers == SPIDEV_MAX_XFERS))
+      {
+        /* Message full, continue the frame in the next one */
+        if (0 != SpiDevFlush(ptSpiDevice, atXfers, ulXfers, 1))
+          return;
+
+        memset(atXfers, 0, sizeof(atXfers));
+        ulXfers = 0;
+        ulTxLen = 0;
+        ulRxLen = 0;
+        continue;
+      }
+
+      SpiDevSetupXfer(ptSpiDevice, &atXfers[ulXfers], pbSend, pbRecv, ulChunkLen);
+      if (0 != atXfers[ulXfers].tx_buf)
+        ulTxLen += SPIDEV_ALIGN(ulChunkLen);
+      if (0 != atXfers[ulXfers].rx_buf)
+        ulRxLen += SPIDEV_ALIGN(ulChunkLen);
+      ++ulXfers;
+
+      ulOffset += ulChunkLen;
+    }
+  }
+
+  (void)SpiDevFlush(ptSpiDevice, atXfers, ulXfers, 0);
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ * @file           :  OS_SPIEmu.c
+ * @brief          :  SPI abstraction layer on top of the serial DPM emulator
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file OS_SPIEmu.c
+*    SPI abstraction layer without a bus. Every transfer is clocked into the
+*    SERDPM_EMU_T referenced by pvEmu of the SPI context, which answers as
+*    the netX would and counts the bytes and frames on the bus.              */
+/*****************************************************************************/
+
+#include "OS_Spi.h"
+#include <string.h>
+#include "SerialDPMEmu.h"
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_OS_ABSTRACTION Operating System Abstraction
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Initialize SPI components
+*   \param pvOSDependent OS Dependent parameter
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+long OS_SpiInit(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  if ((NULL == ptSpiDevice) || (NULL == ptSpiDevice->pvEmu))
+    return CIFX_INVALID_PARAMETER;
+
+  memset(ptSpiDevice->abTxIdle, 0, sizeof(ptSpiDevice->abTxIdle));
+  (void)OS_SpiBusAttach(ptSpiDevice);
+  SerialDPMEmu_Select((SERDPM_EMU_T*)ptSpiDevice->pvEmu, 0);
+
+  UM_INFO(GBCIFX_UM_EN, "GBNETX: Using the serial DPM emulator, chip type [%d]",
+          ((SERDPM_EMU_T*)ptSpiDevice->pvEmu)->iChip);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Assert chip select
+*   \param pvOSDependent OS Dependent parameter to identify card             */
+/*****************************************************************************/
+void OS_SpiAssert(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  SerialDPMEmu_Select((SERDPM_EMU_T*)ptSpiDevice->pvEmu, 1);
+}
+
+/*****************************************************************************/
+/*! Deassert chip select
+*   \param pvOSDependent OS Dependent parameter to identify card             */
+/*****************************************************************************/
+void OS_SpiDeassert(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  SerialDPMEmu_Select((SERDPM_EMU_T*)ptSpiDevice->pvEmu, 0);
+}
+
+/*****************************************************************************/
+/*! Lock the SPI bus for a transaction of the class of the calling thread
+*   \param pvOSDependent OS Dependent parameter                              */
+/*****************************************************************************/
+void OS_SpiLock(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* wait for the transaction boundary of the current bus owner */
+  OS_SpiBusAcquire(ptSpiDevice);
+}
+
+/*****************************************************************************/
+/*! Unlock the SPI bus
+*   \param pvOSDependent OS Dependent parameter                              */
+/*****************************************************************************/
+void OS_SpiUnlock(void* pvOSDependent)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  /* hand the bus over to the next waiting transaction */
+  OS_SpiBusRelease(ptSpiDevice);
+}
+
+/*****************************************************************************/
+/*! Transfer byte stream via SPI. Without a send buffer zeros are clocked
+*   out, as done by the hardware backends.
+*   \param pvOSDependent OS Dependent parameter to identify card
+*   \param pbSend        Send buffer (NULL for polling)
+*   \param pbRecv        Receive buffer (NULL if discard)
+*   \param ulLen         Length of SPI transfer                              */
+/*****************************************************************************/
+void OS_SpiTransfer(void* pvOSDependent, uint8_t* pbSend, uint8_t* pbRecv, uint32_t ulLen)
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  SerialDPMEmu_Clock((SERDPM_EMU_T*)ptSpiDevice->pvEmu, pbSend, pbRecv, ulLen);
+}
+
+/*****************************************************************************/
+/*! Transfer a complete chip select frame
+*   \param pvOSDependent OS Dependent parameter to identify card
+*   \param ptSegments    Segments of the frame
+*   \param ulSegments    Number of segments                                  */
+/*****************************************************************************/
+void OS_SpiTransferFrame(void* pvOSDependent, const OS_SPI_SEGMENT_T* ptSegments, uint32_t ulSegments)
+{
+  uint32_t ulIdx;
+
+  OS_SpiAssert(pvOSDependent);
+  for (ulIdx = 0; ulIdx < ulSegments; ulIdx++)
+  {
+    OS_SpiTransfer(pvOSDependent, ptSegments[ulIdx].pbSend, ptSegments[ulIdx].pbRecv, ptSegments[ulIdx].ulLen);
+  }
+  OS_SpiDeassert(pvOSDependent);
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
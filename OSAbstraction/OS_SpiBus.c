@@ -0,0 +1,248 @@
+/**
+ ******************************************************************************
+ * @file           :  OS_SpiBus.c
+ * @brief          :  Arbitration of an SPI bus shared by several devices
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file OS_SpiBus.c
+*    Bus arbiter used by OS_SpiLock/OS_SpiUnlock of all backends. A
+*    transaction is everything between OS_SpiLock and OS_SpiUnlock, the bus
+*    changes hands only between transactions. On release the bus is handed
+*    over directly to the next waiter: the oldest one of the highest waiting
+*    class, unless a lower class has been bypassed OS_SPI_BUS_MAX_BYPASS
+*    times. The arbiter state is protected by a priority inheritance mutex
+*    which is only held for the hand over, not for the transaction.         */
+/*****************************************************************************/
+
+#include "OS_Spi.h"
+#include <string.h>
+#include <time.h>
+
+/* Traffic class of the transactions of the calling thread */
+static __thread OS_SPI_CLASS_E s_eThreadClass = eOS_SPI_CLASS_MAILBOX;
+
+/* Serializes the creation of the arbiters of shared buses */
+static pthread_mutex_t s_tAttachLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_OS_ABSTRACTION Operating System Abstraction
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Get the time base of the bus accounting
+*   \return Monotonic time in ns                                             */
+/*****************************************************************************/
+static uint64_t SpiBusNow(void)
+{
+  struct timespec tNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow);
+  return (uint64_t)tNow.tv_sec * 1000000000ULL + (uint64_t)tNow.tv_nsec;
+}
+
+/*****************************************************************************/
+/*! Select the class the bus is handed over to, must be called with the
+*   arbiter lock held
+*   \param ptBus Bus
+*   \return Class of the next transaction, -1 if nobody waits               */
+/*****************************************************************************/
+static int SpiBusNextClass(OS_SPI_BUS_T* ptBus)
+{
+  int iNext = -1;
+  int iClass;
+
+  for (iClass = 0; iClass < eOS_SPI_CLASS_COUNT; iClass++)
+  {
+    if (ptBus->aulTicket[iClass] == ptBus->aulServing[iClass])
+      continue;
+
+    if (iNext < 0)
+    {
+      iNext = iClass;
+    } else if (ptBus->aulBypass[iClass] >= OS_SPI_BUS_MAX_BYPASS)
+    {
+      /* waited long enough behind higher classes */
+      iNext = iClass;
+      break;
+    }
+  }
+
+  if (iNext >= 0)
+  {
+    /* every waiting class below the selected one has been bypassed once more */
+    for (iClass = iNext + 1; iClass < eOS_SPI_CLASS_COUNT; iClass++)
+    {
+      if (ptBus->aulTicket[iClass] != ptBus->aulServing[iClass])
+        ++ptBus->aulBypass[iClass];
+    }
+    ptBus->aulBypass[iNext] = 0;
+  }
+
+  return iNext;
+}
+
+/*****************************************************************************/
+/*! Attach the device to its bus and create the arbiter on first use
+*   \param ptSpiDevice SPI device context
+*   \return Bus of the device                                                */
+/*****************************************************************************/
+OS_SPI_BUS_T* OS_SpiBusAttach(OS_SPI_DEVICE_T* ptSpiDevice)
+{
+  OS_SPI_BUS_T* ptBus;
+
+  pthread_mutex_lock(&s_tAttachLock);
+
+  if (NULL == ptSpiDevice->ptBus)
+    ptSpiDevice->ptBus = &ptSpiDevice->tOwnBus;
+
+  ptBus = ptSpiDevice->ptBus;
+  if (!ptBus->fInit)
+  {
+    pthread_mutexattr_t tAttr;
+    int                 iClass;
+
+    pthread_mutexattr_init(&tAttr);
+    pthread_mutexattr_setprotocol(&tAttr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&ptBus->tLock, &tAttr);
+    pthread_mutexattr_destroy(&tAttr);
+
+    for (iClass = 0; iClass < eOS_SPI_CLASS_COUNT; iClass++)
+    {
+      pthread_cond_init(&ptBus->atCond[iClass], NULL);
+      ptBus->aulTicket[iClass]  = 0;
+      ptBus->aulServing[iClass] = 0;
+      ptBus->aulBypass[iClass]  = 0;
+    }
+    ptBus->fBusy   = 0;
+    ptBus->iGrant  = -1;
+    ptBus->pvOwner = NULL;
+    ptBus->fInit   = 1;
+  }
+
+  pthread_mutex_unlock(&s_tAttachLock);
+
+  return ptBus;
+}
+
+/*****************************************************************************/
+/*! Wait for the bus and take it for a transaction
+*   \param ptSpiDevice SPI device context                                    */
+/*****************************************************************************/
+void OS_SpiBusAcquire(OS_SPI_DEVICE_T* ptSpiDevice)
+{
+  OS_SPI_BUS_T*       ptBus      = ptSpiDevice->ptBus;
+  int                 iClass     = (int)s_eThreadClass;
+  OS_SPI_BUS_STATS_T* ptStats    = &ptSpiDevice->atBusStats[iClass];
+  uint64_t            ullStartNs = SpiBusNow();
+
+  pthread_mutex_lock(&ptBus->tLock);
+
+  if (!ptBus->fBusy)
+  {
+    /* bus is idle, so nobody is waiting either */
+    ptBus->fBusy      = 1;
+    ptBus->ullGrantNs = ullStartNs;
+  } else
+  {
+    uint32_t ulTicket = ptBus->aulTicket[iClass]++;
+    uint64_t ullWaitNs;
+
+    while ((ptBus->iGrant != iClass) || (ptBus->aulServing[iClass] != ulTicket))
+      pthread_cond_wait(&ptBus->atCond[iClass], &ptBus->tLock);
+
+    /* handed over by OS_SpiBusRelease, fBusy was kept set */
+    ptBus->iGrant = -1;
+    ++ptBus->aulServing[iClass];
+    ptBus->ullGrantNs = SpiBusNow();
+
+    ullWaitNs = ptBus->ullGrantNs - ullStartNs;
+    ++ptStats->ullContended;
+    ptStats->ullWaitTimeNs += ullWaitNs;
+    if (ullWaitNs > ptStats->ullMaxWaitNs)
+      ptStats->ullMaxWaitNs = ullWaitNs;
+  }
+
+  ptBus->pvOwner     = ptSpiDevice;
+  ptBus->iOwnerClass = iClass;
+
+  pthread_mutex_unlock(&ptBus->tLock);
+}
+
+/*****************************************************************************/
+/*! End the transaction and hand the bus over to the next waiter
+*   \param ptSpiDevice SPI device context                                    */
+/*****************************************************************************/
+void OS_SpiBusRelease(OS_SPI_DEVICE_T* ptSpiDevice)
+{
+  OS_SPI_BUS_T*       ptBus    = ptSpiDevice->ptBus;
+  uint64_t            ullEndNs = SpiBusNow();
+  OS_SPI_BUS_STATS_T* ptStats;
+  int                 iNext;
+
+  pthread_mutex_lock(&ptBus->tLock);
+
+  ptStats = &ptSpiDevice->atBusStats[ptBus->iOwnerClass];
+  ++ptStats->ullTransactions;
+  ptStats->ullBusTimeNs += ullEndNs - ptBus->ullGrantNs;
+  ptBus->pvOwner = NULL;
+
+  if ((iNext = SpiBusNextClass(ptBus)) < 0)
+  {
+    ptBus->fBusy = 0;
+  } else
+  {
+    /* all waiters of the class wake up, the one holding the served ticket takes the bus */
+    ptBus->iGrant = iNext;
+    pthread_cond_broadcast(&ptBus->atCond[iNext]);
+  }
+
+  pthread_mutex_unlock(&ptBus->tLock);
+}
+
+/*****************************************************************************/
+/*! Set the traffic class of the bus transactions of the calling thread
+*   \param eClass Traffic class
+*   \return Previous class of the thread                                     */
+/*****************************************************************************/
+OS_SPI_CLASS_E OS_SpiSetThreadClass(OS_SPI_CLASS_E eClass)
+{
+  OS_SPI_CLASS_E ePrevious = s_eThreadClass;
+
+  if ((int)eClass < (int)eOS_SPI_CLASS_COUNT)
+    s_eThreadClass = eClass;
+
+  return ePrevious;
+}
+
+/*****************************************************************************/
+/*! Get the bus usage of a device
+*   \param pvOSDependent OS Dependent parameter
+*   \param atStats       Returned usage per traffic class                    */
+/*****************************************************************************/
+void OS_SpiGetBusStats(void* pvOSDependent, OS_SPI_BUS_STATS_T atStats[eOS_SPI_CLASS_COUNT])
+{
+  OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)pvOSDependent;
+
+  if ((NULL == ptSpiDevice->ptBus) || !ptSpiDevice->ptBus->fInit)
+  {
+    memset(atStats, 0, sizeof(OS_SPI_BUS_STATS_T) * eOS_SPI_CLASS_COUNT);
+    return;
+  }
+
+  pthread_mutex_lock(&ptSpiDevice->ptBus->tLock);
+  memcpy(atStats, ptSpiDevice->atBusStats, sizeof(OS_SPI_BUS_STATS_T) * eOS_SPI_CLASS_COUNT);
+  pthread_mutex_unlock(&ptSpiDevice->ptBus->tLock);
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
@@ -12,6 +12,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
   Changes:
     Date        Description
     -----------------------------------------------------------------------------------
+    2026-10-17  Bus arbiter for several devices on one SPI bus
     2014-08-01  initial version
 
 **************************************************************************************/
@@ -26,23 +27,126 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 
 #include <stdint.h>
 #include <stdlib.h>
-#include "bcm2835.h"
+#include <pthread.h>
 #include "cifXErrors.h"
 #include "user_message.h"
 #include "log.h"
 
-#define RPI_CS_PIN 8
+/* Size of the persistent scratch buffer used for dummy transmit bytes. Transfers
+   without a send buffer which are longer than this are split into chunks. */
+#ifndef OS_SPI_SCRATCH_SIZE
+  #define OS_SPI_SCRATCH_SIZE  2048
+#endif
+
+#define OS_SPI_CACHE_LINE      64
+
+/* Maximum number of segments in one chip select frame (OS_SpiTransferFrame) */
+#ifndef OS_SPI_MAX_SEGMENTS
+  #define OS_SPI_MAX_SEGMENTS  16
+#endif
 
+/* Chip select GPIO used if ulCsGpio of the SPI context is 0 (CE0 of the Raspberry Pi) */
+#ifndef OS_SPI_DEFAULT_CS_GPIO
+  #define OS_SPI_DEFAULT_CS_GPIO  8
+#endif
 
+/* Transactions of a higher class which may be granted ahead of a waiting lower
+   class transaction, before the lower class gets the bus once */
+#ifndef OS_SPI_BUS_MAX_BYPASS
+  #define OS_SPI_BUS_MAX_BYPASS   16
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/*****************************************************************************/
+/*! Traffic class of a bus transaction (OS_SpiLock .. OS_SpiUnlock), taken
+*   from the calling thread (OS_SpiSetThreadClass). Lower value means higher
+*   priority.                                                                */
+/*****************************************************************************/
+typedef enum OS_SPI_CLASS_Etag
+{
+  eOS_SPI_CLASS_CYCLIC = 0,       /*!< Cyclic I/O and the DSR thread                  */
+  eOS_SPI_CLASS_MAILBOX,          /*!< Mailbox and acyclic services (thread default)  */
+  eOS_SPI_CLASS_DIAG,             /*!< Diagnostics and statistics                     */
+  eOS_SPI_CLASS_COUNT
+} OS_SPI_CLASS_E;
+
+/*****************************************************************************/
+/*! Bus usage of a device in one traffic class                               */
+/*****************************************************************************/
+typedef struct OS_SPI_BUS_STATS_Ttag
+{
+  uint64_t ullTransactions;       /*!< Completed transactions                                 */
+  uint64_t ullContended;          /*!< Transactions which had to wait for the bus             */
+  uint64_t ullBusTimeNs;          /*!< Time the bus was owned                                 */
+  uint64_t ullWaitTimeNs;         /*!< Time spent waiting for the bus                         */
+  uint64_t ullMaxWaitNs;          /*!< Longest wait for the bus                               */
+} OS_SPI_BUS_STATS_T;
+
+/*****************************************************************************/
+/*! SPI bus shared by several devices (chip selects). Transactions are
+*   granted at transaction boundaries by class, in request order within a
+*   class. A lower class is bypassed at most OS_SPI_BUS_MAX_BYPASS times.
+*   Zero initialized, set up by the first OS_SpiInit of a device on it.     */
+/*****************************************************************************/
+typedef struct OS_SPI_BUS_Ttag
+{
+  int             fInit;                                /*!< Lock and conditions created            */
+  int             fHwReady;                             /*!< Controller set up (backend specific)   */
+  pthread_mutex_t tLock;                                /*!< Protects the arbiter state             */
+  pthread_cond_t  atCond[eOS_SPI_CLASS_COUNT];          /*!< Waiters per class                      */
+  int             fBusy;                                /*!< Bus owned or handed over               */
+  int             iGrant;                               /*!< Class the bus was handed over to, -1: none */
+  uint32_t        aulTicket[eOS_SPI_CLASS_COUNT];       /*!< Next ticket per class                  */
+  uint32_t        aulServing[eOS_SPI_CLASS_COUNT];      /*!< Ticket served next per class           */
+  uint32_t        aulBypass[eOS_SPI_CLASS_COUNT];       /*!< Grants to higher classes while waiting */
+  void*           pvOwner;                              /*!< SPI context owning the bus             */
+  int             iOwnerClass;                          /*!< Class of the current transaction       */
+  uint64_t        ullGrantNs;                           /*!< Start of the current transaction       */
+} OS_SPI_BUS_T;
+
+/*****************************************************************************/
+/*! Per device SPI context, passed as pvOSDependent in the DEVICEINSTANCE.
+*   Holds all buffers needed by OS_SpiTransfer, so no heap allocations are
+*   done while the device is in cyclic operation.                            */
+/*****************************************************************************/
+typedef struct OS_SPI_DEVICE_Ttag
+{
+  void*       pvDevInstance;                                /*!< Device instance owning this context */
+  const char* szDevice;                                     /*!< spidev device node (SPIDEV backend only) */
+  uint32_t    ulSpeedHz;                                    /*!< SPI clock in Hz (SPIDEV backend only) */
+  int         iFd;                                          /*!< spidev file descriptor (SPIDEV backend only) */
+  uint32_t    ulMaxMsgLen;                                  /*!< Max. bytes per SPI_IOC_MESSAGE (SPIDEV backend only) */
+  int         fFrameOpen;                                   /*!< Chip select asserted by OS_SpiAssert (SPIDEV backend only) */
+  int         fFrameError;                                  /*!< A message of the open frame failed, the rest is dropped (SPIDEV backend only) */
+  int         fCsHeld;                                      /*!< CS kept active after last transfer (SPIDEV backend only) */
+  void*       pvIrq;                                        /*!< OS_IRQ_DEVICE_T of the DIRQ line, NULL: polling mode */
+  void*       pvEmu;                                        /*!< SERDPM_EMU_T of the emulated netX (EMU backend only) */
+  OS_SPI_BUS_T* ptBus;                                      /*!< Bus shared with other devices, NULL: device has a bus of its own */
+  uint32_t    ulCsGpio;                                     /*!< Chip select GPIO, 0: OS_SPI_DEFAULT_CS_GPIO (BCM2835 backend only) */
+  OS_SPI_BUS_T tOwnBus;                                     /*!< Bus used if ptBus is NULL */
+  OS_SPI_BUS_STATS_T atBusStats[eOS_SPI_CLASS_COUNT];       /*!< Bus usage of the device, see OS_SpiGetBusStats */
+  uint8_t     abTxIdle[OS_SPI_SCRATCH_SIZE]
+              __attribute__((aligned(OS_SPI_CACHE_LINE)));  /*!< Zeroed dummy bytes for receive only / idle transfers */
+} OS_SPI_DEVICE_T;
+
+/*****************************************************************************/
+/*! One segment of a chip select frame. Send and receive buffer follow the
+*   same rules as for OS_SpiTransfer.                                        */
+/*****************************************************************************/
+typedef struct OS_SPI_SEGMENT_Ttag
+{
+  uint8_t*  pbSend;   /*!< Send buffer (NULL to send dummy bytes)   */
+  uint8_t*  pbRecv;   /*!< Receive buffer (NULL to discard)         */
+  uint32_t  ulLen;    /*!< Length of the segment                    */
+} OS_SPI_SEGMENT_T;
+
 /*****************************************************************************/
 /*! Initialize SPI components
-*   \param pvOSDependent OS Dependent parameter
+*   \param pvOSDependent OS Dependent parameter (OS_SPI_DEVICE_T)
 *   \return CIFX_NO_ERROR on success                                         */
 /*****************************************************************************/
 long OS_SpiInit(void* pvOSDependent);
@@ -84,6 +188,54 @@ void OS_SpiUnlock(void* pvOSDependent);
 /*****************************************************************************/
 void OS_SpiTransfer(void* pvOSDependent, uint8_t* pbSend, uint8_t* pbRecv, uint32_t ulLen);
 
+/*****************************************************************************/
+/*! Transfer a complete chip select frame. Chip select is asserted before the
+*   first segment and deasserted after the last one. Backends which are able
+*   to queue transfers (e.g. spidev) execute the frame as one transaction.
+*   Must only be used if none of the segments depends on data received in a
+*   previous segment of the same frame.
+*   \param pvOSDependent OS Dependent parameter
+*   \param ptSegments    Segments of the frame
+*   \param ulSegments    Number of segments (max. OS_SPI_MAX_SEGMENTS)       */
+/*****************************************************************************/
+void OS_SpiTransferFrame(void* pvOSDependent, const OS_SPI_SEGMENT_T* ptSegments, uint32_t ulSegments);
+
+/*****************************************************************************/
+/*! Attach the device to its bus (ptBus or the own bus) and create the
+*   arbiter of the bus on first use. Called by OS_SpiInit of the backends.
+*   \param ptSpiDevice SPI device context
+*   \return Bus of the device                                                */
+/*****************************************************************************/
+OS_SPI_BUS_T* OS_SpiBusAttach(OS_SPI_DEVICE_T* ptSpiDevice);
+
+/*****************************************************************************/
+/*! Wait for the bus and take it for a transaction of the class of the
+*   calling thread. Called by OS_SpiLock of the backends.
+*   \param ptSpiDevice SPI device context                                    */
+/*****************************************************************************/
+void OS_SpiBusAcquire(OS_SPI_DEVICE_T* ptSpiDevice);
+
+/*****************************************************************************/
+/*! End the transaction and hand the bus over to the next waiter. Called by
+*   OS_SpiUnlock of the backends.
+*   \param ptSpiDevice SPI device context                                    */
+/*****************************************************************************/
+void OS_SpiBusRelease(OS_SPI_DEVICE_T* ptSpiDevice);
+
+/*****************************************************************************/
+/*! Set the traffic class of the bus transactions of the calling thread
+*   \param eClass Traffic class
+*   \return Previous class of the thread                                     */
+/*****************************************************************************/
+OS_SPI_CLASS_E OS_SpiSetThreadClass(OS_SPI_CLASS_E eClass);
+
+/*****************************************************************************/
+/*! Get the bus usage of a device
+*   \param pvOSDependent OS Dependent parameter
+*   \param atStats       Returned usage per traffic class                    */
+/*****************************************************************************/
+void OS_SpiGetBusStats(void* pvOSDependent, OS_SPI_BUS_STATS_T atStats[eOS_SPI_CLASS_COUNT]);
+
 #ifdef __cplusplus
 }
 #endif
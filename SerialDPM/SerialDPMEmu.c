@@ -0,0 +1,273 @@
+/**
+ ******************************************************************************
+ * @file           :  SerialDPMEmu.c
+ * @brief          :  netX side of the serial DPM protocols on a memory array
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file SerialDPMEmu.c
+*    Byte level state machine of the serial DPM slave. A frame starts with
+*    the assertion of chip select and consists of the command header and the
+*    data phase. Frame formats as sent by SerialDPMInterface.c:
+*    - netX10:      addr[15:8], addr[7:0], rd/len (0: until CS release), data
+*    - netX50/500:  addr[15:8], addr[7:0], rd/len, reads: idle bytes, 0xA5,
+*                   data. The netX100/500 only supports DWORD accesses.
+*    - netX51/52:   rd/addr[19:16], addr[15:8], addr[7:0], reads: len
+*                   (0: until CS release), data. Writes last until CS release.
+*    While the header is clocked in, the slave returns the bytes the chip
+*    detection of SerialDPM_Init tells the chips apart by.                   */
+/*****************************************************************************/
+
+#include <string.h>
+#include "cifXHWFunctions.h"
+#include "SerialDPMEmu.h"
+#include "SerialDPMInterface.h"
+
+#define SERDPM_EMU_PHASE_HEADER   0   /*!< Command header is clocked in          */
+#define SERDPM_EMU_PHASE_WAIT     1   /*!< Idle bytes and ready marker (netX50/500 read) */
+#define SERDPM_EMU_PHASE_DATA     2   /*!< DPM data                              */
+#define SERDPM_EMU_PHASE_DONE     3   /*!< Access finished or invalid            */
+
+#define SERDPM_EMU_READY          0xA5
+#define SERDPM_EMU_IDLE           0x00
+
+/*****************************************************************************/
+/*! Length of the command header
+*   \param ptEmu  Emulator
+*   \return Number of header bytes                                           */
+/*****************************************************************************/
+static uint32_t SerialDPMEmu_HeaderLen(SERDPM_EMU_T* ptEmu)
+{
+  /* netX51 reads carry an additional length byte */
+  if( (SERDPM_NETX51 == ptEmu->iChip) &&
+      (0 != (ptEmu->abHeader[0] & 0x80)) )
+    return 4;
+
+  return 3;
+}
+
+/*****************************************************************************/
+/*! Byte returned while the command header is clocked in
+*   \param ptEmu  Emulator
+*   \param ulIdx  Index of the header byte
+*   \return MISO byte                                                        */
+/*****************************************************************************/
+static uint8_t SerialDPMEmu_HeaderMiso(SERDPM_EMU_T* ptEmu, uint32_t ulIdx)
+{
+  switch(ptEmu->iChip)
+  {
+    case SERDPM_NETX50:
+      return 0xFF;
+    case SERDPM_NETX100:
+      return (0 == ulIdx) ? 0x64 : 0x00;
+    case SERDPM_NETX51:
+      return (0 == ulIdx) ? 0x11 : 0x00;
+    default:
+      return 0x00;
+  }
+}
+
+/*****************************************************************************/
+/*! Decode the complete command header and start the access
+*   \param ptEmu  Emulator                                                   */
+/*****************************************************************************/
+static void SerialDPMEmu_Decode(SERDPM_EMU_T* ptEmu)
+{
+  uint8_t* pbHeader = ptEmu->abHeader;
+
+  ptEmu->iPhase = SERDPM_EMU_PHASE_DATA;
+
+  switch(ptEmu->iChip)
+  {
+    case SERDPM_NETX51:
+      ptEmu->fWrite      = (0 == (pbHeader[0] & 0x80));
+      ptEmu->ulAddr      = ((uint32_t)(pbHeader[0] & 0x0F) << 16) |
+                           ((uint32_t)pbHeader[1] << 8) |
+                           (uint32_t)pbHeader[2];
+      ptEmu->ulRemaining = ptEmu->fWrite ? 0 : pbHeader[3];
+      ptEmu->fStream     = (0 == ptEmu->ulRemaining);
+      break;
+
+    case SERDPM_NETX10:
+      ptEmu->fWrite      = (0 == (pbHeader[2] & 0x80));
+      ptEmu->ulAddr      = ((uint32_t)pbHeader[0] << 8) | (uint32_t)pbHeader[1];
+      ptEmu->ulRemaining = pbHeader[2] & 0x7F;
+      ptEmu->fStream     = (0 == ptEmu->ulRemaining);
+      break;
+
+    default:
+      /* netX50, netX100/500 */
+      ptEmu->fWrite      = (0 == (pbHeader[2] & 0x80));
+      ptEmu->ulAddr      = ((uint32_t)pbHeader[0] << 8) | (uint32_t)pbHeader[1];
+      ptEmu->ulRemaining = pbHeader[2] & 0x7F;
+      ptEmu->fStream     = 0;
+
+      if(0 == ptEmu->ulRemaining)
+      {
+        ++ptEmu->tStats.ullErrors;
+        ptEmu->iPhase = SERDPM_EMU_PHASE_DONE;
+        break;
+      }
+
+      if( (SERDPM_NETX100 == ptEmu->iChip) &&
+          (0 != ((ptEmu->ulAddr | ptEmu->ulRemaining) & 0x3)) )
+        ++ptEmu->tStats.ullErrors;
+
+      if(!ptEmu->fWrite)
+      {
+        ptEmu->ulWaitCnt = ptEmu->ulWaitBytes;
+        ptEmu->iPhase    = SERDPM_EMU_PHASE_WAIT;
+      }
+      break;
+  }
+}
+
+/*****************************************************************************/
+/*! Clock a single byte of the current frame
+*   \param ptEmu  Emulator
+*   \param bMosi  Byte sent by the host
+*   \return Byte returned to the host                                        */
+/*****************************************************************************/
+static uint8_t SerialDPMEmu_Byte(SERDPM_EMU_T* ptEmu, uint8_t bMosi)
+{
+  uint8_t bMiso = SERDPM_EMU_IDLE;
+
+  switch(ptEmu->iPhase)
+  {
+    case SERDPM_EMU_PHASE_HEADER:
+      bMiso = SerialDPMEmu_HeaderMiso(ptEmu, ptEmu->ulHeaderCnt);
+      ptEmu->abHeader[ptEmu->ulHeaderCnt++] = bMosi;
+      ++ptEmu->tStats.ullHeaderBytes;
+
+      if(ptEmu->ulHeaderCnt == SerialDPMEmu_HeaderLen(ptEmu))
+        SerialDPMEmu_Decode(ptEmu);
+      break;
+
+    case SERDPM_EMU_PHASE_WAIT:
+      ++ptEmu->tStats.ullDummyBytes;
+
+      if(0 != ptEmu->ulWaitCnt)
+      {
+        --ptEmu->ulWaitCnt;
+      } else
+      {
+        bMiso         = SERDPM_EMU_READY;
+        ptEmu->iPhase = SERDPM_EMU_PHASE_DATA;
+      }
+      break;
+
+    case SERDPM_EMU_PHASE_DATA:
+      ++ptEmu->tStats.ullDataBytes;
+
+      if(ptEmu->ulAddr >= ptEmu->ulDpmSize)
+        ++ptEmu->tStats.ullErrors;
+      else if(ptEmu->fWrite)
+        ptEmu->pbDpm[ptEmu->ulAddr] = bMosi;
+      else
+        bMiso = ptEmu->pbDpm[ptEmu->ulAddr];
+
+      ++ptEmu->ulAddr;
+
+      if( !ptEmu->fStream && (0 == --ptEmu->ulRemaining) )
+        ptEmu->iPhase = SERDPM_EMU_PHASE_DONE;
+      break;
+
+    default:
+      ++ptEmu->tStats.ullDummyBytes;
+      break;
+  }
+
+  return bMiso;
+}
+
+/*****************************************************************************/
+/*! Initialize the emulator, chip select is released
+*   \param ptEmu      Emulator
+*   \param iChip      Emulated chip (SERDPM_NETX10/50/51/100)
+*   \param pbDpm      DPM content
+*   \param ulDpmSize  Size of the DPM
+*   \param ptDpmLock  Lock shared with the producer of the DPM content (e.g.
+*                     the simulated firmware), NULL if there is none         */
+/*****************************************************************************/
+void SerialDPMEmu_Init(SERDPM_EMU_T* ptEmu, int iChip, uint8_t* pbDpm, uint32_t ulDpmSize, pthread_mutex_t* ptDpmLock)
+{
+  memset(ptEmu, 0, sizeof(*ptEmu));
+  ptEmu->iChip       = iChip;
+  ptEmu->pbDpm       = pbDpm;
+  ptEmu->ulDpmSize   = ulDpmSize;
+  ptEmu->ptDpmLock   = ptDpmLock;
+  ptEmu->ulWaitBytes = SERDPM_EMU_DEFAULT_WAIT_BYTES;
+  ptEmu->iPhase      = SERDPM_EMU_PHASE_DONE;
+}
+
+/*****************************************************************************/
+/*! Chip select edge, an assertion starts a new frame
+*   \param ptEmu    Emulator
+*   \param fSelect  !=0 if chip select is asserted                           */
+/*****************************************************************************/
+void SerialDPMEmu_Select(SERDPM_EMU_T* ptEmu, int fSelect)
+{
+  if(fSelect && !ptEmu->fSelected)
+  {
+    ++ptEmu->tStats.ullCsAsserts;
+    ptEmu->iPhase      = SERDPM_EMU_PHASE_HEADER;
+    ptEmu->ulHeaderCnt = 0;
+  }
+
+  ptEmu->fSelected = fSelect;
+}
+
+/*****************************************************************************/
+/*! Clock bytes on the bus
+*   \param ptEmu   Emulator
+*   \param pbMosi  Bytes sent by the host (NULL: zeros)
+*   \param pbMiso  Bytes returned by the slave (NULL: discard)
+*   \param ulLen   Number of bytes                                           */
+/*****************************************************************************/
+void SerialDPMEmu_Clock(SERDPM_EMU_T* ptEmu, const uint8_t* pbMosi, uint8_t* pbMiso, uint32_t ulLen)
+{
+  uint32_t ulIdx;
+
+  ptEmu->tStats.ullClockBytes += ulLen;
+
+  /* Not selected, the slave does not drive MISO */
+  if(!ptEmu->fSelected)
+  {
+    ptEmu->tStats.ullDummyBytes += ulLen;
+    if(NULL != pbMiso)
+      memset(pbMiso, 0xFF, ulLen);
+    return;
+  }
+
+  if(NULL != ptEmu->ptDpmLock)
+    pthread_mutex_lock(ptEmu->ptDpmLock);
+
+  for(ulIdx = 0; ulIdx < ulLen; ++ulIdx)
+  {
+    uint8_t bMiso = SerialDPMEmu_Byte(ptEmu, (NULL != pbMosi) ? pbMosi[ulIdx] : 0x00);
+
+    if(NULL != pbMiso)
+      pbMiso[ulIdx] = bMiso;
+  }
+
+  if(NULL != ptEmu->ptDpmLock)
+    pthread_mutex_unlock(ptEmu->ptDpmLock);
+}
+
+/*****************************************************************************/
+/*! Read the bus counters. The counters are only written by the bus owner,
+*   take a snapshot before and after an access to get its cost.
+*   \param ptEmu    Emulator
+*   \param ptStats  Returned counters                                        */
+/*****************************************************************************/
+void SerialDPMEmu_GetStats(SERDPM_EMU_T* ptEmu, SERDPM_EMU_STATS_T* ptStats)
+{
+  *ptStats = ptEmu->tStats;
+}
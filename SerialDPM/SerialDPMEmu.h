@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file           :  SerialDPMEmu.h
+ * @brief          :  netX side of the serial DPM protocols on a memory array
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file SerialDPMEmu.h
+*    Emulates the SPI slave of a netX10, netX50, netX100/500 or netX51/52 as
+*    driven by SerialDPMInterface.c. The emulator is fed with the bytes
+*    clocked on the bus and the chip select edges, so it can sit below any
+*    OS_Spi implementation (OS_SPIEmu.c, the bcm2835 stand-in of the bench).
+*
+*    Every clocked byte is accounted as one of
+*    - header: command/address/length bytes of a frame,
+*    - data:   DPM bytes read or written by the access,
+*    - dummy:  everything else, i.e. the idle bytes and the 0xA5 ready marker
+*              of the netX50/500 read, bytes clocked after the access ended,
+*              bytes of frames without a valid command and bytes clocked
+*              while chip select is released.                               */
+/*****************************************************************************/
+
+#ifndef SERIALDPMEMU__H
+#define SERIALDPMEMU__H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Idle bytes sent by a netX50/500 before the 0xA5 ready marker of a read */
+#ifndef SERDPM_EMU_DEFAULT_WAIT_BYTES
+  #define SERDPM_EMU_DEFAULT_WAIT_BYTES  1
+#endif
+
+/*****************************************************************************/
+/*! Bus counters of the emulated slave                                       */
+/*****************************************************************************/
+typedef struct SERDPM_EMU_STATS_Ttag
+{
+  uint64_t ullClockBytes;   /*!< Bytes clocked on the bus                     */
+  uint64_t ullCsAsserts;    /*!< Chip select assertions (frames)              */
+  uint64_t ullHeaderBytes;  /*!< Command header bytes                         */
+  uint64_t ullDataBytes;    /*!< DPM bytes read or written                    */
+  uint64_t ullDummyBytes;   /*!< Bytes without header or DPM data             */
+  uint64_t ullErrors;       /*!< Protocol violations (range, alignment, length) */
+} SERDPM_EMU_STATS_T;
+
+/*****************************************************************************/
+/*! Emulated serial DPM slave                                                */
+/*****************************************************************************/
+typedef struct SERDPM_EMU_Ttag
+{
+  int                iChip;          /*!< SERDPM_NETX10/50/51/100               */
+  uint8_t*           pbDpm;          /*!< DPM content                           */
+  uint32_t           ulDpmSize;      /*!< Size of pbDpm                         */
+  pthread_mutex_t*   ptDpmLock;      /*!< Held while DPM bytes are accessed, NULL: none */
+  uint32_t           ulWaitBytes;    /*!< Idle bytes before 0xA5 (netX50/500)   */
+
+  /* State of the current frame */
+  int                fSelected;      /*!< Chip select active                    */
+  int                iPhase;         /*!< SERDPM_EMU_PHASE_*                    */
+  uint8_t            abHeader[4];    /*!< Header bytes received so far          */
+  uint32_t           ulHeaderCnt;    /*!< Number of bytes in abHeader           */
+  int                fWrite;         /*!< Access is a write                     */
+  int                fStream;        /*!< Access lasts until chip select is released */
+  uint32_t           ulAddr;         /*!< Next DPM address                      */
+  uint32_t           ulRemaining;    /*!< Bytes left of a fixed length access   */
+  uint32_t           ulWaitCnt;      /*!< Idle bytes left before 0xA5           */
+
+  SERDPM_EMU_STATS_T tStats;
+} SERDPM_EMU_T;
+
+void SerialDPMEmu_Init     (SERDPM_EMU_T* ptEmu, int iChip, uint8_t* pbDpm, uint32_t ulDpmSize, pthread_mutex_t* ptDpmLock);
+void SerialDPMEmu_Select   (SERDPM_EMU_T* ptEmu, int fSelect);
+void SerialDPMEmu_Clock    (SERDPM_EMU_T* ptEmu, const uint8_t* pbMosi, uint8_t* pbMiso, uint32_t ulLen);
+void SerialDPMEmu_GetStats (SERDPM_EMU_T* ptEmu, SERDPM_EMU_STATS_T* ptStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERIALDPMEMU__H */
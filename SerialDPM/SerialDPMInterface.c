@@ -25,6 +25,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 
 #include "OS_Spi.h"
 #include "cifXHWFunctions.h"
+#include "cifXStats.h"
 #include "SerialDPMInterface.h"
 #include "cifXErrors.h"
 
@@ -41,6 +42,20 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #define CMD_WRITE_NX51(addr) ((addr>>16)&0xF)
 #define CMD_LEN_NX51(len)    ((len > 255)? 0x00:len)
 
+/* Bus time of a chip select frame besides its header, in byte times (chip select
+   setup and hold, driver call). Sets the merge gap of the delta writes */
+#ifndef SERDPM_FRAME_OVERHEAD
+  #define SERDPM_FRAME_OVERHEAD 16
+#endif
+
+/* Idle bytes and ready marker a netX50/500 read is expected to take before the data */
+#ifndef SERDPM_READ_WAIT_BYTES
+  #define SERDPM_READ_WAIT_BYTES 2
+#endif
+
+/* Assembles the command header of a serial DPM frame, returns header length */
+typedef uint32_t (*PFN_SERDPM_HEADER)(uint8_t* pbHeader, uint32_t ulDpmAddr, uint32_t ulLen, int fWrite);
+
 #ifndef CIFX_TOOLKIT_HWIF
 //  #error "CIFX_TOOLKIT_HWIF must be explicitly enabled to support serial DPM!"
 #endif
@@ -73,29 +88,29 @@ static void* Read_NX50( void* pvDevInstance, void* pvAddr, void* pvData, uint32_
     abSend[1] = (uint8_t)((ulDpmAddr >> 0) & 0xFF);
     abSend[2] = (uint8_t)(CMD_READ_NX50(ulChunkLen));
 
-    OS_SpiAssert(pvDevInstance);
-    OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
+    OS_SpiAssert(ptDevice->pvOSDependent);
+    OS_SpiTransfer(ptDevice->pvOSDependent, abSend, NULL, MAX_CNT(abSend));
+    CIFX_STATS_HWIF_FRAME(ptDevice, ulChunkLen);
 
     do
     {
       if(ulByteTimeout == 0)
       {
-          OS_SpiDeassert(pvDevInstance);
+          OS_SpiDeassert(ptDevice->pvOSDependent);
+          OS_SpiUnlock(ptDevice->pvOSDependent);
           return pvData;
       }
       --ulByteTimeout;
 
       /* get the idle bytes done */
-      OS_SpiTransfer(pvDevInstance, NULL, &bUnused, 1);
+      OS_SpiTransfer(ptDevice->pvOSDependent, NULL, &bUnused, 1);
 
     } while((bUnused & 0xFF) != 0xA5);
 
-    while(ulChunkLen--)
-    {
-      OS_SpiTransfer(pvDevInstance, &bUnused, pabData++, 1);
-    }
+    OS_SpiTransfer(ptDevice->pvOSDependent, NULL, pabData, ulChunkLen);
+    pabData += ulChunkLen;      /*lint !e662 */
 
-    OS_SpiDeassert(pvDevInstance);
+    OS_SpiDeassert(ptDevice->pvOSDependent);
 
     ulDpmAddr += MAX_TRANSFER_LEN;
   }
@@ -130,10 +145,11 @@ static void* Write_NX50( void* pvDevInstance, void* pvAddr, void* pvData, uint32
     abSend[1] = (uint8_t)((ulDpmAddr >> 0) & 0xFF);
     abSend[2] = (uint8_t)ulChunkLen;
 
-    OS_SpiAssert(pvDevInstance);
-    OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
-    OS_SpiTransfer(pvDevInstance, pabData, NULL, ulChunkLen);
-    OS_SpiDeassert(pvDevInstance);
+    OS_SpiAssert(ptDevice->pvOSDependent);
+    OS_SpiTransfer(ptDevice->pvOSDependent, abSend, NULL, MAX_CNT(abSend));
+    CIFX_STATS_HWIF_FRAME(ptDevice, ulChunkLen);
+    OS_SpiTransfer(ptDevice->pvOSDependent, pabData, NULL, ulChunkLen);
+    OS_SpiDeassert(ptDevice->pvOSDependent);
 
     ulDpmAddr += ulChunkLen;
     pabData   += ulChunkLen;      /*lint !e662 */
@@ -157,57 +173,56 @@ static void* Read_NX500( void* pvDevInstance, void* pvAddr, void* pvData, uint32
   uint32_t        ulByteTimeout = 100;
   uint32_t        ulDpmAddr     = (uint32_t)pvAddr;
   uint8_t*        pabData       = (uint8_t*)pvData;
-  uint32_t        ulPreLen      = ulDpmAddr&0x3;
-
-  /* Align offset and length */
-  ulDpmAddr &= ~0x3;
 
   OS_SpiLock(ptDevice->pvOSDependent);
   while (ulLen > 0)
   {
     uint8_t  abSend[3];
-    uint32_t ulChunkLen   = MIN(MAX_TRANSFER_LEN, ulLen);
-    uint32_t ulAlignedLen = (ulChunkLen+3)&~0x3;
+    /* Align offset and length, the leading bytes up to ulDpmAddr are part of the aligned access */
+    uint32_t ulPreLen     = ulDpmAddr&0x3;
+    uint32_t ulChunkLen   = MIN(MAX_TRANSFER_LEN - ulPreLen, ulLen);
+    uint32_t ulAlignedLen = (ulPreLen+ulChunkLen+3)&~0x3;
 
     ulLen -= ulChunkLen;
 
     /* Assemble command */
-    abSend[0] = (uint8_t)((ulDpmAddr >> 8) & 0xFF);
-    abSend[1] = (uint8_t)((ulDpmAddr >> 0) & 0xFF);
+    abSend[0] = (uint8_t)(((ulDpmAddr&~0x3) >> 8) & 0xFF);
+    abSend[1] = (uint8_t)(((ulDpmAddr&~0x3) >> 0) & 0xFF);
     abSend[2] = (uint8_t)(CMD_READ_NX50(ulAlignedLen));
 
     /* assert chip select */
-    OS_SpiAssert(pvDevInstance);
-    OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
+    OS_SpiAssert(ptDevice->pvOSDependent);
+    OS_SpiTransfer(ptDevice->pvOSDependent, abSend, NULL, MAX_CNT(abSend));
+    CIFX_STATS_HWIF_FRAME(ptDevice, ulChunkLen);
 
     do
     {
       if(ulByteTimeout == 0)
       {
-          OS_SpiDeassert(pvDevInstance);
+          OS_SpiDeassert(ptDevice->pvOSDependent);
+          OS_SpiUnlock(ptDevice->pvOSDependent);
           return pvData;
       }
       --ulByteTimeout;
 
       /* get the idle bytes done */
-      OS_SpiTransfer(pvDevInstance, NULL, &bUnused, 1);
+      OS_SpiTransfer(ptDevice->pvOSDependent, NULL, &bUnused, 1);
 
     } while((bUnused & 0xFF) != 0xA5);
 
     if (ulPreLen)
     {
-      OS_SpiTransfer(pvDevInstance, NULL, NULL, ulPreLen);
-      ulPreLen = 0;
+      OS_SpiTransfer(ptDevice->pvOSDependent, NULL, NULL, ulPreLen);
     }
 
-    OS_SpiTransfer(pvDevInstance, NULL, pabData, ulChunkLen);
+    OS_SpiTransfer(ptDevice->pvOSDependent, NULL, pabData, ulChunkLen);
 
-    if (0 != (ulAlignedLen - ulChunkLen))
+    if (0 != (ulAlignedLen - ulPreLen - ulChunkLen))
     {
-      OS_SpiTransfer(pvDevInstance, NULL, NULL, ulAlignedLen - ulChunkLen);
+      OS_SpiTransfer(ptDevice->pvOSDependent, NULL, NULL, ulAlignedLen - ulPreLen - ulChunkLen);
     }
 
-    OS_SpiDeassert(pvDevInstance);
+    OS_SpiDeassert(ptDevice->pvOSDependent);
 
     ulDpmAddr += ulChunkLen;
     pabData   += ulChunkLen;      /*lint !e662 */
@@ -279,19 +294,25 @@ static void* ReadModifyWrite_NX500( void* pvDevInstance, void* pvAddr, void* pvD
 /*****************************************************************************/
 static void* Read_NX10( void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
 {
-  DEVICEINSTANCE* ptDevice = (DEVICEINSTANCE*) pvDevInstance;
-  uint8_t         abSend[3];
+  DEVICEINSTANCE*  ptDevice = (DEVICEINSTANCE*) pvDevInstance;
+  uint8_t          abSend[3];
+  OS_SPI_SEGMENT_T atFrame[2];
 
   /* Assemble command */
   abSend[0] = (uint8_t)(((uint32_t)pvAddr >> 8) & 0xFF);
   abSend[1] = (uint8_t)(((uint32_t)pvAddr >> 0) & 0xFF);
   abSend[2] = (uint8_t)(CMD_READ_NX10(ulLen));
 
+  atFrame[0].pbSend = abSend;
+  atFrame[0].pbRecv = NULL;
+  atFrame[0].ulLen  = MAX_CNT(abSend);
+  atFrame[1].pbSend = NULL;
+  atFrame[1].pbRecv = (uint8_t*)pvData;
+  atFrame[1].ulLen  = ulLen;
+
   OS_SpiLock(ptDevice->pvOSDependent);
-  OS_SpiAssert(pvDevInstance);
-  OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
-  OS_SpiTransfer(pvDevInstance, NULL, (uint8_t*)pvData, ulLen);
-  OS_SpiDeassert(pvDevInstance);
+  OS_SpiTransferFrame(ptDevice->pvOSDependent, atFrame, MAX_CNT(atFrame));
+  CIFX_STATS_HWIF_FRAME(ptDevice, ulLen);
   OS_SpiUnlock(ptDevice->pvOSDependent);
   return pvData;
 }
@@ -305,19 +326,25 @@ static void* Read_NX10( void* pvDevInstance, void* pvAddr, void* pvData, uint32_
 /*****************************************************************************/
 static void* Write_NX10( void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
 {
-  DEVICEINSTANCE* ptDevice = (DEVICEINSTANCE*) pvDevInstance;
-  uint8_t         abSend[3];
+  DEVICEINSTANCE*  ptDevice = (DEVICEINSTANCE*) pvDevInstance;
+  uint8_t          abSend[3];
+  OS_SPI_SEGMENT_T atFrame[2];
 
   /* Assemble command */
   abSend[0] = (uint8_t)(((uint32_t)pvAddr >> 8) & 0xFF);
   abSend[1] = (uint8_t)(((uint32_t)pvAddr >> 0) & 0xFF);
   abSend[2] = (uint8_t)(CMD_WRITE_NX10(ulLen));
 
+  atFrame[0].pbSend = abSend;
+  atFrame[0].pbRecv = NULL;
+  atFrame[0].ulLen  = MAX_CNT(abSend);
+  atFrame[1].pbSend = (uint8_t*)pvData;
+  atFrame[1].pbRecv = NULL;
+  atFrame[1].ulLen  = ulLen;
+
   OS_SpiLock(ptDevice->pvOSDependent);
-  OS_SpiAssert(pvDevInstance);
-  OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
-  OS_SpiTransfer(pvDevInstance, (uint8_t*)pvData, NULL, ulLen);
-  OS_SpiDeassert(pvDevInstance);
+  OS_SpiTransferFrame(ptDevice->pvOSDependent, atFrame, MAX_CNT(atFrame));
+  CIFX_STATS_HWIF_FRAME(ptDevice, ulLen);
   OS_SpiUnlock(ptDevice->pvOSDependent);
   return pvAddr;
 }
@@ -331,8 +358,9 @@ static void* Write_NX10( void* pvDevInstance, void* pvAddr, void* pvData, uint32
 /*****************************************************************************/
 static void* Read_NX51( void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
 {
-  DEVICEINSTANCE* ptDevice = (DEVICEINSTANCE*) pvDevInstance;
-  uint8_t         abSend[4];
+  DEVICEINSTANCE*  ptDevice = (DEVICEINSTANCE*) pvDevInstance;
+  uint8_t          abSend[4];
+  OS_SPI_SEGMENT_T atFrame[2];
 
   /* Assemble command */
   abSend[0] = (uint8_t)(CMD_READ_NX51((uint32_t)pvAddr));
@@ -340,11 +368,16 @@ static void* Read_NX51( void* pvDevInstance, void* pvAddr, void* pvData, uint32_
   abSend[2] = (uint8_t)(((uint32_t)pvAddr >> 0) & 0xFF);
   abSend[3] = (uint8_t)(CMD_LEN_NX51(ulLen));
 
+  atFrame[0].pbSend = abSend;
+  atFrame[0].pbRecv = NULL;
+  atFrame[0].ulLen  = MAX_CNT(abSend);
+  atFrame[1].pbSend = NULL;
+  atFrame[1].pbRecv = (uint8_t*)pvData;
+  atFrame[1].ulLen  = ulLen;
+
   OS_SpiLock(ptDevice->pvOSDependent);
-  OS_SpiAssert(pvDevInstance);
-  OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
-  OS_SpiTransfer(pvDevInstance, NULL, (uint8_t*)pvData, ulLen);
-  OS_SpiDeassert(pvDevInstance);
+  OS_SpiTransferFrame(ptDevice->pvOSDependent, atFrame, MAX_CNT(atFrame));
+  CIFX_STATS_HWIF_FRAME(ptDevice, ulLen);
   OS_SpiUnlock(ptDevice->pvOSDependent);
   return pvData;
 }
@@ -358,23 +391,258 @@ static void* Read_NX51( void* pvDevInstance, void* pvAddr, void* pvData, uint32_
 /*****************************************************************************/
 static void* Write_NX51( void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
 {
-  DEVICEINSTANCE* ptDevice = (DEVICEINSTANCE*) pvDevInstance;
-  uint8_t         abSend[3];
+  DEVICEINSTANCE*  ptDevice = (DEVICEINSTANCE*) pvDevInstance;
+  uint8_t          abSend[3];
+  OS_SPI_SEGMENT_T atFrame[2];
 
   /* Assemble command */
   abSend[0] = (uint8_t)(CMD_WRITE_NX51((uint32_t)pvAddr));
   abSend[1] = (uint8_t)(((uint32_t)pvAddr >> 8) & 0xFF);
   abSend[2] = (uint8_t)(((uint32_t)pvAddr >> 0) & 0xFF);
 
+  atFrame[0].pbSend = abSend;
+  atFrame[0].pbRecv = NULL;
+  atFrame[0].ulLen  = MAX_CNT(abSend);
+  atFrame[1].pbSend = (uint8_t*)pvData;
+  atFrame[1].pbRecv = NULL;
+  atFrame[1].ulLen  = ulLen;
+
   OS_SpiLock(ptDevice->pvOSDependent);
-  OS_SpiAssert(pvDevInstance);
-  OS_SpiTransfer(pvDevInstance, abSend, NULL, MAX_CNT(abSend));
-  OS_SpiTransfer(pvDevInstance, (uint8_t*)pvData, NULL, ulLen);
-  OS_SpiDeassert(pvDevInstance);
+  OS_SpiTransferFrame(ptDevice->pvOSDependent, atFrame, MAX_CNT(atFrame));
+  CIFX_STATS_HWIF_FRAME(ptDevice, ulLen);
   OS_SpiUnlock(ptDevice->pvOSDependent);
   return pvAddr;
 }
 
+/*****************************************************************************/
+/*! Assemble command header (netX10 Slave)
+*   \param pbHeader   Buffer for header (at least 3 bytes)
+*   \param ulDpmAddr  DPM address of the access
+*   \param ulLen      Number of bytes to transfer
+*   \param fWrite     !=0 for a write access
+*   \return Length of the header                                             */
+/*****************************************************************************/
+static uint32_t Header_NX10( uint8_t* pbHeader, uint32_t ulDpmAddr, uint32_t ulLen, int fWrite)
+{
+  pbHeader[0] = (uint8_t)((ulDpmAddr >> 8) & 0xFF);
+  pbHeader[1] = (uint8_t)((ulDpmAddr >> 0) & 0xFF);
+  pbHeader[2] = (uint8_t)(fWrite ? CMD_WRITE_NX10(ulLen) : CMD_READ_NX10(ulLen));
+  return 3;
+}
+
+/*****************************************************************************/
+/*! Assemble command header (netX51 Slave)
+*   \param pbHeader   Buffer for header (at least 4 bytes)
+*   \param ulDpmAddr  DPM address of the access
+*   \param ulLen      Number of bytes to transfer
+*   \param fWrite     !=0 for a write access
+*   \return Length of the header                                             */
+/*****************************************************************************/
+static uint32_t Header_NX51( uint8_t* pbHeader, uint32_t ulDpmAddr, uint32_t ulLen, int fWrite)
+{
+  pbHeader[1] = (uint8_t)((ulDpmAddr >> 8) & 0xFF);
+  pbHeader[2] = (uint8_t)((ulDpmAddr >> 0) & 0xFF);
+
+  if(fWrite)
+  {
+    pbHeader[0] = (uint8_t)(CMD_WRITE_NX51(ulDpmAddr));
+    return 3;
+  }
+
+  pbHeader[0] = (uint8_t)(CMD_READ_NX51(ulDpmAddr));
+  pbHeader[3] = (uint8_t)(CMD_LEN_NX51(ulLen));
+  return 4;
+}
+
+/*****************************************************************************/
+/*! Execute a vectored access as few serial DPM frames as possible.
+*   Consecutive entries are joined into one frame, if the next entry starts
+*   at or behind the end of the current frame. Reads may skip up to
+*   SERDPM_READV_MAX_GAP unused bytes, writes are only joined if the ranges
+*   are adjacent, as the skipped DPM content would be overwritten.
+*   \param ptDevice   Device Instance
+*   \param ptIoVec    List of DPM ranges and buffers
+*   \param ulCount    Number of entries in ptIoVec
+*   \param pfnHeader  Command header builder of the chip
+*   \param fWrite     !=0 for a write access                                 */
+/*****************************************************************************/
+static void TransferV( DEVICEINSTANCE* ptDevice, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount,
+                       PFN_SERDPM_HEADER pfnHeader, int fWrite)
+{
+  uint8_t          abHeader[4];
+  OS_SPI_SEGMENT_T atFrame[OS_SPI_MAX_SEGMENTS];
+  uint32_t         ulIdx = 0;
+
+  OS_SpiLock(ptDevice->pvOSDependent);
+  while(ulIdx < ulCount)
+  {
+    uint32_t ulSegments = 1; /* Segment 0 is the command header */
+    uint32_t ulStart    = (uint32_t)ptIoVec[ulIdx].pvAddr;
+    uint32_t ulEnd      = ulStart;
+
+    if(0 == ptIoVec[ulIdx].ulLen)
+    {
+      ++ulIdx;
+      continue;
+    }
+
+    while(ulIdx < ulCount)
+    {
+      HWIF_IOVEC_T* ptEntry = &ptIoVec[ulIdx];
+      uint32_t      ulAddr  = (uint32_t)ptEntry->pvAddr;
+      uint32_t      ulGap;
+
+      if(0 == ptEntry->ulLen)
+      {
+        ++ulIdx;
+        continue;
+      }
+
+      if(ulAddr < ulEnd)
+        break;
+
+      ulGap = ulAddr - ulEnd;
+      if( (fWrite && (0 != ulGap)) ||
+          (ulGap > SERDPM_READV_MAX_GAP) ||
+          ((ulSegments + ((0 != ulGap)? 2 : 1)) > OS_SPI_MAX_SEGMENTS) )
+        break;
+
+      if(0 != ulGap)
+      {
+        /* Clock in and discard the bytes in between */
+        atFrame[ulSegments].pbSend = NULL;
+        atFrame[ulSegments].pbRecv = NULL;
+        atFrame[ulSegments].ulLen  = ulGap;
+        ++ulSegments;
+      }
+
+      atFrame[ulSegments].pbSend = fWrite ? (uint8_t*)ptEntry->pvData : NULL;
+      atFrame[ulSegments].pbRecv = fWrite ? NULL : (uint8_t*)ptEntry->pvData;
+      atFrame[ulSegments].ulLen  = ptEntry->ulLen;
+      ++ulSegments;
+
+      ulEnd = ulAddr + ptEntry->ulLen;
+      ++ulIdx;
+    }
+
+    atFrame[0].pbSend = abHeader;
+    atFrame[0].pbRecv = NULL;
+    atFrame[0].ulLen  = pfnHeader(abHeader, ulStart, ulEnd - ulStart, fWrite);
+
+    OS_SpiTransferFrame(ptDevice->pvOSDependent, atFrame, ulSegments);
+    CIFX_STATS_HWIF_FRAME(ptDevice, ulEnd - ulStart);
+  }
+  OS_SpiUnlock(ptDevice->pvOSDependent);
+}
+
+/*****************************************************************************/
+/*! Vectored read from SPI interface (netX10 Slave)
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and destination buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void ReadV_NX10( void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  TransferV((DEVICEINSTANCE*)pvDevInstance, ptIoVec, ulCount, Header_NX10, 0);
+}
+
+/*****************************************************************************/
+/*! Vectored write to SPI interface (netX10 Slave)
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and source buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void WriteV_NX10( void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  TransferV((DEVICEINSTANCE*)pvDevInstance, ptIoVec, ulCount, Header_NX10, 1);
+}
+
+/*****************************************************************************/
+/*! Vectored read from SPI interface (netX51 Slave)
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and destination buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void ReadV_NX51( void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  TransferV((DEVICEINSTANCE*)pvDevInstance, ptIoVec, ulCount, Header_NX51, 0);
+}
+
+/*****************************************************************************/
+/*! Vectored write to SPI interface (netX51 Slave)
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and source buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void WriteV_NX51( void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  TransferV((DEVICEINSTANCE*)pvDevInstance, ptIoVec, ulCount, Header_NX51, 1);
+}
+
+/*****************************************************************************/
+/*! Bus cost of a write (netX10/netX51 Slave), one frame of the 3 byte
+*   command header and the data
+*   \param pvDevInstance  Device Instance
+*   \param pvAddr         Address offset in DPM to write data to
+*   \param ulLen          Number of bytes to write
+*   \param ptCost         Cost the write is added to                        */
+/*****************************************************************************/
+static void WriteCost_NX10( void* pvDevInstance, void* pvAddr, uint32_t ulLen, HWIF_COST_T* ptCost)
+{
+  (void)pvDevInstance;
+  (void)pvAddr;
+
+  ptCost->ulBytes  += 3 + ulLen;
+  ptCost->ulFrames += 1;
+}
+
+/*****************************************************************************/
+/*! Bus cost of a write (netX50 Slave), a frame per MAX_TRANSFER_LEN bytes
+*   \param pvDevInstance  Device Instance
+*   \param pvAddr         Address offset in DPM to write data to
+*   \param ulLen          Number of bytes to write
+*   \param ptCost         Cost the write is added to                        */
+/*****************************************************************************/
+static void WriteCost_NX50( void* pvDevInstance, void* pvAddr, uint32_t ulLen, HWIF_COST_T* ptCost)
+{
+  uint32_t ulChunks = (ulLen + MAX_TRANSFER_LEN - 1) / MAX_TRANSFER_LEN;
+
+  (void)pvDevInstance;
+  (void)pvAddr;
+
+  ptCost->ulBytes  += 3 * ulChunks + ulLen;
+  ptCost->ulFrames += ulChunks;
+}
+
+/*****************************************************************************/
+/*! Bus cost of a write (netX500 Slave), see ReadModifyWrite_NX500. An
+*   unaligned start or end costs a 4 byte read and a 4 byte write each
+*   \param pvDevInstance  Device Instance
+*   \param pvAddr         Address offset in DPM to write data to
+*   \param ulLen          Number of bytes to write
+*   \param ptCost         Cost the write is added to                        */
+/*****************************************************************************/
+static void WriteCost_NX500( void* pvDevInstance, void* pvAddr, uint32_t ulLen, HWIF_COST_T* ptCost)
+{
+  uint32_t ulDpmAddr  = (uint32_t)pvAddr;
+  uint32_t ulPartials = 0;
+
+  if (ulDpmAddr&0x3)
+  {
+    ulLen -= MIN(ulLen, (4 - (ulDpmAddr&0x3)));
+    ++ulPartials;
+  }
+
+  if (ulLen&~0x3)
+    WriteCost_NX50(pvDevInstance, pvAddr, ulLen&~0x3, ptCost);
+
+  if (ulLen&0x3)
+    ++ulPartials;
+
+  ptCost->ulBytes  += ulPartials * ((3 + SERDPM_READ_WAIT_BYTES + 4) + (3 + 4));
+  ptCost->ulFrames += ulPartials * 2;
+}
+
 /*****************************************************************************/
 /*! Initialize serial DPM interface
 *   \param ptDevice  Device Instance
@@ -399,9 +667,9 @@ int SerialDPM_Init(DEVICEINSTANCE* ptDevice)
     do
     {
       /* Execute the SPI chip detection */
-      OS_SpiAssert(ptDevice);
-      OS_SpiTransfer(ptDevice, abSend, (unsigned char*)&ulDetect, MAX_CNT(abSend));
-      OS_SpiDeassert(ptDevice);
+      OS_SpiAssert(ptDevice->pvOSDependent);
+      OS_SpiTransfer(ptDevice->pvOSDependent, abSend, (unsigned char*)&ulDetect, MAX_CNT(abSend));
+      OS_SpiDeassert(ptDevice->pvOSDependent);
 
       if (0 == ulDetect)
       {
@@ -431,15 +699,29 @@ int SerialDPM_Init(DEVICEINSTANCE* ptDevice)
       case SERDPM_NETX100:
         ptDevice->pfnHwIfRead  = Read_NX500;
         ptDevice->pfnHwIfWrite = ReadModifyWrite_NX500;
+        ptDevice->pfnHwIfReadV  = NULL;
+        ptDevice->pfnHwIfWriteV = NULL;
+        ptDevice->pfnHwIfWriteCost = WriteCost_NX500;
+        /* Write frame as netX50, plus a 4 byte read and write for each unaligned end */
+        ptDevice->ulHwIfWriteMergeGap = (3 + 2 * SERDPM_FRAME_OVERHEAD) + 2 * (2 * (3 + 4) + 4 * SERDPM_FRAME_OVERHEAD);
         break;
 
       case SERDPM_NETX50:
         ptDevice->pfnHwIfRead  = Read_NX50;
         ptDevice->pfnHwIfWrite = Write_NX50;
+        ptDevice->pfnHwIfReadV  = NULL;
+        ptDevice->pfnHwIfWriteV = NULL;
+        ptDevice->pfnHwIfWriteCost = WriteCost_NX50;
+        /* 3 byte header, sent in a transfer of its own */
+        ptDevice->ulHwIfWriteMergeGap = 3 + 2 * SERDPM_FRAME_OVERHEAD;
         break;
       case SERDPM_NETX10:
         ptDevice->pfnHwIfRead  = Read_NX10;
         ptDevice->pfnHwIfWrite = Write_NX10;
+        ptDevice->pfnHwIfReadV  = ReadV_NX10;
+        ptDevice->pfnHwIfWriteV = WriteV_NX10;
+        ptDevice->pfnHwIfWriteCost = WriteCost_NX10;
+        ptDevice->ulHwIfWriteMergeGap = 3 + SERDPM_FRAME_OVERHEAD;
         /* Initialize SPI unit of slave by making 2 dummy reads */
         (void) Read_NX10(ptDevice, 0, &bUnused, 1);
         (void) Read_NX10(ptDevice, 0, &bUnused, 1);
@@ -447,6 +729,10 @@ int SerialDPM_Init(DEVICEINSTANCE* ptDevice)
       case SERDPM_NETX51:
         ptDevice->pfnHwIfRead  = Read_NX51;
         ptDevice->pfnHwIfWrite = Write_NX51;
+        ptDevice->pfnHwIfReadV  = ReadV_NX51;
+        ptDevice->pfnHwIfWriteV = WriteV_NX51;
+        ptDevice->pfnHwIfWriteCost = WriteCost_NX10;
+        ptDevice->ulHwIfWriteMergeGap = 3 + SERDPM_FRAME_OVERHEAD;
         /* Initialize SPI unit of slave by making 2 dummy reads */
         (void) Read_NX51(ptDevice, 0, &bUnused, 1);
         (void) Read_NX51(ptDevice, 0, &bUnused, 1);
@@ -35,6 +35,11 @@ extern "C"
 #define SERDPM_NETX51   0x03
 #define SERDPM_NETX100  0x04
 
+/* Maximum number of unused bytes clocked in to join two read ranges into one burst */
+#ifndef SERDPM_READV_MAX_GAP
+  #define SERDPM_READV_MAX_GAP 32
+#endif
+
 int SerialDPM_Init ( DEVICEINSTANCE* ptDevice);
 
 #ifdef __cplusplus
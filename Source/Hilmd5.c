@@ -1,5 +1,9 @@
 /*-------------------------------------------------------------------------
 * 20.04.2007 RM - Changed int to long for compiler / machine independency
+* 17.10.2026 GB - Consecutive blocks processed with the state in registers,
+*                 message words loaded with memcpy instead of md5_memcpy,
+*                 byte order taken from the compiler if available, round
+*                 additions reordered to shorten the dependency chain
 --------------------------------------------------------------------------*/
 /*
   Copyright (C) 1999, 2000, 2002 Aladdin Enterprises.  All rights reserved.
@@ -55,27 +59,19 @@
  */
 
 #include "Hilmd5.h"
+#include <string.h>
 
 #undef BYTE_ORDER /* 1 = big-endian, -1 = little-endian, 0 = unknown */
 #ifdef ARCH_IS_BIG_ENDIAN
 #  define BYTE_ORDER (ARCH_IS_BIG_ENDIAN ? 1 : -1)
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define BYTE_ORDER -1
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#  define BYTE_ORDER 1
 #else
 #  define BYTE_ORDER 0
 #endif
 
-static void* md5_memcpy(void* pvDest, const void* pvSrc, long iSize)
-{
-  char* pcDest=(char*)pvDest;
-  const char* pcSrc=(const char*)pvSrc;
-  while(iSize-->0)
-  {
-    *(pcDest++)=*(pcSrc)++;
-  }
-  return pvDest;
-}
-
-
-
 #define T_MASK ((md5_word_t)~0)
 #define T1 /* 0xd76aa478 */ (T_MASK ^ 0x28955b87)
 #define T2 /* 0xe8c7b756 */ (T_MASK ^ 0x173848a9)
@@ -144,22 +140,16 @@ static void* md5_memcpy(void* pvDest, const void* pvSrc, long iSize)
 
 
 static void
-md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
+md5_process(md5_state_t *pms, const md5_byte_t *data /*[64 * blocks]*/, long blocks)
 {
     md5_word_t
   a = pms->abcd[0], b = pms->abcd[1],
   c = pms->abcd[2], d = pms->abcd[3];
+    md5_word_t aa, bb, cc, dd;
     md5_word_t t;
-#if BYTE_ORDER > 0
-    /* Define storage only for big-endian CPUs. */
     md5_word_t X[16];
-#else
-    /* Define storage for little-endian or both types of CPUs. */
-    md5_word_t xbuf[16];
-    const md5_word_t *X;
-#endif
 
-  {
+  for (; blocks > 0; --blocks, data += 64) {
 #if BYTE_ORDER == 0
   /*
    * Determine dynamically whether this is a big-endian or
@@ -173,17 +163,11 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
 #if BYTE_ORDER <= 0   /* little-endian */
   {
       /*
-       * On little-endian machines, we can process properly aligned
-       * data without copying it.
+       * On little-endian machines the words are in memory order, memcpy
+       * is a plain load (also for unaligned data) with any optimizing
+       * compiler.
        */
-      if (!((data - /*lint -e413*/ (const md5_byte_t *)0) & 3)) {
-        /* data are properly aligned */
-        X = (const md5_word_t *)data;
-      } else {
-        /* not aligned */
-        (void)md5_memcpy(xbuf, data, 64);
-        X = xbuf;
-      }
+      memcpy(X, data, sizeof(X));
   }
 #endif
 #if BYTE_ORDER == 0
@@ -198,25 +182,21 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
       const md5_byte_t *xp = data;
       long i;
 
-#  if BYTE_ORDER == 0
-      X = xbuf;   /* (dynamic only) */
-#  else
-#    define xbuf X    /* (static only) */
-#  endif
       for (i = 0; i < 16; ++i, xp += 4)
-        xbuf[i] = xp[0] + (xp[1] << 8) + (xp[2] << 16) + (xp[3] << 24);
+        X[i] = xp[0] + (xp[1] << 8) + (xp[2] << 16) + ((md5_word_t)xp[3] << 24);
   }
 #endif
-  }
+
+    aa = a; bb = b; cc = c; dd = d;
 
 #define ROTATE_LEFT(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 
     /* Round 1. */
     /* Let [abcd k s i] denote the operation
        a = b + ((a + F(b,c,d) + X[k] + T[i]) <<< s). */
-#define F(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z)))) /* (x & y) | (~x & z) */
 #define SET(a, b, c, d, k, s, Ti)\
-  t = a + F(b,c,d) + X[k] + Ti;\
+  t = a + X[k] + Ti + F(b,c,d);\
   a = ROTATE_LEFT(t, s) + b
     /* Do the following 16 operations. */
     SET(a, b, c, d,  0,  7,  T1);
@@ -241,8 +221,10 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
      /* Let [abcd k s i] denote the operation
           a = b + ((a + G(b,c,d) + X[k] + T[i]) <<< s). */
 #define G(x, y, z) (((x) & (z)) | ((y) & ~(z)))
+    /* the terms of G never have a bit set in common, adding them lets the
+       second term be computed before b is known */
 #define SET(a, b, c, d, k, s, Ti)\
-  t = a + G(b,c,d) + X[k] + Ti;\
+  t = a + X[k] + Ti + ((c) & ~(d)) + ((b) & (d));\
   a = ROTATE_LEFT(t, s) + b
      /* Do the following 16 operations. */
     SET(a, b, c, d,  1,  5, T17);
@@ -268,7 +250,7 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
           a = b + ((a + H(b,c,d) + X[k] + T[i]) <<< s). */
 #define H(x, y, z) ((x) ^ (y) ^ (z))
 #define SET(a, b, c, d, k, s, Ti)\
-  t = a + H(b,c,d) + X[k] + Ti;\
+  t = a + X[k] + Ti + H(b,c,d);\
   a = ROTATE_LEFT(t, s) + b
      /* Do the following 16 operations. */
     SET(a, b, c, d,  5,  4, T33);
@@ -294,7 +276,7 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
           a = b + ((a + I(b,c,d) + X[k] + T[i]) <<< s). */
 #define I(x, y, z) ((y) ^ ((x) | ~(z)))
 #define SET(a, b, c, d, k, s, Ti)\
-  t = a + I(b,c,d) + X[k] + Ti;\
+  t = a + X[k] + Ti + I(b,c,d);\
   a = ROTATE_LEFT(t, s) + b
      /* Do the following 16 operations. */
     SET(a, b, c, d,  0,  6, T49);
@@ -318,10 +300,16 @@ md5_process(md5_state_t *pms, const md5_byte_t *data /*[64]*/)
      /* Then perform the following additions. (That is increment each
         of the four registers by the value it had before this block
         was started.) */
-    pms->abcd[0] += a;
-    pms->abcd[1] += b;
-    pms->abcd[2] += c;
-    pms->abcd[3] += d;
+    a += aa;
+    b += bb;
+    c += cc;
+    d += dd;
+  }
+
+    pms->abcd[0] = a;
+    pms->abcd[1] = b;
+    pms->abcd[2] = c;
+    pms->abcd[3] = d;
 }
 
 void
@@ -355,21 +343,24 @@ md5_append(md5_state_t *pms, const md5_byte_t *data, long nbytes)
     if (offset) {
       long copy = (offset + nbytes > 64 ? 64 - offset : nbytes);
 
-      (void)md5_memcpy(pms->buf + offset, p, copy);
+      memcpy(pms->buf + offset, p, (size_t)copy);
       if (offset + copy < 64)
           return;
       p += copy;
       left -= copy;
-      md5_process(pms, pms->buf);
+      md5_process(pms, pms->buf, 1);
     }
 
     /* Process full blocks. */
-    for (; left >= 64; p += 64, left -= 64)
-      md5_process(pms, p);
+    if (left >= 64) {
+      md5_process(pms, p, left >> 6);
+      p += left & ~63L;
+      left &= 63;
+    }
 
     /* Process a final partial block. */
     if (left)
-      (void)md5_memcpy(pms->buf, p, left);
+      memcpy(pms->buf, p, (size_t)left);
 }
 
 void
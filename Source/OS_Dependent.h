@@ -58,15 +58,38 @@ void     OS_Memmove(void* pvDest, void* pvSrc, uint32_t ulSize);
 
 void*    OS_ReadPCIConfig(void* pvOSDependent);
 void     OS_WritePCIConfig(void* pvOSDependent, void* pvPCIConfig);
-void     OS_EnableInterrupts(void* pvOSDependent);
+int32_t  OS_EnableInterrupts(void* pvOSDependent);
 void     OS_DisableInterrupts(void* pvOSDependent);
 
 void*    OS_FileOpen(char* szFilename, uint32_t* pulFileSize);
 uint32_t OS_FileRead(void* pvFile, uint32_t ulOffset, uint32_t ulSize, void* pvBuffer);
 void     OS_FileClose(void* pvFile);
+#ifdef CIFX_TOOLKIT_FILE_MAP
+void*    OS_FileMap(void* pvFile, uint32_t ulSize);
+void     OS_FileUnmap(void* pvData, uint32_t ulSize);
+#endif
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+/* Identity of an open file, changes whenever the file content may have changed */
+typedef struct OS_FILE_ID_Ttag
+{
+  uint64_t ullSize;
+  uint64_t ullMTimeNs;
+  uint64_t ullInode;
+  uint64_t ullDevice;
+} OS_FILE_ID_T;
+
+int32_t  OS_FileGetId(void* pvFile, OS_FILE_ID_T* ptId);
+int32_t  OS_FileSave(char* szFilename, void* pvData, uint32_t ulSize);
+#endif
 
 uint32_t OS_GetMilliSecCounter(void);
+#if defined(CIFX_TOOLKIT_STATS) || defined(CIFX_TOOLKIT_WAIT_POLICY)
+uint64_t OS_GetNanoSecCounter(void);
+#endif
 void     OS_Sleep(uint32_t ulSleepTimeMs);
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+void     OS_SleepUntilNs(uint64_t ullWakeTimeNs);
+#endif
 
 void*    OS_CreateLock(void);
 void     OS_EnterLock(void* pvLock);
@@ -84,6 +107,13 @@ void     OS_ResetEvent(void* pvEvent);
 void     OS_DeleteEvent(void* pvEvent);
 uint32_t OS_WaitEvent(void* pvEvent, uint32_t ulTimeout);
 
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+typedef void (*PFN_OS_THREAD)(void* pvArg);
+
+void*    OS_CreateThread(PFN_OS_THREAD pfnThread, void* pvArg);
+void     OS_DeleteThread(void* pvThread);
+#endif
+
 int      OS_Strcmp(const char* pszBuf1, const char* pszBuf2);
 int      OS_Strnicmp(const char* pszBuf1, const char* pszBuf2, uint32_t ulLen);
 int      OS_Strlen(const char* szText);
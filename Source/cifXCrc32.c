@@ -0,0 +1,447 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXCrc32.c
+ * @brief          :  CRC32 of the file transfers with runtime selected implementation
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXCrc32.c
+*    CRC-32 implementations of the file transfers. The selection is done
+*    once, cifXTKitInit() calls cifXCrc32Init() before any thread can run a
+*    download.                                                               */
+/*****************************************************************************/
+
+#include <string.h>
+#include "cifXCrc32.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define CIFX_CRC32_PCLMUL
+  #include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__aarch64__) || defined(__ARM_FEATURE_CRC32))
+  #define CIFX_CRC32_ARMV8
+  #if defined(__aarch64__) && !defined(__ARM_FEATURE_CRC32) && !defined(__clang__)
+    /* the intrinsics are only declared with the CRC extension enabled */
+    #pragma GCC push_options
+    #pragma GCC target("+crc")
+    #include <arm_acle.h>
+    #pragma GCC pop_options
+  #else
+    #include <arm_acle.h>
+  #endif
+  #if defined(__ARM_FEATURE_CRC32)
+    #define CIFX_CRC32_TARGET_ARMV8
+  #elif defined(__clang__)
+    #define CIFX_CRC32_TARGET_ARMV8 __attribute__((target("crc")))
+  #else
+    #define CIFX_CRC32_TARGET_ARMV8 __attribute__((target("+crc")))
+  #endif
+  #ifdef __linux__
+    #include <sys/auxv.h>
+    #ifndef HWCAP_CRC32
+      #define HWCAP_CRC32   (1 << 7)  /* AArch64 AT_HWCAP */
+    #endif
+    #ifndef HWCAP2_CRC32
+      #define HWCAP2_CRC32  (1 << 4)  /* ARM AT_HWCAP2     */
+    #endif
+  #endif
+#endif
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Byte wise CRC32 table (polynomial 0xEDB88320)                            */
+/*****************************************************************************/
+static const uint32_t s_aulCrc32Table[256] =
+{
+  0x00000000UL, 0x77073096UL, 0xee0e612cUL, 0x990951baUL, 0x076dc419UL,
+  0x706af48fUL, 0xe963a535UL, 0x9e6495a3UL, 0x0edb8832UL, 0x79dcb8a4UL,
+  0xe0d5e91eUL, 0x97d2d988UL, 0x09b64c2bUL, 0x7eb17cbdUL, 0xe7b82d07UL,
+  0x90bf1d91UL, 0x1db71064UL, 0x6ab020f2UL, 0xf3b97148UL, 0x84be41deUL,
+  0x1adad47dUL, 0x6ddde4ebUL, 0xf4d4b551UL, 0x83d385c7UL, 0x136c9856UL,
+  0x646ba8c0UL, 0xfd62f97aUL, 0x8a65c9ecUL, 0x14015c4fUL, 0x63066cd9UL,
+  0xfa0f3d63UL, 0x8d080df5UL, 0x3b6e20c8UL, 0x4c69105eUL, 0xd56041e4UL,
+  0xa2677172UL, 0x3c03e4d1UL, 0x4b04d447UL, 0xd20d85fdUL, 0xa50ab56bUL,
+  0x35b5a8faUL, 0x42b2986cUL, 0xdbbbc9d6UL, 0xacbcf940UL, 0x32d86ce3UL,
+  0x45df5c75UL, 0xdcd60dcfUL, 0xabd13d59UL, 0x26d930acUL, 0x51de003aUL,
+  0xc8d75180UL, 0xbfd06116UL, 0x21b4f4b5UL, 0x56b3c423UL, 0xcfba9599UL,
+  0xb8bda50fUL, 0x2802b89eUL, 0x5f058808UL, 0xc60cd9b2UL, 0xb10be924UL,
+  0x2f6f7c87UL, 0x58684c11UL, 0xc1611dabUL, 0xb6662d3dUL, 0x76dc4190UL,
+  0x01db7106UL, 0x98d220bcUL, 0xefd5102aUL, 0x71b18589UL, 0x06b6b51fUL,
+  0x9fbfe4a5UL, 0xe8b8d433UL, 0x7807c9a2UL, 0x0f00f934UL, 0x9609a88eUL,
+  0xe10e9818UL, 0x7f6a0dbbUL, 0x086d3d2dUL, 0x91646c97UL, 0xe6635c01UL,
+  0x6b6b51f4UL, 0x1c6c6162UL, 0x856530d8UL, 0xf262004eUL, 0x6c0695edUL,
+  0x1b01a57bUL, 0x8208f4c1UL, 0xf50fc457UL, 0x65b0d9c6UL, 0x12b7e950UL,
+  0x8bbeb8eaUL, 0xfcb9887cUL, 0x62dd1ddfUL, 0x15da2d49UL, 0x8cd37cf3UL,
+  0xfbd44c65UL, 0x4db26158UL, 0x3ab551ceUL, 0xa3bc0074UL, 0xd4bb30e2UL,
+  0x4adfa541UL, 0x3dd895d7UL, 0xa4d1c46dUL, 0xd3d6f4fbUL, 0x4369e96aUL,
+  0x346ed9fcUL, 0xad678846UL, 0xda60b8d0UL, 0x44042d73UL, 0x33031de5UL,
+  0xaa0a4c5fUL, 0xdd0d7cc9UL, 0x5005713cUL, 0x270241aaUL, 0xbe0b1010UL,
+  0xc90c2086UL, 0x5768b525UL, 0x206f85b3UL, 0xb966d409UL, 0xce61e49fUL,
+  0x5edef90eUL, 0x29d9c998UL, 0xb0d09822UL, 0xc7d7a8b4UL, 0x59b33d17UL,
+  0x2eb40d81UL, 0xb7bd5c3bUL, 0xc0ba6cadUL, 0xedb88320UL, 0x9abfb3b6UL,
+  0x03b6e20cUL, 0x74b1d29aUL, 0xead54739UL, 0x9dd277afUL, 0x04db2615UL,
+  0x73dc1683UL, 0xe3630b12UL, 0x94643b84UL, 0x0d6d6a3eUL, 0x7a6a5aa8UL,
+  0xe40ecf0bUL, 0x9309ff9dUL, 0x0a00ae27UL, 0x7d079eb1UL, 0xf00f9344UL,
+  0x8708a3d2UL, 0x1e01f268UL, 0x6906c2feUL, 0xf762575dUL, 0x806567cbUL,
+  0x196c3671UL, 0x6e6b06e7UL, 0xfed41b76UL, 0x89d32be0UL, 0x10da7a5aUL,
+  0x67dd4accUL, 0xf9b9df6fUL, 0x8ebeeff9UL, 0x17b7be43UL, 0x60b08ed5UL,
+  0xd6d6a3e8UL, 0xa1d1937eUL, 0x38d8c2c4UL, 0x4fdff252UL, 0xd1bb67f1UL,
+  0xa6bc5767UL, 0x3fb506ddUL, 0x48b2364bUL, 0xd80d2bdaUL, 0xaf0a1b4cUL,
+  0x36034af6UL, 0x41047a60UL, 0xdf60efc3UL, 0xa867df55UL, 0x316e8eefUL,
+  0x4669be79UL, 0xcb61b38cUL, 0xbc66831aUL, 0x256fd2a0UL, 0x5268e236UL,
+  0xcc0c7795UL, 0xbb0b4703UL, 0x220216b9UL, 0x5505262fUL, 0xc5ba3bbeUL,
+  0xb2bd0b28UL, 0x2bb45a92UL, 0x5cb36a04UL, 0xc2d7ffa7UL, 0xb5d0cf31UL,
+  0x2cd99e8bUL, 0x5bdeae1dUL, 0x9b64c2b0UL, 0xec63f226UL, 0x756aa39cUL,
+  0x026d930aUL, 0x9c0906a9UL, 0xeb0e363fUL, 0x72076785UL, 0x05005713UL,
+  0x95bf4a82UL, 0xe2b87a14UL, 0x7bb12baeUL, 0x0cb61b38UL, 0x92d28e9bUL,
+  0xe5d5be0dUL, 0x7cdcefb7UL, 0x0bdbdf21UL, 0x86d3d2d4UL, 0xf1d4e242UL,
+  0x68ddb3f8UL, 0x1fda836eUL, 0x81be16cdUL, 0xf6b9265bUL, 0x6fb077e1UL,
+  0x18b74777UL, 0x88085ae6UL, 0xff0f6a70UL, 0x66063bcaUL, 0x11010b5cUL,
+  0x8f659effUL, 0xf862ae69UL, 0x616bffd3UL, 0x166ccf45UL, 0xa00ae278UL,
+  0xd70dd2eeUL, 0x4e048354UL, 0x3903b3c2UL, 0xa7672661UL, 0xd06016f7UL,
+  0x4969474dUL, 0x3e6e77dbUL, 0xaed16a4aUL, 0xd9d65adcUL, 0x40df0b66UL,
+  0x37d83bf0UL, 0xa9bcae53UL, 0xdebb9ec5UL, 0x47b2cf7fUL, 0x30b5ffe9UL,
+  0xbdbdf21cUL, 0xcabac28aUL, 0x53b39330UL, 0x24b4a3a6UL, 0xbad03605UL,
+  0xcdd70693UL, 0x54de5729UL, 0x23d967bfUL, 0xb3667a2eUL, 0xc4614ab8UL,
+  0x5d681b02UL, 0x2a6f2b94UL, 0xb40bbe37UL, 0xc30c8ea1UL, 0x5a05df1bUL,
+  0x2d02ef8d
+};
+
+/*****************************************************************************/
+/*! Slicing-by-8 tables, s_aaulCrc32Slice[0] is s_aulCrc32Table              */
+/*****************************************************************************/
+static uint32_t s_aaulCrc32Slice[8][256];
+
+/*****************************************************************************/
+/*! Number of implementations usable on this CPU, 0 = not initialized        */
+/*****************************************************************************/
+static volatile uint32_t s_ulCrc32Impls = 0;
+
+/*****************************************************************************/
+/*! Byte wise table implementation, reference for all others
+*   \param ulState    Inverted CRC register
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return Updated inverted CRC register                                    */
+/*****************************************************************************/
+static uint32_t Crc32UpdateTable(uint32_t ulState, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  while(ulLength-- > 0)
+    ulState = s_aulCrc32Table[(ulState ^ *pabBuffer++) & 0xFF] ^ (ulState >> 8);
+
+  return ulState;
+} /** Crc32UpdateTable */
+
+/*****************************************************************************/
+/*! Slicing-by-8 implementation, 8 bytes per step with 8 table lookups. The
+*   words are assembled byte wise, so it is independent of the endianess and
+*   the alignment of the buffer.
+*   \param ulState    Inverted CRC register
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return Updated inverted CRC register                                    */
+/*****************************************************************************/
+static uint32_t Crc32UpdateSlice8(uint32_t ulState, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  while(ulLength >= 8)
+  {
+    uint32_t ulLow  = ulState ^ ( (uint32_t)pabBuffer[0]        | ((uint32_t)pabBuffer[1] << 8) |
+                                 ((uint32_t)pabBuffer[2] << 16) | ((uint32_t)pabBuffer[3] << 24) );
+    uint32_t ulHigh =             (uint32_t)pabBuffer[4]        | ((uint32_t)pabBuffer[5] << 8) |
+                                 ((uint32_t)pabBuffer[6] << 16) | ((uint32_t)pabBuffer[7] << 24);
+
+    ulState = s_aaulCrc32Slice[7][ulLow         & 0xFF] ^ s_aaulCrc32Slice[6][(ulLow  >> 8)  & 0xFF] ^
+              s_aaulCrc32Slice[5][(ulLow >> 16) & 0xFF] ^ s_aaulCrc32Slice[4][ ulLow  >> 24        ] ^
+              s_aaulCrc32Slice[3][ulHigh        & 0xFF] ^ s_aaulCrc32Slice[2][(ulHigh >> 8)  & 0xFF] ^
+              s_aaulCrc32Slice[1][(ulHigh >> 16)& 0xFF] ^ s_aaulCrc32Slice[0][ ulHigh >> 24        ];
+
+    pabBuffer += 8;
+    ulLength  -= 8;
+  }
+
+  return Crc32UpdateTable(ulState, pabBuffer, ulLength);
+} /** Crc32UpdateSlice8 */
+
+#ifdef CIFX_CRC32_PCLMUL
+/*****************************************************************************/
+/*! Carry-less multiply implementation (folding by 4 x 128 bit, Barrett
+*   reduction, see Intel "Fast CRC Computation for Generic Polynomials Using
+*   PCLMULQDQ Instruction"). Handles multiples of 16 bytes from 64 bytes on,
+*   the rest is done with slicing-by-8.
+*   \param ulState    Inverted CRC register
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return Updated inverted CRC register                                    */
+/*****************************************************************************/
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t Crc32UpdatePclmul(uint32_t ulState, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  const __m128i tK1K2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+  const __m128i tK3K4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+  const __m128i tK5   = _mm_set_epi64x(0,              0x0163cd6124LL);
+  const __m128i tPoly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+  const __m128i tMask = _mm_setr_epi32(-1, 0, -1, 0);
+  __m128i       tX1, tX2, tX3, tX4, tX5, tX6, tX7, tX8;
+  uint32_t      ulBlocks;
+
+  if(ulLength < 64)
+    return Crc32UpdateSlice8(ulState, pabBuffer, ulLength);
+
+  ulBlocks = ulLength & ~15UL;
+
+  tX1 = _mm_loadu_si128((const __m128i*)(pabBuffer + 0x00));
+  tX2 = _mm_loadu_si128((const __m128i*)(pabBuffer + 0x10));
+  tX3 = _mm_loadu_si128((const __m128i*)(pabBuffer + 0x20));
+  tX4 = _mm_loadu_si128((const __m128i*)(pabBuffer + 0x30));
+  tX1 = _mm_xor_si128(tX1, _mm_cvtsi32_si128((int)ulState));
+
+  pabBuffer += 64;
+  ulBlocks  -= 64;
+
+  /* fold 4 x 128 bit in parallel */
+  while(ulBlocks >= 64)
+  {
+    tX5 = _mm_clmulepi64_si128(tX1, tK1K2, 0x00);
+    tX6 = _mm_clmulepi64_si128(tX2, tK1K2, 0x00);
+    tX7 = _mm_clmulepi64_si128(tX3, tK1K2, 0x00);
+    tX8 = _mm_clmulepi64_si128(tX4, tK1K2, 0x00);
+
+    tX1 = _mm_clmulepi64_si128(tX1, tK1K2, 0x11);
+    tX2 = _mm_clmulepi64_si128(tX2, tK1K2, 0x11);
+    tX3 = _mm_clmulepi64_si128(tX3, tK1K2, 0x11);
+    tX4 = _mm_clmulepi64_si128(tX4, tK1K2, 0x11);
+
+    tX1 = _mm_xor_si128(_mm_xor_si128(tX1, tX5), _mm_loadu_si128((const __m128i*)(pabBuffer + 0x00)));
+    tX2 = _mm_xor_si128(_mm_xor_si128(tX2, tX6), _mm_loadu_si128((const __m128i*)(pabBuffer + 0x10)));
+    tX3 = _mm_xor_si128(_mm_xor_si128(tX3, tX7), _mm_loadu_si128((const __m128i*)(pabBuffer + 0x20)));
+    tX4 = _mm_xor_si128(_mm_xor_si128(tX4, tX8), _mm_loadu_si128((const __m128i*)(pabBuffer + 0x30)));
+
+    pabBuffer += 64;
+    ulBlocks  -= 64;
+  }
+
+  /* fold into 128 bit */
+  tX5 = _mm_clmulepi64_si128(tX1, tK3K4, 0x00);
+  tX1 = _mm_clmulepi64_si128(tX1, tK3K4, 0x11);
+  tX1 = _mm_xor_si128(_mm_xor_si128(tX1, tX2), tX5);
+
+  tX5 = _mm_clmulepi64_si128(tX1, tK3K4, 0x00);
+  tX1 = _mm_clmulepi64_si128(tX1, tK3K4, 0x11);
+  tX1 = _mm_xor_si128(_mm_xor_si128(tX1, tX3), tX5);
+
+  tX5 = _mm_clmulepi64_si128(tX1, tK3K4, 0x00);
+  tX1 = _mm_clmulepi64_si128(tX1, tK3K4, 0x11);
+  tX1 = _mm_xor_si128(_mm_xor_si128(tX1, tX4), tX5);
+
+  /* single 128 bit blocks left */
+  while(ulBlocks >= 16)
+  {
+    tX2 = _mm_loadu_si128((const __m128i*)pabBuffer);
+
+    tX5 = _mm_clmulepi64_si128(tX1, tK3K4, 0x00);
+    tX1 = _mm_clmulepi64_si128(tX1, tK3K4, 0x11);
+    tX1 = _mm_xor_si128(_mm_xor_si128(tX1, tX2), tX5);
+
+    pabBuffer += 16;
+    ulBlocks  -= 16;
+  }
+
+  /* fold 128 to 64 bit */
+  tX2 = _mm_clmulepi64_si128(tX1, tK3K4, 0x10);
+  tX3 = _mm_srli_si128(tX1, 8);
+  tX1 = _mm_xor_si128(tX2, tX3);
+
+  /* fold 64 to 32 bit */
+  tX2 = _mm_srli_si128(tX1, 4);
+  tX1 = _mm_and_si128(tX1, tMask);
+  tX1 = _mm_clmulepi64_si128(tX1, tK5, 0x00);
+  tX1 = _mm_xor_si128(tX1, tX2);
+
+  /* Barrett reduction */
+  tX2 = _mm_and_si128(tX1, tMask);
+  tX2 = _mm_clmulepi64_si128(tX2, tPoly, 0x10);
+  tX2 = _mm_and_si128(tX2, tMask);
+  tX2 = _mm_clmulepi64_si128(tX2, tPoly, 0x00);
+  tX1 = _mm_xor_si128(tX1, tX2);
+
+  ulState = (uint32_t)_mm_extract_epi32(tX1, 1);
+
+  return Crc32UpdateSlice8(ulState, pabBuffer, ulLength & 15);
+} /** Crc32UpdatePclmul */
+#endif /* CIFX_CRC32_PCLMUL */
+
+#ifdef CIFX_CRC32_ARMV8
+/*****************************************************************************/
+/*! ARMv8 CRC32 instruction implementation
+*   \param ulState    Inverted CRC register
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return Updated inverted CRC register                                    */
+/*****************************************************************************/
+CIFX_CRC32_TARGET_ARMV8
+static uint32_t Crc32UpdateArmv8(uint32_t ulState, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  while( (ulLength > 0) && (((uintptr_t)pabBuffer & 7) != 0) )
+  {
+    ulState = __crc32b(ulState, *pabBuffer++);
+    --ulLength;
+  }
+
+#ifdef __aarch64__
+  while(ulLength >= 8)
+  {
+    uint64_t ullData;
+
+    memcpy(&ullData, pabBuffer, sizeof(ullData));
+    ulState = __crc32d(ulState, ullData);
+    pabBuffer += 8;
+    ulLength  -= 8;
+  }
+#endif
+
+  while(ulLength >= 4)
+  {
+    uint32_t ulData;
+
+    memcpy(&ulData, pabBuffer, sizeof(ulData));
+    ulState = __crc32w(ulState, ulData);
+    pabBuffer += 4;
+    ulLength  -= 4;
+  }
+
+  while(ulLength-- > 0)
+    ulState = __crc32b(ulState, *pabBuffer++);
+
+  return ulState;
+} /** Crc32UpdateArmv8 */
+#endif /* CIFX_CRC32_ARMV8 */
+
+/*****************************************************************************/
+/*! Implementations ordered by speed, the last one usable on the CPU is used */
+/*****************************************************************************/
+static const CIFX_CRC32_IMPL_T s_atCrc32Impls[] =
+{
+  { "table",  Crc32UpdateTable  },
+  { "slice8", Crc32UpdateSlice8 },
+#ifdef CIFX_CRC32_PCLMUL
+  { "pclmul", Crc32UpdatePclmul },
+#endif
+#ifdef CIFX_CRC32_ARMV8
+  { "armv8",  Crc32UpdateArmv8  },
+#endif
+};
+
+/*****************************************************************************/
+/*! Builds the slicing-by-8 tables and selects the implementation. Called by
+*   cifXTKitInit(), further calls have no effect.                            */
+/*****************************************************************************/
+void cifXCrc32Init(void)
+{
+  uint32_t ulImpls = 2;
+  int      iIdx;
+  int      iSlice;
+
+  if(0 != s_ulCrc32Impls)
+    return;
+
+  for(iIdx = 0; iIdx < 256; ++iIdx)
+  {
+    uint32_t ulCrc = s_aulCrc32Table[iIdx];
+
+    s_aaulCrc32Slice[0][iIdx] = ulCrc;
+    for(iSlice = 1; iSlice < 8; ++iSlice)
+    {
+      ulCrc = s_aulCrc32Table[ulCrc & 0xFF] ^ (ulCrc >> 8);
+      s_aaulCrc32Slice[iSlice][iIdx] = ulCrc;
+    }
+  }
+
+#ifdef CIFX_CRC32_PCLMUL
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+    ulImpls = 3;
+#endif
+
+#ifdef CIFX_CRC32_ARMV8
+  #if defined(__linux__) && defined(__aarch64__)
+    if(0 != (getauxval(AT_HWCAP) & HWCAP_CRC32))
+      ulImpls = 3;
+  #elif defined(__linux__)
+    if(0 != (getauxval(AT_HWCAP2) & HWCAP2_CRC32))
+      ulImpls = 3;
+  #elif defined(__ARM_FEATURE_CRC32)
+    ulImpls = 3;
+  #endif
+#endif
+
+  s_ulCrc32Impls = ulImpls;
+} /** cifXCrc32Init */
+
+/*****************************************************************************/
+/*! Calculates the CRC32 with the given implementation
+*   \param ptImpl     Implementation (see cifXCrc32GetImpls)
+*   \param ulCRC      CRC of the preceding data, 0 to start
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return CRC including the data, ulCRC if there is no data                */
+/*****************************************************************************/
+uint32_t cifXCrc32Impl(const CIFX_CRC32_IMPL_T* ptImpl, uint32_t ulCRC, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  if( (NULL == pabBuffer) || (0 == ulLength) )
+    return ulCRC;
+
+  return ptImpl->pfnUpdate(ulCRC ^ 0xFFFFFFFFUL, pabBuffer, ulLength) ^ 0xFFFFFFFFUL;
+} /** cifXCrc32Impl */
+
+/*****************************************************************************/
+/*! Calculates the CRC32 with the fastest implementation of the CPU
+*   \param ulCRC      CRC of the preceding data, 0 to start
+*   \param pabBuffer  Data
+*   \param ulLength   Length of the data
+*   \return CRC including the data, ulCRC if there is no data                */
+/*****************************************************************************/
+uint32_t cifXCrc32(uint32_t ulCRC, const uint8_t* pabBuffer, uint32_t ulLength)
+{
+  return cifXCrc32Impl(cifXCrc32GetActiveImpl(), ulCRC, pabBuffer, ulLength);
+} /** cifXCrc32 */
+
+/*****************************************************************************/
+/*! Returns the implementations usable on this CPU
+*   \param pptImpls  Returned array, [0] is the reference, the last entry the
+*                    active implementation
+*   \return Number of entries                                                */
+/*****************************************************************************/
+uint32_t cifXCrc32GetImpls(const CIFX_CRC32_IMPL_T** pptImpls)
+{
+  cifXCrc32Init();
+
+  *pptImpls = s_atCrc32Impls;
+  return s_ulCrc32Impls;
+} /** cifXCrc32GetImpls */
+
+/*****************************************************************************/
+/*! Returns the implementation used by cifXCrc32
+*   \return Active implementation                                            */
+/*****************************************************************************/
+const CIFX_CRC32_IMPL_T* cifXCrc32GetActiveImpl(void)
+{
+  cifXCrc32Init();
+
+  return &s_atCrc32Impls[s_ulCrc32Impls - 1];
+} /** cifXCrc32GetActiveImpl */
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXCrc32.h
+ * @brief          :  CRC32 of the file transfers with runtime selected implementation
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXCrc32.h
+*    CRC-32 (IEEE 802.3, reflected, init and final XOR 0xFFFFFFFF) of the
+*    file download and upload data. The fastest implementation the CPU
+*    supports is selected once, in cifXTKitInit() or on the first call:
+*    - "armv8":  CRC32 instructions (AArch64, or 32 bit ARM built with
+*                __ARM_FEATURE_CRC32), checked with HWCAP on Linux
+*    - "pclmul": carry-less multiply folding on x86 (PCLMULQDQ + SSE4.1)
+*    - "slice8": slicing-by-8 tables, portable fallback
+*    All of them give the same result as the byte wise table ("table").    */
+/*****************************************************************************/
+
+#ifndef CIFX_CRC32__H
+#define CIFX_CRC32__H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*****************************************************************************/
+/*! CRC update on the inverted register, no init or final XOR              */
+/*****************************************************************************/
+typedef uint32_t (*PFN_CIFX_CRC32_UPDATE)(uint32_t ulState, const uint8_t* pabBuffer, uint32_t ulLength);
+
+/*****************************************************************************/
+/*! One implementation of the CRC                                           */
+/*****************************************************************************/
+typedef struct CIFX_CRC32_IMPL_Ttag
+{
+  const char*           szName;     /*!< Name in traces and benchmarks       */
+  PFN_CIFX_CRC32_UPDATE pfnUpdate;
+} CIFX_CRC32_IMPL_T;
+
+void                     cifXCrc32Init         (void);
+uint32_t                 cifXCrc32             (uint32_t ulCRC, const uint8_t* pabBuffer, uint32_t ulLength);
+uint32_t                 cifXCrc32Impl         (const CIFX_CRC32_IMPL_T* ptImpl, uint32_t ulCRC, const uint8_t* pabBuffer, uint32_t ulLength);
+uint32_t                 cifXCrc32GetImpls     (const CIFX_CRC32_IMPL_T** pptImpls);
+const CIFX_CRC32_IMPL_T* cifXCrc32GetActiveImpl(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_CRC32__H */
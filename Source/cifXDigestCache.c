@@ -0,0 +1,423 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXDigestCache.c
+ * @brief          :  Persistent MD5 cache of the download files
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXDigestCache.c
+*    The cache is kept in memory and written to the cache file whenever an
+*    entry is added or dropped. A cache file that cannot be read or has a
+*    wrong checksum is ignored, the toolkit then hashes and asks the device
+*    as without the cache.                                                   */
+/*****************************************************************************/
+
+#include "cifXToolkit.h"
+#include "cifXErrors.h"
+#include "cifXCrc32.h"
+#include "cifXDigestCache.h"
+#include "Hilmd5.h"
+
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+#define CIFX_DIGEST_CACHE_MAGIC     0x43444247UL  /*!< "GBDC"                  */
+#define CIFX_DIGEST_CACHE_VERSION   1
+
+/*****************************************************************************/
+/*! MD5 of a host file                                                       */
+/*****************************************************************************/
+typedef struct CIFX_DIGEST_FILE_ENTRY_Ttag
+{
+  OS_FILE_ID_T tId;
+  uint8_t      abMd5[16];
+  uint32_t     ulLastUse;         /*!< 0: entry unused                                   */
+} CIFX_DIGEST_FILE_ENTRY_T;
+
+/*****************************************************************************/
+/*! MD5 of a file on a device, as last reported by the device                */
+/*****************************************************************************/
+typedef struct CIFX_DIGEST_DEVICE_ENTRY_Ttag
+{
+  uint32_t ulDeviceNumber;
+  uint32_t ulSerialNumber;
+  uint32_t ulChannel;
+  char     szFileName[CIFX_MAX_FILE_NAME_LENGTH];
+  uint8_t  abMd5[16];
+  uint32_t ulLastUse;             /*!< 0: entry unused                                   */
+} CIFX_DIGEST_DEVICE_ENTRY_T;
+
+/*****************************************************************************/
+/*! Content of the cache file, host byte order                               */
+/*****************************************************************************/
+typedef struct CIFX_DIGEST_CACHE_DATA_Ttag
+{
+  uint32_t                   ulMagic;
+  uint32_t                   ulVersion;
+  uint32_t                   ulCrc;         /*!< CRC32 from ulUseCounter to the end      */
+  uint32_t                   ulUseCounter;
+  CIFX_DIGEST_FILE_ENTRY_T   atFiles[CIFX_DIGEST_CACHE_MAX_FILES];
+  CIFX_DIGEST_DEVICE_ENTRY_T atDevices[CIFX_DIGEST_CACHE_MAX_DEVICE_FILES];
+} CIFX_DIGEST_CACHE_DATA_T;
+
+static void*                     s_pvDigestLock = NULL;
+static char                      s_szDigestFile[CIFX_MAX_FILE_NAME_LENGTH];
+static CIFX_DIGEST_CACHE_DATA_T  s_tDigestData;
+static CIFX_DIGEST_CACHE_STATS_T s_tDigestStats;
+
+/*****************************************************************************/
+/*! Checksum of the cache content
+*   \param ptData  Cache content
+*   \return CRC32 of the content behind ulCrc                                */
+/*****************************************************************************/
+static uint32_t DigestCacheCrc(CIFX_DIGEST_CACHE_DATA_T* ptData)
+{
+  const uint8_t* pbStart = (const uint8_t*)&ptData->ulUseCounter;
+
+  return cifXCrc32(0, pbStart, (uint32_t)(sizeof(*ptData) - (pbStart - (const uint8_t*)ptData)));
+}
+
+/*****************************************************************************/
+/*! Writes the cache file, called with the cache lock held                   */
+/*****************************************************************************/
+static void DigestCacheSave(void)
+{
+  int32_t lRet;
+
+  s_tDigestData.ulCrc = DigestCacheCrc(&s_tDigestData);
+
+  if(CIFX_NO_ERROR != (lRet = OS_FileSave(s_szDigestFile, &s_tDigestData, (uint32_t)sizeof(s_tDigestData))))
+  {
+    if(g_ulTraceLevel & TRACE_LEVEL_WARNING)
+    {
+      USER_Trace(NULL,
+                 TRACE_LEVEL_WARNING,
+                 "Failed to write digest cache '%s' (lRet=0x%08X)",
+                 s_szDigestFile,
+                 lRet);
+    }
+  } else
+  {
+    ++s_tDigestStats.ulSaves;
+  }
+}
+
+/*****************************************************************************/
+/*! Next use stamp of an entry, called with the cache lock held
+*   \return Stamp, never 0                                                   */
+/*****************************************************************************/
+static uint32_t DigestCacheNextUse(void)
+{
+  if(0 == ++s_tDigestData.ulUseCounter)
+    s_tDigestData.ulUseCounter = 1;
+
+  return s_tDigestData.ulUseCounter;
+}
+
+/*****************************************************************************/
+/*! Checks if the files of a device can be remembered. RAM based devices lose
+*   their files on reset, devices without serial number cannot be told apart.
+*   \param ptDevInstance  Device instance
+*   \return !=0 if device entries may be used                                */
+/*****************************************************************************/
+static int DigestCacheDeviceUsable(PDEVICEINSTANCE ptDevInstance)
+{
+  return (eCIFX_DEVICE_FLASH_BASED == ptDevInstance->eDeviceType) &&
+         (0 != ptDevInstance->ulSerialNumber);
+}
+
+/*****************************************************************************/
+/*! Searches the entry of a file on a device, called with the cache lock held
+*   \param ptDevInstance  Device instance
+*   \param ulChannel      Channel number
+*   \param pszFileName    File name on the device
+*   \return Entry, NULL if not cached                                        */
+/*****************************************************************************/
+static CIFX_DIGEST_DEVICE_ENTRY_T* DigestCacheFindDevice(PDEVICEINSTANCE ptDevInstance, uint32_t ulChannel, char* pszFileName)
+{
+  uint32_t ulIdx;
+
+  for(ulIdx = 0; ulIdx < CIFX_DIGEST_CACHE_MAX_DEVICE_FILES; ++ulIdx)
+  {
+    CIFX_DIGEST_DEVICE_ENTRY_T* ptEntry = &s_tDigestData.atDevices[ulIdx];
+
+    if( (0 != ptEntry->ulLastUse)                                    &&
+        (ptEntry->ulDeviceNumber == ptDevInstance->ulDeviceNumber)   &&
+        (ptEntry->ulSerialNumber == ptDevInstance->ulSerialNumber)   &&
+        (ptEntry->ulChannel      == ulChannel)                       &&
+        (0 == OS_Strnicmp(ptEntry->szFileName, pszFileName, sizeof(ptEntry->szFileName))) )
+    {
+      return ptEntry;
+    }
+  }
+
+  return NULL;
+}
+
+/*****************************************************************************/
+/*! Loads the cache file, an unreadable or invalid file gives an empty cache.
+*   Called by cifXTKitInit, may be called again to use another cache file.
+*   \param szCacheFile  Full file name of the cache
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t cifXDigestCacheInit(char* szCacheFile)
+{
+  uint32_t ulFileSize = 0;
+  void*    pvFile;
+
+  cifXDigestCacheDeinit();
+
+  if(NULL == (s_pvDigestLock = OS_CreateLock()))
+    return CIFX_INVALID_POINTER;
+
+  OS_Memset(&s_tDigestData,  0, sizeof(s_tDigestData));
+  OS_Memset(&s_tDigestStats, 0, sizeof(s_tDigestStats));
+  (void)OS_Strncpy(s_szDigestFile, szCacheFile, sizeof(s_szDigestFile) - 1);
+  s_szDigestFile[sizeof(s_szDigestFile) - 1] = '\0';
+
+  if(NULL != (pvFile = OS_FileOpen(s_szDigestFile, &ulFileSize)))
+  {
+    if( (ulFileSize != sizeof(s_tDigestData))                                                      ||
+        (ulFileSize != OS_FileRead(pvFile, 0, ulFileSize, &s_tDigestData))                         ||
+        (CIFX_DIGEST_CACHE_MAGIC   != s_tDigestData.ulMagic)                                       ||
+        (CIFX_DIGEST_CACHE_VERSION != s_tDigestData.ulVersion)                                     ||
+        (DigestCacheCrc(&s_tDigestData) != s_tDigestData.ulCrc) )
+    {
+      if(g_ulTraceLevel & TRACE_LEVEL_WARNING)
+      {
+        USER_Trace(NULL,
+                   TRACE_LEVEL_WARNING,
+                   "Ignoring invalid digest cache '%s'",
+                   s_szDigestFile);
+      }
+      OS_Memset(&s_tDigestData, 0, sizeof(s_tDigestData));
+    }
+    OS_FileClose(pvFile);
+  }
+
+  s_tDigestData.ulMagic   = CIFX_DIGEST_CACHE_MAGIC;
+  s_tDigestData.ulVersion = CIFX_DIGEST_CACHE_VERSION;
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Releases the cache, called by cifXTKitDeinit                             */
+/*****************************************************************************/
+void cifXDigestCacheDeinit(void)
+{
+  if(NULL != s_pvDigestLock)
+  {
+    OS_DeleteLock(s_pvDigestLock);
+    s_pvDigestLock = NULL;
+  }
+}
+
+/*****************************************************************************/
+/*! MD5 of the data read from an open host file. Taken from the cache if the
+*   file identity is known, otherwise calculated and added to the cache.
+*   \param pvFile   Open file the data was read from
+*   \param pbData   File data
+*   \param ulSize   Length of the data
+*   \param abMd5    Returned MD5
+*   \return !=0 if the MD5 was taken from the cache                          */
+/*****************************************************************************/
+int cifXDigestCacheGetFileMd5(void* pvFile, const uint8_t* pbData, uint32_t ulSize, uint8_t abMd5[16])
+{
+  OS_FILE_ID_T tId;
+  OS_FILE_ID_T tIdAfter;
+  md5_state_t  tMd5State;
+  int          fKnown = 0;
+  uint32_t     ulIdx;
+
+  OS_Memset(&tId, 0, sizeof(tId));
+
+  /* only the complete file can be cached */
+  if( (NULL != s_pvDigestLock)                        &&
+      (CIFX_NO_ERROR == OS_FileGetId(pvFile, &tId))   &&
+      (tId.ullSize == ulSize) )
+  {
+    fKnown = 1;
+
+    OS_EnterLock(s_pvDigestLock);
+    for(ulIdx = 0; ulIdx < CIFX_DIGEST_CACHE_MAX_FILES; ++ulIdx)
+    {
+      CIFX_DIGEST_FILE_ENTRY_T* ptEntry = &s_tDigestData.atFiles[ulIdx];
+
+      if( (0 != ptEntry->ulLastUse) &&
+          (0 == OS_Memcmp(&ptEntry->tId, &tId, sizeof(tId))) )
+      {
+        OS_Memcpy(abMd5, ptEntry->abMd5, 16);
+        ptEntry->ulLastUse = DigestCacheNextUse();
+        ++s_tDigestStats.ulFileHits;
+        OS_LeaveLock(s_pvDigestLock);
+        return 1;
+      }
+    }
+    OS_LeaveLock(s_pvDigestLock);
+  }
+
+  md5_init(&tMd5State);
+  md5_append(&tMd5State, (const md5_byte_t*)pbData, (long)ulSize);
+  md5_finish(&tMd5State, abMd5);
+
+  /* Do not cache a file that was written while it was hashed */
+  if( fKnown                                                  &&
+      (CIFX_NO_ERROR == OS_FileGetId(pvFile, &tIdAfter))      &&
+      (0 == OS_Memcmp(&tId, &tIdAfter, sizeof(tId))) )
+  {
+    CIFX_DIGEST_FILE_ENTRY_T* ptVictim;
+
+    OS_EnterLock(s_pvDigestLock);
+    ptVictim = &s_tDigestData.atFiles[0];
+    for(ulIdx = 1; ulIdx < CIFX_DIGEST_CACHE_MAX_FILES; ++ulIdx)
+    {
+      if(s_tDigestData.atFiles[ulIdx].ulLastUse < ptVictim->ulLastUse)
+        ptVictim = &s_tDigestData.atFiles[ulIdx];
+    }
+    ptVictim->tId = tId;
+    OS_Memcpy(ptVictim->abMd5, abMd5, 16);
+    ptVictim->ulLastUse = DigestCacheNextUse();
+    ++s_tDigestStats.ulFileMisses;
+    DigestCacheSave();
+    OS_LeaveLock(s_pvDigestLock);
+  }
+
+  return 0;
+}
+
+/*****************************************************************************/
+/*! Checks if the device is known to have a file with the given MD5
+*   \param ptDevInstance  Device instance
+*   \param ulChannel      Channel number
+*   \param pszFileName    File name on the device
+*   \param abMd5          MD5 of the file to download
+*   \return !=0 if the last MD5 reported by the device is abMd5              */
+/*****************************************************************************/
+int cifXDigestCacheCheckDevice(PDEVICEINSTANCE ptDevInstance, uint32_t ulChannel, char* pszFileName, const uint8_t abMd5[16])
+{
+  CIFX_DIGEST_DEVICE_ENTRY_T* ptEntry;
+  int                         fHit = 0;
+
+  if( (NULL == s_pvDigestLock) || !DigestCacheDeviceUsable(ptDevInstance) )
+    return 0;
+
+  OS_EnterLock(s_pvDigestLock);
+  if( (NULL != (ptEntry = DigestCacheFindDevice(ptDevInstance, ulChannel, pszFileName))) &&
+      (0 == OS_Memcmp(ptEntry->abMd5, (void*)abMd5, 16)) )
+  {
+    ptEntry->ulLastUse = DigestCacheNextUse();
+    ++s_tDigestStats.ulDeviceHits;
+    fHit = 1;
+  }
+  OS_LeaveLock(s_pvDigestLock);
+
+  return fHit;
+}
+
+/*****************************************************************************/
+/*! Remembers the MD5 a device reported for one of its files
+*   \param ptDevInstance  Device instance
+*   \param ulChannel      Channel number
+*   \param pszFileName    File name on the device
+*   \param abMd5          MD5 reported by the device                         */
+/*****************************************************************************/
+void cifXDigestCacheSetDevice(PDEVICEINSTANCE ptDevInstance, uint32_t ulChannel, char* pszFileName, const uint8_t abMd5[16])
+{
+  CIFX_DIGEST_DEVICE_ENTRY_T* ptEntry;
+  uint32_t                    ulIdx;
+
+  if( (NULL == s_pvDigestLock) || !DigestCacheDeviceUsable(ptDevInstance) )
+    return;
+
+  OS_EnterLock(s_pvDigestLock);
+  if(NULL == (ptEntry = DigestCacheFindDevice(ptDevInstance, ulChannel, pszFileName)))
+  {
+    ptEntry = &s_tDigestData.atDevices[0];
+    for(ulIdx = 1; ulIdx < CIFX_DIGEST_CACHE_MAX_DEVICE_FILES; ++ulIdx)
+    {
+      if(s_tDigestData.atDevices[ulIdx].ulLastUse < ptEntry->ulLastUse)
+        ptEntry = &s_tDigestData.atDevices[ulIdx];
+    }
+    OS_Memset(ptEntry, 0, sizeof(*ptEntry));
+    ptEntry->ulDeviceNumber = ptDevInstance->ulDeviceNumber;
+    ptEntry->ulSerialNumber = ptDevInstance->ulSerialNumber;
+    ptEntry->ulChannel      = ulChannel;
+    (void)OS_Strncpy(ptEntry->szFileName, pszFileName, sizeof(ptEntry->szFileName) - 1);
+  } else if(0 == OS_Memcmp(ptEntry->abMd5, (void*)abMd5, 16))
+  {
+    /* already known */
+    ptEntry->ulLastUse = DigestCacheNextUse();
+    OS_LeaveLock(s_pvDigestLock);
+    return;
+  }
+  OS_Memcpy(ptEntry->abMd5, (void*)abMd5, 16);
+  ptEntry->ulLastUse = DigestCacheNextUse();
+  DigestCacheSave();
+  OS_LeaveLock(s_pvDigestLock);
+}
+
+/*****************************************************************************/
+/*! Forgets a file of a device in all channels, called before the file is
+*   written or deleted
+*   \param ptDevInstance  Device instance
+*   \param pszFileName    File name on the device                            */
+/*****************************************************************************/
+void cifXDigestCacheDropDevice(PDEVICEINSTANCE ptDevInstance, char* pszFileName)
+{
+  int      fDropped = 0;
+  uint32_t ulIdx;
+
+  if(NULL == s_pvDigestLock)
+    return;
+
+  OS_EnterLock(s_pvDigestLock);
+  for(ulIdx = 0; ulIdx < CIFX_DIGEST_CACHE_MAX_DEVICE_FILES; ++ulIdx)
+  {
+    CIFX_DIGEST_DEVICE_ENTRY_T* ptEntry = &s_tDigestData.atDevices[ulIdx];
+
+    if( (0 != ptEntry->ulLastUse)                                    &&
+        (ptEntry->ulDeviceNumber == ptDevInstance->ulDeviceNumber)   &&
+        (ptEntry->ulSerialNumber == ptDevInstance->ulSerialNumber)   &&
+        (0 == OS_Strnicmp(ptEntry->szFileName, pszFileName, sizeof(ptEntry->szFileName))) )
+    {
+      OS_Memset(ptEntry, 0, sizeof(*ptEntry));
+      fDropped = 1;
+    }
+  }
+  if(fDropped)
+    DigestCacheSave();
+  OS_LeaveLock(s_pvDigestLock);
+}
+
+/*****************************************************************************/
+/*! Returns the counters of the cache
+*   \param ptStats  Returned counters                                        */
+/*****************************************************************************/
+void cifXDigestCacheGetStats(CIFX_DIGEST_CACHE_STATS_T* ptStats)
+{
+  if(NULL != s_pvDigestLock)
+    OS_EnterLock(s_pvDigestLock);
+
+  *ptStats = s_tDigestStats;
+
+  if(NULL != s_pvDigestLock)
+    OS_LeaveLock(s_pvDigestLock);
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#endif /* CIFX_TOOLKIT_DIGEST_CACHE */
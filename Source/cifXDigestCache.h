@@ -0,0 +1,75 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXDigestCache.h
+ * @brief          :  Persistent MD5 cache of the download files
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXDigestCache.h
+*    Digest cache used by DEV_CheckForDownload, enabled by
+*    CIFX_TOOLKIT_DIGEST_CACHE. It remembers
+*    - the MD5 of a host file by its identity (size, modification time,
+*      inode, device), so an unchanged file is not hashed again, and
+*    - the MD5 a flash based device last reported for a file of a channel
+*      (by device and serial number), so the MD5 request to the device is
+*      skipped while the host file is unchanged.
+*    Downloads and deletes done through the toolkit drop the device entry
+*    of the file. Changes made to the device flash by other tools (e.g.
+*    over USB) are not noticed, the cache file must be deleted then.        */
+/*****************************************************************************/
+
+#ifndef CIFX_DIGEST_CACHE__H
+#define CIFX_DIGEST_CACHE__H
+
+#include "cifXHWFunctions.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+
+#ifndef CIFX_TOOLKIT_DIGEST_CACHE_FILE
+  #define CIFX_TOOLKIT_DIGEST_CACHE_FILE    "/var/cache/gbcifx.digest"
+#endif
+#ifndef CIFX_DIGEST_CACHE_MAX_FILES
+  #define CIFX_DIGEST_CACHE_MAX_FILES       16  /*!< Host files, least recently used is replaced  */
+#endif
+#ifndef CIFX_DIGEST_CACHE_MAX_DEVICE_FILES
+  #define CIFX_DIGEST_CACHE_MAX_DEVICE_FILES 32 /*!< Files on devices, least recently used is replaced */
+#endif
+
+/*****************************************************************************/
+/*! Counters of the cache since cifXDigestCacheInit                          */
+/*****************************************************************************/
+typedef struct CIFX_DIGEST_CACHE_STATS_Ttag
+{
+  uint32_t ulFileHits;            /*!< MD5 of a host file taken from the cache           */
+  uint32_t ulFileMisses;          /*!< MD5 of a host file calculated and added           */
+  uint32_t ulDeviceHits;          /*!< MD5 requests to a device skipped                  */
+  uint32_t ulSaves;               /*!< Cache file written                                */
+} CIFX_DIGEST_CACHE_STATS_T;
+
+int32_t cifXDigestCacheInit       (char* szCacheFile);
+void    cifXDigestCacheDeinit     (void);
+int     cifXDigestCacheGetFileMd5 (void* pvFile, const uint8_t* pbData, uint32_t ulSize, uint8_t abMd5[16]);
+int     cifXDigestCacheCheckDevice(PDEVICEINSTANCE ptDevInstance, uint32_t ulChannel, char* pszFileName, const uint8_t abMd5[16]);
+void    cifXDigestCacheSetDevice  (PDEVICEINSTANCE ptDevInstance, uint32_t ulChannel, char* pszFileName, const uint8_t abMd5[16]);
+void    cifXDigestCacheDropDevice (PDEVICEINSTANCE ptDevInstance, char* pszFileName);
+void    cifXDigestCacheGetStats   (CIFX_DIGEST_CACHE_STATS_T* ptStats);
+
+#endif /* CIFX_TOOLKIT_DIGEST_CACHE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_DIGEST_CACHE__H */
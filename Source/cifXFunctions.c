@@ -30,6 +30,8 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #include "cifXToolkit.h"
 #include "cifXErrors.h"
 #include "cifXEndianess.h"
+#include "cifXStats.h"
+#include "cifXIODelta.h"
 
 #include "Hil_Results.h"
 #include "Hil_Packet.h"
@@ -602,6 +604,7 @@ int32_t APIENTRY xSysdeviceDownload( CIFXHANDLE            hSysdevice,
           if ( CIFX_NO_ERROR == (lRet = DEV_ProcessFWDownload( ptDevInstance,
                                                                ulChannel,
                                                                NULL,
+                                                               NULL,
                                                                pszFileName,
                                                                ulFileSize,
                                                                pabFileData,
@@ -1456,6 +1459,239 @@ int32_t APIENTRY xChannelIOInfo(CIFXHANDLE hChannel, uint32_t ulCmd, uint32_t ul
   return lRet;
 }
 
+/*****************************************************************************/
+/*! Reads Input data from the DPM of an I/O area and hands the area back to
+*   the device, the area mutex must be held by the caller
+*   \param ptChannel    Channel instance
+*   \param ptIOArea     Input area
+*   \param bIOBitState  Handshake bit state to wait for
+*   \param ulOffset     Data offset in Input area
+*   \param ulDataLen    Length of data to read
+*   \param pvData       Buffer to place returned data
+*   \param ulTimeout    Timeout in ms to wait for finished I/O Handshake
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t IOReadArea(PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOArea, uint8_t bIOBitState,
+                          uint32_t ulOffset, uint32_t ulDataLen, void* pvData, uint32_t ulTimeout)
+{
+  int32_t lRet = CIFX_NO_ERROR;
+
+  /* Read data */
+  if(HIL_FLAGS_NONE == bIOBitState)
+  {
+    /* Read data */
+    HWIF_READN( ptChannel->pvDeviceInstance,
+                pvData,
+                &ptIOArea->pbDPMAreaStart[ulOffset],
+                ulDataLen);
+
+    /* Check COMM Flag for return value */
+    (void)DEV_IsCommunicating(ptChannel, &lRet);
+
+  } else if(!DEV_WaitForBitState(ptChannel, ptIOArea->bHandshakeBit, bIOBitState, ulTimeout))
+  {
+    lRet = CIFX_DEV_EXCHANGE_FAILED;
+  } else
+  {
+    /* Read data */
+    HWIF_READN( ptChannel->pvDeviceInstance,
+                pvData,
+                &ptIOArea->pbDPMAreaStart[ulOffset],
+                ulDataLen);
+
+    /* Lock flag access */
+    OS_EnterLock(ptChannel->pvLock);
+
+    /* Read data done */
+    DEV_ToggleBit(ptChannel, (uint32_t)(1UL << ptIOArea->bHandshakeBit));
+
+    /* Unlock flag access */
+    OS_LeaveLock(ptChannel->pvLock);
+
+    /* Check COMM Flag for return value */
+    (void)DEV_IsCommunicating(ptChannel, &lRet);
+  }
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Add the bus cost of a DPM write to ptCost. Interfaces without a cost hook
+*   (e.g. memory mapped DPM) count the data plus the merge gap and no frames
+*   \param ptDevInstance  Device instance
+*   \param pvAddr         DPM address of the write
+*   \param ulLen          Length of the write
+*   \param ulMergeGap     Merge gap of the device
+*   \param ptCost         Cost the write is added to                        */
+/*****************************************************************************/
+static void IOWriteCost(PDEVICEINSTANCE ptDevInstance, void* pvAddr, uint32_t ulLen, uint32_t ulMergeGap,
+                        HWIF_COST_T* ptCost)
+{
+#ifdef CIFX_TOOLKIT_HWIF
+  if(NULL != ptDevInstance->pfnHwIfWriteCost)
+  {
+    ptDevInstance->pfnHwIfWriteCost(ptDevInstance, pvAddr, ulLen, ptCost);
+    return;
+  }
+#else
+  (void)ptDevInstance;
+  (void)pvAddr;
+#endif
+
+  ptCost->ulBytes += ulLen + ulMergeGap;
+}
+
+/*****************************************************************************/
+/*! Writes Output data to the DPM of an I/O area. In delta write mode only the
+*   spans that differ from the data last written are transferred, the area
+*   mutex must be held by the caller then. The spans are limited to the bus
+*   frames the complete data takes. Each span is a write of its own, if they
+*   cost at least as many bus bytes or more frames than the complete data,
+*   the complete data is written.
+*   \param ptChannel    Channel instance
+*   \param ptIOArea     Output area
+*   \param ulOffset     Data offset in Output area
+*   \param ulDataLen    Length of data to send
+*   \param pvData       Buffer containing send data                          */
+/*****************************************************************************/
+static void IOWriteData(PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOArea,
+                        uint32_t ulOffset, uint32_t ulDataLen, void* pvData)
+{
+  PDEVICEINSTANCE       ptDevInstance = (PDEVICEINSTANCE)ptChannel->pvDeviceInstance;
+  uint8_t*              pbData        = (uint8_t*)pvData;
+  uint8_t*              pbLast        = NULL;
+  uint32_t              ulMergeGap    = CIFX_IO_DELTA_MERGE_GAP;
+  CIFX_IO_DELTA_SPAN_T  atSpans[CIFX_IO_DELTA_MAX_SPANS];
+  HWIF_IOVEC_T          atIoVec[CIFX_IO_DELTA_MAX_SPANS];
+  uint32_t              ulMaxSpans    = CIFX_IO_DELTA_MAX_SPANS;
+  uint32_t              ulSpans;
+  uint32_t              ulIdx;
+  uint32_t              ulSent        = 0;
+  HWIF_COST_T           tFullCost     = {0, 0};
+  HWIF_COST_T           tDeltaCost    = {0, 0};
+
+  if(NULL == ptIOArea->pbLastImage)
+  {
+    HWIF_WRITEN(  ptDevInstance,
+                 &ptIOArea->pbDPMAreaStart[ulOffset],
+                  pvData,
+                  ulDataLen);
+    return;
+  }
+
+  if(!ptIOArea->fLastImageValid)
+  {
+    /* DPM content is unknown (mode just enabled or device reset), take it as reference */
+    HWIF_READN( ptDevInstance,
+                ptIOArea->pbLastImage,
+                ptIOArea->pbDPMAreaStart,
+                ptIOArea->ulDPMAreaLength);
+    ptIOArea->fLastImageValid = 1;
+    ++ptIOArea->tWriteStats.ullResyncs;
+  }
+
+#ifdef CIFX_TOOLKIT_HWIF
+  if(0 != ptDevInstance->ulHwIfWriteMergeGap)
+    ulMergeGap = ptDevInstance->ulHwIfWriteMergeGap;
+#endif
+
+  /* More spans than frames of the complete data never pay off */
+  IOWriteCost(ptDevInstance, &ptIOArea->pbDPMAreaStart[ulOffset], ulDataLen, ulMergeGap, &tFullCost);
+  if( (0 != tFullCost.ulFrames) && (tFullCost.ulFrames < ulMaxSpans) )
+    ulMaxSpans = tFullCost.ulFrames;
+
+  pbLast  = &ptIOArea->pbLastImage[ulOffset];
+  ulSpans = cifXIODeltaSpans(pbData, pbLast, ulDataLen, ulMergeGap, atSpans, ulMaxSpans);
+
+  for(ulIdx = 0; ulIdx < ulSpans; ++ulIdx)
+  {
+    atIoVec[ulIdx].pvAddr = &ptIOArea->pbDPMAreaStart[ulOffset + atSpans[ulIdx].ulOffset];
+    atIoVec[ulIdx].pvData = &pbData[atSpans[ulIdx].ulOffset];
+    atIoVec[ulIdx].ulLen  = atSpans[ulIdx].ulLen;
+    ulSent += atSpans[ulIdx].ulLen;
+    IOWriteCost(ptDevInstance, atIoVec[ulIdx].pvAddr, atIoVec[ulIdx].ulLen, ulMergeGap, &tDeltaCost);
+  }
+
+  if( (0 != ulSpans) &&
+      ((tDeltaCost.ulBytes >= tFullCost.ulBytes) || (tDeltaCost.ulFrames > tFullCost.ulFrames)) )
+  {
+    /* Spans cost as many bytes or more frames than the complete data */
+    HWIF_WRITEN(  ptDevInstance,
+                 &ptIOArea->pbDPMAreaStart[ulOffset],
+                  pvData,
+                  ulDataLen);
+    OS_Memcpy(pbLast, pbData, ulDataLen);
+    ulSpans = 1;
+    ulSent  = ulDataLen;
+    ++ptIOArea->tWriteStats.ullFullWrites;
+  } else if(0 != ulSpans)
+  {
+    HWIF_WRITEV(ptDevInstance, atIoVec, ulSpans);
+
+    for(ulIdx = 0; ulIdx < ulSpans; ++ulIdx)
+      OS_Memcpy(&pbLast[atSpans[ulIdx].ulOffset], &pbData[atSpans[ulIdx].ulOffset], atSpans[ulIdx].ulLen);
+  } else
+  {
+    ++ptIOArea->tWriteStats.ullUnchanged;
+  }
+
+  ++ptIOArea->tWriteStats.ullWrites;
+  ptIOArea->tWriteStats.ullSpans          += ulSpans;
+  ptIOArea->tWriteStats.ullBytesRequested += ulDataLen;
+  ptIOArea->tWriteStats.ullBytesSent      += ulSent;
+  ptIOArea->tWriteStats.ullBytesSaved     += ulDataLen - ulSent;
+}
+
+/*****************************************************************************/
+/*! Writes Output data to the DPM of an I/O area and hands the area over to
+*   the device, the area mutex must be held by the caller
+*   \param ptChannel    Channel instance
+*   \param ptIOArea     Output area
+*   \param bIOBitState  Handshake bit state to wait for
+*   \param ulOffset     Data offset in Output area
+*   \param ulDataLen    Length of data to send
+*   \param pvData       Buffer containing send data
+*   \param ulTimeout    Timeout in ms to wait for handshake completion
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t IOWriteArea(PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOArea, uint8_t bIOBitState,
+                           uint32_t ulOffset, uint32_t ulDataLen, void* pvData, uint32_t ulTimeout)
+{
+  int32_t lRet = CIFX_NO_ERROR;
+
+  /* TODO: define write procedure ??Toggle -> Write or Write->Toggle */
+  if(HIL_FLAGS_NONE == bIOBitState)
+  {
+    /* Write data without handshake */
+    IOWriteData(ptChannel, ptIOArea, ulOffset, ulDataLen, pvData);
+
+    /* Check COMM Flag for return value */
+    (void)DEV_IsCommunicating(ptChannel, &lRet);
+
+  } else if(!DEV_WaitForBitState(ptChannel, ptIOArea->bHandshakeBit, bIOBitState, ulTimeout))
+  {
+    lRet = CIFX_DEV_EXCHANGE_FAILED;
+  } else
+  {
+    /* Write data */
+    IOWriteData(ptChannel, ptIOArea, ulOffset, ulDataLen, pvData);
+
+    /* Lock flag access */
+    OS_EnterLock(ptChannel->pvLock);
+
+    /* Write data done */
+    DEV_ToggleBit(ptChannel, (uint32_t)(1UL << ptIOArea->bHandshakeBit));
+
+    /* Unlock flag access */
+    OS_LeaveLock(ptChannel->pvLock);
+
+    /* Check COMM Flag for return value */
+    (void)DEV_IsCommunicating(ptChannel, &lRet);
+  }
+
+  return lRet;
+}
+
 /*****************************************************************************/
 /*! Reads the Input data from the channel
 *   \param hChannel     Channel handle acquired by xChannelOpen
@@ -1472,6 +1708,9 @@ int32_t APIENTRY xChannelIORead(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint
   int32_t          lRet        = CIFX_NO_ERROR;
   PIOINSTANCE      ptIOArea    = NULL;
   uint8_t          bIOBitState = HIL_FLAGS_NONE;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
 
   if(!DEV_IsRunning(ptChannel))
     return CIFX_DEV_NOT_RUNNING;
@@ -1553,46 +1792,14 @@ int32_t APIENTRY xChannelIORead(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint
     if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
       return CIFX_DRV_CMD_ACTIVE;
 
-    /* Read data */
-    if(HIL_FLAGS_NONE == bIOBitState)
-    {
-      /* Read data */
-      HWIF_READN( ptChannel->pvDeviceInstance,
-                  pvData,
-                  &ptIOArea->pbDPMAreaStart[ulOffset],
-                  ulDataLen);
-
-      /* Check COMM Flag for return value */
-      (void)DEV_IsCommunicating(ptChannel, &lRet);
-
-    } else if(!DEV_WaitForBitState(ptChannel, ptIOArea->bHandshakeBit, bIOBitState, ulTimeout))
-    {
-      lRet = CIFX_DEV_EXCHANGE_FAILED;
-    } else
-    {
-      /* Read data */
-      HWIF_READN( ptChannel->pvDeviceInstance,
-                  pvData,
-                  &ptIOArea->pbDPMAreaStart[ulOffset],
-                  ulDataLen);
-
-      /* Lock flag access */
-      OS_EnterLock(ptChannel->pvLock);
-
-      /* Read data done */
-      DEV_ToggleBit(ptChannel, (uint32_t)(1UL << ptIOArea->bHandshakeBit));
-
-      /* Unlock flag access */
-      OS_LeaveLock(ptChannel->pvLock);
-
-      /* Check COMM Flag for return value */
-      (void)DEV_IsCommunicating(ptChannel, &lRet);
-    }
+    lRet = IOReadArea(ptChannel, ptIOArea, bIOBitState, ulOffset, ulDataLen, pvData, ulTimeout);
 
     /* Release command */
     OS_ReleaseMutex( ptIOArea->pvMutex);
   }
 
+  CIFX_STATS_IO(ptChannel, tSample, eCIFX_STATS_IO_READ, ulDataLen, lRet);
+
   return lRet;
 }
 
@@ -1612,6 +1819,9 @@ int32_t APIENTRY xChannelIOWrite(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uin
   int32_t          lRet        = CIFX_NO_ERROR;
   PIOINSTANCE      ptIOArea    = NULL;
   uint8_t          bIOBitState = HIL_FLAGS_NONE;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
 
   if(!DEV_IsRunning(ptChannel))
     return CIFX_DEV_NOT_RUNNING;
@@ -1692,53 +1902,526 @@ int32_t APIENTRY xChannelIOWrite(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uin
     if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
       return CIFX_DRV_CMD_ACTIVE;
 
-    /* Read data */
-    /* TODO: define write procedure ??Toggle -> Write or Write->Toggle */
-    if(HIL_FLAGS_NONE == bIOBitState)
-    {
-      /* Read data without handshake */
-      HWIF_WRITEN(  ptChannel->pvDeviceInstance,
-                   &ptIOArea->pbDPMAreaStart[ulOffset],
-                    pvData,
-                    ulDataLen);
+    lRet = IOWriteArea(ptChannel, ptIOArea, bIOBitState, ulOffset, ulDataLen, pvData, ulTimeout);
 
-      /* Check COMM Flag for return value */
-      (void)DEV_IsCommunicating(ptChannel, &lRet);
+    /* Release command */
+    OS_ReleaseMutex( ptIOArea->pvMutex);
+  }
 
-    } else
+  CIFX_STATS_IO(ptChannel, tSample, eCIFX_STATS_IO_WRITE, ulDataLen, lRet);
+
+  return lRet;
+}
+
+/* Part of the common status block fetched by xChannelIOExchange (ulCommunicationCOS .. bPDOutSource) */
+#define IOEXCHANGE_STATUS_LEN 0x14
+
+/*****************************************************************************/
+/*! Checks the cached handshake flags for the expected I/O bit state
+*   \param ptChannel     Channel instance
+*   \param bHandshakeBit Handshake bit of the I/O area
+*   \param bState        Expected bit state
+*   \return !=0 if the bit is already in the expected state                  */
+/*****************************************************************************/
+static int IOBitStateReached(PCHANNELINSTANCE ptChannel, uint8_t bHandshakeBit, uint8_t bState)
+{
+  uint16_t usBitMask = (uint16_t)(1U << bHandshakeBit);
+
+  switch(bState)
+  {
+    case HIL_FLAGS_NONE:
+      return 1;
+
+    case HIL_FLAGS_SET:
+      return (0 != (ptChannel->usNetxFlags & usBitMask));
+
+    case HIL_FLAGS_CLEAR:
+      return (0 == (ptChannel->usNetxFlags & usBitMask));
+
+    case HIL_FLAGS_NOT_EQUAL:
+      return (0 != ((ptChannel->usHostFlags ^ ptChannel->usNetxFlags) & usBitMask));
+
+    case HIL_FLAGS_EQUAL:
+    default:
+      return (0 == ((ptChannel->usHostFlags ^ ptChannel->usNetxFlags) & usBitMask));
+  }
+}
+
+/*****************************************************************************/
+/*! Reads the Input data and writes the Output data of an I/O area pair in
+*   one call. In polling mode the handshake cell, the COS/handshake mode part
+*   of the common status block and the input data are fetched with a single
+*   vectored DPM read, and both I/O handshake bits are toggled with one write.
+*   On serial DPM the vectored read only joins ranges up to
+*   SERDPM_READV_MAX_GAP bytes apart into one frame. The three ranges are
+*   further apart, so the read takes three frames and the exchange five in
+*   all (netX10/51, if the device is ready), compared to twelve for
+*   xChannelIORead followed by xChannelIOWrite. In interrupt or DMA mode this
+*   falls back to xChannelIORead followed by xChannelIOWrite.
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n), used for input and output
+*   \param ulInOffset   Data offset in Input area
+*   \param ulInLen      Length of data to read
+*   \param pvInData     Buffer to place returned data
+*   \param ulOutOffset  Data offset in Output area
+*   \param ulOutLen     Length of data to send
+*   \param pvOutData    Buffer containing send data
+*   \param ulTimeout    Timeout in ms to wait for finished I/O Handshake
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOExchange(CIFXHANDLE hChannel, uint32_t ulAreaNumber,
+                                    uint32_t ulInOffset,  uint32_t ulInLen,  void* pvInData,
+                                    uint32_t ulOutOffset, uint32_t ulOutLen, void* pvOutData,
+                                    uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE              ptChannel     = (PCHANNELINSTANCE)hChannel;
+  PDEVICEINSTANCE               ptDevInstance = (PDEVICEINSTANCE)ptChannel->pvDeviceInstance;
+  int32_t                       lRet          = CIFX_NO_ERROR;
+  PIOINSTANCE                   ptInArea      = NULL;
+  PIOINSTANCE                   ptOutArea     = NULL;
+  uint8_t                       bInBitState   = HIL_FLAGS_NONE;
+  uint8_t                       bOutBitState  = HIL_FLAGS_NONE;
+  uint32_t                      ulToggleMask  = 0;
+  uint16_t                      usNetxFlags   = 0;
+  int                           fSeparate     = ptDevInstance->fIrqEnabled;
+  HIL_DPM_HANDSHAKE_CELL_T      tHskCell;
+  HIL_DPM_COMMON_STATUS_BLOCK_T tStatus;
+  HWIF_IOVEC_T                  atIoVec[3];
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
+
+  if(ptChannel->fIsSysDevice)
+    return CIFX_DEV_NOT_RUNNING;
+
+  if( (ulAreaNumber >= ptChannel->ulIOInputAreas) ||
+      (ulAreaNumber >= ptChannel->ulIOOutputAreas) )
+    return CIFX_INVALID_PARAMETER;
+
+#ifdef CIFX_TOOLKIT_DMA
+  if(ptChannel->ulDeviceCOSFlags & HIL_COMM_COS_DMA)
+    fSeparate = 1;
+#endif
+
+  /* Flags are maintained by the ISR/DSR or data is located in DMA buffers */
+  if(fSeparate)
+  {
+    lRet = xChannelIORead(hChannel, ulAreaNumber, ulInOffset, ulInLen, pvInData, ulTimeout);
+    if( (CIFX_NO_ERROR == lRet) || (CIFX_DEV_NO_COM_FLAG == lRet) )
+      lRet = xChannelIOWrite(hChannel, ulAreaNumber, ulOutOffset, ulOutLen, pvOutData, ulTimeout);
+
+    return lRet;
+  }
+
+  ptInArea  = ptChannel->pptIOInputAreas[ulAreaNumber];
+  ptOutArea = ptChannel->pptIOOutputAreas[ulAreaNumber];
+
+  if( ((ulInOffset  + ulInLen)  > ptInArea->ulDPMAreaLength) ||
+      ((ulOutOffset + ulOutLen) > ptOutArea->ulDPMAreaLength) )
+    return CIFX_INVALID_ACCESS_SIZE;
+
+  /* Check if another command is active */
+  if ( !OS_WaitMutex( ptInArea->pvMutex, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  if ( !OS_WaitMutex( ptOutArea->pvMutex, ulTimeout))
+  {
+    OS_ReleaseMutex( ptInArea->pvMutex);
+    return CIFX_DRV_CMD_ACTIVE;
+  }
+
+  /* Entries are in ascending DPM order. The handshake cell is read before
+     the COS flags and the input data, so both are consistent with it */
+  atIoVec[0].pvAddr = (void*)ptChannel->ptHandshakeCell;
+  atIoVec[0].pvData = &tHskCell;
+  atIoVec[0].ulLen  = sizeof(tHskCell);
+  atIoVec[1].pvAddr = (void*)ptChannel->ptCommonStatusBlock;
+  atIoVec[1].pvData = &tStatus;
+  atIoVec[1].ulLen  = IOEXCHANGE_STATUS_LEN;
+  atIoVec[2].pvAddr = &ptInArea->pbDPMAreaStart[ulInOffset];
+  atIoVec[2].pvData = pvInData;
+  atIoVec[2].ulLen  = ulInLen;
+
+  /* Lock Handshake Cell and COS flag accesses */
+  OS_EnterLock(ptChannel->pvLock);
+
+  HWIF_READV(ptDevInstance, atIoVec, 3);
+
+  if(ptChannel->bHandshakeWidth == HIL_HANDSHAKE_SIZE_8BIT)
+    usNetxFlags = tHskCell.t8Bit.bNetxFlags;
+  else
+    usNetxFlags = LE16_TO_HOST(tHskCell.t16Bit.usNetxFlags);
+
+  DEV_UpdateHandshakeFlags(ptChannel, usNetxFlags, LE32_TO_HOST(tStatus.ulCommunicationCOS));
+
+  OS_LeaveLock(ptChannel->pvLock);
+
+  if( !(ptChannel->ulDeviceCOSFlags & HIL_COMM_COS_READY) ||
+      !(ptChannel->ulDeviceCOSFlags & HIL_COMM_COS_RUN) )
+  {
+    lRet = CIFX_DEV_NOT_RUNNING;
+  } else
+  {
+    bInBitState  = DEV_GetIOBitstateFromMode(ptInArea,  tStatus.bPDInHskMode);
+    bOutBitState = DEV_GetIOBitstateFromMode(ptOutArea, tStatus.bPDOutHskMode);
+
+    /* Input data is only valid, if the buffer was owned by the host when the
+       handshake cell was read. Otherwise wait for it and read it again */
+    if(!IOBitStateReached(ptChannel, ptInArea->bHandshakeBit, bInBitState))
     {
-      if(!DEV_WaitForBitState(ptChannel, ptIOArea->bHandshakeBit, bIOBitState, ulTimeout))
+      if(!DEV_WaitForBitState(ptChannel, ptInArea->bHandshakeBit, bInBitState, ulTimeout))
+        lRet = CIFX_DEV_EXCHANGE_FAILED;
+      else
+        HWIF_READN( ptDevInstance,
+                    pvInData,
+                    &ptInArea->pbDPMAreaStart[ulInOffset],
+                    ulInLen);
+    }
+
+    if(CIFX_NO_ERROR == lRet)
+    {
+      if(HIL_FLAGS_NONE != bInBitState)
+        ulToggleMask |= (uint32_t)(1UL << ptInArea->bHandshakeBit);
+
+      if( !IOBitStateReached(ptChannel, ptOutArea->bHandshakeBit, bOutBitState) &&
+          !DEV_WaitForBitState(ptChannel, ptOutArea->bHandshakeBit, bOutBitState, ulTimeout) )
       {
         lRet = CIFX_DEV_EXCHANGE_FAILED;
       } else
       {
-        /* Read data */
-        HWIF_WRITEN(  ptChannel->pvDeviceInstance,
-                     &ptIOArea->pbDPMAreaStart[ulOffset],
-                      pvData,
-                      ulDataLen);
+        IOWriteData(ptChannel, ptOutArea, ulOutOffset, ulOutLen, pvOutData);
 
-        /* Lock flag access */
-        OS_EnterLock(ptChannel->pvLock);
+        if(HIL_FLAGS_NONE != bOutBitState)
+          ulToggleMask |= (uint32_t)(1UL << ptOutArea->bHandshakeBit);
+      }
+    }
 
-        /* Read data done */
-        DEV_ToggleBit(ptChannel, (uint32_t)(1UL << ptIOArea->bHandshakeBit));
+    if(0 != ulToggleMask)
+    {
+      /* Lock flag access */
+      OS_EnterLock(ptChannel->pvLock);
 
-        /* Unlock flag access */
-        OS_LeaveLock(ptChannel->pvLock);
+      /* Read/write data done */
+      DEV_ToggleBit(ptChannel, ulToggleMask);
 
-        /* Check COMM Flag for return value */
-        (void)DEV_IsCommunicating(ptChannel, &lRet);
-      }
+      /* Unlock flag access */
+      OS_LeaveLock(ptChannel->pvLock);
     }
 
+    /* Check COMM Flag for return value (flags are up to date from the burst) */
+    if( (CIFX_NO_ERROR == lRet) &&
+        !(ptChannel->usNetxFlags & NCF_COMMUNICATING) )
+      lRet = CIFX_DEV_NO_COM_FLAG;
+  }
+
+  /* Release command */
+  OS_ReleaseMutex( ptOutArea->pvMutex);
+  OS_ReleaseMutex( ptInArea->pvMutex);
+
+  CIFX_STATS_IO(ptChannel, tSample, eCIFX_STATS_IO_EXCHANGE, ulInLen + ulOutLen, lRet);
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Reads the Input data into the host side image of the input area and lends
+*   the image to the caller, instead of copying the data into a caller
+*   buffer. On serial DPM the SPI receive goes directly into the image. The
+*   area is handed back to the device right away (handshake toggled), the
+*   image stays unchanged and the area locked until xChannelIOReadRelease.
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \param ulOffset     Data offset in Input area
+*   \param ulDataLen    Length of data to read
+*   \param ppvData      Returned pointer to the data in the image
+*                       (CIFX_IO_IMAGE_ALIGN aligned at offset 0), NULL if
+*                       nothing was lent out
+*   \param ulTimeout    Timeout in ms to wait for finished I/O Handshake
+*   \return CIFX_NO_ERROR on success. The image is also lent out on
+*           CIFX_DEV_NO_COM_FLAG, release it whenever *ppvData != NULL      */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOReadAcquire(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint32_t ulOffset, uint32_t ulDataLen, const void** ppvData, uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE ptChannel   = (PCHANNELINSTANCE)hChannel;
+  int32_t          lRet        = CIFX_NO_ERROR;
+  PIOINSTANCE      ptIOArea    = NULL;
+  uint8_t          bIOBitState = HIL_FLAGS_NONE;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
+
+  if(NULL == ppvData)
+    return CIFX_INVALID_POINTER;
+
+  *ppvData = NULL;
+
+  if(!DEV_IsRunning(ptChannel))
+    return CIFX_DEV_NOT_RUNNING;
+
+  if(ulAreaNumber >= ptChannel->ulIOInputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+#ifdef CIFX_TOOLKIT_DMA
+  /* Data is located in the DMA buffers, use xChannelIORead */
+  if(ptChannel->ulDeviceCOSFlags & HIL_COMM_COS_DMA)
+    return CIFX_FUNCTION_NOT_AVAILABLE;
+#endif
+
+  ptIOArea    = ptChannel->pptIOInputAreas[ulAreaNumber];
+  bIOBitState = DEV_GetIOBitstate(ptChannel, ptIOArea, 0);
+
+  if( (ulOffset + ulDataLen) > ptIOArea->ulDPMAreaLength)
+    return CIFX_INVALID_ACCESS_SIZE; /* read size too long */
+
+  /* Check if another command is active */
+  if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  lRet = IOReadArea(ptChannel, ptIOArea, bIOBitState, ulOffset, ulDataLen, &ptIOArea->pbHostImage[ulOffset], ulTimeout);
+
+  if( (CIFX_NO_ERROR == lRet) || (CIFX_DEV_NO_COM_FLAG == lRet) )
+  {
+    /* Data was read, keep the area locked while the image is lent out */
+    ptIOArea->fImageBorrowed = 1;
+    ptIOArea->ulImageOffset  = ulOffset;
+    ptIOArea->ulImageLen     = ulDataLen;
+    *ppvData                 = &ptIOArea->pbHostImage[ulOffset];
+  } else
+  {
     /* Release command */
     OS_ReleaseMutex( ptIOArea->pvMutex);
   }
 
+  CIFX_STATS_IO(ptChannel, tSample, eCIFX_STATS_IO_READ, ulDataLen, lRet);
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Ends the loan of an input image returned by xChannelIOReadAcquire
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOReadRelease(CIFXHANDLE hChannel, uint32_t ulAreaNumber)
+{
+  PCHANNELINSTANCE ptChannel = (PCHANNELINSTANCE)hChannel;
+  PIOINSTANCE      ptIOArea  = NULL;
+
+  if(ulAreaNumber >= ptChannel->ulIOInputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+  ptIOArea = ptChannel->pptIOInputAreas[ulAreaNumber];
+
+  if(!ptIOArea->fImageBorrowed)
+    return CIFX_INVALID_COMMAND;
+
+  ptIOArea->fImageBorrowed = 0;
+
+  /* Release command */
+  OS_ReleaseMutex( ptIOArea->pvMutex);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Lends the host side image of the output area to the caller, who fills in
+*   the Output data in place. xChannelIOWriteCommit sends it to the device,
+*   on serial DPM the SPI transmit is done directly from the image. The image
+*   keeps its content between commits, so only changed data has to be
+*   written. The area is locked until the commit.
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \param ulOffset     Data offset in Output area
+*   \param ulDataLen    Length of data to send on commit
+*   \param ppvData      Returned pointer to the data in the image
+*                       (CIFX_IO_IMAGE_ALIGN aligned at offset 0)
+*   \param ulTimeout    Timeout in ms to wait for the area lock
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOWriteAcquire(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint32_t ulOffset, uint32_t ulDataLen, void** ppvData, uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE ptChannel = (PCHANNELINSTANCE)hChannel;
+  PIOINSTANCE      ptIOArea  = NULL;
+
+  if(NULL == ppvData)
+    return CIFX_INVALID_POINTER;
+
+  *ppvData = NULL;
+
+  if(!DEV_IsRunning(ptChannel))
+    return CIFX_DEV_NOT_RUNNING;
+
+  if(ulAreaNumber >= ptChannel->ulIOOutputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+#ifdef CIFX_TOOLKIT_DMA
+  /* Data is located in the DMA buffers, use xChannelIOWrite */
+  if(ptChannel->ulDeviceCOSFlags & HIL_COMM_COS_DMA)
+    return CIFX_FUNCTION_NOT_AVAILABLE;
+#endif
+
+  ptIOArea = ptChannel->pptIOOutputAreas[ulAreaNumber];
+
+  if( (ulOffset + ulDataLen) > ptIOArea->ulDPMAreaLength)
+    return CIFX_INVALID_ACCESS_SIZE; /* write size too long */
+
+  /* Check if another command is active */
+  if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  ptIOArea->fImageBorrowed = 1;
+  ptIOArea->ulImageOffset  = ulOffset;
+  ptIOArea->ulImageLen     = ulDataLen;
+  *ppvData                 = &ptIOArea->pbHostImage[ulOffset];
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Sends the output image lent out by xChannelIOWriteAcquire to the device
+*   and ends the loan. The loan also ends if the handshake fails, the image
+*   content is kept for the next commit then.
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \param ulTimeout    Timeout in ms to wait for handshake completion
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOWriteCommit(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE ptChannel   = (PCHANNELINSTANCE)hChannel;
+  int32_t          lRet        = CIFX_NO_ERROR;
+  PIOINSTANCE      ptIOArea    = NULL;
+  uint8_t          bIOBitState = HIL_FLAGS_NONE;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
+
+  if(ulAreaNumber >= ptChannel->ulIOOutputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+  ptIOArea = ptChannel->pptIOOutputAreas[ulAreaNumber];
+
+  if(!ptIOArea->fImageBorrowed)
+    return CIFX_INVALID_COMMAND;
+
+  if(!DEV_IsRunning(ptChannel))
+  {
+    lRet = CIFX_DEV_NOT_RUNNING;
+  } else
+  {
+    bIOBitState = DEV_GetIOBitstate(ptChannel, ptIOArea, 1);
+    lRet        = IOWriteArea(ptChannel, ptIOArea, bIOBitState,
+                              ptIOArea->ulImageOffset, ptIOArea->ulImageLen,
+                              &ptIOArea->pbHostImage[ptIOArea->ulImageOffset], ulTimeout);
+  }
+
+  ptIOArea->fImageBorrowed = 0;
+
+  /* Release command */
+  OS_ReleaseMutex( ptIOArea->pvMutex);
+
+  CIFX_STATS_IO(ptChannel, tSample, eCIFX_STATS_IO_WRITE, ptIOArea->ulImageLen, lRet);
+
   return lRet;
 }
 
+/*****************************************************************************/
+/*! Selects how xChannelIOWrite, xChannelIOExchange, xChannelIOWriteCommit and
+*   xChannelPLCActivateWrite transfer the data of an output area. In delta
+*   mode the toolkit keeps a copy of the data last written to the DPM and
+*   only transfers the spans that changed. The copy is taken from the DPM on
+*   the first write and again after a device reset or channel init. Data
+*   written to the output area DPM by other means (e.g. the DPM pointer of
+*   xChannelPLCMemoryPtr on memory mapped devices) is not noticed until then.
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \param ulMode       CIFX_IO_WRITE_MODE_FULL or CIFX_IO_WRITE_MODE_DELTA
+*   \param ulTimeout    Timeout in ms to wait for the area lock
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOWriteMode(CIFXHANDLE hChannel, uint32_t ulAreaNumber, uint32_t ulMode, uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE ptChannel = (PCHANNELINSTANCE)hChannel;
+  int32_t          lRet      = CIFX_NO_ERROR;
+  PIOINSTANCE      ptIOArea  = NULL;
+
+  if(ulAreaNumber >= ptChannel->ulIOOutputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+  if( (CIFX_IO_WRITE_MODE_FULL  != ulMode) &&
+      (CIFX_IO_WRITE_MODE_DELTA != ulMode) )
+    return CIFX_INVALID_PARAMETER;
+
+  ptIOArea = ptChannel->pptIOOutputAreas[ulAreaNumber];
+
+  /* Check if another command is active */
+  if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  if(CIFX_IO_WRITE_MODE_FULL == ulMode)
+  {
+    if(NULL != ptIOArea->pbLastImage)
+    {
+      OS_Memfree(ptIOArea->pbLastImage);
+      ptIOArea->pbLastImage = NULL;
+    }
+
+  } else if(NULL == ptIOArea->pbLastImage)
+  {
+    if(NULL == (ptIOArea->pbLastImage = (uint8_t*)OS_Memalloc(ptIOArea->ulDPMAreaLength)))
+    {
+      lRet = CIFX_INVALID_POINTER;
+    } else
+    {
+      ptIOArea->fLastImageValid = 0;
+      OS_Memset(&ptIOArea->tWriteStats, 0, sizeof(ptIOArea->tWriteStats));
+    }
+  }
+
+  /* Release command */
+  OS_ReleaseMutex( ptIOArea->pvMutex);
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Returns the delta write counters of an output area
+*   \param hChannel     Channel handle acquired by xChannelOpen
+*   \param ulAreaNumber Number of the I/O Area (0..n)
+*   \param ptStats      Returned counters
+*   \param fReset       !=0 to clear the counters after reading them
+*   \param ulTimeout    Timeout in ms to wait for the area lock
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t APIENTRY xChannelIOWriteStats(CIFXHANDLE hChannel, uint32_t ulAreaNumber, CIFX_IO_WRITE_STATS_T* ptStats, int fReset, uint32_t ulTimeout)
+{
+  PCHANNELINSTANCE ptChannel = (PCHANNELINSTANCE)hChannel;
+  PIOINSTANCE      ptIOArea  = NULL;
+
+  if(NULL == ptStats)
+    return CIFX_INVALID_POINTER;
+
+  if(ulAreaNumber >= ptChannel->ulIOOutputAreas)
+    return CIFX_INVALID_PARAMETER;
+
+  ptIOArea = ptChannel->pptIOOutputAreas[ulAreaNumber];
+
+  /* Counters are updated under the area lock */
+  if ( !OS_WaitMutex( ptIOArea->pvMutex, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  OS_Memcpy(ptStats, &ptIOArea->tWriteStats, sizeof(*ptStats));
+
+  if(fReset)
+    OS_Memset(&ptIOArea->tWriteStats, 0, sizeof(ptIOArea->tWriteStats));
+
+  /* Release command */
+  OS_ReleaseMutex( ptIOArea->pvMutex);
+
+  return CIFX_NO_ERROR;
+}
+
 /*****************************************************************************/
 /*! Read back Send Data Area from channel
 *   \param hChannel     Channel handle acquired by xChannelOpen
@@ -2021,7 +2704,10 @@ int32_t APIENTRY xChannelUserBlock(CIFXHANDLE  hChannel, uint32_t ulAreaNumber,
 }
 
 /*****************************************************************************/
-/*! Gets a pointer to an IO Area
+/*! Gets a pointer to an IO Area. On hardware interface devices (serial DPM)
+*   the DPM is not mapped, the pointer references the host side image of the
+*   area instead. xChannelPLCActivateRead fetches the input image and
+*   xChannelPLCActivateWrite flushes the output image, each in one burst.
 *   \param hChannel       Handle to the channel
 *   \param ulCmd          CIFX_MEM_PTR_OPEN/CIFX_MEM_PTR_CLOSE
 *   \param pvMemoryInfo   Pointer to requested memory structure
@@ -2153,7 +2839,11 @@ int32_t APIENTRY xChannelPLCMemoryPtr(CIFXHANDLE hChannel, uint32_t ulCmd, void*
         case CIFX_MEM_PTR_OPEN:
         {
           void*    pvMappedDPM  = NULL;
+#ifdef CIFX_TOOLKIT_HWIF
+          void*    pvDPM        = pptIOInstances[ptMemory->ulAreaNumber]->pbHostImage;
+#else
           void*    pvDPM        = pptIOInstances[ptMemory->ulAreaNumber]->pbDPMAreaStart;
+#endif
           uint32_t ulDPMSize    = pptIOInstances[ptMemory->ulAreaNumber]->ulDPMAreaLength;
 
           /* Return global memory information */
@@ -2300,7 +2990,9 @@ int32_t APIENTRY xChannelPLCIsWriteReady(CIFXHANDLE hChannel, uint32_t ulAreaNum
 }
 
 /*****************************************************************************/
-/*! Toggles the Handshake bit for the given IO Output Area
+/*! Toggles the Handshake bit for the given IO Output Area. On hardware
+*   interface devices the output image (xChannelPLCMemoryPtr) is written to
+*   the DPM in one burst before.
 *   \param hChannel       Handle to the channel
 *   \param ulAreaNumber   Areanumber
 *   \return CIFX_NO_ERROR on success                                         */
@@ -2333,6 +3025,18 @@ int32_t APIENTRY xChannelPLCActivateWrite(CIFXHANDLE hChannel, uint32_t ulAreaNu
       {
         PIOINSTANCE ptIOInst = ptChannel->pptIOOutputAreas[ulAreaNumber];
 
+#ifdef CIFX_TOOLKIT_HWIF
+        /* The image may be lent out by xChannelIOWriteAcquire */
+        if ( !OS_WaitMutex( ptIOInst->pvMutex, 0))
+          return CIFX_DRV_CMD_ACTIVE;
+
+        /* Flush the output image */
+        IOWriteData(ptChannel, ptIOInst, 0, ptIOInst->ulDPMAreaLength, ptIOInst->pbHostImage);
+#else
+        /* The application wrote to the DPM directly */
+        ptIOInst->fLastImageValid = 0;
+#endif
+
         /* Lock flag access */
         OS_EnterLock(ptChannel->pvLock);
 
@@ -2340,6 +3044,10 @@ int32_t APIENTRY xChannelPLCActivateWrite(CIFXHANDLE hChannel, uint32_t ulAreaNu
 
         /* Unlock flag access */
         OS_LeaveLock(ptChannel->pvLock);
+
+#ifdef CIFX_TOOLKIT_HWIF
+        OS_ReleaseMutex( ptIOInst->pvMutex);
+#endif
       }
     }
   }
@@ -2348,7 +3056,11 @@ int32_t APIENTRY xChannelPLCActivateWrite(CIFXHANDLE hChannel, uint32_t ulAreaNu
 }
 
 /*****************************************************************************/
-/*! Toggles the Handshake bit for the given IO Input Area
+/*! Toggles the Handshake bit for the given IO Input Area. On hardware
+*   interface devices the input data is read into the input image
+*   (xChannelPLCMemoryPtr) in one burst before, so the image holds the data
+*   of the last call. Call it once the area is ready and use the image
+*   afterwards.
 *   \param hChannel       Handle to the channel
 *   \param ulAreaNumber   Areanumber
 *   \return CIFX_NO_ERROR on success                                         */
@@ -2381,6 +3093,18 @@ int32_t APIENTRY xChannelPLCActivateRead(CIFXHANDLE hChannel, uint32_t ulAreaNum
       {
         PIOINSTANCE ptIOInst = ptChannel->pptIOInputAreas[ulAreaNumber];
 
+#ifdef CIFX_TOOLKIT_HWIF
+        /* The image may be lent out by xChannelIOReadAcquire */
+        if ( !OS_WaitMutex( ptIOInst->pvMutex, 0))
+          return CIFX_DRV_CMD_ACTIVE;
+
+        /* Fetch the input image */
+        HWIF_READN( ptChannel->pvDeviceInstance,
+                    ptIOInst->pbHostImage,
+                    ptIOInst->pbDPMAreaStart,
+                    ptIOInst->ulDPMAreaLength);
+#endif
+
         /* Lock flag access */
         OS_EnterLock(ptChannel->pvLock);
 
@@ -2388,6 +3112,10 @@ int32_t APIENTRY xChannelPLCActivateRead(CIFXHANDLE hChannel, uint32_t ulAreaNum
 
         /* Unlock flag access */
         OS_LeaveLock(ptChannel->pvLock);
+
+#ifdef CIFX_TOOLKIT_HWIF
+        OS_ReleaseMutex( ptIOInst->pvMutex);
+#endif
       }
     }
   }
@@ -35,6 +35,9 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 /*****************************************************************************/
 
 #include "cifXHWFunctions.h"
+#include "cifXHWShadow.h"
+#include "cifXStats.h"
+#include "cifXWait.h"
 #include "cifXErrors.h"
 #include "cifXEndianess.h"
 
@@ -56,6 +59,9 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 int32_t DEV_PutPacket(PCHANNELINSTANCE ptChannel, CIFX_PACKET* ptSendPkt, uint32_t ulTimeout)
 {
   int32_t lRet = CIFX_DEV_MAILBOX_FULL;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
 
   if(!DEV_IsReady(ptChannel))
     return CIFX_DEV_NOT_READY;
@@ -85,6 +91,8 @@ int32_t DEV_PutPacket(PCHANNELINSTANCE ptChannel, CIFX_PACKET* ptSendPkt, uint32
     lRet = CIFX_NO_ERROR;
   }
 
+  CIFX_STATS_MAILBOX(ptChannel, tSample, 1, lRet);
+
   return lRet;
 }
 
@@ -101,6 +109,9 @@ int32_t DEV_GetPacket( PCHANNELINSTANCE ptChannel, CIFX_PACKET* ptRecvPkt, uint3
   int32_t       lRet        = CIFX_NO_ERROR;
   uint32_t      ulCopySize  = 0;
   CIFX_PACKET*  ptPacket    = NULL;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
 
   if(!DEV_IsReady(ptChannel))
     return CIFX_DEV_NOT_READY;
@@ -130,6 +141,8 @@ int32_t DEV_GetPacket( PCHANNELINSTANCE ptChannel, CIFX_PACKET* ptRecvPkt, uint3
   /* Unlock flag access */
   OS_LeaveLock(ptChannel->pvLock);
 
+  CIFX_STATS_MAILBOX(ptChannel, tSample, 0, lRet);
+
   return lRet;
 }
 
@@ -209,6 +222,9 @@ static int DEV_WaitForBitState_Poll(PCHANNELINSTANCE ptChannel, uint32_t ulBitNu
   int       iRet        = 0;
   uint32_t  ulBitMask   = 1 << ulBitNumber;
   int32_t   lStartTime  = 0;
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+  CIFX_WAIT_STATE_T tWait;
+#endif
 
   DEV_ReadHandshakeFlags(ptChannel, 0, 1);
 
@@ -235,6 +251,12 @@ static int DEV_WaitForBitState_Poll(PCHANNELINSTANCE ptChannel, uint32_t ulBitNu
 
   lStartTime = (int32_t)OS_GetMilliSecCounter();
 
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+  /* Sleep until shortly before the expected toggle, then spin and back off */
+  cifXWaitBegin(ptChannel, &tWait, ulBitNumber, ulTimeout);
+  cifXWaitPause(ptChannel, &tWait);
+#endif
+
   /* Poll for desired bit state */
   while(bActualState != bState)
   {
@@ -268,9 +290,17 @@ static int DEV_WaitForBitState_Poll(PCHANNELINSTANCE ptChannel, uint32_t ulBitNu
       break;
     }
 
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+    cifXWaitPause(ptChannel, &tWait);
+#else
     OS_Sleep(0);
+#endif
   }
 
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+  cifXWaitEnd(ptChannel, &tWait, iRet);
+#endif
+
   return iRet;
 }
 
@@ -378,10 +408,19 @@ static int DEV_WaitForBitState_Irq(PCHANNELINSTANCE ptChannel, uint32_t ulBitNum
 /*****************************************************************************/
 int DEV_WaitForBitState(PCHANNELINSTANCE ptChannel, uint32_t ulBitNumber, uint8_t bState, uint32_t ulTimeout)
 {
+  int fRet;
+  CIFX_STATS_SAMPLE(tSample);
+
+  CIFX_STATS_BEGIN(ptChannel, tSample);
+
   if( ((PDEVICEINSTANCE)(ptChannel->pvDeviceInstance))->fIrqEnabled)
-    return DEV_WaitForBitState_Irq(ptChannel, ulBitNumber, bState, ulTimeout);
+    fRet = DEV_WaitForBitState_Irq(ptChannel, ulBitNumber, bState, ulTimeout);
   else
-    return DEV_WaitForBitState_Poll(ptChannel, ulBitNumber, bState, ulTimeout);
+    fRet = DEV_WaitForBitState_Poll(ptChannel, ulBitNumber, bState, ulTimeout);
+
+  CIFX_STATS_HSKWAIT(ptChannel, tSample, ulBitNumber, fRet);
+
+  return fRet;
 }
 
 /*****************************************************************************/
@@ -393,7 +432,6 @@ int DEV_WaitForBitState(PCHANNELINSTANCE ptChannel, uint32_t ulBitNumber, uint8_
 /*****************************************************************************/
 uint8_t DEV_GetIOBitstate(PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOInstance, int fOutput)
 {
-  uint8_t  bRet        = ptIOInstance->bHandshakeBitState;
   uint8_t* pbIOHskMode = NULL;
 
   if(fOutput)
@@ -401,7 +439,21 @@ uint8_t DEV_GetIOBitstate(PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOInstance,
   else
     pbIOHskMode = &ptChannel->ptCommonStatusBlock->bPDInHskMode;
 
-  switch(HWIF_READ8(ptChannel->pvDeviceInstance, *pbIOHskMode))
+  return DEV_GetIOBitstateFromMode(ptIOInstance, HWIF_READ8(ptChannel->pvDeviceInstance, *pbIOHskMode));
+}
+
+/*****************************************************************************/
+/*! Get expected handshake bit state from an already read I/O handshake mode
+*   (bPDInHskMode / bPDOutHskMode of the common status block)
+*   \param ptIOInstance Pointer to IOInstance
+*   \param bIOHskMode   I/O handshake mode read from DPM
+*   \return Expected handshake bit state                                     */
+/*****************************************************************************/
+uint8_t DEV_GetIOBitstateFromMode(PIOINSTANCE ptIOInstance, uint8_t bIOHskMode)
+{
+  uint8_t bRet = ptIOInstance->bHandshakeBitState;
+
+  switch(bIOHskMode)
   {
     case HIL_IO_MODE_BUFF_DEV_CTRL:
       bRet = HIL_FLAGS_NOT_EQUAL;
@@ -709,6 +761,7 @@ void DEV_ReadHandshakeFlags(PCHANNELINSTANCE ptChannel, int fReadSyncFlags, int
     {
       ptChannel->ulDeviceCOSFlagsChanged  = ptChannel->ulDeviceCOSFlags ^ ulNewCOSFlags;
       ptChannel->ulDeviceCOSFlags         = ulNewCOSFlags;
+      CIFX_STATS_COS(ptChannel);
     }
 
     DEV_ToggleBit(ptChannel, usCOSAckBitMask);
@@ -719,6 +772,31 @@ void DEV_ReadHandshakeFlags(PCHANNELINSTANCE ptChannel, int fReadSyncFlags, int
     OS_LeaveLock(ptChannel->pvLock);
 }
 
+/*****************************************************************************/
+/*! Updates the cached handshake state of a communication channel from
+*   values that were already fetched from DPM (e.g. by a vectored read),
+*   and acknowledges a pending COS command. Caller must hold ptChannel->pvLock.
+*   \param ptChannel          Channel instance
+*   \param usNetxFlags        netX flags as read from the handshake cell
+*   \param ulCommunicationCOS COS flags as read from the common status block */
+/*****************************************************************************/
+void DEV_UpdateHandshakeFlags(PCHANNELINSTANCE ptChannel, uint16_t usNetxFlags, uint32_t ulCommunicationCOS)
+{
+  ptChannel->usNetxFlags = usNetxFlags;
+
+  if ((ptChannel->usNetxFlags ^ ptChannel->usHostFlags) & NCF_NETX_COS_CMD)
+  {
+    if(ptChannel->ulDeviceCOSFlags != ulCommunicationCOS)
+    {
+      ptChannel->ulDeviceCOSFlagsChanged  = ptChannel->ulDeviceCOSFlags ^ ulCommunicationCOS;
+      ptChannel->ulDeviceCOSFlags         = ulCommunicationCOS;
+      CIFX_STATS_COS(ptChannel);
+    }
+
+    DEV_ToggleBit(ptChannel, HCF_NETX_COS_ACK);
+  }
+}
+
 /*****************************************************************************/
 /*! Wait for NOT READY in poll mode
 *   \param ptChannel Channel instance to check
@@ -1147,6 +1225,9 @@ int32_t DEV_TriggerWatchdog(PCHANNELINSTANCE ptChannel, uint32_t ulTriggerCmd, u
       /* Unknown command */
       lRet = CIFX_INVALID_COMMAND;
     }
+
+    /* Watchdog cell is not followed by a handshake toggle, write it out now */
+    HWIF_SHADOW_FLUSH(ptChannel->pvDeviceInstance);
   }
 
   return lRet;
@@ -1560,6 +1641,19 @@ void DEV_CheckCOSFlags(PDEVICEINSTANCE ptDevInstance)
   }
 }
 
+/*****************************************************************************/
+/*! Mark the copies of the delta write mode outdated, as the firmware may
+*   have changed the output areas. The next write takes them from the DPM.
+*   \param ptChannel Channel instance                                        */
+/*****************************************************************************/
+static void DEV_InvalidateLastImages(PCHANNELINSTANCE ptChannel)
+{
+  uint32_t ulIdx;
+
+  for(ulIdx = 0; ulIdx < ptChannel->ulIOOutputAreas; ++ulIdx)
+    ptChannel->pptIOOutputAreas[ulIdx]->fLastImageValid = 0;
+}
+
 /*****************************************************************************/
 /*! Performs a channel initialization
 *   \param ptChannel Channel instance
@@ -1655,6 +1749,8 @@ int32_t DEV_DoChannelInit(PCHANNELINSTANCE ptChannel, uint32_t ulTimeout)
       }
     }
 
+    DEV_InvalidateLastImages(ptChannel);
+
     OS_ReleaseMutex(ptChannel->pvInitMutex);
   }
 
@@ -1687,6 +1783,8 @@ static void DEV_Reset_Prepare(PDEVICEINSTANCE ptDevInstance)
     ptDevInstance->pptCommChannels[ulIdx]->ulDeviceCOSFlags = 0;
     ptDevInstance->pptCommChannels[ulIdx]->ulHostCOSFlags   = 0;
     OS_LeaveLock(ptDevInstance->pptCommChannels[ulIdx]->pvLock);
+
+    DEV_InvalidateLastImages(ptDevInstance->pptCommChannels[ulIdx]);
   }
 }
 
@@ -2467,6 +2565,56 @@ uint32_t HwIfRead32(PDEVICEINSTANCE ptDev, void* pvSrc)
   return ulData;
 }
 #endif /* CIFX_TOOLKIT_HWIF */
+
+/*****************************************************************************/
+/*! Vectored read from DPM. Uses the interface's scatter/gather function if
+*   available, otherwise each entry is read separately (in list order)
+*   \param ptDev   Device instance
+*   \param ptIoVec List of DPM ranges and destination buffers
+*   \param ulCount Number of entries in ptIoVec                              */
+/*****************************************************************************/
+void HwIfReadV(PDEVICEINSTANCE ptDev, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  uint32_t ulIdx;
+
+#ifdef CIFX_TOOLKIT_HWIF
+  if(NULL != ptDev->pfnHwIfReadV)
+  {
+    ptDev->pfnHwIfReadV(ptDev, ptIoVec, ulCount);
+    return;
+  }
+#else
+  UNREFERENCED_PARAMETER(ptDev);
+#endif /* CIFX_TOOLKIT_HWIF */
+
+  for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+    HWIF_READN(ptDev, ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].pvAddr, ptIoVec[ulIdx].ulLen);
+}
+
+/*****************************************************************************/
+/*! Vectored write to DPM. Uses the interface's scatter/gather function if
+*   available, otherwise each entry is written separately (in list order)
+*   \param ptDev   Device instance
+*   \param ptIoVec List of DPM ranges and source buffers
+*   \param ulCount Number of entries in ptIoVec                              */
+/*****************************************************************************/
+void HwIfWriteV(PDEVICEINSTANCE ptDev, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  uint32_t ulIdx;
+
+#ifdef CIFX_TOOLKIT_HWIF
+  if(NULL != ptDev->pfnHwIfWriteV)
+  {
+    ptDev->pfnHwIfWriteV(ptDev, ptIoVec, ulCount);
+    return;
+  }
+#else
+  UNREFERENCED_PARAMETER(ptDev);
+#endif /* CIFX_TOOLKIT_HWIF */
+
+  for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+    HWIF_WRITEN(ptDev, ptIoVec[ulIdx].pvAddr, ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].ulLen);
+}
 /*****************************************************************************/
 /*! \}                                                                       */
 /*****************************************************************************/
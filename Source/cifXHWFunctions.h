@@ -67,6 +67,10 @@ typedef struct USERINSTANCEtag
 
 } USERINSTANCE, *PUSERINSTANCE;
 
+#ifndef CIFX_IO_IMAGE_ALIGN
+  #define CIFX_IO_IMAGE_ALIGN 64 /*!< Alignment of the host side I/O images (cache line) */
+#endif
+
 /*****************************************************************************/
 /*! Structure defining an I/O Block                                          */
 /*****************************************************************************/
@@ -81,6 +85,13 @@ typedef struct IOINSTANCEtag
   uint32_t                      ulNotifyEvent;            /*!< Event that is signalled via callback             */
   PFN_NOTIFY_CALLBACK           pfnCallback;              /*!< Notification callback                            */
   void*                         pvUser;                   /*!< User pointer for callback                        */
+  uint8_t*                      pbHostImage;              /*!< Host side image of the area (CIFX_IO_IMAGE_ALIGN aligned), lent out by xChannelIO*Acquire */
+  int                           fImageBorrowed;           /*!< !=0 while the image is lent out, the area mutex is held then */
+  uint32_t                      ulImageOffset;            /*!< Data offset of the lent out part of the image    */
+  uint32_t                      ulImageLen;               /*!< Length of the lent out part of the image         */
+  uint8_t*                      pbLastImage;              /*!< Output data last written to the DPM (CIFX_IO_WRITE_MODE_DELTA), NULL: full writes */
+  int                           fLastImageValid;          /*!< !=0 if pbLastImage matches the DPM, cleared on device reset and channel init */
+  CIFX_IO_WRITE_STATS_T         tWriteStats;              /*!< Delta write counters, protected by the area mutex */
 
 } IOINSTANCE, *PIOINSTANCE;
 
@@ -134,6 +145,30 @@ typedef struct NETX_SYNC_DATA_Ttag
   void*                         pvUser;                   /*!< User pointer for callback                        */
 } NETX_SYNC_DATA_T;
 
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+/*****************************************************************************/
+/*! Wait policy of a channel for handshake bit waits in polling mode
+*   (see cifXWait.h)                                                         */
+/*****************************************************************************/
+typedef struct CIFX_WAIT_CONFIG_Ttag
+{
+  uint32_t                      ulSpinNs;                 /*!< Poll without sleeping for this time (after the predicted wake-up) */
+  uint32_t                      ulBackoffMinNs;           /*!< First sleep after the spin phase                 */
+  uint32_t                      ulBackoffMaxNs;           /*!< Sleep limit of the exponential backoff, waits block in steps of this time once reached */
+  uint32_t                      ulWakeAheadNs;            /*!< Wake up this time before the expected toggle, 0: no prediction */
+  uint32_t                      ulEwmaShift;              /*!< Weight of a new turnaround time 1/2^ulEwmaShift (~ last 2^ulEwmaShift waits) */
+} CIFX_WAIT_CONFIG_T;
+
+typedef struct CIFX_WAIT_POLICY_Ttag
+{
+  CIFX_WAIT_CONFIG_T            tConfig;                  /*!< Configuration, set with cifXWaitSetConfig        */
+  uint32_t                      aulTurnaroundNs[HIL_DPM_HANDSHAKE_PAIRS]; /*!< EWMA of the turnaround time per handshake bit, 0: unknown */
+  uint32_t                      ulWaits;                  /*!< Waits that had to poll                           */
+  uint32_t                      ulPolls;                  /*!< Polls not finding the expected state             */
+  uint32_t                      ulSleeps;                 /*!< Sleeps during these waits                        */
+} CIFX_WAIT_POLICY_T;
+#endif /* CIFX_TOOLKIT_WAIT_POLICY */
+
 /*****************************************************************************/
 /*! Structure defining a channel instance                                    */
 /*****************************************************************************/
@@ -199,6 +234,14 @@ typedef struct CHANNELINSTANCEtag
   uint32_t              ulUserAreas;                      /*!< Number of user areas                 */
 
   NETX_SYNC_DATA_T      tSynch;                           /*!< Sync handling                        */
+
+#ifdef CIFX_TOOLKIT_STATS
+  struct CIFX_CHANNEL_STATS_Ttag* ptStats;                /*!< Timing statistics (see cifXStats.h), NULL: not recorded */
+#endif /* CIFX_TOOLKIT_STATS */
+
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+  CIFX_WAIT_POLICY_T    tWaitPolicy;                      /*!< Handshake wait policy in polling mode */
+#endif /* CIFX_TOOLKIT_WAIT_POLICY */
   
 } CHANNELINSTANCE, *PCHANNELINSTANCE;
 
@@ -334,8 +377,48 @@ typedef struct CIFX_SYNCH_DATA_Ttag
  
 } CIFX_SYNCH_DATA_T;
 
+/*****************************************************************************/
+/*! Duration of the start-up phases of a device in ms, filled in by
+*   cifXTKitAddDevice. Phases the device type does not pass stay 0.          */
+/*****************************************************************************/
+typedef struct CIFX_DEVICE_STARTUP_TIME_Ttag
+{
+  uint32_t  ulStartMs;                      /*!< OS_GetMilliSecCounter when the add was requested         */
+  uint32_t  ulDetectMs;                     /*!< Device type evaluation (incl. reset) and chip detection  */
+  uint32_t  ulBootMs;                       /*!< Bootloader / flash start and system channel creation     */
+  uint32_t  ulDownloadMs;                   /*!< Base OS, firmware and configuration downloads            */
+  uint32_t  ulFirmwareMs;                   /*!< Firmware start                                           */
+  uint32_t  ulChannelsMs;                   /*!< Channel creation, configuration and warmstart handling   */
+  uint32_t  ulRegisterMs;                   /*!< Entry into the device list, incl. waiting for the lock   */
+  uint32_t  ulTotalMs;                      /*!< Request to completion                                    */
+} CIFX_DEVICE_STARTUP_TIME_T;
+
+/*****************************************************************************/
+/*! Scatter/gather entry for vectored DPM accesses (HWIF_READV/HWIF_WRITEV).
+*   Entries are processed in list order. An interface may merge an entry
+*   with its successor into a single bus transfer, if the successor starts
+*   at the same or a higher DPM address.                                     */
+/*****************************************************************************/
+typedef struct HWIF_IOVEC_Ttag
+{
+  void*     pvAddr;                         /*!< DPM address (inside pbDPM) */
+  void*     pvData;                         /*!< Host buffer to read into / write from */
+  uint32_t  ulLen;                          /*!< Length of the access in bytes */
+} HWIF_IOVEC_T;
+
+/*****************************************************************************/
+/*! Bus cost of a DPM access, as reported by pfnHwIfWriteCost                */
+/*****************************************************************************/
+typedef struct HWIF_COST_Ttag
+{
+  uint32_t  ulBytes;                        /*!< Bytes clocked on the bus, incl. command headers and reads */
+  uint32_t  ulFrames;                       /*!< Bus transactions (chip select frames) */
+} HWIF_COST_T;
+
 #ifdef CIFX_TOOLKIT_HWIF
   typedef void*    (*PFN_HWIF_MEMCPY)  ( void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen);
+  typedef void     (*PFN_HWIF_MEMCPYV) ( void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount);
+  typedef void     (*PFN_HWIF_COST)    ( void* pvDevInstance, void* pvAddr, uint32_t ulLen, HWIF_COST_T* ptCost);
 
   /*lint -emacro(534, HWIF_READN)  : ignore return value */
   /*lint -emacro(534, HWIF_WRITE*) : ignore return value */
@@ -359,6 +442,8 @@ typedef struct CIFX_SYNCH_DATA_Ttag
     ((PDEVICEINSTANCE)ptDev)->pfnHwIfWrite(ptDev, (void*)&(Dst), (void*)&ulData, 4); \
   } while (0);
   #define HWIF_WRITEN(ptDev, Dst, Src, Len) ((PDEVICEINSTANCE)ptDev)->pfnHwIfWrite(ptDev, (void*)(Dst), Src, Len)
+  #define HWIF_READV(ptDev, ptIoVec, Count)  HwIfReadV((PDEVICEINSTANCE)(ptDev), ptIoVec, Count)
+  #define HWIF_WRITEV(ptDev, ptIoVec, Count) HwIfWriteV((PDEVICEINSTANCE)(ptDev), ptIoVec, Count)
 
 #else
   #define HWIF_READ8(ptDev,  Src) Src
@@ -369,6 +454,8 @@ typedef struct CIFX_SYNCH_DATA_Ttag
   #define HWIF_WRITE16(ptDev, Dst, Src)  (Dst) = (Src);
   #define HWIF_WRITE32(ptDev, Dst, Src)  (Dst) = (Src);
   #define HWIF_WRITEN(ptDev, Dst, Src, Len) OS_Memcpy(Dst, Src, Len)
+  #define HWIF_READV(ptDev, ptIoVec, Count)  HwIfReadV((PDEVICEINSTANCE)(ptDev), ptIoVec, Count)
+  #define HWIF_WRITEV(ptDev, ptIoVec, Count) HwIfWriteV((PDEVICEINSTANCE)(ptDev), ptIoVec, Count)
 #endif /* CIFX_TOOLKIT_HWIF */
 
 /*****************************************************************************/
@@ -425,6 +512,8 @@ typedef struct DEVICEINSTANCEtag
 
   int                       fResetActive;           /*!< !=0 if a reset is pending on device (DEV_DoSystemStart) */
 
+  CIFX_DEVICE_STARTUP_TIME_T tStartupTime;          /*!< Start-up timing of the last cifXTKitAddDevice */
+
   /* Extended memory (additional target memory) */
   uint8_t*                  pbExtendedMemory;       /*!< Virtual/usable pointer to an extended memory area       */
   uint32_t                  ulExtendedMemorySize;   /*!< Size of the extended memory area                        */
@@ -432,8 +521,19 @@ typedef struct DEVICEINSTANCEtag
 #ifdef CIFX_TOOLKIT_HWIF
   PFN_HWIF_MEMCPY        pfnHwIfRead;
   PFN_HWIF_MEMCPY        pfnHwIfWrite;
+  PFN_HWIF_MEMCPYV       pfnHwIfReadV;              /*!< Optional vectored read (NULL: pfnHwIfRead per entry)   */
+  PFN_HWIF_MEMCPYV       pfnHwIfWriteV;             /*!< Optional vectored write (NULL: pfnHwIfWrite per entry) */
+  uint32_t               ulHwIfWriteMergeGap;       /*!< Unchanged bytes worth rewriting to save a transfer (delta writes), 0: CIFX_IO_DELTA_MERGE_GAP */
+  PFN_HWIF_COST          pfnHwIfWriteCost;          /*!< Optional, adds the bus cost of a pfnHwIfWrite to *ptCost (delta writes) */
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+  void*                  pvHwIfShadow;              /*!< Shadow DPM instance (see cifXHWShadow.c)               */
+#endif /* CIFX_TOOLKIT_HWIF_SHADOW */
 #endif /* CIFX_TOOLKIT_HWIF */
 
+#ifdef CIFX_TOOLKIT_STATS
+  struct CIFX_DEVICE_STATS_Ttag* ptStats;           /*!< Hardware interface counters (see cifXStats.h), NULL: not recorded */
+#endif /* CIFX_TOOLKIT_STATS */
+
 } DEVICEINSTANCE, *PDEVICEINSTANCE;
 
 /*****************************************************************************/
@@ -447,8 +547,10 @@ void cifXTKitDSRHandler   (PDEVICEINSTANCE ptDevInstance);
 void    DEV_WriteHandshakeFlags   (PCHANNELINSTANCE ptChannel);
 void    DEV_ReadHostFlags         (PCHANNELINSTANCE ptChannel, int fReadHostCOS);
 void    DEV_ReadHandshakeFlags    (PCHANNELINSTANCE ptChannel, int fReadSyncFlags, int fLockNeeded);
+void    DEV_UpdateHandshakeFlags  (PCHANNELINSTANCE ptChannel, uint16_t usNetxFlags, uint32_t ulCommunicationCOS);
 
 uint8_t DEV_GetIOBitstate         (PCHANNELINSTANCE ptChannel, PIOINSTANCE ptIOInstance, int fOutput);
+uint8_t DEV_GetIOBitstateFromMode (PIOINSTANCE ptIOInstance, uint8_t bIOHskMode);
 
 int     DEV_WaitForBitState       (PCHANNELINSTANCE ptChannel, uint32_t ulBitNumber, uint8_t bState, uint32_t ulTimeout);
 void    DEV_ToggleBit             (PCHANNELINSTANCE ptChannel, uint32_t ulBitMask);
@@ -496,6 +598,8 @@ uint8_t DEV_GetHandshakeBitState  (PCHANNELINSTANCE ptChannel, uint32_t ulBitMsk
   uint16_t HwIfRead16             (PDEVICEINSTANCE ptDev, void* pvSrc);
   uint32_t HwIfRead32             (PDEVICEINSTANCE ptDev, void* pvSrc);
 #endif /* CIFX_TOOLKIT_HWIF */
+void     HwIfReadV                (PDEVICEINSTANCE ptDev, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount);
+void     HwIfWriteV               (PDEVICEINSTANCE ptDev, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount);
 
 /******************************************************************************
 * Functions to be implemented by USER                                         *
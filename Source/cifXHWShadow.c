@@ -0,0 +1,608 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXHWShadow.c
+ * @brief          :  Host side shadow copy of DPM channel blocks (HWIF only)
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXHWShadow.c
+*    Shadow DPM layer. Sits between the toolkit and the hardware interface
+*    functions (pfnHwIfRead/pfnHwIfWrite) and keeps a host copy of the
+*    control block and the first part of the common status block of every
+*    communication channel.
+*
+*    - Handshake cells are always read from / written to DPM. A change of
+*      the state flags (bits 0-3, netX or host side: ready/communicating,
+*      error and change of state) starts a new epoch for the channel, which
+*      invalidates all shadowed blocks of this channel. The netX changes the
+*      blocks together with these flags. The mailbox and I/O handshake bits
+*      toggle with every exchange and leave the blocks valid, so the I/O
+*      handshake modes read on every exchange come from the shadow.
+*    - Reads of a shadowed block load the whole block once per epoch.
+*    - Writes to a shadowed block are collected as dirty ranges and written
+*      back in one burst before any other DPM access, on an epoch change or
+*      on HwIfShadowFlush().                                                 */
+/*****************************************************************************/
+
+#include "cifXHWShadow.h"
+#include "cifXErrors.h"
+#include "OS_Dependent.h"
+
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+
+/* Shadowed part of the common status block (ulCommunicationCOS .. bPDOutSource).
+   ulHostWatchdog and the error counters behind it change without a handshake
+   toggle and are always read from DPM */
+#ifndef HWIF_SHADOW_STATUS_LEN
+  #define HWIF_SHADOW_STATUS_LEN    0x14
+#endif
+
+#define HWIF_SHADOW_MAX_BLOCK_LEN   HWIF_SHADOW_STATUS_LEN
+#define HWIF_SHADOW_CELL_LEN        sizeof(HIL_DPM_HANDSHAKE_CELL_T)
+
+/* Handshake flags whose change starts a new epoch, the low bits of the netX and host flags */
+#define HWIF_SHADOW_STATE_FLAGS     0x0F
+#define HWIF_SHADOW_MAX_REGIONS     (3 * CIFX_MAX_NUMBER_OF_CHANNELS)
+
+/*****************************************************************************/
+/*! DPM region known to the shadow layer                                     */
+/*****************************************************************************/
+typedef struct HWIF_SHADOW_REGION_Ttag
+{
+  uint8_t*  pbStart;                              /*!< DPM address of the region */
+  uint32_t  ulLen;                                /*!< Length of the region */
+  uint32_t  ulChannel;                            /*!< Channel owning the region (epoch index) */
+  int       fLive;                                /*!< !=0 for handshake cells (never served from shadow) */
+  int       fValid;                               /*!< !=0 if abData holds the DPM content of ulEpoch */
+  uint32_t  ulEpoch;                              /*!< Channel epoch abData was loaded in */
+  uint32_t  ulDirtyStart;                         /*!< Start of dirty range (offset in region) */
+  uint32_t  ulDirtyEnd;                           /*!< End of dirty range, == ulDirtyStart if clean */
+  uint8_t   abEpochMask[HWIF_SHADOW_CELL_LEN];    /*!< Handshake cell bits starting a new epoch */
+  uint8_t   abData[HWIF_SHADOW_MAX_BLOCK_LEN];    /*!< Shadow copy / last seen handshake cell */
+} HWIF_SHADOW_REGION_T;
+
+/*****************************************************************************/
+/*! Shadow DPM instance, one per device                                      */
+/*****************************************************************************/
+typedef struct HWIF_SHADOW_Ttag
+{
+  void*                 pvLock;                                 /*!< Lock for shadow accesses */
+  PFN_HWIF_MEMCPY       pfnRead;                                /*!< Hardware interface read */
+  PFN_HWIF_MEMCPY       pfnWrite;                               /*!< Hardware interface write */
+  PFN_HWIF_MEMCPYV      pfnReadV;                               /*!< Hardware interface vectored read (optional) */
+  PFN_HWIF_MEMCPYV      pfnWriteV;                              /*!< Hardware interface vectored write (optional) */
+  uint32_t              aulEpoch[CIFX_MAX_NUMBER_OF_CHANNELS];  /*!< Current epoch per channel */
+  uint32_t              ulRegionCount;                          /*!< Number of used entries in atRegions */
+  HWIF_SHADOW_REGION_T  atRegions[HWIF_SHADOW_MAX_REGIONS];     /*!< Known regions */
+  HWIF_SHADOW_STATS_T   tStats;                                 /*!< Access counters */
+} HWIF_SHADOW_T;
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Checks if a region holds valid shadow data
+*   \param ptShadow Shadow instance
+*   \param ptRegion Region to check
+*   \return !=0 if valid                                                     */
+/*****************************************************************************/
+static int ShadowIsValid(HWIF_SHADOW_T* ptShadow, HWIF_SHADOW_REGION_T* ptRegion)
+{
+  return ptRegion->fValid && (ptRegion->ulEpoch == ptShadow->aulEpoch[ptRegion->ulChannel]);
+}
+
+/*****************************************************************************/
+/*! Looks up the region containing a DPM range completely
+*   \param ptShadow Shadow instance
+*   \param pbAddr   DPM address
+*   \param ulLen    Length of the access
+*   \return Region or NULL if the range is not (completely) inside a region  */
+/*****************************************************************************/
+static HWIF_SHADOW_REGION_T* ShadowFindRegion(HWIF_SHADOW_T* ptShadow, uint8_t* pbAddr, uint32_t ulLen)
+{
+  uint32_t ulIdx;
+
+  for(ulIdx = 0; ulIdx < ptShadow->ulRegionCount; ++ulIdx)
+  {
+    HWIF_SHADOW_REGION_T* ptRegion = &ptShadow->atRegions[ulIdx];
+
+    if( (pbAddr >= ptRegion->pbStart) &&
+        ((pbAddr + ulLen) <= (ptRegion->pbStart + ptRegion->ulLen)) )
+      return ptRegion;
+  }
+
+  return NULL;
+}
+
+/*****************************************************************************/
+/*! Writes all dirty ranges back to DPM in one vectored write
+*   \param ptDevInstance Device instance
+*   \param ptShadow      Shadow instance                                     */
+/*****************************************************************************/
+static void ShadowFlush(PDEVICEINSTANCE ptDevInstance, HWIF_SHADOW_T* ptShadow)
+{
+  HWIF_IOVEC_T atIoVec[HWIF_SHADOW_MAX_REGIONS];
+  uint32_t     ulCount = 0;
+  uint32_t     ulIdx;
+
+  for(ulIdx = 0; ulIdx < ptShadow->ulRegionCount; ++ulIdx)
+  {
+    HWIF_SHADOW_REGION_T* ptRegion = &ptShadow->atRegions[ulIdx];
+
+    if(ptRegion->ulDirtyEnd == ptRegion->ulDirtyStart)
+      continue;
+
+    atIoVec[ulCount].pvAddr = ptRegion->pbStart + ptRegion->ulDirtyStart;
+    atIoVec[ulCount].pvData = &ptRegion->abData[ptRegion->ulDirtyStart];
+    atIoVec[ulCount].ulLen  = ptRegion->ulDirtyEnd - ptRegion->ulDirtyStart;
+    ++ulCount;
+
+    ptRegion->ulDirtyStart = 0;
+    ptRegion->ulDirtyEnd   = 0;
+  }
+
+  if(0 == ulCount)
+    return;
+
+  ++ptShadow->tStats.ulFlushes;
+
+  if(NULL != ptShadow->pfnWriteV)
+  {
+    ptShadow->pfnWriteV(ptDevInstance, atIoVec, ulCount);
+  } else
+  {
+    for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+      (void)ptShadow->pfnWrite(ptDevInstance, atIoVec[ulIdx].pvAddr, atIoVec[ulIdx].pvData, atIoVec[ulIdx].ulLen);
+  }
+}
+
+/*****************************************************************************/
+/*! Starts a new epoch for a channel, all shadowed blocks of the channel
+*   are reloaded on the next access. Dirty ranges must be flushed before.
+*   \param ptShadow  Shadow instance
+*   \param ulChannel Channel index                                           */
+/*****************************************************************************/
+static void ShadowNewEpoch(HWIF_SHADOW_T* ptShadow, uint32_t ulChannel)
+{
+  ++ptShadow->aulEpoch[ulChannel];
+  ++ptShadow->tStats.ulInvalidations;
+}
+
+/*****************************************************************************/
+/*! Updates the shadow state from data that was transferred to/from DPM
+*   outside of the shadow copy
+*   \param ptShadow Shadow instance
+*   \param pbAddr   DPM address of the transfer
+*   \param pbData   Transferred data
+*   \param ulLen    Length of the transfer
+*   \param fWrite   !=0 if data was written to DPM                           */
+/*****************************************************************************/
+static void ShadowObserve(HWIF_SHADOW_T* ptShadow, uint8_t* pbAddr, uint8_t* pbData, uint32_t ulLen, int fWrite)
+{
+  uint32_t ulIdx;
+
+  for(ulIdx = 0; ulIdx < ptShadow->ulRegionCount; ++ulIdx)
+  {
+    HWIF_SHADOW_REGION_T* ptRegion = &ptShadow->atRegions[ulIdx];
+    uint8_t*              pbStart  = (pbAddr > ptRegion->pbStart) ? pbAddr : ptRegion->pbStart;
+    uint8_t*              pbEnd    = ((pbAddr + ulLen) < (ptRegion->pbStart + ptRegion->ulLen)) ?
+                                     (pbAddr + ulLen) : (ptRegion->pbStart + ptRegion->ulLen);
+    uint32_t              ulOffset;
+    uint32_t              ulPart;
+
+    if(pbStart >= pbEnd)
+      continue;
+
+    ulOffset = (uint32_t)(pbStart - ptRegion->pbStart);
+    ulPart   = (uint32_t)(pbEnd - pbStart);
+
+    if(ptRegion->fLive)
+    {
+      /* Handshake cell: a changed state flag, written by the host or seen from the netX, starts a new epoch */
+      uint8_t* pbCell  = pbData + (pbStart - pbAddr);
+      uint8_t  bChange = 0;
+      uint32_t ulByte;
+
+      for(ulByte = 0; ulByte < ulPart; ++ulByte)
+        bChange |= (uint8_t)((ptRegion->abData[ulOffset + ulByte] ^ pbCell[ulByte]) &
+                             ptRegion->abEpochMask[ulOffset + ulByte]);
+
+      if(0 != bChange)
+        ShadowNewEpoch(ptShadow, ptRegion->ulChannel);
+
+      OS_Memcpy(&ptRegion->abData[ulOffset], pbCell, ulPart);
+
+    } else if( !fWrite && (ulPart == ptRegion->ulLen) )
+    {
+      /* Complete block was read, take it over */
+      OS_Memcpy(ptRegion->abData, pbData + (pbStart - pbAddr), ulPart);
+      ptRegion->ulEpoch = ptShadow->aulEpoch[ptRegion->ulChannel];
+      ptRegion->fValid  = 1;
+
+    } else
+    {
+      ptRegion->fValid = 0;
+    }
+  }
+}
+
+/*****************************************************************************/
+/*! Shadowed hardware interface read
+*   \param pvDevInstance  Device Instance
+*   \param pvAddr         DPM address to read from
+*   \param pvData         Buffer to store read data
+*   \param ulLen          Number of bytes to read
+*   \return pvData                                                           */
+/*****************************************************************************/
+static void* ShadowRead(void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
+{
+  PDEVICEINSTANCE       ptDevInstance = (PDEVICEINSTANCE)pvDevInstance;
+  HWIF_SHADOW_T*        ptShadow      = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+  uint8_t*              pbAddr        = (uint8_t*)pvAddr;
+  HWIF_SHADOW_REGION_T* ptRegion;
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  ptRegion = ShadowFindRegion(ptShadow, pbAddr, ulLen);
+
+  if( (NULL != ptRegion) && !ptRegion->fLive)
+  {
+    if(ShadowIsValid(ptShadow, ptRegion))
+    {
+      ++ptShadow->tStats.ulHits;
+    } else
+    {
+      ++ptShadow->tStats.ulMisses;
+      (void)ptShadow->pfnRead(ptDevInstance, ptRegion->pbStart, ptRegion->abData, ptRegion->ulLen);
+      ptRegion->ulEpoch = ptShadow->aulEpoch[ptRegion->ulChannel];
+      ptRegion->fValid  = 1;
+    }
+
+    OS_Memcpy(pvData, &ptRegion->abData[pbAddr - ptRegion->pbStart], ulLen);
+
+  } else
+  {
+    /* Keep the host write order, dirty data goes out before anything else */
+    ShadowFlush(ptDevInstance, ptShadow);
+
+    ++ptShadow->tStats.ulPassThrough;
+    (void)ptShadow->pfnRead(ptDevInstance, pvAddr, pvData, ulLen);
+
+    ShadowObserve(ptShadow, pbAddr, (uint8_t*)pvData, ulLen, 0);
+  }
+
+  OS_LeaveLock(ptShadow->pvLock);
+
+  return pvData;
+}
+
+/*****************************************************************************/
+/*! Shadowed hardware interface write
+*   \param pvDevInstance  Device Instance
+*   \param pvAddr         DPM address to write to
+*   \param pvData         Data to write
+*   \param ulLen          Number of bytes to write
+*   \return pvAddr                                                           */
+/*****************************************************************************/
+static void* ShadowWrite(void* pvDevInstance, void* pvAddr, void* pvData, uint32_t ulLen)
+{
+  PDEVICEINSTANCE       ptDevInstance = (PDEVICEINSTANCE)pvDevInstance;
+  HWIF_SHADOW_T*        ptShadow      = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+  uint8_t*              pbAddr        = (uint8_t*)pvAddr;
+  HWIF_SHADOW_REGION_T* ptRegion;
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  ptRegion = ShadowFindRegion(ptShadow, pbAddr, ulLen);
+
+  if( (NULL != ptRegion) && !ptRegion->fLive)
+  {
+    uint32_t ulOffset = (uint32_t)(pbAddr - ptRegion->pbStart);
+
+    /* A partial write needs the remaining block content */
+    if(!ShadowIsValid(ptShadow, ptRegion))
+    {
+      ++ptShadow->tStats.ulMisses;
+      (void)ptShadow->pfnRead(ptDevInstance, ptRegion->pbStart, ptRegion->abData, ptRegion->ulLen);
+      ptRegion->ulEpoch = ptShadow->aulEpoch[ptRegion->ulChannel];
+      ptRegion->fValid  = 1;
+    }
+
+    OS_Memcpy(&ptRegion->abData[ulOffset], pvData, ulLen);
+
+    if(ptRegion->ulDirtyEnd == ptRegion->ulDirtyStart)
+    {
+      ptRegion->ulDirtyStart = ulOffset;
+      ptRegion->ulDirtyEnd   = ulOffset + ulLen;
+    } else
+    {
+      if(ulOffset < ptRegion->ulDirtyStart)
+        ptRegion->ulDirtyStart = ulOffset;
+      if((ulOffset + ulLen) > ptRegion->ulDirtyEnd)
+        ptRegion->ulDirtyEnd = ulOffset + ulLen;
+    }
+
+    ++ptShadow->tStats.ulWriteBack;
+
+  } else
+  {
+    ShadowFlush(ptDevInstance, ptShadow);
+
+    ++ptShadow->tStats.ulPassThrough;
+    (void)ptShadow->pfnWrite(ptDevInstance, pvAddr, pvData, ulLen);
+
+    ShadowObserve(ptShadow, pbAddr, (uint8_t*)pvData, ulLen, 1);
+  }
+
+  OS_LeaveLock(ptShadow->pvLock);
+
+  return pvAddr;
+}
+
+/*****************************************************************************/
+/*! Shadowed vectored read. Always reads from DPM (the caller wants one burst)
+*   and takes over complete blocks and handshake cells into the shadow.
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and destination buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void ShadowReadV(void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  PDEVICEINSTANCE ptDevInstance = (PDEVICEINSTANCE)pvDevInstance;
+  HWIF_SHADOW_T*  ptShadow      = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+  uint32_t        ulIdx;
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  ShadowFlush(ptDevInstance, ptShadow);
+
+  ++ptShadow->tStats.ulPassThrough;
+  if(NULL != ptShadow->pfnReadV)
+  {
+    ptShadow->pfnReadV(ptDevInstance, ptIoVec, ulCount);
+  } else
+  {
+    for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+      (void)ptShadow->pfnRead(ptDevInstance, ptIoVec[ulIdx].pvAddr, ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].ulLen);
+  }
+
+  /* List order is DPM access order, so a handshake change seen in an entry
+     already applies to the blocks read behind it */
+  for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+    ShadowObserve(ptShadow, (uint8_t*)ptIoVec[ulIdx].pvAddr, (uint8_t*)ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].ulLen, 0);
+
+  OS_LeaveLock(ptShadow->pvLock);
+}
+
+/*****************************************************************************/
+/*! Shadowed vectored write. Always writes to DPM and drops shadowed blocks
+*   that were touched.
+*   \param pvDevInstance  Device Instance
+*   \param ptIoVec        List of DPM ranges and source buffers
+*   \param ulCount        Number of entries in ptIoVec                       */
+/*****************************************************************************/
+static void ShadowWriteV(void* pvDevInstance, HWIF_IOVEC_T* ptIoVec, uint32_t ulCount)
+{
+  PDEVICEINSTANCE ptDevInstance = (PDEVICEINSTANCE)pvDevInstance;
+  HWIF_SHADOW_T*  ptShadow      = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+  uint32_t        ulIdx;
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  ShadowFlush(ptDevInstance, ptShadow);
+
+  ++ptShadow->tStats.ulPassThrough;
+  if(NULL != ptShadow->pfnWriteV)
+  {
+    ptShadow->pfnWriteV(ptDevInstance, ptIoVec, ulCount);
+  } else
+  {
+    for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+      (void)ptShadow->pfnWrite(ptDevInstance, ptIoVec[ulIdx].pvAddr, ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].ulLen);
+  }
+
+  for(ulIdx = 0; ulIdx < ulCount; ++ulIdx)
+    ShadowObserve(ptShadow, (uint8_t*)ptIoVec[ulIdx].pvAddr, (uint8_t*)ptIoVec[ulIdx].pvData, ptIoVec[ulIdx].ulLen, 1);
+
+  OS_LeaveLock(ptShadow->pvLock);
+}
+
+/*****************************************************************************/
+/*! Adds a region to the shadow
+*   \param ptShadow    Shadow instance
+*   \param pvStart     DPM address of the region
+*   \param ulLen       Length of the region
+*   \param ulChannel   Channel index
+*   \param pbEpochMask Bits starting a new epoch for a handshake cell, NULL
+*                      for a shadowed block
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t ShadowAddRegion(HWIF_SHADOW_T* ptShadow, void* pvStart, uint32_t ulLen, uint32_t ulChannel,
+                               const uint8_t* pbEpochMask)
+{
+  HWIF_SHADOW_REGION_T* ptRegion;
+
+  if( (ptShadow->ulRegionCount >= HWIF_SHADOW_MAX_REGIONS) ||
+      (ulLen > HWIF_SHADOW_MAX_BLOCK_LEN) )
+    return CIFX_INVALID_PARAMETER;
+
+  ptRegion = &ptShadow->atRegions[ptShadow->ulRegionCount++];
+  OS_Memset(ptRegion, 0, sizeof(*ptRegion));
+
+  ptRegion->pbStart   = (uint8_t*)pvStart;
+  ptRegion->ulLen     = ulLen;
+  ptRegion->ulChannel = ulChannel;
+  ptRegion->fLive     = (NULL != pbEpochMask);
+
+  if(ptRegion->fLive)
+    OS_Memcpy(ptRegion->abEpochMask, (void*)pbEpochMask, HWIF_SHADOW_CELL_LEN);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Adds the blocks of a communication channel to the shadow DPM of its
+*   device. The shadow is installed on the hardware interface of the device
+*   with the first channel.
+*   \param ptDevInstance Device instance
+*   \param ptChannel     Communication channel (layout already read)
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t HwIfShadowAddChannel(PDEVICEINSTANCE ptDevInstance, PCHANNELINSTANCE ptChannel)
+{
+  HWIF_SHADOW_T* ptShadow = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+  int32_t        lRet     = CIFX_NO_ERROR;
+  uint8_t        abEpochMask[HWIF_SHADOW_CELL_LEN];
+
+  if( (ptChannel->ulChannelNumber >= CIFX_MAX_NUMBER_OF_CHANNELS) ||
+      (NULL == ptChannel->ptControlBlock)                          ||
+      (NULL == ptChannel->ptCommonStatusBlock) )
+    return CIFX_INVALID_PARAMETER;
+
+  if(NULL == ptShadow)
+  {
+    void* pvLock = NULL;
+
+    if( (NULL == (ptShadow = (HWIF_SHADOW_T*)OS_Memalloc(sizeof(*ptShadow)))) ||
+        (NULL == (pvLock   = OS_CreateLock())) )
+    {
+      OS_Memfree(ptShadow);
+      return CIFX_INVALID_POINTER;
+    }
+
+    OS_Memset(ptShadow, 0, sizeof(*ptShadow));
+    ptShadow->pvLock    = pvLock;
+    ptShadow->pfnRead   = ptDevInstance->pfnHwIfRead;
+    ptShadow->pfnWrite  = ptDevInstance->pfnHwIfWrite;
+    ptShadow->pfnReadV  = ptDevInstance->pfnHwIfReadV;
+    ptShadow->pfnWriteV = ptDevInstance->pfnHwIfWriteV;
+
+    ptDevInstance->pvHwIfShadow  = ptShadow;
+    ptDevInstance->pfnHwIfRead   = ShadowRead;
+    ptDevInstance->pfnHwIfWrite  = ShadowWrite;
+    ptDevInstance->pfnHwIfReadV  = ShadowReadV;
+    ptDevInstance->pfnHwIfWriteV = ShadowWriteV;
+  }
+
+  /* State flags are the low bits of the netX and host flags, DPM is little endian */
+  OS_Memset(abEpochMask, 0, sizeof(abEpochMask));
+  if(HIL_HANDSHAKE_SIZE_8BIT == ptChannel->bHandshakeWidth)
+  {
+    abEpochMask[2] = HWIF_SHADOW_STATE_FLAGS;
+    abEpochMask[3] = HWIF_SHADOW_STATE_FLAGS;
+  } else
+  {
+    abEpochMask[0] = HWIF_SHADOW_STATE_FLAGS;
+    abEpochMask[2] = HWIF_SHADOW_STATE_FLAGS;
+  }
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  if( (CIFX_NO_ERROR != (lRet = ShadowAddRegion(ptShadow, (void*)ptChannel->ptHandshakeCell,
+                                                sizeof(*ptChannel->ptHandshakeCell),
+                                                ptChannel->ulChannelNumber, abEpochMask)))        ||
+      (CIFX_NO_ERROR != (lRet = ShadowAddRegion(ptShadow, (void*)ptChannel->ptControlBlock,
+                                                sizeof(*ptChannel->ptControlBlock),
+                                                ptChannel->ulChannelNumber, NULL)))               ||
+      (CIFX_NO_ERROR != (lRet = ShadowAddRegion(ptShadow, (void*)ptChannel->ptCommonStatusBlock,
+                                                HWIF_SHADOW_STATUS_LEN,
+                                                ptChannel->ulChannelNumber, NULL))) )
+  {
+    if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
+    {
+      USER_Trace(ptDevInstance,
+                 TRACE_LEVEL_ERROR,
+                 "Error adding channel %u to shadow DPM, Error: 0x%08X",
+                 ptChannel->ulChannelNumber,
+                 lRet);
+    }
+  }
+
+  OS_LeaveLock(ptShadow->pvLock);
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Writes back pending data and removes the shadow DPM from a device
+*   \param ptDevInstance Device instance                                     */
+/*****************************************************************************/
+void HwIfShadowDelete(PDEVICEINSTANCE ptDevInstance)
+{
+  HWIF_SHADOW_T* ptShadow = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+
+  if(NULL == ptShadow)
+    return;
+
+  OS_EnterLock(ptShadow->pvLock);
+  ShadowFlush(ptDevInstance, ptShadow);
+  OS_LeaveLock(ptShadow->pvLock);
+
+  ptDevInstance->pfnHwIfRead   = ptShadow->pfnRead;
+  ptDevInstance->pfnHwIfWrite  = ptShadow->pfnWrite;
+  ptDevInstance->pfnHwIfReadV  = ptShadow->pfnReadV;
+  ptDevInstance->pfnHwIfWriteV = ptShadow->pfnWriteV;
+  ptDevInstance->pvHwIfShadow  = NULL;
+
+  OS_DeleteLock(ptShadow->pvLock);
+  OS_Memfree(ptShadow);
+}
+
+/*****************************************************************************/
+/*! Writes all pending (dirty) shadow data to DPM
+*   \param ptDevInstance Device instance                                     */
+/*****************************************************************************/
+void HwIfShadowFlush(PDEVICEINSTANCE ptDevInstance)
+{
+  HWIF_SHADOW_T* ptShadow = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+
+  if(NULL == ptShadow)
+    return;
+
+  OS_EnterLock(ptShadow->pvLock);
+  ShadowFlush(ptDevInstance, ptShadow);
+  OS_LeaveLock(ptShadow->pvLock);
+}
+
+/*****************************************************************************/
+/*! Returns the shadow DPM access counters of a device
+*   \param ptDevInstance Device instance
+*   \param ptStats       Returned counters
+*   \param fReset        !=0 to clear the counters after reading
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t HwIfShadowGetStats(PDEVICEINSTANCE ptDevInstance, HWIF_SHADOW_STATS_T* ptStats, int fReset)
+{
+  HWIF_SHADOW_T* ptShadow = (HWIF_SHADOW_T*)ptDevInstance->pvHwIfShadow;
+
+  if(NULL == ptStats)
+    return CIFX_INVALID_POINTER;
+
+  if(NULL == ptShadow)
+    return CIFX_FUNCTION_NOT_AVAILABLE;
+
+  OS_EnterLock(ptShadow->pvLock);
+
+  OS_Memcpy(ptStats, &ptShadow->tStats, sizeof(*ptStats));
+  if(fReset)
+    OS_Memset(&ptShadow->tStats, 0, sizeof(ptShadow->tStats));
+
+  OS_LeaveLock(ptShadow->pvLock);
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#endif /* CIFX_TOOLKIT_HWIF_SHADOW */
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXHWShadow.h
+ * @brief          :  Host side shadow copy of DPM channel blocks (HWIF only)
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXHWShadow.h
+*    Shadow DPM layer for hardware interfaces (CIFX_TOOLKIT_HWIF), enabled by
+*    CIFX_TOOLKIT_HWIF_SHADOW.                                               */
+/*****************************************************************************/
+
+#ifndef CIFX_HWSHADOW__H
+#define CIFX_HWSHADOW__H
+
+#include "cifXHWFunctions.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(CIFX_TOOLKIT_HWIF_SHADOW) && !defined(CIFX_TOOLKIT_HWIF)
+  #error "CIFX_TOOLKIT_HWIF_SHADOW requires CIFX_TOOLKIT_HWIF"
+#endif
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_STRUCTURE Toolkit Structure Definitions
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Shadow DPM access counters. Every miss, pass-through access and flush is
+*   one access on the hardware interface, hits and write-backs are not.      */
+/*****************************************************************************/
+typedef struct HWIF_SHADOW_STATS_Ttag
+{
+  uint32_t ulHits;                /*!< Reads served from the shadow copy                      */
+  uint32_t ulMisses;              /*!< Shadowed blocks (re)loaded from DPM                    */
+  uint32_t ulPassThrough;         /*!< Accesses outside shadowed blocks and handshake cells   */
+  uint32_t ulWriteBack;           /*!< Writes absorbed by the shadow copy                     */
+  uint32_t ulFlushes;             /*!< Write-back bursts of dirty ranges                      */
+  uint32_t ulInvalidations;       /*!< Channel epoch changes (handshake toggles)              */
+} HWIF_SHADOW_STATS_T;
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+  int32_t HwIfShadowAddChannel    (PDEVICEINSTANCE ptDevInstance, PCHANNELINSTANCE ptChannel);
+  void    HwIfShadowDelete        (PDEVICEINSTANCE ptDevInstance);
+  void    HwIfShadowFlush         (PDEVICEINSTANCE ptDevInstance);
+  int32_t HwIfShadowGetStats      (PDEVICEINSTANCE ptDevInstance, HWIF_SHADOW_STATS_T* ptStats, int fReset);
+
+  #define HWIF_SHADOW_FLUSH(ptDev) HwIfShadowFlush((PDEVICEINSTANCE)(ptDev))
+#else
+  #define HWIF_SHADOW_FLUSH(ptDev)
+#endif /* CIFX_TOOLKIT_HWIF_SHADOW */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_HWSHADOW__H */
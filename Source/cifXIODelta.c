@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXIODelta.c
+ * @brief          :  Changed spans of the output data for delta writes
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXIODelta.c
+*    Span search of the delta writes. The data is compared in blocks of 16
+*    bytes, each block gives a mask of the changed bytes. Unchanged blocks
+*    cost a single compare, the masks of changed blocks are split into runs
+*    of changed bytes, which are merged into the spans.                      */
+/*****************************************************************************/
+
+#include <string.h>
+#include "cifXIODelta.h"
+
+#if defined(__SSE2__)
+  #define CIFX_IO_DELTA_SSE2
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define CIFX_IO_DELTA_NEON
+  #include <arm_neon.h>
+#endif
+
+#define DELTA_BLOCK_SIZE 16
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Spans found so far                                                       */
+/*****************************************************************************/
+typedef struct DELTA_STATE_Ttag
+{
+  CIFX_IO_DELTA_SPAN_T* ptSpans;
+  uint32_t              ulMaxSpans;
+  uint32_t              ulCount;
+  uint32_t              ulMergeGap;
+} DELTA_STATE_T;
+
+/*****************************************************************************/
+/*! Number of trailing zero bits
+*   \param ulValue Value (!= 0)
+*   \return Index of the lowest set bit                                      */
+/*****************************************************************************/
+static uint32_t DeltaCtz(uint32_t ulValue)
+{
+#ifdef __GNUC__
+  return (uint32_t)__builtin_ctz(ulValue);
+#else
+  uint32_t ulBit = 0;
+
+  while(0 == (ulValue & 1))
+  {
+    ulValue >>= 1;
+    ++ulBit;
+  }
+  return ulBit;
+#endif
+}
+
+/*****************************************************************************/
+/*! Compare a block of data
+*   \param pbData Output data
+*   \param pbLast Data last written
+*   \return Bit n set if byte n differs                                      */
+/*****************************************************************************/
+static uint32_t DeltaBlockMask(const uint8_t* pbData, const uint8_t* pbLast)
+{
+#if defined(CIFX_IO_DELTA_SSE2)
+  __m128i tEqual = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)pbData),
+                                  _mm_loadu_si128((const __m128i*)pbLast));
+
+  return ~(uint32_t)_mm_movemask_epi8(tEqual) & 0xFFFF;
+
+#elif defined(CIFX_IO_DELTA_NEON)
+  static const uint8_t s_abBits[DELTA_BLOCK_SIZE] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                                                      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+  uint8x16_t tDiff = vmvnq_u8(vceqq_u8(vld1q_u8(pbData), vld1q_u8(pbLast)));
+  uint8x16_t tBits = vandq_u8(tDiff, vld1q_u8(s_abBits));
+  uint8x8_t  tSum;
+
+  /* Three pairwise adds collect the bits of each half in one lane */
+  tSum = vpadd_u8(vget_low_u8(tBits), vget_high_u8(tBits));
+  tSum = vpadd_u8(tSum, tSum);
+  tSum = vpadd_u8(tSum, tSum);
+
+  return (uint32_t)vget_lane_u8(tSum, 0) | ((uint32_t)vget_lane_u8(tSum, 1) << 8);
+
+#else
+  uint32_t ulMask = 0;
+  uint32_t ulHalf;
+
+  for(ulHalf = 0; ulHalf < DELTA_BLOCK_SIZE; ulHalf += 8)
+  {
+    uint64_t ullData;
+    uint64_t ullLast;
+    uint32_t ulIdx;
+
+    memcpy(&ullData, &pbData[ulHalf], sizeof(ullData));
+    memcpy(&ullLast, &pbLast[ulHalf], sizeof(ullLast));
+    if(ullData == ullLast)
+      continue;
+
+    for(ulIdx = ulHalf; ulIdx < ulHalf + 8; ++ulIdx)
+    {
+      if(pbData[ulIdx] != pbLast[ulIdx])
+        ulMask |= 1UL << ulIdx;
+    }
+  }
+
+  return ulMask;
+#endif
+}
+
+/*****************************************************************************/
+/*! Add a run of changed bytes, it is merged into the last span if the gap is
+*   small enough or no span is left
+*   \param ptState  Spans found so far
+*   \param ulStart  Offset of the first changed byte
+*   \param ulEnd    Offset behind the last changed byte                      */
+/*****************************************************************************/
+static void DeltaAddRun(DELTA_STATE_T* ptState, uint32_t ulStart, uint32_t ulEnd)
+{
+  if(ptState->ulCount > 0)
+  {
+    CIFX_IO_DELTA_SPAN_T* ptLast    = &ptState->ptSpans[ptState->ulCount - 1];
+    uint32_t              ulLastEnd = ptLast->ulOffset + ptLast->ulLen;
+
+    if( ((ulStart - ulLastEnd) <= ptState->ulMergeGap) ||
+        (ptState->ulCount == ptState->ulMaxSpans) )
+    {
+      ptLast->ulLen = ulEnd - ptLast->ulOffset;
+      return;
+    }
+  }
+
+  ptState->ptSpans[ptState->ulCount].ulOffset = ulStart;
+  ptState->ptSpans[ptState->ulCount].ulLen    = ulEnd - ulStart;
+  ++ptState->ulCount;
+}
+
+/*****************************************************************************/
+/*! Split the changed bytes of a block into runs
+*   \param ptState  Spans found so far
+*   \param ulBase   Offset of the block
+*   \param ulMask   Changed bytes of the block (bit n: byte n)               */
+/*****************************************************************************/
+static void DeltaAddMask(DELTA_STATE_T* ptState, uint32_t ulBase, uint32_t ulMask)
+{
+  while(0 != ulMask)
+  {
+    uint32_t ulFirst = DeltaCtz(ulMask);
+    uint32_t ulRun   = DeltaCtz(~(ulMask >> ulFirst));
+
+    DeltaAddRun(ptState, ulBase + ulFirst, ulBase + ulFirst + ulRun);
+
+    /* A run never reaches bit 31, the mask only has DELTA_BLOCK_SIZE bits */
+    ulMask &= ~((1UL << (ulFirst + ulRun)) - 1);
+  }
+}
+
+/*****************************************************************************/
+/*! Get the spans of the output data that differ from the data last written.
+*   Runs of changed bytes separated by up to ulMergeGap unchanged bytes are
+*   returned as one span. If there are more than ulMaxSpans spans, the last
+*   one covers all remaining changes.
+*   \param pbData      Output data
+*   \param pbLast      Data last written (same offset and length)
+*   \param ulLen       Length of the data
+*   \param ulMergeGap  Unchanged bytes rewritten to join two spans
+*   \param ptSpans     Returned spans, in ascending order
+*   \param ulMaxSpans  Number of entries in ptSpans (>= 1)
+*   \return Number of spans, 0 if the data is unchanged                      */
+/*****************************************************************************/
+uint32_t cifXIODeltaSpans(const uint8_t* pbData, const uint8_t* pbLast, uint32_t ulLen, uint32_t ulMergeGap,
+                          CIFX_IO_DELTA_SPAN_T* ptSpans, uint32_t ulMaxSpans)
+{
+  DELTA_STATE_T tState;
+  uint32_t      ulPos = 0;
+
+  if(0 == ulMaxSpans)
+    return 0;
+
+  tState.ptSpans    = ptSpans;
+  tState.ulMaxSpans = ulMaxSpans;
+  tState.ulCount    = 0;
+  tState.ulMergeGap = ulMergeGap;
+
+  for(; (ulPos + DELTA_BLOCK_SIZE) <= ulLen; ulPos += DELTA_BLOCK_SIZE)
+  {
+    uint32_t ulMask = DeltaBlockMask(&pbData[ulPos], &pbLast[ulPos]);
+
+    if(0 != ulMask)
+      DeltaAddMask(&tState, ulPos, ulMask);
+  }
+
+  if(ulPos < ulLen)
+  {
+    uint32_t ulMask = 0;
+    uint32_t ulIdx;
+
+    for(ulIdx = 0; (ulPos + ulIdx) < ulLen; ++ulIdx)
+    {
+      if(pbData[ulPos + ulIdx] != pbLast[ulPos + ulIdx])
+        ulMask |= 1UL << ulIdx;
+    }
+
+    DeltaAddMask(&tState, ulPos, ulMask);
+  }
+
+  return tState.ulCount;
+}
+
+/*****************************************************************************/
+/*! Get the name of the compare implementation
+*   \return "sse2", "neon" or "scalar"                                       */
+/*****************************************************************************/
+const char* cifXIODeltaImplName(void)
+{
+#if defined(CIFX_IO_DELTA_SSE2)
+  return "sse2";
+#elif defined(CIFX_IO_DELTA_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
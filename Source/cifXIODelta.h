@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXIODelta.h
+ * @brief          :  Changed spans of the output data for delta writes
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXIODelta.h
+*    Compares the output data of a write with the data last written to the
+*    DPM (CIFX_IO_WRITE_MODE_DELTA, see xChannelIOWriteMode) and returns the
+*    spans that have to be transferred. Spans separated by at most the merge
+*    gap are joined, as rewriting a few unchanged bytes is cheaper than the
+*    command header and frame of another transfer. The compare runs 16 bytes
+*    at a time with SSE2 (x86) or NEON (ARM), otherwise 8 bytes at a time.  */
+/*****************************************************************************/
+
+#ifndef CIFX_IO_DELTA__H
+#define CIFX_IO_DELTA__H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef CIFX_IO_DELTA_MAX_SPANS
+  #define CIFX_IO_DELTA_MAX_SPANS  16 /*!< Spans per write, further changes are merged into the last span */
+#endif
+#ifndef CIFX_IO_DELTA_MERGE_GAP
+  #define CIFX_IO_DELTA_MERGE_GAP  8  /*!< Merge gap of interfaces not setting ulHwIfWriteMergeGap (e.g. memory mapped DPM) */
+#endif
+
+/*****************************************************************************/
+/*! Changed part of the output data                                          */
+/*****************************************************************************/
+typedef struct CIFX_IO_DELTA_SPAN_Ttag
+{
+  uint32_t ulOffset;              /*!< Offset relative to the compared data */
+  uint32_t ulLen;                 /*!< Length in bytes                      */
+} CIFX_IO_DELTA_SPAN_T;
+
+uint32_t    cifXIODeltaSpans   (const uint8_t* pbData, const uint8_t* pbLast, uint32_t ulLen, uint32_t ulMergeGap,
+                                CIFX_IO_DELTA_SPAN_T* ptSpans, uint32_t ulMaxSpans);
+const char* cifXIODeltaImplName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_IO_DELTA__H */
@@ -34,8 +34,11 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 **************************************************************************************/
 
 #include "cifXToolkit.h"
+#include "cifXHWShadow.h"
 #include "cifXErrors.h"
 #include "cifXEndianess.h"
+#include "cifXCrc32.h"
+#include "cifXDigestCache.h"
 
 #include "Hil_Packet.h"
 #include "Hil_ModuleLoader.h"
@@ -75,6 +78,11 @@ static const CIFX_ENDIANESS_ENTRY_T s_atFWIdentifyConv[] =
 
 uint32_t g_ulTraceLevel = TRACE_LEVEL_ERROR;  /*!< Tracelevel used by the toolkit */
 
+/* The host side image of an I/O area is placed behind the instance, in the same allocation */
+#define IO_INSTANCE_ALLOC_SIZE(ulAreaLen) ((uint32_t)sizeof(IOINSTANCE) + (ulAreaLen) + CIFX_IO_IMAGE_ALIGN - 1)
+#define IO_INSTANCE_IMAGE(ptIoInst)       ((uint8_t*)(((uintptr_t)((ptIoInst) + 1) + CIFX_IO_IMAGE_ALIGN - 1) & \
+                                                      ~(uintptr_t)(CIFX_IO_IMAGE_ALIGN - 1)))
+
 /*****************************************************************************/
 /*!  \addtogroup CIFX_TOOLKIT_FUNCS cifX DPM Toolkit specific functions
 *    \{                                                                      */
@@ -106,6 +114,71 @@ void cifXTKitCyclicTimer(void)
   OS_LeaveLock(g_pvTkitLock);
 }
 
+/*****************************************************************************/
+/*! Create the buffer holding a file for download. With
+*   CIFX_TOOLKIT_FILE_MAP the file is mapped, no heap buffer of the file size
+*   is needed and the OS reads the file while it is hashed and transferred
+*   \param pvFile        File handle returned by OS_FileOpen
+*   \param ulFileLength  Length of the file
+*   \param pfMapped      Returned !=0 if the buffer is a mapping of the file
+*   \return buffer of ulFileLength bytes, NULL if out of memory             */
+/*****************************************************************************/
+void* cifXFileBufferCreate(void* pvFile, uint32_t ulFileLength, int* pfMapped)
+{
+  void* pvBuffer = NULL;
+
+#ifdef CIFX_TOOLKIT_FILE_MAP
+  pvBuffer = OS_FileMap(pvFile, ulFileLength);
+#else
+  (void)pvFile;
+#endif
+
+  *pfMapped = (NULL != pvBuffer);
+  if(NULL == pvBuffer)
+    pvBuffer = OS_Memalloc(ulFileLength);
+
+  return pvBuffer;
+}
+
+/*****************************************************************************/
+/*! Fill a buffer created by cifXFileBufferCreate with the file content
+*   \param pvFile        File handle returned by OS_FileOpen
+*   \param ulFileLength  Length of the file
+*   \param pvBuffer      Buffer from cifXFileBufferCreate
+*   \param fMapped       Mapping flag from cifXFileBufferCreate
+*   \return number of bytes read, ulFileLength on success                   */
+/*****************************************************************************/
+uint32_t cifXFileBufferRead(void* pvFile, uint32_t ulFileLength, void* pvBuffer, int fMapped)
+{
+  /* a mapped file is read on access */
+  if(fMapped)
+    return ulFileLength;
+
+  return OS_FileRead(pvFile, 0, ulFileLength, pvBuffer);
+}
+
+/*****************************************************************************/
+/*! Free a buffer created by cifXFileBufferCreate
+*   \param pvBuffer      Buffer from cifXFileBufferCreate
+*   \param ulFileLength  Length of the file
+*   \param fMapped       Mapping flag from cifXFileBufferCreate              */
+/*****************************************************************************/
+void cifXFileBufferFree(void* pvBuffer, uint32_t ulFileLength, int fMapped)
+{
+#ifdef CIFX_TOOLKIT_FILE_MAP
+  if(fMapped)
+  {
+    OS_FileUnmap(pvBuffer, ulFileLength);
+    return;
+  }
+#else
+  (void)ulFileLength;
+  (void)fMapped;
+#endif
+
+  OS_Memfree(pvBuffer);
+}
+
 /*****************************************************************************/
 /*! Delete a channel instance structure and all contained allocated data
 *   \param   ptChannelInst Channel instance to delete (will also be free'd)  */
@@ -164,6 +237,10 @@ static void cifXDeleteChannelInstance(PCHANNELINSTANCE ptChannelInst)
         /* Delete synchronisation object */
         OS_DeleteMutex(ptIoInst->pvMutex);
 
+        /* Delete data of the delta write mode */
+        if(NULL != ptIoInst->pbLastImage)
+          OS_Memfree(ptIoInst->pbLastImage);
+
         OS_Memfree(ptIoInst);
         ptChannelInst->pptIOOutputAreas[ulTemp] = NULL;
       }
@@ -457,7 +534,8 @@ static int32_t cifXRunBootloader(PDEVICEINSTANCE ptDevInstance)
   } else
   {
     /* Read bootloader file data */
-    uint8_t* pbBuffer = (uint8_t*)OS_Memalloc(ulFileSize);
+    int      fMapped  = 0;
+    uint8_t* pbBuffer = (uint8_t*)cifXFileBufferCreate(pvFile, ulFileSize, &fMapped);
 
     if(g_ulTraceLevel & TRACE_LEVEL_INFO)
     {
@@ -479,7 +557,7 @@ static int32_t cifXRunBootloader(PDEVICEINSTANCE ptDevInstance)
       }
     } else
     {
-      if(ulFileSize != OS_FileRead(pvFile, 0, ulFileSize, pbBuffer))
+      if(ulFileSize != cifXFileBufferRead(pvFile, ulFileSize, pbBuffer, fMapped))
       {
         lRet = CIFX_FILE_READ_ERROR;
 
@@ -600,7 +678,7 @@ static int32_t cifXRunBootloader(PDEVICEINSTANCE ptDevInstance)
       }
 
       /* Free file buffer */
-      OS_Memfree(pbBuffer);
+      cifXFileBufferFree(pbBuffer, ulFileSize, fMapped);
     }
 
     /* Close file */
@@ -753,7 +831,8 @@ static int32_t cifXHandleRAMBaseOSModule(PDEVICEINSTANCE ptDevInstance)
       /*-------------------------------------------------------*/
       /* Create local buffer and read the file into the buffer */
       /*-------------------------------------------------------*/
-      void* pbBuffer = OS_Memalloc(ulFileLength);
+      int   fMapped  = 0;
+      void* pbBuffer = cifXFileBufferCreate(pvFile, ulFileLength, &fMapped);
       if (NULL == pbBuffer)
       {
         lRet = CIFX_FILE_LOAD_INSUFF_MEM;
@@ -770,7 +849,7 @@ static int32_t cifXHandleRAMBaseOSModule(PDEVICEINSTANCE ptDevInstance)
         /*-------------------------------------------------------*/
         /* Read the file into the buffer                         */
         /*-------------------------------------------------------*/
-        if(ulFileLength != OS_FileRead(pvFile, 0, ulFileLength, pbBuffer))
+        if(ulFileLength != cifXFileBufferRead(pvFile, ulFileLength, pbBuffer, fMapped))
         {
           /* Error reading file */
           if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
@@ -892,7 +971,7 @@ static int32_t cifXHandleRAMBaseOSModule(PDEVICEINSTANCE ptDevInstance)
         }
 
         /* Free the file buffer */
-        OS_Memfree(pbBuffer);
+        cifXFileBufferFree(pbBuffer, ulFileLength, fMapped);
       }
 
       /* Close the file */
@@ -984,7 +1063,8 @@ static int32_t cifXHandleFlashBaseOSModule(PDEVICEINSTANCE ptDevInstance)
       /*-------------------------------------------------------*/
       /* Create local buffer and read the file into the buffer */
       /*-------------------------------------------------------*/
-      uint8_t* pbBuffer = (uint8_t*)OS_Memalloc(ulFileLength);
+      int      fMapped  = 0;
+      uint8_t* pbBuffer = (uint8_t*)cifXFileBufferCreate(pvFile, ulFileLength, &fMapped);
 
       if (NULL == pbBuffer)
       {
@@ -1002,7 +1082,7 @@ static int32_t cifXHandleFlashBaseOSModule(PDEVICEINSTANCE ptDevInstance)
         /*-------------------------------------------------------*/
         /* Read the file into the buffer                         */
         /*-------------------------------------------------------*/
-        if(ulFileLength != OS_FileRead(pvFile, 0, ulFileLength, pbBuffer))
+        if(ulFileLength != cifXFileBufferRead(pvFile, ulFileLength, pbBuffer, fMapped))
         {
           /* Error reading file */
           if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
@@ -1027,6 +1107,7 @@ static int32_t cifXHandleFlashBaseOSModule(PDEVICEINSTANCE ptDevInstance)
                                                               tFileInfo.szShortFileName,
                                                               pbBuffer,
                                                               ulFileLength,
+                                                              pvFile,
                                                               DEV_TransferPacket,
                                                               NULL,
                                                               NULL)))
@@ -1109,7 +1190,7 @@ static int32_t cifXHandleFlashBaseOSModule(PDEVICEINSTANCE ptDevInstance)
         } /*lint !e429 : pbBuffer not freed or returned */
 
         /* Free the file buffer */
-        OS_Memfree(pbBuffer);
+        cifXFileBufferFree(pbBuffer, ulFileLength, fMapped);
       }
 
       /* Close the file */
@@ -1202,7 +1283,8 @@ static int32_t cifXDownloadFWFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANNE
           /*-------------------------------------------------------*/
           /* Create local buffer and read the file into the buffer */
           /*-------------------------------------------------------*/
-          uint8_t* pbBuffer = (uint8_t*)OS_Memalloc(ulFileLength);
+          int      fMapped  = 0;
+          uint8_t* pbBuffer = (uint8_t*)cifXFileBufferCreate(pvFile, ulFileLength, &fMapped);
 
           if (NULL == pbBuffer)
           {
@@ -1220,7 +1302,7 @@ static int32_t cifXDownloadFWFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANNE
             /*-------------------------------------------------------*/
             /* Read the file into the buffer                         */
             /*-------------------------------------------------------*/
-            if(ulFileLength != OS_FileRead(pvFile, 0, ulFileLength, pbBuffer))
+            if(ulFileLength != cifXFileBufferRead(pvFile, ulFileLength, pbBuffer, fMapped))
             {
               /* Error reading file */
               if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
@@ -1236,6 +1318,7 @@ static int32_t cifXDownloadFWFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANNE
               if( CIFX_NO_ERROR == (lRet = DEV_ProcessFWDownload( ptDevInstance,
                                                                   ulChannel,
                                                                   tFileInfo.szFullFileName,
+                                                                  pvFile,
                                                                   tFileInfo.szShortFileName,
                                                                   ulFileLength,
                                                                   pbBuffer,
@@ -1277,7 +1360,7 @@ static int32_t cifXDownloadFWFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANNE
             }
 
             /* Free the file buffer */
-            OS_Memfree(pbBuffer);
+            cifXFileBufferFree(pbBuffer, ulFileLength, fMapped);
           }
 
           /* Close the file */
@@ -1371,7 +1454,8 @@ static int32_t cifXDownloadCNFFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANN
           /*-------------------------------------------------------*/
           /* Create local buffer and read the file into the buffer */
           /*-------------------------------------------------------*/
-          uint8_t*  pbBuffer = (uint8_t*)OS_Memalloc(ulFileLength);
+          int       fMapped  = 0;
+          uint8_t*  pbBuffer = (uint8_t*)cifXFileBufferCreate(pvFile, ulFileLength, &fMapped);
 
           if (NULL == pbBuffer)
           {
@@ -1389,7 +1473,7 @@ static int32_t cifXDownloadCNFFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANN
             /*-------------------------------------------------------*/
             /* Read the file into the buffer                         */
             /*-------------------------------------------------------*/
-            if( ulFileLength != OS_FileRead(pvFile, 0, ulFileLength, pbBuffer))
+            if( ulFileLength != cifXFileBufferRead(pvFile, ulFileLength, pbBuffer, fMapped))
             {
               /* Error reading file */
               if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
@@ -1409,6 +1493,7 @@ static int32_t cifXDownloadCNFFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANN
                                                                   tFileInfo.szShortFileName,
                                                                   pbBuffer,
                                                                   ulFileLength,
+                                                                  pvFile,
                                                                   DEV_TransferPacket,
                                                                   NULL,
                                                                   NULL)))
@@ -1471,7 +1556,7 @@ static int32_t cifXDownloadCNFFiles(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANN
             }
 
             /* Free the file buffer */
-            OS_Memfree(pbBuffer);
+            cifXFileBufferFree(pbBuffer, ulFileLength, fMapped);
           }
 
           /* Close the file */
@@ -2368,7 +2453,7 @@ static int32_t cifXReadChannelLayout(PDEVICEINSTANCE ptDevInstance, PCHANNELINST
             /* Output Data image */
             case HIL_DIRECTION_OUT:
             {
-              PIOINSTANCE ptIOOutputInstance = (PIOINSTANCE)OS_Memalloc(sizeof(*ptIOOutputInstance));
+              PIOINSTANCE ptIOOutputInstance = (PIOINSTANCE)OS_Memalloc(IO_INSTANCE_ALLOC_SIZE(LE32_TO_HOST(tRecvPkt.tData.ulSize)));
               void*       pvMutex            = NULL;
 
               if (NULL == ptIOOutputInstance           ||
@@ -2396,6 +2481,8 @@ static int32_t cifXReadChannelLayout(PDEVICEINSTANCE ptDevInstance, PCHANNELINST
                 ptIOOutputInstance->ulDPMAreaLength = LE32_TO_HOST(tRecvPkt.tData.ulSize);
                 ptIOOutputInstance->bHandshakeBit   = (uint8_t)LE16_TO_HOST(tRecvPkt.tData.usHandshakeBit);
                 ptIOOutputInstance->usHandshakeMode = LE16_TO_HOST(tRecvPkt.tData.usHandshakeMode);
+                ptIOOutputInstance->pbHostImage     = IO_INSTANCE_IMAGE(ptIOOutputInstance);
+                OS_Memset(ptIOOutputInstance->pbHostImage, 0, ptIOOutputInstance->ulDPMAreaLength);
 
                 if((LE32_TO_HOST(tRecvPkt.tData.ulType) & HIL_BLOCK_MASK) == HIL_BLOCK_DATA_IMAGE)
                   ptIOOutputInstance->ulNotifyEvent = CIFX_NOTIFY_PD0_OUT;
@@ -2458,7 +2545,7 @@ static int32_t cifXReadChannelLayout(PDEVICEINSTANCE ptDevInstance, PCHANNELINST
             /* Input Data image          */
             case HIL_DIRECTION_IN:
             {
-              PIOINSTANCE ptIOInputInstance = (PIOINSTANCE)OS_Memalloc(sizeof(*ptIOInputInstance));
+              PIOINSTANCE ptIOInputInstance = (PIOINSTANCE)OS_Memalloc(IO_INSTANCE_ALLOC_SIZE(LE32_TO_HOST(tRecvPkt.tData.ulSize)));
               void*       pvMutex           = NULL;
 
               if (NULL == ptIOInputInstance            ||
@@ -2486,6 +2573,8 @@ static int32_t cifXReadChannelLayout(PDEVICEINSTANCE ptDevInstance, PCHANNELINST
                 ptIOInputInstance->ulDPMAreaLength = LE32_TO_HOST(tRecvPkt.tData.ulSize);
                 ptIOInputInstance->bHandshakeBit   = (uint8_t)LE16_TO_HOST(tRecvPkt.tData.usHandshakeBit);
                 ptIOInputInstance->usHandshakeMode = LE16_TO_HOST(tRecvPkt.tData.usHandshakeMode);
+                ptIOInputInstance->pbHostImage     = IO_INSTANCE_IMAGE(ptIOInputInstance);
+                OS_Memset(ptIOInputInstance->pbHostImage, 0, ptIOInputInstance->ulDPMAreaLength);
 
                 if((LE32_TO_HOST(tRecvPkt.tData.ulType) & HIL_BLOCK_MASK) == HIL_BLOCK_DATA_IMAGE)
                   ptIOInputInstance->ulNotifyEvent = CIFX_NOTIFY_PD0_IN;
@@ -3174,6 +3263,11 @@ static int32_t cifXCreateChannels(PDEVICEINSTANCE ptDevInstance, PDEVICE_CHANNEL
             {
               ptDevInstance->pptCommChannels[ptDevInstance->ulCommChannelCount - 1] = ptChannelInst;
 
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+              /* Without a shadow the channel is accessed directly, which is only slower */
+              (void)HwIfShadowAddChannel(ptDevInstance, ptChannelInst);
+#endif
+
               /* Check ready again including COS flag handling, because we have to handle the COS flags */
               /* If a module firmware was loaded we are waiting before on the channel ready. */
               /* If we have not downloaded a firmware / module we skipping the prior test but we have to */
@@ -3704,6 +3798,21 @@ static int32_t cifXEvaluateDeviceType(PDEVICEINSTANCE ptDevInstance)
   return lRet;
 }
 
+/*****************************************************************************/
+/*! Account the time since the end of the previous start-up phase
+*   \param pulPhaseMs Phase duration to add to
+*   \param ulLastMs   End of the previous phase
+*   \return End of this phase                                                */
+/*****************************************************************************/
+static uint32_t cifXStartupPhase(uint32_t* pulPhaseMs, uint32_t ulLastMs)
+{
+  uint32_t ulNowMs = OS_GetMilliSecCounter();
+
+  *pulPhaseMs += ulNowMs - ulLastMs;
+
+  return ulNowMs;
+}
+
 /*****************************************************************************/
 /*! Basic netX device start-up
 *   \param ptDevInstance Instance to start up
@@ -3711,8 +3820,10 @@ static int32_t cifXEvaluateDeviceType(PDEVICEINSTANCE ptDevInstance)
 /*****************************************************************************/
 static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
 {
-  int32_t               lRet            = CIFX_DRV_INIT_STATE_ERROR;
-  DEVICE_CHANNEL_CONFIG tDevChannelCfg;
+  int32_t                     lRet            = CIFX_DRV_INIT_STATE_ERROR;
+  DEVICE_CHANNEL_CONFIG       tDevChannelCfg;
+  CIFX_DEVICE_STARTUP_TIME_T* ptTime          = &ptDevInstance->tStartupTime;
+  uint32_t                    ulLastMs        = OS_GetMilliSecCounter();
 
   OS_Memset(&tDevChannelCfg, 0, sizeof(tDevChannelCfg));
 
@@ -3739,7 +3850,7 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
       /* Perform check at DPM start */
       cifXDetectChipType(ptDevInstance, 0);
     }
-
+    ulLastMs = cifXStartupPhase(&ptTime->ulDetectMs, ulLastMs);
 
 
     switch(ptDevInstance->eDeviceType)
@@ -3756,6 +3867,8 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
              Toolkit even if firmware startup fails (e.g. Wrong firmware for this card) */
           int32_t lTempResult;
 
+          ulLastMs = cifXStartupPhase(&ptTime->ulBootMs, ulLastMs);
+
           /* Check if we have a BASE OS system to download and to start*/
           lTempResult = cifXHandleRAMBaseOSModule( ptDevInstance);
           if( CIFX_NO_ERROR == lTempResult)
@@ -3768,10 +3881,12 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
 
             /* Download configuration files */
             (void)cifXDownloadCNFFiles(ptDevInstance, &tDevChannelCfg);
+            ulLastMs = cifXStartupPhase(&ptTime->ulDownloadMs, ulLastMs);
 
             /* Start firmware / module files if necessary */
             lTempResult = cifXStartRAMFirmware(ptDevInstance, &tDevChannelCfg);
           }
+          ulLastMs = cifXStartupPhase(&ptTime->ulFirmwareMs, ulLastMs);
 
           /* Only enter our error if no function already inserted one. Readout of channel
              Information may already have inserted an error */
@@ -3808,6 +3923,8 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
              Toolkit even if firmware startup fails (e.g. Wrong firmware for this card) */
           int32_t lTempResult;
 
+          ulLastMs = cifXStartupPhase(&ptTime->ulBootMs, ulLastMs);
+
           /* Check if we have a BASE OS system to download and to start*/
           lTempResult = cifXHandleFlashBaseOSModule( ptDevInstance);
           if( CIFX_NO_ERROR == lTempResult)
@@ -3820,10 +3937,12 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
 
             /* Download configuration files */
             (void)cifXDownloadCNFFiles(ptDevInstance, &tDevChannelCfg);
+            ulLastMs = cifXStartupPhase(&ptTime->ulDownloadMs, ulLastMs);
 
             /* Start firmware / module files if necessary */
             lTempResult = cifXStartFlashFirmware(ptDevInstance, &tDevChannelCfg);
           }
+          ulLastMs = cifXStartupPhase(&ptTime->ulFirmwareMs, ulLastMs);
 
           /* Only enter our error if no function already inserted one. Readout of channel
              Information may already have inserted an error */
@@ -3849,6 +3968,9 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
     }
   }
 
+  /* Start of devices without download handling (or failed start) */
+  ulLastMs = cifXStartupPhase(&ptTime->ulBootMs, ulLastMs);
+
   if(CIFX_NO_ERROR == lRet)
   {
     HIL_DPM_SYSTEM_CHANNEL_T* ptSysChannel = (HIL_DPM_SYSTEM_CHANNEL_T*)ptDevInstance->tSystemDevice.pbDPMChannelStart;
@@ -3918,6 +4040,8 @@ static int32_t cifXStartDevice(PDEVICEINSTANCE ptDevInstance)
   if(CIFX_NO_ERROR != lRet)
     ptDevInstance->lInitError = lRet;
 
+  (void)cifXStartupPhase(&ptTime->ulChannelsMs, ulLastMs);
+
   return lRet;
 }
 
@@ -3934,6 +4058,11 @@ static int32_t cifXStopDevice(PDEVICEINSTANCE ptDevInstance)
   uint32_t         ulIdx          = 0;
   PCHANNELINSTANCE ptSystemDevice = &ptDevInstance->tSystemDevice;
 
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+  /* Write back pending data and access DPM directly again */
+  HwIfShadowDelete(ptDevInstance);
+#endif
+
   /* Process all created communication channels */
   for(ulIdx = 0; ulIdx < ptDevInstance->ulCommChannelCount; ++ulIdx)
   {
@@ -4103,18 +4232,13 @@ void cifXTKitDisableHWInterrupt(PDEVICEINSTANCE ptDevInstance)
 }
 
 /*****************************************************************************/
-/*! Adds a newly found device to the list of handled device
-*   \param ptDevInstance Device to add (must at least include the pointer to
-*                        the DPM)
+/*! Check the device instance passed to the add device functions
+*   \param ptDevInstance Device to add
 *   \return CIFX_NO_ERROR on success                                         */
 /*****************************************************************************/
-int32_t cifXTKitAddDevice(PDEVICEINSTANCE ptDevInstance)
+static int32_t cifXCheckDevice(PDEVICEINSTANCE ptDevInstance)
 {
-  int32_t lRet;
-
-  /* Check if we have a pointer */
-  if(NULL == ptDevInstance)
-    return CIFX_INVALID_POINTER;
+  int32_t lRet = CIFX_NO_ERROR;
 
   /* Disable interrupts during startup phase. Just in case the user has set this flag! */
   ptDevInstance->fIrqEnabled = 0;
@@ -4131,61 +4255,237 @@ int32_t cifXTKitAddDevice(PDEVICEINSTANCE ptDevInstance)
   if( ptDevInstance->fPCICard)
   {
     /* Check DMA buffer configuration */
-    if(CIFX_NO_ERROR != (lRet = cifXTKitCheckDMABufferConfig( ptDevInstance)))
-      return lRet;
+    lRet = cifXTKitCheckDMABufferConfig( ptDevInstance);
   }
 #endif
 
-  /* Run the toolkit start device functions */
-  lRet = cifXStartDevice(ptDevInstance);
-  if(CIFX_NO_ERROR == lRet)
-  {
-    /* Lock tkit global data access against reentrancy*/
-    OS_EnterLock(g_pvTkitLock);
+  /* Start-up timing of this add request */
+  OS_Memset(&ptDevInstance->tStartupTime, 0, sizeof(ptDevInstance->tStartupTime));
+  ptDevInstance->tStartupTime.ulStartMs = OS_GetMilliSecCounter();
 
-    /* Increment device count */
-    ++g_ulDeviceCount;
+  return lRet;
+}
 
-    /* Create new list entry */
-    g_pptDevices = (PDEVICEINSTANCE*)OS_Memrealloc(g_pptDevices, g_ulDeviceCount * (uint32_t)sizeof(*g_pptDevices));
+/*****************************************************************************/
+/*! Enter a started device into the device list. This is the only part of
+*   the device start-up that is serialized against other devices.
+*   \param ptDevInstance Started device
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t cifXRegisterDevice(PDEVICEINSTANCE ptDevInstance)
+{
+  int32_t  lRet      = CIFX_NO_ERROR;
+  uint32_t ulStartMs = OS_GetMilliSecCounter();
 
-    if (NULL == g_pptDevices)
+  /* Lock tkit global data access against reentrancy*/
+  OS_EnterLock(g_pvTkitLock);
+
+  /* Increment device count */
+  ++g_ulDeviceCount;
+
+  /* Create new list entry */
+  g_pptDevices = (PDEVICEINSTANCE*)OS_Memrealloc(g_pptDevices, g_ulDeviceCount * (uint32_t)sizeof(*g_pptDevices));
+
+  if (NULL == g_pptDevices)
+  {
+    lRet = CIFX_INVALID_POINTER;
+
+    if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
     {
-      lRet = CIFX_INVALID_POINTER;
+      USER_Trace(ptDevInstance,
+                TRACE_LEVEL_ERROR,
+                "Error creating device list buffer!");
+    }
 
-      if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
-      {
-        USER_Trace(ptDevInstance,
-                  TRACE_LEVEL_ERROR,
-                  "Error creating device list buffer!");
-      }
+  } else
+  {
+    /* Add the new entry to the device list */
+    g_pptDevices[g_ulDeviceCount - 1] = ptDevInstance;
 
-    } else
+    /* Setup interrupts if as given during cifXStartDevice() */
+    if(0 != (ptDevInstance->fIrqEnabled))
     {
-      /* Add the new entry to the device list */
-      g_pptDevices[g_ulDeviceCount - 1] = ptDevInstance;
+      /* Perform a dummy interrupt cycle to get handshake flags in Sync for proper operation */
+      if(CIFX_TKIT_IRQ_DSR_REQUESTED == cifXTKitISRHandler(ptDevInstance, 1))
+        cifXTKitDSRHandler(ptDevInstance);
 
-      /* Setup interrupts if as given during cifXStartDevice() */
-      if(0 != (ptDevInstance->fIrqEnabled))
+#ifndef CIFX_TOOLKIT_MANUAL_IRQ_ENABLE
+      if(CIFX_NO_ERROR != OS_EnableInterrupts(ptDevInstance->pvOSDependent))
       {
-        /* Perform a dummy interrupt cycle to get handshake flags in Sync for proper operation */
-        if(CIFX_TKIT_IRQ_DSR_REQUESTED == cifXTKitISRHandler(ptDevInstance, 1))
-          cifXTKitDSRHandler(ptDevInstance);
+        /* No interrupt delivery, fall back to polling mode */
+        ptDevInstance->fIrqEnabled = 0;
 
-#ifndef CIFX_TOOLKIT_MANUAL_IRQ_ENABLE
-        OS_EnableInterrupts(ptDevInstance->pvOSDependent);
+        if(g_ulTraceLevel & TRACE_LEVEL_WARNING)
+        {
+          USER_Trace(ptDevInstance,
+                    TRACE_LEVEL_WARNING,
+                    "Enabling interrupts failed, device is used in polling mode!");
+        }
+      } else
+      {
         cifXTKitEnableHWInterrupt(ptDevInstance);
-#endif /* CIFX_TOOLKIT_MANUAL_IRQ_ENABLE */
       }
+#endif /* CIFX_TOOLKIT_MANUAL_IRQ_ENABLE */
     }
+  }
 
-    /* Done with the initialisation */
-    OS_LeaveLock(g_pvTkitLock);
+  /* Done with the initialisation */
+  OS_LeaveLock(g_pvTkitLock);
+
+  ptDevInstance->tStartupTime.ulRegisterMs = OS_GetMilliSecCounter() - ulStartMs;
+
+  return lRet;
+}
+
+/*****************************************************************************/
+/*! Start a device and enter it into the device list
+*   \param ptDevInstance Checked device
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+static int32_t cifXStartAndRegisterDevice(PDEVICEINSTANCE ptDevInstance)
+{
+  /* Run the toolkit start device functions */
+  int32_t lRet = cifXStartDevice(ptDevInstance);
+
+  if(CIFX_NO_ERROR == lRet)
+    lRet = cifXRegisterDevice(ptDevInstance);
+
+  ptDevInstance->tStartupTime.ulTotalMs = OS_GetMilliSecCounter() - ptDevInstance->tStartupTime.ulStartMs;
+
+  if(g_ulTraceLevel & TRACE_LEVEL_DEBUG)
+  {
+    CIFX_DEVICE_STARTUP_TIME_T* ptTime = &ptDevInstance->tStartupTime;
+
+    USER_Trace(ptDevInstance,
+              TRACE_LEVEL_DEBUG,
+              "Device start-up took %u ms (detect %u, boot %u, download %u, firmware %u, channels %u, register %u), lRet=0x%08X",
+              (unsigned int)ptTime->ulTotalMs,
+              (unsigned int)ptTime->ulDetectMs,
+              (unsigned int)ptTime->ulBootMs,
+              (unsigned int)ptTime->ulDownloadMs,
+              (unsigned int)ptTime->ulFirmwareMs,
+              (unsigned int)ptTime->ulChannelsMs,
+              (unsigned int)ptTime->ulRegisterMs,
+              (unsigned int)lRet);
   }
 
   return lRet;
 }
 
+/*****************************************************************************/
+/*! Adds a newly found device to the list of handled device
+*   \param ptDevInstance Device to add (must at least include the pointer to
+*                        the DPM)
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t cifXTKitAddDevice(PDEVICEINSTANCE ptDevInstance)
+{
+  int32_t lRet;
+
+  /* Check if we have a pointer */
+  if(NULL == ptDevInstance)
+    return CIFX_INVALID_POINTER;
+
+  if(CIFX_NO_ERROR != (lRet = cifXCheckDevice(ptDevInstance)))
+    return lRet;
+
+  return cifXStartAndRegisterDevice(ptDevInstance);
+}
+
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+/*****************************************************************************/
+/*! Worker of cifXTKitAddDeviceAsync
+*   \param pvAdd Add request (CIFX_ADD_DEVICE_T)                             */
+/*****************************************************************************/
+static void cifXAddDeviceWorker(void* pvAdd)
+{
+  CIFX_ADD_DEVICE_T* ptAdd = (CIFX_ADD_DEVICE_T*)pvAdd;
+
+  ptAdd->lResult = cifXStartAndRegisterDevice(ptAdd->ptDevInstance);
+
+  OS_SetEvent(ptAdd->pvDoneEvent);
+}
+
+/*****************************************************************************/
+/*! Adds a newly found device like cifXTKitAddDevice, but runs the start-up
+*   (reset, bootloader, downloads, firmware start, channel creation) on a
+*   worker thread of its own. Several devices started this way boot in
+*   parallel, only the entry into the device list is serialized. Devices
+*   are therefore listed in the order their start-up completes.
+*   Every successful call must be completed by cifXTKitAddDeviceWait before
+*   the device instance or the request is released and before
+*   cifXTKitDeinit is called.
+*   \param ptDevInstance Device to add (must at least include the pointer to
+*                        the DPM)
+*   \param ptAdd         Request, must stay valid until the start-up has
+*                        been waited for
+*   \return CIFX_NO_ERROR if the start-up is running                         */
+/*****************************************************************************/
+int32_t cifXTKitAddDeviceAsync(PDEVICEINSTANCE ptDevInstance, CIFX_ADD_DEVICE_T* ptAdd)
+{
+  int32_t lRet;
+
+  /* Check if we have a pointer */
+  if( (NULL == ptDevInstance) ||
+      (NULL == ptAdd)          )
+    return CIFX_INVALID_POINTER;
+
+  OS_Memset(ptAdd, 0, sizeof(*ptAdd));
+  ptAdd->ptDevInstance = ptDevInstance;
+  ptAdd->lResult       = CIFX_DRV_INIT_STATE_ERROR;
+
+  if(CIFX_NO_ERROR != (lRet = cifXCheckDevice(ptDevInstance)))
+    return lRet;
+
+  if(NULL == (ptAdd->pvDoneEvent = OS_CreateEvent()))
+    return CIFX_FUNCTION_FAILED;
+
+  if(NULL == (ptAdd->pvThread = OS_CreateThread(cifXAddDeviceWorker, ptAdd)))
+  {
+    if(g_ulTraceLevel & TRACE_LEVEL_ERROR)
+    {
+      USER_Trace(ptDevInstance,
+                TRACE_LEVEL_ERROR,
+                "Error creating device start-up thread!");
+    }
+
+    OS_DeleteEvent(ptAdd->pvDoneEvent);
+    ptAdd->pvDoneEvent = NULL;
+    return CIFX_FUNCTION_FAILED;
+  }
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Wait for the completion of a cifXTKitAddDeviceAsync request. The request
+*   may be waited for repeatedly until it has completed.
+*   \param ptAdd     Request started by cifXTKitAddDeviceAsync
+*   \param ulTimeout Timeout in ms to wait for the completion
+*   \return CIFX_DRV_CMD_ACTIVE if the start-up is still running, otherwise
+*           the result cifXTKitAddDevice would have returned                 */
+/*****************************************************************************/
+int32_t cifXTKitAddDeviceWait(CIFX_ADD_DEVICE_T* ptAdd, uint32_t ulTimeout)
+{
+  if(NULL == ptAdd)
+    return CIFX_INVALID_POINTER;
+
+  /* Already completed */
+  if(NULL == ptAdd->pvThread)
+    return ptAdd->lResult;
+
+  if(CIFX_EVENT_SIGNALLED != OS_WaitEvent(ptAdd->pvDoneEvent, ulTimeout))
+    return CIFX_DRV_CMD_ACTIVE;
+
+  OS_DeleteThread(ptAdd->pvThread);
+  OS_DeleteEvent(ptAdd->pvDoneEvent);
+  ptAdd->pvThread    = NULL;
+  ptAdd->pvDoneEvent = NULL;
+
+  return ptAdd->lResult;
+}
+#endif /* CIFX_TOOLKIT_ASYNC_ADD */
+
 /*****************************************************************************/
 /*! This functions removes a device from being handled by the toolkit.
 *   \param szBoard        Name or Alias of the board to remove
@@ -4285,6 +4585,9 @@ int32_t cifXTKitInit( void)
   /* Initialize OS functions */
   lRet = OS_Init();
 
+  /* Select the CRC32 implementation before any download can run */
+  cifXCrc32Init();
+
   /* Create toolkit lock, signal toolkit initialization */
   if(CIFX_NO_ERROR == lRet)
   {
@@ -4297,6 +4600,11 @@ int32_t cifXTKitInit( void)
       OS_Deinit();
     } else
     {
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+      /* Without a cache file the download files are hashed and checked on the device as usual */
+      (void)cifXDigestCacheInit(CIFX_TOOLKIT_DIGEST_CACHE_FILE);
+#endif
+
       /* Toolkit successfully initialized */
       g_tDriverInfo.fInitialized = 1;
     }
@@ -4336,6 +4644,10 @@ void cifXTKitDeinit( void)
     g_pvTkitLock = NULL;
   }
 
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+  cifXDigestCacheDeinit();
+#endif
+
   /* Uninitialize OS functions */
   OS_Deinit();
 
@@ -20,6 +20,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #include "cifXHWFunctions.h"
 #include "cifXErrors.h"
 #include "cifXEndianess.h"
+#include "cifXStats.h"
 
 /*****************************************************************************/
 /*!  \addtogroup CIFX_TOOLKIT_FUNCS cifX DPM Toolkit specific functions
@@ -360,6 +361,7 @@ void cifXTKitDSRHandler(PDEVICEINSTANCE ptDevInstance)
             {
               ptChannel->ulDeviceCOSFlagsChanged  = ptChannel->ulDeviceCOSFlags ^ ulNewCOSFlags;
               ptChannel->ulDeviceCOSFlags         = ulNewCOSFlags;
+              CIFX_STATS_COS(ptChannel);
             }
 
             DEV_ToggleBit(ptChannel, HCF_NETX_COS_ACK);
@@ -462,6 +464,7 @@ void cifXTKitDSRHandler(PDEVICEINSTANCE ptDevInstance)
             {
               ptChannel->ulDeviceCOSFlagsChanged  = ptChannel->ulDeviceCOSFlags ^ ulNewCOSFlags;
               ptChannel->ulDeviceCOSFlags         = ulNewCOSFlags;
+              CIFX_STATS_COS(ptChannel);
             }
 
             DEV_ToggleBit(ptChannel, HSF_NETX_COS_ACK);
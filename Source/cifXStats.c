@@ -0,0 +1,149 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXStats.c
+ * @brief          :  Per channel timing statistics of the cifX I/O path
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXStats.c
+*    Recording of the channel statistics. All functions are called from the
+*    measured toolkit functions through the CIFX_STATS_xxx macros and only
+*    touch the statistic blocks attached by the user.                        */
+/*****************************************************************************/
+
+#include "cifXToolkit.h"
+#include "cifXErrors.h"
+#include "cifXStats.h"
+
+#ifdef CIFX_TOOLKIT_STATS
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Remembers the start of a measured call
+*   \param ptChannel  Channel instance
+*   \param ptSample   Sample to initialize                                   */
+/*****************************************************************************/
+void cifXStatsBegin(PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample)
+{
+  PDEVICEINSTANCE ptDevInstance = (PDEVICEINSTANCE)ptChannel->pvDeviceInstance;
+
+  if(NULL == ptChannel->ptStats)
+    return;
+
+  ptSample->ullStartNs = OS_GetNanoSecCounter();
+  ptSample->ullFrames  = (NULL != ptDevInstance->ptStats) ? ptDevInstance->ptStats->ullHwIfFrames : 0;
+}
+
+/*****************************************************************************/
+/*! Records a finished I/O call. The frame count includes mailbox transfers
+*   of other threads that got the interface in between.
+*   \param ptChannel  Channel instance
+*   \param ptSample   Sample passed to cifXStatsBegin
+*   \param eType      Type of the I/O call
+*   \param ulBytes    Process data bytes transferred
+*   \param lRet       Return value of the call                               */
+/*****************************************************************************/
+void cifXStatsIO(PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, CIFX_STATS_IO_E eType, uint32_t ulBytes, int32_t lRet)
+{
+  CIFX_CHANNEL_STATS_T* ptStats       = ptChannel->ptStats;
+  PDEVICEINSTANCE       ptDevInstance = (PDEVICEINSTANCE)ptChannel->pvDeviceInstance;
+  uint64_t              ullDuration;
+
+  if(NULL == ptStats)
+    return;
+
+  ullDuration = OS_GetNanoSecCounter() - ptSample->ullStartNs;
+
+  switch(eType)
+  {
+    case eCIFX_STATS_IO_READ:
+      latency_hist_record(&ptStats->tIORead, ullDuration);
+      ++ptStats->ulIOReadCalls;
+      break;
+
+    case eCIFX_STATS_IO_WRITE:
+      latency_hist_record(&ptStats->tIOWrite, ullDuration);
+      ++ptStats->ulIOWriteCalls;
+      break;
+
+    case eCIFX_STATS_IO_EXCHANGE:
+    default:
+      latency_hist_record(&ptStats->tIOExchange, ullDuration);
+      ++ptStats->ulIOExchangeCalls;
+      break;
+  }
+
+  if(NULL != ptDevInstance->ptStats)
+    latency_hist_record(&ptStats->tIOFrames, ptDevInstance->ptStats->ullHwIfFrames - ptSample->ullFrames);
+
+  if( (CIFX_NO_ERROR == lRet) || (CIFX_DEV_NO_COM_FLAG == lRet) )
+    ptStats->ullIOBytes += ulBytes;
+  else
+    ++ptStats->ulIOErrors;
+}
+
+/*****************************************************************************/
+/*! Records a finished mailbox access
+*   \param ptChannel  Channel instance
+*   \param ptSample   Sample passed to cifXStatsBegin
+*   \param fPut       !=0 for DEV_PutPacket, 0 for DEV_GetPacket
+*   \param lRet       Return value of the call                               */
+/*****************************************************************************/
+void cifXStatsMailbox(PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, int fPut, int32_t lRet)
+{
+  CIFX_CHANNEL_STATS_T* ptStats = ptChannel->ptStats;
+
+  if(NULL == ptStats)
+    return;
+
+  if(CIFX_NO_ERROR != lRet)
+  {
+    /* Failed accesses only count, a timeout would swamp the histogram */
+    ++ptStats->ulMbxErrors;
+  } else if(fPut)
+  {
+    latency_hist_record(&ptStats->tPutPacket, OS_GetNanoSecCounter() - ptSample->ullStartNs);
+    ++ptStats->ulPutPackets;
+  } else
+  {
+    latency_hist_record(&ptStats->tGetPacket, OS_GetNanoSecCounter() - ptSample->ullStartNs);
+    ++ptStats->ulGetPackets;
+  }
+}
+
+/*****************************************************************************/
+/*! Records a finished handshake bit wait
+*   \param ptChannel    Channel instance
+*   \param ptSample     Sample passed to cifXStatsBegin
+*   \param ulBitNumber  Handshake bit waited for
+*   \param fSuccess     !=0 if the bit reached the expected state            */
+/*****************************************************************************/
+void cifXStatsHskWait(PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, uint32_t ulBitNumber, int fSuccess)
+{
+  CIFX_CHANNEL_STATS_T* ptStats = ptChannel->ptStats;
+
+  if( (NULL == ptStats) || (ulBitNumber >= HIL_DPM_HANDSHAKE_PAIRS) )
+    return;
+
+  if(fSuccess)
+    latency_hist_record(&ptStats->atHskWait[ulBitNumber], OS_GetNanoSecCounter() - ptSample->ullStartNs);
+  else
+    ++ptStats->aulHskTimeouts[ulBitNumber];
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#endif /* CIFX_TOOLKIT_STATS */
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXStats.h
+ * @brief          :  Per channel timing statistics of the cifX I/O path
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXStats.h
+*    Lock-free timing statistics of I/O, mailbox and handshake accesses,
+*    enabled by CIFX_TOOLKIT_STATS. The toolkit never allocates the blocks,
+*    the user attaches them (e.g. in shared memory) by setting ptStats of
+*    the device and channel instances. Nothing is recorded while ptStats is
+*    NULL.                                                                   */
+/*****************************************************************************/
+
+#ifndef CIFX_STATS__H
+#define CIFX_STATS__H
+
+#include "cifXHWFunctions.h"
+#include "latency_hist.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_STRUCTURE Toolkit Structure Definitions
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Hardware interface counters of a device. Only updated while the
+*   interface lock (OS_SpiLock) is held, so every thread may cause updates.  */
+/*****************************************************************************/
+typedef struct CIFX_DEVICE_STATS_Ttag
+{
+  uint64_t ullHwIfFrames;         /*!< Bus transactions (serial DPM: chip select frames)      */
+  uint64_t ullHwIfBytes;          /*!< DPM bytes transferred, without command headers         */
+} CIFX_DEVICE_STATS_T;
+
+/*****************************************************************************/
+/*! Statistics of a channel. Plain data, so the block can live in shared
+*   memory. Each group has a single writer: the I/O caller writes the I/O
+*   fields, the mailbox caller the mailbox fields, the handshake wait of a
+*   bit is written by whoever owns that bit and COS changes are counted
+*   under the channel lock. Readers see every counter consistently but not
+*   necessarily all counters of the same call.                               */
+/*****************************************************************************/
+typedef struct CIFX_CHANNEL_STATS_Ttag
+{
+  uint32_t       ulIOReadCalls;     /*!< Completed xChannelIORead calls                       */
+  uint32_t       ulIOWriteCalls;    /*!< Completed xChannelIOWrite calls                      */
+  uint32_t       ulIOExchangeCalls; /*!< Completed xChannelIOExchange calls (fast path only)  */
+  uint32_t       ulIOErrors;        /*!< I/O calls returning an error other than NO_COM_FLAG  */
+  uint64_t       ullIOBytes;        /*!< Process data bytes read and written                  */
+
+  uint32_t       ulPutPackets;      /*!< Packets sent (DEV_PutPacket)                         */
+  uint32_t       ulGetPackets;      /*!< Packets received (DEV_GetPacket)                     */
+  uint32_t       ulMbxErrors;       /*!< Mailbox accesses that failed or timed out            */
+
+  uint32_t       ulCOSChanges;      /*!< Changes of the device COS flags                      */
+
+  latency_hist_t tIORead;           /*!< Duration of xChannelIORead in ns                     */
+  latency_hist_t tIOWrite;          /*!< Duration of xChannelIOWrite in ns                    */
+  latency_hist_t tIOExchange;       /*!< Duration of xChannelIOExchange in ns                 */
+  latency_hist_t tIOFrames;         /*!< Hardware interface frames per I/O call (count, not ns) */
+  latency_hist_t tPutPacket;        /*!< Duration of DEV_PutPacket in ns                      */
+  latency_hist_t tGetPacket;        /*!< Duration of DEV_GetPacket in ns                      */
+
+  uint32_t       aulHskTimeouts[HIL_DPM_HANDSHAKE_PAIRS];  /*!< Failed waits per handshake bit     */
+  latency_hist_t atHskWait[HIL_DPM_HANDSHAKE_PAIRS];       /*!< DEV_WaitForBitState per bit in ns  */
+} CIFX_CHANNEL_STATS_T;
+
+/*****************************************************************************/
+/*! Start of a measured call                                                 */
+/*****************************************************************************/
+typedef struct CIFX_STATS_SAMPLE_Ttag
+{
+  uint64_t ullStartNs;            /*!< OS_GetNanoSecCounter at the start of the call          */
+  uint64_t ullFrames;             /*!< Hardware interface frames of the device at the start   */
+} CIFX_STATS_SAMPLE_T;
+
+/*****************************************************************************/
+/*! I/O call types                                                           */
+/*****************************************************************************/
+typedef enum CIFX_STATS_IO_Etag
+{
+  eCIFX_STATS_IO_READ,
+  eCIFX_STATS_IO_WRITE,
+  eCIFX_STATS_IO_EXCHANGE
+} CIFX_STATS_IO_E;
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#ifdef CIFX_TOOLKIT_STATS
+  void cifXStatsBegin   (PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample);
+  void cifXStatsIO      (PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, CIFX_STATS_IO_E eType, uint32_t ulBytes, int32_t lRet);
+  void cifXStatsMailbox (PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, int fPut, int32_t lRet);
+  void cifXStatsHskWait (PCHANNELINSTANCE ptChannel, CIFX_STATS_SAMPLE_T* ptSample, uint32_t ulBitNumber, int fSuccess);
+
+  #define CIFX_STATS_SAMPLE(tSample)                            CIFX_STATS_SAMPLE_T tSample
+  #define CIFX_STATS_BEGIN(ptChannel, tSample)                  cifXStatsBegin(ptChannel, &(tSample))
+  #define CIFX_STATS_IO(ptChannel, tSample, eType, ulBytes, lRet) cifXStatsIO(ptChannel, &(tSample), eType, ulBytes, lRet)
+  #define CIFX_STATS_MAILBOX(ptChannel, tSample, fPut, lRet)    cifXStatsMailbox(ptChannel, &(tSample), fPut, lRet)
+  #define CIFX_STATS_HSKWAIT(ptChannel, tSample, ulBit, fOk)    cifXStatsHskWait(ptChannel, &(tSample), ulBit, fOk)
+  #define CIFX_STATS_COS(ptChannel)                             do { if(NULL != (ptChannel)->ptStats) \
+                                                                  ++(ptChannel)->ptStats->ulCOSChanges; } while(0)
+  #define CIFX_STATS_HWIF_FRAME(ptDev, ulBytes)                 do { if(NULL != (ptDev)->ptStats) { \
+                                                                  ++(ptDev)->ptStats->ullHwIfFrames; \
+                                                                  (ptDev)->ptStats->ullHwIfBytes += (ulBytes); } } while(0)
+#else
+  #define CIFX_STATS_SAMPLE(tSample)
+  #define CIFX_STATS_BEGIN(ptChannel, tSample)
+  #define CIFX_STATS_IO(ptChannel, tSample, eType, ulBytes, lRet)
+  #define CIFX_STATS_MAILBOX(ptChannel, tSample, fPut, lRet)
+  #define CIFX_STATS_HSKWAIT(ptChannel, tSample, ulBit, fOk)
+  #define CIFX_STATS_COS(ptChannel)
+  #define CIFX_STATS_HWIF_FRAME(ptDev, ulBytes)
+#endif /* CIFX_TOOLKIT_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_STATS__H */
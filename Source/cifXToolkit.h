@@ -69,11 +69,28 @@ typedef struct DEVICE_CHANNEL_CONFIGtag
 /*! \}                                                                       */
 /*****************************************************************************/
 
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+/*****************************************************************************/
+/*! Asynchronous add device request (cifXTKitAddDeviceAsync)                 */
+/*****************************************************************************/
+typedef struct CIFX_ADD_DEVICE_Ttag
+{
+  PDEVICEINSTANCE ptDevInstance;  /*!< Device being started                               */
+  void*           pvThread;       /*!< Start-up worker, NULL once waited for              */
+  void*           pvDoneEvent;    /*!< Signalled by the worker on completion              */
+  int32_t         lResult;        /*!< Result of the start-up, valid after completion     */
+} CIFX_ADD_DEVICE_T;
+#endif
+
 /* Toolkit Global Functions */
 int32_t cifXTKitInit         (void);
 void    cifXTKitDeinit       (void);
 int32_t cifXTKitAddDevice    (PDEVICEINSTANCE ptDevInstance);
 int32_t cifXTKitRemoveDevice (char* szBoard, int fForceRemove);
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+int32_t cifXTKitAddDeviceAsync(PDEVICEINSTANCE ptDevInstance, CIFX_ADD_DEVICE_T* ptAdd);
+int32_t cifXTKitAddDeviceWait (CIFX_ADD_DEVICE_T* ptAdd, uint32_t ulTimeout);
+#endif
 
 void cifXTKitDisableHWInterrupt(PDEVICEINSTANCE ptDevInstance);
 void cifXTKitEnableHWInterrupt(PDEVICEINSTANCE ptDevInstance);
@@ -81,6 +98,10 @@ void cifXTKitEnableHWInterrupt(PDEVICEINSTANCE ptDevInstance);
 void cifXTKitCyclicTimer  (void);
 
 /* Toolkit Internal Functions */
+void*    cifXFileBufferCreate (void* pvFile, uint32_t ulFileLength, int* pfMapped);
+uint32_t cifXFileBufferRead   (void* pvFile, uint32_t ulFileLength, void* pvBuffer, int fMapped);
+void     cifXFileBufferFree   (void* pvBuffer, uint32_t ulFileLength, int fMapped);
+
 int DEV_RemoveChannelFiles    (PCHANNELINSTANCE ptChannel, uint32_t ulChannel,
                                PFN_TRANSFER_PACKET    pfnTransferPacket,
                                PFN_RECV_PKT_CALLBACK  pfnRecvPacket,
@@ -99,6 +120,7 @@ int32_t DEV_DeleteFile        (void* pvChannel, uint32_t ulChannelNumber, char*
 
 int32_t DEV_CheckForDownload  (void* pvChannel,   uint32_t ulChannelNumber, int*      pfDownload,
                                char* pszFileName, void*    pvFileData,      uint32_t  ulFileSize,
+                               void*                  pvFile,
                                PFN_TRANSFER_PACKET    pfnTransferPacket,
                                PFN_RECV_PKT_CALLBACK  pfnRecvPacket,
                                void*                  pvUser);
@@ -113,6 +135,7 @@ int32_t DEV_GetFWTransferTypeFromFileName (char* pszFileName, uint32_t* pulTrans
 int32_t DEV_ProcessFWDownload (PDEVICEINSTANCE        ptDevInstance,
                                uint32_t               ulChannel,
                                char*                  pszFullFileName,
+                               void*                  pvFile,
                                char*                  pszFileName,
                                uint32_t               ulFileLength,
                                uint8_t*               pbBuffer,
@@ -0,0 +1,195 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXWait.c
+ * @brief          :  Adaptive handshake wait policy for polling mode
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXWait.c
+*    Wait policy used by DEV_WaitForBitState_Poll. The turnaround time of a
+*    handshake bit is only written by the owner of that bit, the counters
+*    are informational.                                                      */
+/*****************************************************************************/
+
+#include "cifXToolkit.h"
+#include "cifXErrors.h"
+#include "cifXWait.h"
+
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_HARDWARE Hardware Access
+*    \{                                                                      */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*! Sets the default policy of a channel and forgets all turnaround times
+*   \param ptChannel  Channel instance                                       */
+/*****************************************************************************/
+void cifXWaitInit(PCHANNELINSTANCE ptChannel)
+{
+  CIFX_WAIT_CONFIG_T tConfig;
+
+  tConfig.ulSpinNs       = CIFX_WAIT_DEFAULT_SPIN_NS;
+  tConfig.ulBackoffMinNs = CIFX_WAIT_DEFAULT_BACKOFF_MIN_NS;
+  tConfig.ulBackoffMaxNs = CIFX_WAIT_DEFAULT_BACKOFF_MAX_NS;
+  tConfig.ulWakeAheadNs  = CIFX_WAIT_DEFAULT_WAKE_AHEAD_NS;
+  tConfig.ulEwmaShift    = CIFX_WAIT_DEFAULT_EWMA_SHIFT;
+
+  (void)cifXWaitSetConfig(ptChannel, &tConfig);
+}
+
+/*****************************************************************************/
+/*! Changes the policy of a channel. Must not be called while a thread waits
+*   for a handshake bit of the channel.
+*   \param ptChannel  Channel instance
+*   \param ptConfig   New policy
+*   \return CIFX_NO_ERROR on success                                         */
+/*****************************************************************************/
+int32_t cifXWaitSetConfig(PCHANNELINSTANCE ptChannel, const CIFX_WAIT_CONFIG_T* ptConfig)
+{
+  CIFX_WAIT_POLICY_T* ptPolicy = &ptChannel->tWaitPolicy;
+
+  if( (NULL == ptConfig)                                   ||
+      (0 == ptConfig->ulBackoffMinNs)                      ||
+      (ptConfig->ulBackoffMinNs > ptConfig->ulBackoffMaxNs) ||
+      (ptConfig->ulEwmaShift > 16) )
+    return CIFX_INVALID_PARAMETER;
+
+  OS_Memset(ptPolicy, 0, sizeof(*ptPolicy));
+  ptPolicy->tConfig = *ptConfig;
+
+  return CIFX_NO_ERROR;
+}
+
+/*****************************************************************************/
+/*! Starts a wait, called after the first poll did not find the bit state
+*   \param ptChannel    Channel instance
+*   \param ptWait       Wait state to initialize
+*   \param ulBitNumber  Handshake bit waited for
+*   \param ulTimeout    Timeout of the wait in ms                            */
+/*****************************************************************************/
+void cifXWaitBegin(PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait, uint32_t ulBitNumber, uint32_t ulTimeout)
+{
+  CIFX_WAIT_POLICY_T* ptPolicy = &ptChannel->tWaitPolicy;
+  uint32_t            ulTurnaroundNs;
+
+  /* Channel was never configured */
+  if(0 == ptPolicy->tConfig.ulBackoffMaxNs)
+    cifXWaitInit(ptChannel);
+
+  ++ptPolicy->ulWaits;
+
+  ptWait->ulBitNumber   = ulBitNumber;
+  ptWait->ullStartNs    = OS_GetNanoSecCounter();
+  ptWait->ullDeadlineNs = ptWait->ullStartNs + (uint64_t)ulTimeout * 1000000ULL;
+  ptWait->ullWakeNs     = 0;
+  ptWait->ullSpinEndNs  = 0;
+  ptWait->ulBackoffNs   = ptPolicy->tConfig.ulBackoffMinNs;
+
+  ulTurnaroundNs = (ulBitNumber < HIL_DPM_HANDSHAKE_PAIRS) ? ptPolicy->aulTurnaroundNs[ulBitNumber] : 0;
+
+  if( (0 != ptPolicy->tConfig.ulWakeAheadNs) &&
+      (ulTurnaroundNs > ptPolicy->tConfig.ulWakeAheadNs) )
+  {
+    ptWait->ullWakeNs = ptWait->ullStartNs + ulTurnaroundNs - ptPolicy->tConfig.ulWakeAheadNs;
+
+    if(ptWait->ullWakeNs > ptWait->ullDeadlineNs)
+      ptWait->ullWakeNs = ptWait->ullDeadlineNs;
+  }
+}
+
+/*****************************************************************************/
+/*! Pause between two polls of the handshake flags
+*   \param ptChannel  Channel instance
+*   \param ptWait     Wait state                                             */
+/*****************************************************************************/
+void cifXWaitPause(PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait)
+{
+  CIFX_WAIT_POLICY_T* ptPolicy = &ptChannel->tWaitPolicy;
+  uint64_t            ullNow   = OS_GetNanoSecCounter();
+  uint64_t            ullWake;
+
+  ++ptPolicy->ulPolls;
+
+  /* Nothing to expect before the predicted toggle */
+  if(ullNow < ptWait->ullWakeNs)
+  {
+    OS_SleepUntilNs(ptWait->ullWakeNs);
+    ++ptPolicy->ulSleeps;
+    return;
+  }
+
+  if(0 == ptWait->ullSpinEndNs)
+    ptWait->ullSpinEndNs = ullNow + ptPolicy->tConfig.ulSpinNs;
+
+  if(ullNow < ptWait->ullSpinEndNs)
+    return;
+
+  if(ullNow >= ptWait->ullDeadlineNs)
+    return;
+
+  ullWake = ullNow + ptWait->ulBackoffNs;
+  if(ullWake > ptWait->ullDeadlineNs)
+    ullWake = ptWait->ullDeadlineNs;
+
+  OS_SleepUntilNs(ullWake);
+  ++ptPolicy->ulSleeps;
+
+  if(ptWait->ulBackoffNs < ptPolicy->tConfig.ulBackoffMaxNs / 2)
+    ptWait->ulBackoffNs *= 2;
+  else
+    ptWait->ulBackoffNs = ptPolicy->tConfig.ulBackoffMaxNs;
+}
+
+/*****************************************************************************/
+/*! Finishes a wait, successful waits update the turnaround time of the bit
+*   \param ptChannel  Channel instance
+*   \param ptWait     Wait state
+*   \param fSuccess   !=0 if the bit reached the expected state              */
+/*****************************************************************************/
+void cifXWaitEnd(PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait, int fSuccess)
+{
+  CIFX_WAIT_POLICY_T* ptPolicy = &ptChannel->tWaitPolicy;
+  uint64_t            ullSample;
+  uint32_t            ulSample;
+  uint32_t*           pulTurnaround;
+
+  if( !fSuccess || (ptWait->ulBitNumber >= HIL_DPM_HANDSHAKE_PAIRS) )
+    return;
+
+  /* Found on the first poll after the predicted wake-up: the toggle was
+     somewhere before, so only move the estimate towards the earlier wake-up.
+     Using the time of the poll would let the sleep latency add up. */
+  if( (0 != ptWait->ullWakeNs) && (0 == ptWait->ullSpinEndNs) )
+    ullSample = ptWait->ullWakeNs - ptWait->ullStartNs;
+  else
+    ullSample = OS_GetNanoSecCounter() - ptWait->ullStartNs;
+
+  ulSample      = (ullSample > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : (uint32_t)ullSample;
+  pulTurnaround = &ptPolicy->aulTurnaroundNs[ptWait->ulBitNumber];
+
+  if(0 == *pulTurnaround)
+    *pulTurnaround = ulSample;
+  else if(ulSample >= *pulTurnaround)
+    *pulTurnaround += (ulSample - *pulTurnaround) >> ptPolicy->tConfig.ulEwmaShift;
+  else
+    *pulTurnaround -= (*pulTurnaround - ulSample) >> ptPolicy->tConfig.ulEwmaShift;
+
+  /* 0 means unknown */
+  if(0 == *pulTurnaround)
+    *pulTurnaround = 1;
+}
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+#endif /* CIFX_TOOLKIT_WAIT_POLICY */
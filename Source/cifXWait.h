@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @file           :  cifXWait.h
+ * @brief          :  Adaptive handshake wait policy for polling mode
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+/*****************************************************************************/
+/*! \file cifXWait.h
+*    Spin-then-block waiting for handshake bits, enabled by
+*    CIFX_TOOLKIT_WAIT_POLICY. Every poll of the handshake flags is a bus
+*    transaction on serial DPM, so instead of polling continuously a wait
+*    - sleeps until shortly before the expected toggle (EWMA of the last
+*      turnaround times of the bit),
+*    - polls without sleeping for ulSpinNs,
+*    - backs off exponentially from ulBackoffMinNs up to ulBackoffMaxNs and
+*      keeps polling at that rate until the toggle or the timeout.        */
+/*****************************************************************************/
+
+#ifndef CIFX_WAIT__H
+#define CIFX_WAIT__H
+
+#include "cifXHWFunctions.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef CIFX_TOOLKIT_WAIT_POLICY
+
+/*****************************************************************************/
+/*!  \addtogroup CIFX_TK_STRUCTURE Toolkit Structure Definitions
+*    \{                                                                      */
+/*****************************************************************************/
+
+/* Defaults of a channel, may be overridden by the build */
+#ifndef CIFX_WAIT_DEFAULT_SPIN_NS
+  #define CIFX_WAIT_DEFAULT_SPIN_NS         20000   /*!< 20us of continuous polling               */
+#endif
+#ifndef CIFX_WAIT_DEFAULT_BACKOFF_MIN_NS
+  #define CIFX_WAIT_DEFAULT_BACKOFF_MIN_NS  10000   /*!< First backoff sleep 10us                 */
+#endif
+#ifndef CIFX_WAIT_DEFAULT_BACKOFF_MAX_NS
+  #define CIFX_WAIT_DEFAULT_BACKOFF_MAX_NS  1000000 /*!< Poll every 1ms at the latest             */
+#endif
+#ifndef CIFX_WAIT_DEFAULT_WAKE_AHEAD_NS
+  #define CIFX_WAIT_DEFAULT_WAKE_AHEAD_NS   50000   /*!< Covers the wake-up latency of the sleep  */
+#endif
+#ifndef CIFX_WAIT_DEFAULT_EWMA_SHIFT
+  #define CIFX_WAIT_DEFAULT_EWMA_SHIFT      3       /*!< Average over ~8 waits                    */
+#endif
+
+/*****************************************************************************/
+/*! State of a single wait                                                   */
+/*****************************************************************************/
+typedef struct CIFX_WAIT_STATE_Ttag
+{
+  uint32_t ulBitNumber;           /*!< Handshake bit waited for                          */
+  uint64_t ullStartNs;            /*!< Start of the wait                                 */
+  uint64_t ullDeadlineNs;         /*!< No sleep lasts beyond this time (timeout)         */
+  uint64_t ullWakeNs;             /*!< Predicted wake-up, 0: no prediction               */
+  uint64_t ullSpinEndNs;          /*!< End of the spin phase, 0: not started yet         */
+  uint32_t ulBackoffNs;           /*!< Next backoff sleep                                */
+} CIFX_WAIT_STATE_T;
+
+/*****************************************************************************/
+/*! \}                                                                       */
+/*****************************************************************************/
+
+void    cifXWaitInit      (PCHANNELINSTANCE ptChannel);
+int32_t cifXWaitSetConfig (PCHANNELINSTANCE ptChannel, const CIFX_WAIT_CONFIG_T* ptConfig);
+void    cifXWaitBegin     (PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait, uint32_t ulBitNumber, uint32_t ulTimeout);
+void    cifXWaitPause     (PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait);
+void    cifXWaitEnd       (PCHANNELINSTANCE ptChannel, CIFX_WAIT_STATE_T* ptWait, int fSuccess);
+
+#endif /* CIFX_TOOLKIT_WAIT_POLICY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CIFX_WAIT__H */
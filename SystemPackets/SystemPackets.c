@@ -34,10 +34,44 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 *   protocol independent system packets                                      */
 /*****************************************************************************/
 #include "SystemPackets.h"
+#include "gbcifx_config.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
 
+/*****************************************************************************/
+/*! Packet buffers of the mailbox traffic, no heap is used after startup     */
+/*****************************************************************************/
+static pkt_pool_entry_t s_atPktPoolEntries[PKT_POOL_SIZE];
+pkt_pool_t g_tPktPool;
+
+/*****************************************************************************/
+/*! Set up the mailbox packet pool, call once before the first Pkt_Alloc
+*   and before any thread uses the pool                                      */
+/*****************************************************************************/
+void Pkt_PoolInit(void)
+{
+    pkt_pool_init(&g_tPktPool, s_atPktPoolEntries, PKT_POOL_SIZE);
+} /** Pkt_PoolInit */
+
+/*****************************************************************************/
+/*! Take a packet from the mailbox packet pool
+*   \return packet with one reference, NULL if the pool is exhausted         */
+/*****************************************************************************/
+CIFX_PACKET* Pkt_Alloc(void)
+{
+    return pkt_pool_alloc(&g_tPktPool);
+} /** Pkt_Alloc */
+
+/*****************************************************************************/
+/*! Drop a reference to a packet of the mailbox packet pool
+*   \param ptPkt  Packet from Pkt_Alloc, NULL is ignored                     */
+/*****************************************************************************/
+void Pkt_Release(CIFX_PACKET* ptPkt)
+{
+    pkt_pool_release(&g_tPktPool, ptPkt);
+} /** Pkt_Release */
+
 
 /*****************************************************************************/
 /*! Displays a hex dump on the debug console (16 bytes per line)
@@ -188,6 +222,21 @@ uint32_t Pkt_ReceivePacket(CIFXHANDLE hChannel, CIFX_PACKET* ptRecvPkt, uint32_t
 int32_t Sys_EmptyPacketReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulId, uint32_t ulCmd)
 {
     uint32_t lRet = CIFX_NO_ERROR;
+
+    Sys_BuildEmptyPacketReq(ptPkt, ulCmd);
+
+    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
+
+    return lRet;
+} /** Sys_EmptyPacketReq */
+
+/*****************************************************************************/
+/*! fill in an empty rcX packet with command ulCmd, without sending it
+*   \param ptPkt      Packet to fill in
+*   \param ulCmd      Packet Command                                         */
+/*****************************************************************************/
+void Sys_BuildEmptyPacketReq(CIFX_PACKET *ptPkt, uint32_t ulCmd)
+{
     CIFX_PACKET_HEADER* ptHead = (CIFX_PACKET_HEADER*)&ptPkt->tHeader;
 
     memset(ptHead, 0, sizeof(*ptHead));
@@ -195,11 +244,7 @@ int32_t Sys_EmptyPacketReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulI
     ptHead->ulDest = LOCAL_CHANNEL;
     ptHead->ulCmd = ulCmd;
     ptHead->ulLen = 0;
-
-    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
-
-    return lRet;
-} /** Sys_EmptyPacketReq */
+} /** Sys_BuildEmptyPacketReq */
 
 
 /*****************************************************************************/
@@ -213,6 +258,21 @@ int32_t Sys_EmptyPacketReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulI
 int32_t Sys_StartStopCommReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulId, bool fStart)
 {
     uint32_t lRet = CIFX_NO_ERROR;
+
+    Sys_BuildStartStopCommReq(ptPkt, fStart);
+
+    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
+
+    return lRet;
+} /** Sys_StartStopCommReq */
+
+/*****************************************************************************/
+/*! fill in a start/stop communication request, without sending it
+*   \param ptPkt      Packet to fill in
+*   \param fStart     true: start, false: stop                               */
+/*****************************************************************************/
+void Sys_BuildStartStopCommReq(CIFX_PACKET *ptPkt, bool fStart)
+{
     RCX_START_STOP_COMM_REQ_T* ptReq = (RCX_START_STOP_COMM_REQ_T*)ptPkt;
 
     memset(ptReq, 0, sizeof(*ptReq));
@@ -222,11 +282,7 @@ int32_t Sys_StartStopCommReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t u
     ptReq->tHead.ulLen = sizeof(ptReq->tData);
 
     ptReq->tData.ulParam = fStart ? 1 : 2;
-
-    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
-
-    return lRet;
-} /** Sys_StartStopCommReq */
+} /** Sys_BuildStartStopCommReq */
 
 
 /*****************************************************************************/
@@ -241,6 +297,20 @@ int32_t Sys_SetMacAddressReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t u
 {
     uint32_t lRet = CIFX_NO_ERROR;
 
+    Sys_BuildSetMacAddressReq(ptPkt, abMacAddr);
+
+    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
+
+    return lRet;
+} /** Sys_SetMacAddressReq */
+
+/*****************************************************************************/
+/*! fill in a set MAC address request, without sending it
+*   \param ptPkt      Packet to fill in
+*   \param abMacAddr  mac address pointer                                    */
+/*****************************************************************************/
+void Sys_BuildSetMacAddressReq(CIFX_PACKET *ptPkt, uint8_t *abMacAddr)
+{
     RCX_SET_MAC_ADDR_REQ_T* ptSetMacAddrReq=(RCX_SET_MAC_ADDR_REQ_T*)ptPkt;
     memset(ptSetMacAddrReq, 0, sizeof(RCX_SET_MAC_ADDR_REQ_T));
 
@@ -250,12 +320,7 @@ int32_t Sys_SetMacAddressReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t u
 
     ptSetMacAddrReq->tData.ulParam   = 0x00;
     memcpy(&ptSetMacAddrReq->tData.abMacAddr, abMacAddr, sizeof(ptSetMacAddrReq->tData.abMacAddr));
-
-
-    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
-
-    return lRet;
-} /** Sys_SetMacAddressReq */
+} /** Sys_BuildSetMacAddressReq */
 
 
 /*****************************************************************************/
@@ -275,6 +340,20 @@ int32_t Sys_FirmwareIdentifyReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_
 {
     uint32_t lRet = CIFX_NO_ERROR;
 
+    Sys_BuildFirmwareIdentifyReq(ptPkt, ulChannelId);
+
+    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
+
+    return lRet;
+} /** Sys_FirmwareIdentifyReq */
+
+/*****************************************************************************/
+/*! fill in an Identifying channel firmware request, without sending it
+*   \param ptPkt        Packet to fill in
+*   \param ulChannelId  Channel Identification, see Sys_FirmwareIdentifyReq  */
+/*****************************************************************************/
+void Sys_BuildFirmwareIdentifyReq(CIFX_PACKET *ptPkt, uint32_t ulChannelId)
+{
     RCX_FIRMWARE_IDENTIFY_REQ_T* ptFirmwareIdentityReq=(RCX_FIRMWARE_IDENTIFY_REQ_T*)ptPkt;
     memset(ptFirmwareIdentityReq, 0, sizeof(RCX_FIRMWARE_IDENTIFY_REQ_T));
 
@@ -283,11 +362,7 @@ int32_t Sys_FirmwareIdentifyReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_
     ptFirmwareIdentityReq->tHead.ulLen  = sizeof(ptFirmwareIdentityReq->tData);
 
     ptFirmwareIdentityReq->tData.ulChannelId  = ulChannelId;
-
-    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
-
-    return lRet;
-} /** Sys_FirmwareIdentifyReq */
+} /** Sys_BuildFirmwareIdentifyReq */
 
 
 /*****************************************************************************/
@@ -301,17 +376,26 @@ int32_t Sys_HardwareInfoReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt,  uint32_t u
 {
     uint32_t lRet = CIFX_NO_ERROR;
 
+    Sys_BuildHardwareInfoReq(ptPkt);
+
+    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
+
+    return lRet;
+} /** Sys_HardwareInfoReq */
+
+/*****************************************************************************/
+/*! fill in a read hardware information request, without sending it
+*   \param ptPkt      Packet to fill in                                      */
+/*****************************************************************************/
+void Sys_BuildHardwareInfoReq(CIFX_PACKET *ptPkt)
+{
     RCX_HW_HARDWARE_INFO_REQ_T* ptReq=(RCX_HW_HARDWARE_INFO_REQ_T*)ptPkt;
     memset(ptReq, 0, sizeof(RCX_HW_HARDWARE_INFO_REQ_T));
 
     ptReq->tHead.ulDest = SYSTEM_CHANNEL;
     ptReq->tHead.ulCmd  = RCX_HW_HARDWARE_INFO_REQ;
     ptReq->tHead.ulLen  = 0;
-
-    lRet = Pkt_SendPacket(hChannel, ptPkt, ulId, TX_TIMEOUT);
-
-    return lRet;
-} /** Sys_HardwareInfoReq */
+} /** Sys_BuildHardwareInfoReq */
 
 /*******************************************************************************
  *  _           _ _                 _
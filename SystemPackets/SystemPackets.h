@@ -42,6 +42,7 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #include "cifXUser.h"
 #include "cifXErrors.h"
 #include "rcX_Public.h"
+#include "pkt_pool.h"
 
 #define SYSTEM_CHANNEL 0x00
 #define CHANNEL0 0x01
@@ -53,9 +54,16 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 #define TX_TIMEOUT 500
 #define RX_TIMEOUT 10
 
+/* pool of all mailbox packets, PKT_POOL_SIZE packets */
+extern pkt_pool_t g_tPktPool;
+
 /*****************************************************************************/
 /*! FUNCTION PROTOTYPES                                                      */
 /*****************************************************************************/
+void         Pkt_PoolInit(void);
+CIFX_PACKET* Pkt_Alloc(void);
+void         Pkt_Release(CIFX_PACKET* ptPkt);
+
 uint32_t Pkt_SendPacket(CIFXHANDLE hChannel, CIFX_PACKET* ptSendPkt, uint32_t ulId, uint32_t ulTimeout);
 uint32_t Pkt_ReturnPacket(CIFXHANDLE hChannel, CIFX_PACKET* ptSendPkt, uint32_t ulTimeout);
 uint32_t Pkt_ReceivePacket(CIFXHANDLE hChannel, CIFX_PACKET* ptRecvPkt, uint32_t ulTimeout);
@@ -66,6 +74,13 @@ int32_t Sys_SetMacAddressReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt,  uint32_t
 int32_t Sys_FirmwareIdentifyReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulId,  uint32_t ulChannelId);
 int32_t Sys_HardwareInfoReq(CIFXHANDLE hChannel, CIFX_PACKET *ptPkt, uint32_t ulId);
 
+/* requests filled in only, e.g. for the mailbox engine which sends them itself */
+void Sys_BuildEmptyPacketReq(CIFX_PACKET *ptPkt, uint32_t ulCmd);
+void Sys_BuildStartStopCommReq(CIFX_PACKET *ptPkt, bool fStart);
+void Sys_BuildSetMacAddressReq(CIFX_PACKET *ptPkt, uint8_t *abMacAddr);
+void Sys_BuildFirmwareIdentifyReq(CIFX_PACKET *ptPkt, uint32_t ulChannelId);
+void Sys_BuildHardwareInfoReq(CIFX_PACKET *ptPkt);
+
 int32_t Sys_LinkStatusChangeInd(CIFXHANDLE hChannel, CIFX_PACKET* ptPkt);
 
 int32_t Sys_RegisterAppCnf(CIFX_PACKET* ptRegisterAppCnf);
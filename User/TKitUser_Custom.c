@@ -23,6 +23,9 @@ Copyright (c) Hilscher Gesellschaft fuer Systemautomation mbH. All Rights Reserv
 
 #include "cifXToolkit.h"
 #include "cifXErrors.h"
+#ifdef GBCIFX_IRQ
+#include "OS_Spi.h"
+#endif
 
 //#error "Implement target system specifc user functions in this file"
 
@@ -140,7 +143,14 @@ void USER_GetAliasName(PCIFX_DEVICE_INFORMATION ptDevInfo, uint32_t ulMaxLen, ch
 /*****************************************************************************/
 int USER_GetInterruptEnable(PCIFX_DEVICE_INFORMATION ptDevInfo)
 {
+#ifdef GBCIFX_IRQ
+    OS_SPI_DEVICE_T* ptSpiDevice = (OS_SPI_DEVICE_T*)((PDEVICEINSTANCE)ptDevInfo->ptDeviceInstance)->pvOSDependent;
+
+    /* interrupt mode if the application set up the DIRQ line */
+    return (NULL != ptSpiDevice->pvIrq);
+#else
     return 0;
+#endif
 }
 
 #ifdef CIFX_TOOLKIT_DMA
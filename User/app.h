@@ -14,6 +14,8 @@
 #define GBCIFX_APP_H
 
 #include "cifXToolkit.h"
+#include "mbx_engine.h"
+#include "pkt_dispatch.h"
 
 typedef struct APP_INPUT_DATA_Ttag {
     uint8_t abApp_Inputdata[200];
@@ -28,12 +30,20 @@ typedef struct APP_DATA_Ttag {
     int fRunning;
 
     CIFXHANDLE hChannel[1];  /* handle to channel */
-    CIFX_PACKET tPkt;       /** Buffer for mailbox packets, dual usage send and receive */
     uint32_t ulSendPktCnt;  /** global send packet counter*/
+    mbx_engine_t tMbx;      /** asynchronous mailbox of hChannel[0] */
+    pkt_dispatch_t tDispatch; /** handlers of Protocol_PacketHandler() */
 
     APP_INPUT_DATA_T tInputData;
     APP_OUTPUT_DATA_T tOutputData;
 } APP_DATA_T;
 
+/* protocol specific packet handling, EtherCAT/Src/PacketHandlerECS.c */
+uint32_t Protocol_SendFirstPacket(APP_DATA_T *ptAppData);
+uint32_t Protocol_PacketHandler(APP_DATA_T *ptAppData);
+int Protocol_RegisterIndications(APP_DATA_T *ptAppData);
+int Protocol_RegisterHandlers(APP_DATA_T *ptAppData);
+int32_t Protocol_Startup(APP_DATA_T *ptAppData);
+
 
 #endif //GBCIFX_APP_H
@@ -0,0 +1,204 @@
+/**
+ ******************************************************************************
+ * @file           :  cyclic_exec.c
+ * @brief          :  real-time cyclic executive for the process data exchange
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "cyclic_exec.h"
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "user_message.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+/** stack that is left untouched by the prefault (frames of the prefault call itself, guard) */
+#define CYCLIC_EXEC_STACK_RESERVE (8 * 1024)
+
+static int64_t timespec_to_ns(const struct timespec *ts) {
+    return (int64_t) ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void timespec_add_ns(struct timespec *ts, int64_t ns) {
+    ns += ts->tv_nsec;
+    ts->tv_sec += (time_t) (ns / NSEC_PER_SEC);
+    ts->tv_nsec = (long) (ns % NSEC_PER_SEC);
+}
+
+/**
+ * @brief touch the stack once so that no page faults happen in the cycle (memory is locked by mlockall)
+ * @param size number of bytes to touch
+ */
+static void __attribute__((noinline)) prefault_stack(size_t size) {
+    unsigned char dummy[size];
+    memset(dummy, 0, size);
+    __asm__ __volatile__("" : : "r"(dummy) : "memory");
+}
+
+static void stats_begin_update(cyclic_exec_t *exec) {
+    __atomic_store_n(&exec->seq, exec->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void stats_end_update(cyclic_exec_t *exec) {
+    __atomic_store_n(&exec->seq, exec->seq + 1, __ATOMIC_RELEASE);
+}
+
+static void *cyclic_exec_thread(void *arg) {
+    cyclic_exec_t *exec = (cyclic_exec_t *) arg;
+    const int64_t period_ns = exec->config.period_ns;
+    struct timespec next;
+    struct timespec now;
+
+    if (exec->config.stack_size > CYCLIC_EXEC_STACK_RESERVE) {
+        prefault_stack(exec->config.stack_size - CYCLIC_EXEC_STACK_RESERVE);
+    }
+
+    if (exec->config.thread_init != NULL) {
+        exec->config.thread_init(exec->config.arg);
+    }
+
+    /* absolute timeline, the first release is one period from now */
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    timespec_add_ns(&next, period_ns);
+
+    while (exec->running) {
+        int64_t release_ns;
+        int64_t start_ns;
+        int64_t end_ns;
+        int overrun = 0;
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        release_ns = timespec_to_ns(&next);
+        start_ns = timespec_to_ns(&now);
+
+        exec->config.cycle(exec->config.arg);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        end_ns = timespec_to_ns(&now);
+
+        /* next release, skip releases that were missed completely */
+        timespec_add_ns(&next, period_ns);
+        if (end_ns > timespec_to_ns(&next)) {
+            overrun = 1;
+            timespec_add_ns(&next, ((end_ns - timespec_to_ns(&next)) / period_ns + 1) * period_ns);
+        }
+
+        stats_begin_update(exec);
+        if (exec->stats.cycles == 0 || start_ns - release_ns < exec->stats.jitter_min_ns) {
+            exec->stats.jitter_min_ns = start_ns - release_ns;
+        }
+        if (exec->stats.cycles == 0 || start_ns - release_ns > exec->stats.jitter_max_ns) {
+            exec->stats.jitter_max_ns = start_ns - release_ns;
+        }
+        exec->stats.jitter_sum_ns += start_ns - release_ns;
+        exec->stats.exec_last_ns = end_ns - start_ns;
+        if (end_ns - start_ns > exec->stats.exec_max_ns) {
+            exec->stats.exec_max_ns = end_ns - start_ns;
+        }
+        exec->stats.overruns += overrun;
+        exec->stats.cycles++;
+        stats_end_update(exec);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief locks memory and starts the cyclic SCHED_FIFO thread
+ * @param exec executive instance
+ * @param config period, priority, affinity and cycle function
+ * @return 0 on success, errno value otherwise
+ */
+int cyclic_exec_start(cyclic_exec_t *exec, const cyclic_exec_config_t *config) {
+    pthread_attr_t attr;
+    struct sched_param param;
+    int rc;
+
+    if (config == NULL || config->cycle == NULL || config->period_ns == 0) {
+        return EINVAL;
+    }
+
+    memset(exec, 0, sizeof(*exec));
+    exec->config = *config;
+
+    /* no page faults in the cycle, covers the thread stack as well (MCL_FUTURE) */
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: mlockall failed [%s]", strerror(rc));
+        return rc;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, config->stack_size);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = config->priority;
+    pthread_attr_setschedparam(&attr, &param);
+
+    if (config->cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(config->cpu, &cpuset);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+    }
+
+    exec->running = 1;
+    rc = pthread_create(&exec->thread, &attr, cyclic_exec_thread, exec);
+    pthread_attr_destroy(&attr);
+
+    if (rc != 0) {
+        exec->running = 0;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create cyclic thread (SCHED_FIFO prio [%d], cpu [%d]) [%s]",
+                 config->priority, config->cpu, strerror(rc));
+        return rc;
+    }
+
+    UM_INFO(GBCIFX_UM_EN, "GBNETX: Cyclic thread started, period [%u] ns, SCHED_FIFO prio [%d], cpu [%d]",
+            config->period_ns, config->priority, config->cpu);
+
+    return 0;
+}
+
+/**
+ * @brief stops the cyclic thread after the current cycle
+ * @param exec executive instance
+ */
+void cyclic_exec_stop(cyclic_exec_t *exec) {
+    if (!exec->running) {
+        return;
+    }
+    exec->running = 0;
+    pthread_join(exec->thread, NULL);
+}
+
+/**
+ * @brief consistent copy of the cycle statistics, safe to call from any thread while the cycle runs
+ * @param exec executive instance
+ * @param stats returned statistics
+ */
+void cyclic_exec_get_stats(cyclic_exec_t *exec, cyclic_exec_stats_t *stats) {
+    uint32_t seq;
+
+    do {
+        seq = __atomic_load_n(&exec->seq, __ATOMIC_ACQUIRE);
+        *stats = exec->stats;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&exec->seq, __ATOMIC_RELAXED));
+}
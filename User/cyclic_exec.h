@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @file           :  cyclic_exec.h
+ * @brief          :  real-time cyclic executive for the process data exchange
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_CYCLIC_EXEC_H
+#define GBCIFX_CYCLIC_EXEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/** function called once per cycle in the real-time thread */
+typedef void (*cyclic_exec_cycle_fn)(void *arg);
+
+typedef struct {
+    uint32_t period_ns;         /** cycle time */
+    int priority;               /** SCHED_FIFO priority of the cyclic thread */
+    int cpu;                    /** CPU the cyclic thread is pinned to, -1 = no pinning */
+    size_t stack_size;          /** stack size of the cyclic thread (prefaulted) */
+    cyclic_exec_cycle_fn thread_init; /** called once in the cyclic thread before the first cycle, NULL for none */
+    cyclic_exec_cycle_fn cycle; /** work done every cycle */
+    void *arg;                  /** argument passed to cycle */
+} cyclic_exec_config_t;
+
+typedef struct {
+    uint64_t cycles;            /** number of cycles executed */
+    uint64_t overruns;          /** cycles that ran past the next release time (missed releases are skipped) */
+    int64_t jitter_min_ns;      /** min. wake-up latency against the absolute timeline */
+    int64_t jitter_max_ns;      /** max. wake-up latency against the absolute timeline */
+    int64_t jitter_sum_ns;      /** sum of wake-up latencies, for the mean */
+    int64_t exec_last_ns;       /** execution time of the last cycle */
+    int64_t exec_max_ns;        /** max. execution time of a cycle */
+} cyclic_exec_stats_t;
+
+typedef struct {
+    cyclic_exec_config_t config;
+    pthread_t thread;
+    volatile int running;
+    /** stats are written by the cyclic thread only, seq is odd while an update is in progress */
+    volatile uint32_t seq;
+    cyclic_exec_stats_t stats;
+} cyclic_exec_t;
+
+int cyclic_exec_start(cyclic_exec_t *exec, const cyclic_exec_config_t *config);
+
+void cyclic_exec_stop(cyclic_exec_t *exec);
+
+void cyclic_exec_get_stats(cyclic_exec_t *exec, cyclic_exec_stats_t *stats);
+
+#endif //GBCIFX_CYCLIC_EXEC_H
@@ -0,0 +1,494 @@
+/**
+ ******************************************************************************
+ * @file           :  gbc_notify.c
+ * @brief          :  exchange-complete notification to GBC with pluggable backends
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "gbc_notify.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include "gbcifx_config.h"
+#include "user_message.h"
+
+/** length of /proc/<pid>/comm without the terminating zero */
+#define GBC_NOTIFY_COMM_LEN             15
+
+static void ns_to_timespec(int64_t ns, struct timespec *ts) {
+    ts->tv_sec = (time_t) (ns / 1000000000LL);
+    ts->tv_nsec = (long) (ns % 1000000000LL);
+}
+
+/*** signal ***/
+
+/**
+ * @brief looks for the GBC process by name in /proc, not real-time safe
+ * @return pid of GBC, 0 if it is not running
+ */
+static pid_t find_gbc(void) {
+    char path[sizeof("/proc//comm") + NAME_MAX];
+    char comm[GBC_PROCESS_NAME_MAX_LENGTH];
+    struct dirent *entry;
+    DIR *dir;
+    pid_t found = 0;
+
+    dir = opendir("/proc");
+    if (dir == NULL) {
+        return 0;
+    }
+
+    while (found == 0 && (entry = readdir(dir)) != NULL) {
+        FILE *file;
+
+        if (!isdigit((unsigned char) entry->d_name[0])) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/%s/comm", entry->d_name);
+        file = fopen(path, "r");
+        if (file == NULL) {
+            continue;
+        }
+        if (fgets(comm, sizeof(comm), file) != NULL) {
+            comm[strcspn(comm, "\n")] = '\0';
+            /* the kernel truncates comm, so only the first GBC_NOTIFY_COMM_LEN characters can be compared */
+            if (strncmp(comm, GBC_PROCESS_NAME, GBC_NOTIFY_COMM_LEN) == 0) {
+                found = (pid_t) strtol(entry->d_name, NULL, 10);
+            }
+        }
+        fclose(file);
+    }
+    closedir(dir);
+
+    return found;
+}
+
+static int signal_open(gbc_notify_t *notify) {
+    notify->signo = SIGNAL_TO_SEND;
+    return 0;
+}
+
+static void signal_post(gbc_notify_t *notify) {
+    pid_t pid = __atomic_load_n(&notify->gbc_pid, __ATOMIC_ACQUIRE);
+
+    if (pid <= 0) {
+        return;
+    }
+    if (kill(pid, notify->signo) == 0) {
+        notify->stats.posted++;
+    } else {
+        /* GBC has gone away, gbc_notify_service has to look for it again (unless it already found a new one) */
+        notify->stats.errors++;
+        __atomic_compare_exchange_n(&notify->gbc_pid, &pid, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void signal_service(gbc_notify_t *notify) {
+    pid_t pid;
+
+    if (__atomic_load_n(&notify->gbc_pid, __ATOMIC_ACQUIRE) != 0) {
+        return;
+    }
+    pid = find_gbc();
+    if (pid != 0) {
+        UM_INFO(GBCIFX_UM_EN, "GBNETX: Found GBC process [%s] pid [%d]", GBC_PROCESS_NAME, (int) pid);
+        __atomic_store_n(&notify->gbc_pid, pid, __ATOMIC_RELEASE);
+    }
+}
+
+/* the signal must be blocked in every thread of GBC, sigtimedwait then picks it up in the waiting thread */
+static int signal_attach(gbc_notify_t *notify) {
+    sigset_t sigset;
+
+    notify->signo = SIGNAL_TO_SEND;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, notify->signo);
+    return pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+}
+
+static int signal_wait(gbc_notify_t *notify, int64_t timeout_ns) {
+    struct timespec timeout;
+    sigset_t sigset;
+
+    sigemptyset(&sigset);
+    sigaddset(&sigset, notify->signo);
+    ns_to_timespec(timeout_ns, &timeout);
+    if (sigtimedwait(&sigset, NULL, timeout_ns >= 0 ? &timeout : NULL) < 0) {
+        return errno;
+    }
+    return 0;
+}
+
+/*** futex ***/
+
+static long futex(uint32_t *uaddr, int op, uint32_t val, const struct timespec *timeout) {
+    /* no FUTEX_PRIVATE_FLAG, the word is shared between processes */
+    return syscall(SYS_futex, uaddr, op, val, timeout, NULL, 0);
+}
+
+static void futex_post(gbc_notify_t *notify) {
+    shm_bridge_segment_t *seg = notify->bridge->seg;
+
+    /* seq_cst on both sides, either the waiter sees the new notify_seq or we see the waiter */
+    __atomic_add_fetch(&seg->notify_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&seg->notify_waiters, __ATOMIC_SEQ_CST) != 0) {
+        if (futex(&seg->notify_seq, FUTEX_WAKE, INT_MAX, NULL) < 0) {
+            notify->stats.errors++;
+            return;
+        }
+    }
+    notify->stats.posted++;
+}
+
+static int futex_attach(gbc_notify_t *notify) {
+    notify->seq = __atomic_load_n(&notify->bridge->seg->notify_seq, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+static int futex_wait(gbc_notify_t *notify, int64_t timeout_ns) {
+    shm_bridge_segment_t *seg = notify->bridge->seg;
+    /* FUTEX_WAIT takes a relative timeout, after an interruption or spurious wake-up it is recomputed from here */
+    uint64_t deadline_ns = shm_bridge_now_ns() + (uint64_t) (timeout_ns >= 0 ? timeout_ns : 0);
+    struct timespec timeout;
+    uint32_t seq;
+    int rc = 0;
+
+    __atomic_add_fetch(&seg->notify_waiters, 1, __ATOMIC_SEQ_CST);
+    while ((seq = __atomic_load_n(&seg->notify_seq, __ATOMIC_SEQ_CST)) == notify->seq) {
+        if (timeout_ns >= 0) {
+            uint64_t now_ns = shm_bridge_now_ns();
+
+            if (now_ns >= deadline_ns) {
+                rc = ETIMEDOUT;
+                break;
+            }
+            ns_to_timespec((int64_t) (deadline_ns - now_ns), &timeout);
+        }
+        if (futex(&seg->notify_seq, FUTEX_WAIT, seq, timeout_ns >= 0 ? &timeout : NULL) != 0 &&
+            errno != EAGAIN && errno != EINTR) {
+            rc = errno;
+            break;
+        }
+    }
+    __atomic_sub_fetch(&seg->notify_waiters, 1, __ATOMIC_SEQ_CST);
+
+    notify->seq = __atomic_load_n(&seg->notify_seq, __ATOMIC_ACQUIRE);
+    return rc;
+}
+
+/*** eventfd ***/
+
+static int eventfd_open(gbc_notify_t *notify) {
+    struct sockaddr_un addr;
+    int rc;
+
+    /* non-blocking, a full counter must never stall the cyclic thread */
+    notify->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify->event_fd < 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create eventfd [%s]", strerror(rc));
+        return rc;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, GBC_NOTIFY_SOCKET, sizeof(addr.sun_path) - 1);
+    unlink(addr.sun_path);
+
+    notify->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (notify->listen_fd < 0 ||
+        bind(notify->listen_fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(notify->listen_fd, 4) != 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to listen on [%s] [%s]", GBC_NOTIFY_SOCKET, strerror(rc));
+        return rc;
+    }
+    return 0;
+}
+
+static void eventfd_post(gbc_notify_t *notify) {
+    uint64_t one = 1;
+
+    if (write(notify->event_fd, &one, sizeof(one)) == sizeof(one)) {
+        notify->stats.posted++;
+    } else {
+        notify->stats.errors++;
+    }
+}
+
+/* hands the eventfd to every GBC process that connected since the last call */
+static void eventfd_service(gbc_notify_t *notify) {
+    int client;
+
+    while ((client = accept4(notify->listen_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+        char control[CMSG_SPACE(sizeof(int))];
+        char byte = 0;
+        struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+        struct msghdr msg;
+        struct cmsghdr *cmsg;
+
+        memset(&msg, 0, sizeof(msg));
+        memset(control, 0, sizeof(control));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &notify->event_fd, sizeof(int));
+
+        if (sendmsg(client, &msg, MSG_NOSIGNAL) < 0) {
+            UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to pass eventfd to GBC [%s]", strerror(errno));
+        }
+        close(client);
+    }
+}
+
+/* blocks until gbcifx services the connection, that is at least once per report interval */
+static int eventfd_attach(gbc_notify_t *notify) {
+    char control[CMSG_SPACE(sizeof(int))];
+    char byte;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    struct sockaddr_un addr;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int sock;
+    int rc = 0;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, GBC_NOTIFY_SOCKET, sizeof(addr.sun_path) - 1);
+
+    sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return errno;
+    }
+    if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        rc = errno;
+        close(sock);
+        return rc;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+        rc = errno ? errno : ECONNRESET;
+    } else if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL || cmsg->cmsg_type != SCM_RIGHTS) {
+        rc = EPROTO;
+    } else {
+        memcpy(&notify->event_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    close(sock);
+    return rc;
+}
+
+static int eventfd_wait(gbc_notify_t *notify, int64_t timeout_ns) {
+    struct pollfd pfd = {.fd = notify->event_fd, .events = POLLIN};
+    struct timespec timeout;
+    uint64_t count;
+    int rc;
+
+    /* the descriptor is shared with gbcifx and therefore non-blocking, ppoll does the waiting */
+    ns_to_timespec(timeout_ns, &timeout);
+    rc = ppoll(&pfd, 1, timeout_ns >= 0 ? &timeout : NULL, NULL);
+    if (rc < 0) {
+        return errno;
+    }
+    if (rc == 0) {
+        return ETIMEDOUT;
+    }
+    if (read(notify->event_fd, &count, sizeof(count)) != sizeof(count)) {
+        /* another thread took it */
+        return errno == EAGAIN ? EINTR : errno;
+    }
+    return 0;
+}
+
+static void eventfd_close(gbc_notify_t *notify) {
+    if (notify->listen_fd >= 0) {
+        close(notify->listen_fd);
+        unlink(GBC_NOTIFY_SOCKET);
+    }
+    if (notify->event_fd >= 0) {
+        close(notify->event_fd);
+    }
+}
+
+static const gbc_notify_ops_t gbc_notify_backends[GBC_NOTIFY_NUM_BACKENDS] = {
+        [GBC_NOTIFY_SIGNAL] = {.name = "signal",
+                .open = signal_open,
+                .post = signal_post,
+                .service = signal_service,
+                .attach = signal_attach,
+                .wait = signal_wait,
+        },
+        [GBC_NOTIFY_FUTEX] = {.name = "futex",
+                .post = futex_post,
+                .attach = futex_attach,
+                .wait = futex_wait,
+        },
+        [GBC_NOTIFY_EVENTFD] = {.name = "eventfd",
+                .open = eventfd_open,
+                .post = eventfd_post,
+                .service = eventfd_service,
+                .attach = eventfd_attach,
+                .wait = eventfd_wait,
+                .close = eventfd_close,
+        },
+};
+
+const char *gbc_notify_backend_name(gbc_notify_backend_t backend) {
+    if ((unsigned) backend >= GBC_NOTIFY_NUM_BACKENDS) {
+        return "unknown";
+    }
+    return gbc_notify_backends[backend].name;
+}
+
+static void notify_init(gbc_notify_t *notify, shm_bridge_t *bridge, gbc_notify_backend_t backend,
+                        shm_bridge_side_t side) {
+    memset(notify, 0, sizeof(*notify));
+    notify->ops = &gbc_notify_backends[backend];
+    notify->backend = backend;
+    notify->bridge = bridge;
+    notify->side = side;
+    notify->event_fd = -1;
+    notify->listen_fd = -1;
+}
+
+/**
+ * @brief sets up the notification of GBC, the backend is published in the bridge segment for the GBC side
+ * @param notify notification instance
+ * @param bridge opened bridge (gbcifx side)
+ * @param backend how GBC is woken up
+ * @return 0 on success, errno value otherwise
+ */
+int gbc_notify_open(gbc_notify_t *notify, shm_bridge_t *bridge, gbc_notify_backend_t backend) {
+    int rc;
+
+    if ((unsigned) backend >= GBC_NOTIFY_NUM_BACKENDS) {
+        return EINVAL;
+    }
+    notify_init(notify, bridge, backend, SHM_BRIDGE_SIDE_CIFX);
+
+    if (notify->ops->open != NULL && (rc = notify->ops->open(notify)) != 0) {
+        gbc_notify_close(notify);
+        return rc;
+    }
+
+    latency_hist_reset(&bridge->seg->wake_hist);
+    __atomic_store_n(&bridge->seg->notify_backend, (uint32_t) backend + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief tells GBC an exchange has completed, called once per cycle from the cyclic thread
+ * @param notify notification instance (gbcifx side)
+ */
+void gbc_notify_post(gbc_notify_t *notify) {
+    __atomic_store_n(&notify->bridge->seg->notify_ns, shm_bridge_now_ns(), __ATOMIC_RELEASE);
+    notify->ops->post(notify);
+}
+
+/**
+ * @brief housekeeping which is not real-time safe (finding GBC, handing out the eventfd), call it from the main thread
+ * @param notify notification instance (gbcifx side)
+ */
+void gbc_notify_service(gbc_notify_t *notify) {
+    if (notify->ops->service != NULL) {
+        notify->ops->service(notify);
+    }
+}
+
+/**
+ * @brief connects to the notification set up by gbcifx, the backend is taken from the bridge segment.
+ * For the signal backend this blocks SIGNAL_TO_SEND in the calling thread, threads created later inherit that
+ * @param notify notification instance
+ * @param bridge opened bridge (GBC side)
+ * @return 0 on success, EAGAIN if gbcifx has not set up the notification yet, errno value otherwise
+ */
+int gbc_notify_attach(gbc_notify_t *notify, shm_bridge_t *bridge) {
+    uint32_t backend = __atomic_load_n(&bridge->seg->notify_backend, __ATOMIC_ACQUIRE);
+    int rc;
+
+    if (backend == 0) {
+        return EAGAIN;
+    }
+    if (backend > GBC_NOTIFY_NUM_BACKENDS) {
+        return EPROTO;
+    }
+    notify_init(notify, bridge, (gbc_notify_backend_t) (backend - 1), SHM_BRIDGE_SIDE_GBC);
+
+    if (notify->ops->attach != NULL && (rc = notify->ops->attach(notify)) != 0) {
+        return rc;
+    }
+    return 0;
+}
+
+/**
+ * @brief records the time from the last notification to now in the wake-up histogram of the segment.
+ * gbc_notify_wait does this itself, GBC code that is woken some other way (e.g. a signal handler) can call it directly
+ * @param notify notification instance (GBC side)
+ */
+void gbc_notify_record_wake(gbc_notify_t *notify) {
+    shm_bridge_segment_t *seg = notify->bridge->seg;
+    uint64_t now = shm_bridge_now_ns();
+    uint64_t posted = __atomic_load_n(&seg->notify_ns, __ATOMIC_ACQUIRE);
+
+    if (posted != 0 && now >= posted) {
+        latency_hist_record(&seg->wake_hist, now - posted);
+    }
+}
+
+/**
+ * @brief sleeps until gbcifx completes an exchange
+ * @param notify notification instance (GBC side)
+ * @param timeout_ns relative timeout, < 0 waits forever
+ * @return 0 if an exchange completed, ETIMEDOUT, EAGAIN or EINTR otherwise
+ */
+int gbc_notify_wait(gbc_notify_t *notify, int64_t timeout_ns) {
+    int rc = notify->ops->wait(notify, timeout_ns);
+
+    if (rc == 0) {
+        gbc_notify_record_wake(notify);
+    }
+    return rc;
+}
+
+void gbc_notify_close(gbc_notify_t *notify) {
+    if (notify->side == SHM_BRIDGE_SIDE_CIFX && notify->bridge->seg != NULL) {
+        __atomic_store_n(&notify->bridge->seg->notify_backend, 0, __ATOMIC_RELEASE);
+    }
+    if (notify->ops->close != NULL) {
+        notify->ops->close(notify);
+    }
+    notify->event_fd = -1;
+    notify->listen_fd = -1;
+}
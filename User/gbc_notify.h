@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file           :  gbc_notify.h
+ * @brief          :  exchange-complete notification to GBC with pluggable backends
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_GBC_NOTIFY_H
+#define GBCIFX_GBC_NOTIFY_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "shm_bridge.h"
+
+typedef enum {
+    GBC_NOTIFY_SIGNAL,          /** SIGNAL_TO_SEND to the process found by GBC_PROCESS_NAME */
+    GBC_NOTIFY_FUTEX,           /** futex word in the shared memory segment */
+    GBC_NOTIFY_EVENTFD,         /** eventfd handed to GBC over the unix socket GBC_NOTIFY_SOCKET */
+    GBC_NOTIFY_NUM_BACKENDS,
+} gbc_notify_backend_t;
+
+typedef struct gbc_notify_tag gbc_notify_t;
+
+/** backend functions, the gbcifx side is open/post/service/close, the GBC side attach/wait/close */
+typedef struct {
+    const char *name;
+    int (*open)(gbc_notify_t *notify);
+    void (*post)(gbc_notify_t *notify);
+    void (*service)(gbc_notify_t *notify);
+    int (*attach)(gbc_notify_t *notify);
+    int (*wait)(gbc_notify_t *notify, int64_t timeout_ns);
+    void (*close)(gbc_notify_t *notify);
+} gbc_notify_ops_t;
+
+/** counters of the gbcifx side, written by the cyclic thread only */
+typedef struct {
+    volatile uint32_t posted;           /** notifications delivered */
+    volatile uint32_t errors;           /** failed deliveries */
+} gbc_notify_stats_t;
+
+struct gbc_notify_tag {
+    const gbc_notify_ops_t *ops;
+    gbc_notify_backend_t backend;
+    shm_bridge_t *bridge;
+    shm_bridge_side_t side;
+    /** signal: pid of GBC, 0 = unknown. Cleared by the cyclic thread, set by gbc_notify_service, __atomic access only */
+    pid_t gbc_pid;
+    int signo;
+    /** futex: last notify_seq seen by the waiter */
+    uint32_t seq;
+    /** eventfd: the event and, on the gbcifx side, the socket it is handed out on */
+    int event_fd;
+    int listen_fd;
+    gbc_notify_stats_t stats;
+};
+
+const char *gbc_notify_backend_name(gbc_notify_backend_t backend);
+
+/* gbcifx side */
+int gbc_notify_open(gbc_notify_t *notify, shm_bridge_t *bridge, gbc_notify_backend_t backend);
+
+void gbc_notify_post(gbc_notify_t *notify);
+
+void gbc_notify_service(gbc_notify_t *notify);
+
+/* GBC side */
+int gbc_notify_attach(gbc_notify_t *notify, shm_bridge_t *bridge);
+
+int gbc_notify_wait(gbc_notify_t *notify, int64_t timeout_ns);
+
+void gbc_notify_record_wake(gbc_notify_t *notify);
+
+/* both */
+void gbc_notify_close(gbc_notify_t *notify);
+
+#endif //GBCIFX_GBC_NOTIFY_H
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file           :  latency_hist.c
+ * @brief          :  fixed size log-linear latency histogram
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include "latency_hist.h"
+#include <string.h>
+
+static uint32_t bucket_index(uint32_t ns) {
+    uint32_t msb;
+
+    if (ns < LATENCY_HIST_SUB_BUCKETS) {
+        return ns;
+    }
+    msb = 31 - (uint32_t) __builtin_clz(ns);
+    return (msb - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_BUCKETS +
+           ((ns >> (msb - LATENCY_HIST_SUB_BITS)) & (LATENCY_HIST_SUB_BUCKETS - 1));
+}
+
+/** largest value counted in a bucket */
+static uint64_t bucket_upper(uint32_t index) {
+    uint32_t shift;
+
+    if (index < LATENCY_HIST_SUB_BUCKETS) {
+        return index;
+    }
+    shift = index / LATENCY_HIST_SUB_BUCKETS - 1;
+    return (((uint64_t) (LATENCY_HIST_SUB_BUCKETS + index % LATENCY_HIST_SUB_BUCKETS) + 1) << shift) - 1;
+}
+
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+/**
+ * @brief count one sample, real-time safe
+ * @param hist histogram, single writer only
+ * @param ns sample
+ */
+void latency_hist_record(latency_hist_t *hist, uint64_t ns) {
+    uint32_t value = ns > UINT32_MAX ? UINT32_MAX : (uint32_t) ns;
+    uint32_t count = hist->count;
+
+    __atomic_store_n(&hist->buckets[bucket_index(value)], hist->buckets[bucket_index(value)] + 1, __ATOMIC_RELAXED);
+    if (count == 0 || value < hist->min_ns) {
+        __atomic_store_n(&hist->min_ns, value, __ATOMIC_RELAXED);
+    }
+    if (value > hist->max_ns) {
+        __atomic_store_n(&hist->max_ns, value, __ATOMIC_RELAXED);
+    }
+    hist->sum_ns += value;
+    __atomic_store_n(&hist->count, count + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief percentile from the bucket counts
+ * @param hist histogram
+ * @param pct 0 - 100
+ * @return upper bound of the bucket holding the percentile (max_ns for 100), 0 if nothing was recorded
+ */
+uint64_t latency_hist_percentile(const latency_hist_t *hist, uint32_t pct) {
+    uint32_t count = __atomic_load_n(&hist->count, __ATOMIC_ACQUIRE);
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+    if (pct >= 100) {
+        return hist->max_ns;
+    }
+    /* rank of the sample, 1 based, rounded up */
+    rank = ((uint64_t) count * pct + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += __atomic_load_n(&hist->buckets[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            return upper < hist->max_ns ? upper : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
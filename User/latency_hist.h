@@ -0,0 +1,42 @@
+/**
+ ******************************************************************************
+ * @file           :  latency_hist.h
+ * @brief          :  fixed size log-linear latency histogram
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_LATENCY_HIST_H
+#define GBCIFX_LATENCY_HIST_H
+
+#include <stdint.h>
+
+/** every power of two range is split into 2^LATENCY_HIST_SUB_BITS buckets, i.e. 12.5% resolution */
+#define LATENCY_HIST_SUB_BITS           3
+#define LATENCY_HIST_SUB_BUCKETS        (1 << LATENCY_HIST_SUB_BITS)
+/** covers 0 .. 2^32-1 ns, larger values are counted in the last bucket */
+#define LATENCY_HIST_BUCKETS            ((32 - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_BUCKETS)
+
+/**
+ * Plain data, no pointers, so it can live in shared memory. There must only be one writer, readers in other threads
+ * or processes see each counter consistently but not necessarily all counters of the same sample.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_ns;
+    uint32_t max_ns;
+    uint64_t sum_ns;
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+} latency_hist_t;
+
+void latency_hist_reset(latency_hist_t *hist);
+
+void latency_hist_record(latency_hist_t *hist, uint64_t ns);
+
+uint64_t latency_hist_percentile(const latency_hist_t *hist, uint32_t pct);
+
+#endif //GBCIFX_LATENCY_HIST_H
@@ -0,0 +1,498 @@
+/**
+ ******************************************************************************
+ * @file           :  mbx_engine.c
+ * @brief          :  asynchronous mailbox engine of a communication channel
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#include "mbx_engine.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "cifXErrors.h"
+#include "SystemPackets.h"
+#include "user_message.h"
+
+#define NSEC_PER_SEC 1000000000LL
+#define NSEC_PER_MSEC 1000000LL
+
+static void timespec_add_ms(struct timespec *ts, uint32_t ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long) (ms % 1000) * NSEC_PER_MSEC;
+    if (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_sec++;
+        ts->tv_nsec -= NSEC_PER_SEC;
+    }
+}
+
+static uint64_t mbx_engine_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief hands a request back to its owner, called without the engine lock
+ * @param engine engine instance
+ * @param req request that was removed from the queues
+ * @param result completion code
+ */
+static void mbx_engine_complete(mbx_engine_t *engine, mbx_engine_req_t *req, int32_t result) {
+    req->result = result;
+    req->done_ns = mbx_engine_now_ns();
+
+    pthread_mutex_lock(&engine->lock);
+    if (result == CIFX_NO_ERROR) {
+        engine->stats.completed++;
+    } else if (result == CIFX_DEV_PUT_TIMEOUT || result == CIFX_DEV_GET_TIMEOUT) {
+        engine->stats.timeouts++;
+    } else if (result != CIFX_DEV_NOT_RUNNING) {
+        engine->stats.errors++;
+    }
+    /* done before the callback, so the callback can submit the request again */
+    req->state = MBX_ENGINE_REQ_DONE;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (req->done != NULL) {
+        req->done(req, req->arg);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    pthread_cond_broadcast(&engine->done_cond);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/**
+ * @brief puts queued requests until the send mailbox is busy
+ * @param engine engine instance
+ * @param timeout_ms time the first request waits for the netX to take the previous packet
+ * @return !=0 if requests are left because the netX did not take the previous packet yet
+ */
+static int mbx_engine_send(mbx_engine_t *engine, uint32_t timeout_ms) {
+    for (;; timeout_ms = 0) {
+        mbx_engine_req_t *req;
+        int32_t ret;
+
+        /* only the worker removes requests from the queue, the head stays valid without the lock */
+        pthread_mutex_lock(&engine->lock);
+        req = engine->send_head;
+        pthread_mutex_unlock(&engine->lock);
+        if (req == NULL) {
+            return 0;
+        }
+
+        ret = xChannelPutPacket(engine->channel, req->req, timeout_ms);
+        if (ret == CIFX_DEV_MAILBOX_FULL) {
+            pthread_mutex_lock(&engine->lock);
+            engine->stats.mailbox_full++;
+            pthread_mutex_unlock(&engine->lock);
+            return 1;
+        }
+
+        pthread_mutex_lock(&engine->lock);
+        engine->send_head = req->next;
+        if (engine->send_head == NULL) {
+            engine->send_tail = NULL;
+        }
+        if (ret == CIFX_NO_ERROR) {
+            req->state = MBX_ENGINE_REQ_SENT;
+            req->next = engine->in_flight;
+            engine->in_flight = req;
+            engine->stats.sent++;
+            if (++engine->num_in_flight > engine->stats.in_flight_max) {
+                engine->stats.in_flight_max = engine->num_in_flight;
+            }
+        }
+        pthread_mutex_unlock(&engine->lock);
+
+        if (ret != CIFX_NO_ERROR) {
+            mbx_engine_complete(engine, req, ret);
+        }
+    }
+}
+
+/**
+ * @brief hands a confirmation to its request, or an indication to its handler
+ * @param engine engine instance
+ * @param pkt received packet, engine->rx
+ */
+static void mbx_engine_dispatch(mbx_engine_t *engine, CIFX_PACKET *pkt) {
+    mbx_engine_handler_t handler = {0};
+    int respond;
+
+    if (pkt->tHeader.ulCmd & 0x1) {
+        mbx_engine_req_t **link;
+        mbx_engine_req_t *req = NULL;
+
+        pthread_mutex_lock(&engine->lock);
+        for (link = &engine->in_flight; *link != NULL; link = &(*link)->next) {
+            if ((*link)->req->tHeader.ulId == pkt->tHeader.ulId &&
+                (*link)->req->tHeader.ulSrcId == pkt->tHeader.ulSrcId) {
+                req = *link;
+                *link = req->next;
+                engine->num_in_flight--;
+                break;
+            }
+        }
+        if (req == NULL) {
+            engine->stats.unmatched++;
+        }
+        pthread_mutex_unlock(&engine->lock);
+
+        /* the receive buffer goes to the request, an unmatched packet is received into again */
+        if (req != NULL) {
+            engine->rx = NULL;
+            req->cnf = pkt;
+            mbx_engine_complete(engine, req, CIFX_NO_ERROR);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->stats.indications++;
+    for (uint32_t i = 0; i < engine->num_handlers; i++) {
+        if (engine->handlers[i].cmd == pkt->tHeader.ulCmd) {
+            handler = engine->handlers[i];
+            break;
+        }
+    }
+    if (handler.fn == NULL) {
+        engine->stats.unhandled++;
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (handler.fn != NULL) {
+        respond = handler.fn(engine, pkt, handler.arg);
+    } else {
+        pkt->tHeader.ulLen = 0;
+        pkt->tHeader.ulState = RCX_E_UNKNOWN_COMMAND;
+        respond = 1;
+    }
+
+    if (respond) {
+        pkt->tHeader.ulCmd |= 0x01;
+        xChannelPutPacket(engine->channel, pkt, TX_TIMEOUT);
+    }
+
+    /* the handler may have kept a reference */
+    engine->rx = NULL;
+    pkt_pool_release(engine->pool, pkt);
+}
+
+/**
+ * @brief completes the requests whose timeout expired, queued ones with CIFX_DEV_PUT_TIMEOUT, sent ones with
+ * CIFX_DEV_GET_TIMEOUT
+ * @param engine engine instance
+ */
+static void mbx_engine_expire(mbx_engine_t *engine) {
+    uint64_t now = mbx_engine_now_ns();
+    mbx_engine_req_t *expired = NULL;
+    mbx_engine_req_t **link;
+
+    pthread_mutex_lock(&engine->lock);
+    for (link = &engine->in_flight; *link != NULL;) {
+        mbx_engine_req_t *req = *link;
+
+        if (req->deadline_ns != 0 && now >= req->deadline_ns) {
+            *link = req->next;
+            engine->num_in_flight--;
+            req->result = CIFX_DEV_GET_TIMEOUT;
+            req->next = expired;
+            expired = req;
+        } else {
+            link = &req->next;
+        }
+    }
+    /* the send queue is only shortened by the worker, the tail is rebuilt on the way */
+    engine->send_tail = NULL;
+    for (link = &engine->send_head; *link != NULL;) {
+        mbx_engine_req_t *req = *link;
+
+        if (req->deadline_ns != 0 && now >= req->deadline_ns) {
+            *link = req->next;
+            req->result = CIFX_DEV_PUT_TIMEOUT;
+            req->next = expired;
+            expired = req;
+        } else {
+            engine->send_tail = req;
+            link = &req->next;
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    while (expired != NULL) {
+        mbx_engine_req_t *req = expired;
+
+        expired = req->next;
+        mbx_engine_complete(engine, req, req->result);
+    }
+}
+
+/**
+ * @brief takes a packet from the receive mailbox and dispatches it
+ * @param engine engine instance
+ * @param timeout_ms time to wait for a packet
+ * @return CIFX_NO_ERROR if a packet was dispatched, CIFX_DEV_GET_NO_PACKET if there was none, other errors if the
+ * channel or the packet pool is not available
+ */
+static int32_t mbx_engine_receive(mbx_engine_t *engine, uint32_t timeout_ms) {
+    int32_t ret;
+
+    if (engine->rx == NULL && (engine->rx = pkt_pool_alloc(engine->pool)) == NULL) {
+        pthread_mutex_lock(&engine->lock);
+        engine->stats.pool_empty++;
+        pthread_mutex_unlock(&engine->lock);
+        return CIFX_BUFFER_TOO_SHORT;
+    }
+
+    ret = xChannelGetPacket(engine->channel, sizeof(*engine->rx), engine->rx, timeout_ms);
+    if (ret == CIFX_NO_ERROR) {
+        mbx_engine_dispatch(engine, engine->rx);
+    } else if (ret == CIFX_DEV_GET_TIMEOUT) {
+        ret = CIFX_DEV_GET_NO_PACKET;
+    }
+
+    return ret;
+}
+
+static void *mbx_engine_thread(void *arg) {
+    mbx_engine_t *engine = (mbx_engine_t *) arg;
+
+    while (engine->running) {
+        int busy = mbx_engine_send(engine, 0);
+        int32_t ret = mbx_engine_receive(engine, 0);
+
+        if (ret == CIFX_NO_ERROR) {
+            /* look for more */
+        } else if (ret != CIFX_DEV_GET_NO_PACKET) {
+            /* channel not ready (e.g. restarting) or no packet to receive into, do not spin on it */
+            usleep(engine->poll_ms * 1000);
+        } else if (busy) {
+            /* nothing to receive, the next request goes out as soon as the netX took the previous one */
+            mbx_engine_send(engine, engine->poll_ms);
+        } else {
+            pthread_mutex_lock(&engine->lock);
+            if (engine->num_in_flight != 0) {
+                /* wait for the confirmation */
+                pthread_mutex_unlock(&engine->lock);
+                mbx_engine_receive(engine, engine->poll_ms);
+            } else {
+                /* nothing expected, sleep until a submission or the next poll for indications */
+                struct timespec deadline;
+
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                timespec_add_ms(&deadline, engine->poll_ms);
+                if (engine->running && engine->send_head == NULL) {
+                    pthread_cond_timedwait(&engine->work_cond, &engine->lock, &deadline);
+                }
+                pthread_mutex_unlock(&engine->lock);
+            }
+        }
+
+        mbx_engine_expire(engine);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief starts the worker thread of the engine, it runs with the scheduling policy of the caller
+ * @param engine engine instance
+ * @param channel channel handle (xChannelOpen or the toolkit channel instance)
+ * @param pool packet pool the received packets are taken from
+ * @param poll_ms poll period of the receive mailbox, i.e. the max. delay of an indication in polling mode
+ * @return 0 on success, errno value otherwise
+ */
+int mbx_engine_start(mbx_engine_t *engine, CIFXHANDLE channel, pkt_pool_t *pool, uint32_t poll_ms) {
+    pthread_condattr_t attr;
+    int rc;
+
+    if (channel == NULL || pool == NULL || poll_ms == 0) {
+        return EINVAL;
+    }
+
+    memset(engine, 0, sizeof(*engine));
+    engine->channel = channel;
+    engine->pool = pool;
+    engine->poll_ms = poll_ms;
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&engine->done_cond, &attr);
+    pthread_cond_init(&engine->work_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    engine->running = 1;
+    rc = pthread_create(&engine->thread, NULL, mbx_engine_thread, engine);
+    if (rc != 0) {
+        engine->running = 0;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create mailbox thread [%s]", strerror(rc));
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief stops the worker thread, requests that are still queued or in flight complete with CIFX_DEV_NOT_RUNNING
+ * @param engine engine instance
+ */
+void mbx_engine_stop(mbx_engine_t *engine) {
+    mbx_engine_req_t *req;
+
+    if (!engine->running) {
+        return;
+    }
+    /* under the lock, nothing is queued after this */
+    pthread_mutex_lock(&engine->lock);
+    engine->running = 0;
+    pthread_cond_signal(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->thread, NULL);
+
+    for (;;) {
+        pthread_mutex_lock(&engine->lock);
+        if ((req = engine->send_head) != NULL) {
+            engine->send_head = req->next;
+        } else if ((req = engine->in_flight) != NULL) {
+            engine->in_flight = req->next;
+            engine->num_in_flight--;
+        }
+        pthread_mutex_unlock(&engine->lock);
+        if (req == NULL) {
+            break;
+        }
+        mbx_engine_complete(engine, req, CIFX_DEV_NOT_RUNNING);
+    }
+    engine->send_tail = NULL;
+
+    pkt_pool_release(engine->pool, engine->rx);
+    engine->rx = NULL;
+}
+
+/**
+ * @brief registers the handler of an indication, can be called while the engine runs
+ * @param engine engine instance
+ * @param cmd indication command (ulCmd)
+ * @param fn handler, called by the worker thread
+ * @param arg argument passed to fn
+ * @return 0 on success, EEXIST if cmd has a handler, ENOSPC if MBX_ENGINE_MAX_HANDLERS are registered
+ */
+int mbx_engine_register(mbx_engine_t *engine, uint32_t cmd, mbx_engine_ind_fn fn, void *arg) {
+    int rc = 0;
+
+    if (fn == NULL || (cmd & 0x1)) {
+        return EINVAL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    for (uint32_t i = 0; i < engine->num_handlers; i++) {
+        if (engine->handlers[i].cmd == cmd) {
+            rc = EEXIST;
+        }
+    }
+    if (rc == 0 && engine->num_handlers == MBX_ENGINE_MAX_HANDLERS) {
+        rc = ENOSPC;
+    }
+    if (rc == 0) {
+        engine->handlers[engine->num_handlers].cmd = cmd;
+        engine->handlers[engine->num_handlers].fn = fn;
+        engine->handlers[engine->num_handlers].arg = arg;
+        engine->num_handlers++;
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return rc;
+}
+
+/**
+ * @brief queues a request, never blocks on the device. The request must not be touched until it is done
+ * @param engine engine instance
+ * @param req request with req, timeout_ms and optionally done/arg filled in, the confirmation of a previous
+ * submission is released
+ * @return 0 on success, EINVAL without request packet, EBUSY if the request is still queued or in flight, ESHUTDOWN
+ * if the engine is not running
+ */
+int mbx_engine_submit(mbx_engine_t *engine, mbx_engine_req_t *req) {
+    if (req->req == NULL) {
+        return EINVAL;
+    }
+    if (req->state == MBX_ENGINE_REQ_QUEUED || req->state == MBX_ENGINE_REQ_SENT) {
+        return EBUSY;
+    }
+    pkt_pool_release(engine->pool, req->cnf);
+    req->cnf = NULL;
+
+    req->engine = engine;
+    req->result = CIFX_NO_ERROR;
+    req->submit_ns = mbx_engine_now_ns();
+    req->done_ns = 0;
+    req->deadline_ns = req->timeout_ms ? req->submit_ns + (uint64_t) req->timeout_ms * NSEC_PER_MSEC : 0;
+    req->next = NULL;
+    req->req->tHeader.ulSrc = 0x00;
+
+    pthread_mutex_lock(&engine->lock);
+    if (!engine->running) {
+        pthread_mutex_unlock(&engine->lock);
+        return ESHUTDOWN;
+    }
+    req->req->tHeader.ulId = engine->next_id++;
+    req->state = MBX_ENGINE_REQ_QUEUED;
+    if (engine->send_tail != NULL) {
+        engine->send_tail->next = req;
+    } else {
+        engine->send_head = req;
+    }
+    engine->send_tail = req;
+    engine->stats.submitted++;
+    pthread_cond_signal(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+
+    return 0;
+}
+
+/**
+ * @brief waits for the completion of a submitted request
+ * @param req request
+ * @param timeout_ms max. time to wait, the request stays in flight if the wait times out
+ * @return result of the request, CIFX_DEV_GET_TIMEOUT if it did not complete in time
+ */
+int32_t mbx_engine_wait(mbx_engine_req_t *req, uint32_t timeout_ms) {
+    mbx_engine_t *engine = req->engine;
+    struct timespec deadline;
+    int32_t ret;
+    int rc = 0;
+
+    if (engine == NULL) {
+        return CIFX_INVALID_PARAMETER;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    timespec_add_ms(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&engine->lock);
+    while (req->state != MBX_ENGINE_REQ_DONE && rc != ETIMEDOUT) {
+        rc = pthread_cond_timedwait(&engine->done_cond, &engine->lock, &deadline);
+    }
+    ret = req->state == MBX_ENGINE_REQ_DONE ? req->result : CIFX_DEV_GET_TIMEOUT;
+    pthread_mutex_unlock(&engine->lock);
+
+    return ret;
+}
+
+/**
+ * @brief copy of the engine statistics
+ * @param engine engine instance
+ * @param stats returned statistics
+ */
+void mbx_engine_get_stats(mbx_engine_t *engine, mbx_engine_stats_t *stats) {
+    pthread_mutex_lock(&engine->lock);
+    *stats = engine->stats;
+    pthread_mutex_unlock(&engine->lock);
+}
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file           :  mbx_engine.h
+ * @brief          :  asynchronous mailbox engine of a communication channel
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_MBX_ENGINE_H
+#define GBCIFX_MBX_ENGINE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "cifXUser.h"
+#include "pkt_pool.h"
+
+/**
+ * The engine owns the mailbox of a channel while it runs: a worker thread puts the queued requests as fast as the
+ * send mailbox handshake allows and takes every packet from the receive mailbox. Confirmations are matched to the
+ * request they answer by ulId/ulSrcId, so any number of requests can be in flight. Indications are routed to the
+ * handler registered for their command, unknown indications are answered with RCX_E_UNKNOWN_COMMAND. Received
+ * packets are taken from the packet pool of the engine and handed on without a copy.
+ *
+ * Only the mailbox of the channel is used, the process data exchange of the cyclic thread is never blocked. No
+ * other code may take packets from the channel (xChannelGetPacket) while the engine runs.
+ */
+
+/** indication handlers that can be registered per engine */
+#define MBX_ENGINE_MAX_HANDLERS         16
+
+typedef struct mbx_engine mbx_engine_t;
+typedef struct mbx_engine_req mbx_engine_req_t;
+
+/** called by the worker thread when a request completed, result and confirmation are in req */
+typedef void (*mbx_engine_done_fn)(mbx_engine_req_t *req, void *arg);
+
+/**
+ * called by the worker thread for a received indication. ind is released by the engine after the call, take a
+ * reference (pkt_pool_addref) to keep it
+ * @return !=0 to send ind back as the response (ulCmd is turned into the answer), 0 if no response is sent
+ */
+typedef int (*mbx_engine_ind_fn)(mbx_engine_t *engine, CIFX_PACKET *ind, void *arg);
+
+typedef enum {
+    MBX_ENGINE_REQ_IDLE,                /** never submitted */
+    MBX_ENGINE_REQ_QUEUED,              /** waiting for the send mailbox */
+    MBX_ENGINE_REQ_SENT,                /** taken by the netX, waiting for the confirmation */
+    MBX_ENGINE_REQ_DONE,                /** result (and cnf) valid, may be submitted again */
+} mbx_engine_req_state_t;
+
+/** request with its confirmation, owned by the caller and untouched by the engine until it is submitted */
+struct mbx_engine_req {
+    CIFX_PACKET *req;                   /** request, ulId and ulSrc are set on submission, ulSrcId is kept */
+    CIFX_PACKET *cnf;                   /** confirmation from the pool if result is CIFX_NO_ERROR, released by the owner or by the next submission */
+    uint32_t timeout_ms;                /** time from the submission to the confirmation, 0 = no timeout */
+    mbx_engine_done_fn done;            /** optional completion callback, use either the callback or mbx_engine_wait() */
+    void *arg;                          /** argument passed to done */
+
+    /* set by the engine */
+    volatile mbx_engine_req_state_t state;
+    int32_t result;                     /** CIFX_NO_ERROR, error of the send, CIFX_DEV_PUT_TIMEOUT/CIFX_DEV_GET_TIMEOUT or CIFX_DEV_NOT_RUNNING if the engine stopped */
+    uint64_t submit_ns;                 /** CLOCK_MONOTONIC time of the submission */
+    uint64_t done_ns;                   /** CLOCK_MONOTONIC time of the completion */
+    uint64_t deadline_ns;
+    mbx_engine_t *engine;
+    mbx_engine_req_t *next;
+};
+
+typedef struct {
+    uint64_t submitted;                 /** requests submitted */
+    uint64_t sent;                      /** requests taken by the send mailbox */
+    uint64_t completed;                 /** requests completed with a confirmation */
+    uint64_t errors;                    /** requests that could not be sent */
+    uint64_t timeouts;                  /** requests without confirmation in time */
+    uint64_t mailbox_full;              /** send attempts deferred because the netX had not taken the previous packet */
+    uint64_t indications;               /** indications received */
+    uint64_t unhandled;                 /** indications without handler, answered with RCX_E_UNKNOWN_COMMAND */
+    uint64_t unmatched;                 /** confirmations without request (late or foreign) */
+    uint64_t pool_empty;                /** receive attempts deferred because the packet pool was exhausted */
+    uint32_t in_flight_max;             /** max. requests sent and not yet confirmed */
+} mbx_engine_stats_t;
+
+typedef struct {
+    uint32_t cmd;
+    mbx_engine_ind_fn fn;
+    void *arg;
+} mbx_engine_handler_t;
+
+struct mbx_engine {
+    CIFXHANDLE channel;
+    pkt_pool_t *pool;                   /** packets of the receive mailbox */
+    uint32_t poll_ms;                   /** poll period of the receive mailbox */
+    pthread_t thread;
+    volatile int running;
+    pthread_mutex_t lock;               /** protects the queues, handlers and statistics */
+    pthread_cond_t done_cond;           /** broadcast on every completion, CLOCK_MONOTONIC */
+    pthread_cond_t work_cond;           /** wakes the idle worker on a submission, CLOCK_MONOTONIC */
+    uint32_t next_id;
+    mbx_engine_req_t *send_head;        /** queued requests, FIFO */
+    mbx_engine_req_t *send_tail;
+    mbx_engine_req_t *in_flight;        /** sent requests */
+    uint32_t num_in_flight;
+    mbx_engine_handler_t handlers[MBX_ENGINE_MAX_HANDLERS];
+    uint32_t num_handlers;
+    CIFX_PACKET *rx;                    /** next receive buffer of the worker, from pool */
+    mbx_engine_stats_t stats;
+};
+
+int mbx_engine_start(mbx_engine_t *engine, CIFXHANDLE channel, pkt_pool_t *pool, uint32_t poll_ms);
+
+void mbx_engine_stop(mbx_engine_t *engine);
+
+int mbx_engine_register(mbx_engine_t *engine, uint32_t cmd, mbx_engine_ind_fn fn, void *arg);
+
+int mbx_engine_submit(mbx_engine_t *engine, mbx_engine_req_t *req);
+
+int32_t mbx_engine_wait(mbx_engine_req_t *req, uint32_t timeout_ms);
+
+void mbx_engine_get_stats(mbx_engine_t *engine, mbx_engine_stats_t *stats);
+
+#endif //GBCIFX_MBX_ENGINE_H
@@ -0,0 +1,733 @@
+/**
+ ******************************************************************************
+ * @file           :  netx_sim.c
+ * @brief          :  in-memory netX DPM with a simulated firmware, plugged in through the toolkit HWIF functions
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "netx_sim.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "cifXErrors.h"
+#include "cifXStats.h"
+#include "Hil_Results.h"
+#include "Hil_SystemCmd.h"
+#include "Hil_SharedDefines.h"
+#include "NetX_RegDefs.h"
+#include "SerialDPMInterface.h"
+#include "netx90_4x00_romloader_dpm.h"
+#include "gbcifx_config.h"
+#include "user_message.h"
+
+/** DPM offset of the first communication channel, behind the system and the handshake channel */
+#define NETX_SIM_CHANNEL_START          (HIL_DPM_SYSTEM_CHANNEL_SIZE + sizeof(HIL_DPM_HANDSHAKE_CHANNEL_T))
+
+/** size of the packet header in the mailboxes, in front of the packet buffer */
+#define NETX_SIM_MBX_HEADER             4
+
+#define NETX_SIM_FW_NAME                "netX simulator"
+
+/** one entry of the block table reported by HIL_DPM_GET_BLOCK_INFO_REQ, offsets are relative to the channel */
+typedef struct {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t size;                      /** 0 = io_size of the configuration */
+    uint16_t flags;
+    uint16_t hsk_mode;
+    uint16_t hsk_bit;
+} netx_sim_block_t;
+
+/* PD0 comes first, the toolkit numbers the I/O areas in the order they are reported */
+static const netx_sim_block_t netx_sim_blocks[NETX_SIM_BLOCKS] = {
+        {HIL_BLOCK_DATA_IMAGE, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, abPd0Output), 0,
+                HIL_DIRECTION_OUT | HIL_TRANSMISSION_TYPE_DPM, HIL_IO_MODE_BUFF_HST_CTRL, HCF_PD0_OUT_CMD_BIT_NO},
+        {HIL_BLOCK_DATA_IMAGE, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, abPd0Input), 0,
+                HIL_DIRECTION_IN | HIL_TRANSMISSION_TYPE_DPM, HIL_IO_MODE_BUFF_HST_CTRL, HCF_PD0_IN_ACK_BIT_NO},
+        {HIL_BLOCK_DATA_IMAGE_HI_PRIO, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, abPd1Output), HIL_DPM_HP_IO_DATA_SIZE,
+                HIL_DIRECTION_OUT | HIL_TRANSMISSION_TYPE_DPM, HIL_IO_MODE_BUFF_HST_CTRL, HCF_PD1_OUT_CMD_BIT_NO},
+        {HIL_BLOCK_DATA_IMAGE_HI_PRIO, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, abPd1Input), HIL_DPM_HP_IO_DATA_SIZE,
+                HIL_DIRECTION_IN | HIL_TRANSMISSION_TYPE_DPM, HIL_IO_MODE_BUFF_HST_CTRL, HCF_PD1_IN_ACK_BIT_NO},
+        {HIL_BLOCK_MAILBOX, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tSendMbx), sizeof(HIL_DPM_SEND_MAILBOX_BLOCK_T),
+                HIL_DIRECTION_OUT | HIL_TRANSMISSION_TYPE_DPM, 0, HCF_SEND_MBX_CMD_BIT_NO},
+        {HIL_BLOCK_MAILBOX, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tRecvMbx), sizeof(HIL_DPM_RECV_MAILBOX_BLOCK_T),
+                HIL_DIRECTION_IN | HIL_TRANSMISSION_TYPE_DPM, 0, HCF_RECV_MBX_ACK_BIT_NO},
+        {HIL_BLOCK_CTRL_PARAM, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tControl), sizeof(HIL_DPM_CONTROL_BLOCK_T),
+                HIL_DIRECTION_OUT | HIL_TRANSMISSION_TYPE_DPM, 0, 0},
+        {HIL_BLOCK_COMMON_STATE, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tCommonStatus),
+                sizeof(HIL_DPM_COMMON_STATUS_BLOCK_T), HIL_DIRECTION_IN | HIL_TRANSMISSION_TYPE_DPM, 0, 0},
+        {HIL_BLOCK_EXTENDED_STATE, offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tExtendedStatus),
+                sizeof(HIL_DPM_EXTENDED_STATUS_BLOCK_T), HIL_DIRECTION_IN | HIL_TRANSMISSION_TYPE_DPM, 0, 0},
+};
+
+static uint64_t netx_sim_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief busy waits like a blocking bus transfer, a sleep would be far too coarse for single accesses
+ * @param ns duration
+ */
+static void netx_sim_spin(uint64_t ns) {
+    uint64_t end;
+
+    if (ns == 0) {
+        return;
+    }
+    end = netx_sim_now_ns() + ns;
+    while (netx_sim_now_ns() < end) {
+    }
+}
+
+static HIL_DPM_SYSTEM_CHANNEL_T *netx_sim_sys(netx_sim_t *sim) {
+    return (HIL_DPM_SYSTEM_CHANNEL_T *) sim->dpm;
+}
+
+static HIL_DPM_DEFAULT_COMM_CHANNEL_T *netx_sim_comm(netx_sim_t *sim, uint32_t channel) {
+    return (HIL_DPM_DEFAULT_COMM_CHANNEL_T *) (sim->dpm + sim->channel[channel].offset);
+}
+
+/**
+ * @brief handshake cell of the system channel (index 0, 8 bit) or of a communication channel (block ID, 16 bit)
+ */
+static HIL_DPM_HANDSHAKE_CELL_T *netx_sim_cell(netx_sim_t *sim, uint32_t index) {
+    return (HIL_DPM_HANDSHAKE_CELL_T *) (sim->dpm + HIL_DPM_SYSTEM_CHANNEL_SIZE + index * sizeof(HIL_DPM_HANDSHAKE_CELL_T));
+}
+
+static uint16_t netx_sim_host_flags(const HIL_DPM_HANDSHAKE_CELL_T *cell, int wide) {
+    return wide ? cell->t16Bit.usHostFlags : cell->t8Bit.bHostFlags;
+}
+
+static uint16_t netx_sim_netx_flags(const HIL_DPM_HANDSHAKE_CELL_T *cell, int wide) {
+    return wide ? cell->t16Bit.usNetxFlags : cell->t8Bit.bNetxFlags;
+}
+
+static void netx_sim_set_netx_flags(netx_sim_t *sim, HIL_DPM_HANDSHAKE_CELL_T *cell, int wide, uint16_t flags) {
+    if (netx_sim_netx_flags(cell, wide) == flags) {
+        return;
+    }
+    if (wide) {
+        cell->t16Bit.usNetxFlags = flags;
+    } else {
+        cell->t8Bit.bNetxFlags = (uint8_t) flags;
+    }
+    sim->events++;
+}
+
+static void netx_sim_toggle(netx_sim_t *sim, HIL_DPM_HANDSHAKE_CELL_T *cell, int wide, uint16_t mask) {
+    netx_sim_set_netx_flags(sim, cell, wide, netx_sim_netx_flags(cell, wide) ^ mask);
+}
+
+/**
+ * @brief checks whether the host toggled a command (or acknowledge) bit that the firmware has not answered yet
+ */
+static int netx_sim_pending(const HIL_DPM_HANDSHAKE_CELL_T *cell, int wide, uint16_t mask) {
+    return ((netx_sim_host_flags(cell, wide) ^ netx_sim_netx_flags(cell, wide)) & mask) != 0;
+}
+
+static uint16_t netx_sim_get16(const netx_sim_t *sim, uint32_t offset) {
+    uint16_t value;
+    memcpy(&value, &sim->dpm[offset], sizeof(value));
+    return value;
+}
+
+static void netx_sim_put16(netx_sim_t *sim, uint32_t offset, uint16_t value) {
+    memcpy(&sim->dpm[offset], &value, sizeof(value));
+}
+
+/**
+ * @brief (re)creates the DPM of a started firmware, also the end of a system reset
+ * @param sim simulator instance
+ */
+static void netx_sim_layout(netx_sim_t *sim) {
+    HIL_DPM_SYSTEM_CHANNEL_T *sys = netx_sim_sys(sim);
+    NETX_GLOBAL_REG_BLOCK *global = (NETX_GLOBAL_REG_BLOCK *) (sim->dpm + NETX_SIM_DPM_SIZE - sizeof(NETX_GLOBAL_REG_BLOCK));
+    uint32_t c;
+
+    memset(sim->dpm, 0, sizeof(sim->dpm));
+
+    memcpy(sys->tSystemInfo.abCookie, CIFX_DPMSIGNATURE_FW_STR, sizeof(sys->tSystemInfo.abCookie));
+    sys->tSystemInfo.ulDpmTotalSize = NETX_SIM_DPM_SIZE;
+    sys->tSystemInfo.ulDeviceNumber = 1234567;
+    sys->tSystemInfo.ulSerialNumber = 1;
+
+    sys->atChannelInfo[HIL_DPM_SYSTEM_CHANNEL_INDEX].tSystem.bChannelType = HIL_CHANNEL_TYPE_SYSTEM;
+    sys->atChannelInfo[HIL_DPM_SYSTEM_CHANNEL_INDEX].tSystem.bSizePositionOfHandshake =
+            HIL_HANDSHAKE_POSITION_CHANNEL | HIL_HANDSHAKE_SIZE_8BIT;
+    sys->atChannelInfo[HIL_DPM_SYSTEM_CHANNEL_INDEX].tSystem.ulSizeOfChannel = HIL_DPM_SYSTEM_CHANNEL_SIZE;
+    sys->atChannelInfo[HIL_DPM_SYSTEM_CHANNEL_INDEX].tSystem.usSizeOfMailbox =
+            sizeof(HIL_DPM_SYSTEM_SEND_MAILBOX_T) + sizeof(HIL_DPM_SYSTEM_RECV_MAILBOX_T);
+    sys->atChannelInfo[HIL_DPM_SYSTEM_CHANNEL_INDEX].tSystem.usMailboxStartOffset =
+            offsetof(HIL_DPM_SYSTEM_CHANNEL_T, tSystemSendMailbox);
+
+    sys->atChannelInfo[HIL_DPM_HANDSHAKE_CHANNEL_INDEX].tHandshake.bChannelType = HIL_CHANNEL_TYPE_HANDSHAKE;
+    sys->atChannelInfo[HIL_DPM_HANDSHAKE_CHANNEL_INDEX].tHandshake.ulSizeOfChannel = sizeof(HIL_DPM_HANDSHAKE_CHANNEL_T);
+
+    sys->tSystemState.ulSystemStatus = HIL_SYS_STATUS_OK;
+    sys->tSystemSendMailbox.usPackagesAccepted = 1;
+
+    for (c = 0; c < sim->config.channels; c++) {
+        HIL_DPM_COMMUNICATION_CHANNEL_INFO_T *info = &sys->atChannelInfo[HIL_DPM_COM_CHANNEL_START_INDEX + c].tCom;
+        netx_sim_channel_t *ch = &sim->channel[c];
+        HIL_DPM_DEFAULT_COMM_CHANNEL_T *comm;
+
+        info->bChannelType = HIL_CHANNEL_TYPE_COMMUNICATION;
+        info->bChannelId = (uint8_t) c;
+        info->bSizePositionOfHandshake = HIL_HANDSHAKE_POSITION_CHANNEL | HIL_HANDSHAKE_SIZE_16BIT;
+        info->bNumberOfBlocks = NETX_SIM_BLOCKS;
+        info->ulSizeOfChannel = sizeof(HIL_DPM_DEFAULT_COMM_CHANNEL_T);
+        info->usCommunicationClass = HIL_COMM_CLASS_SLAVE;
+        info->usProtocolClass = HIL_PROT_CLASS_ETHERCAT;
+
+        memset(ch, 0, sizeof(*ch));
+        ch->offset = NETX_SIM_CHANNEL_START + c * sizeof(HIL_DPM_DEFAULT_COMM_CHANNEL_T);
+        ch->cos = HIL_COMM_COS_READY | HIL_COMM_COS_RUN;
+
+        comm = netx_sim_comm(sim, c);
+        comm->tCommonStatus.ulCommunicationCOS = ch->cos;
+        comm->tCommonStatus.ulCommunicationState = HIL_COMM_STATE_STOP;
+        comm->tCommonStatus.bPDInHskMode = HIL_IO_MODE_BUFF_HST_CTRL;
+        comm->tCommonStatus.bPDOutHskMode = HIL_IO_MODE_BUFF_HST_CTRL;
+        comm->tSendMbx.usPackagesAccepted = 1;
+
+        /* the host picks up the initial COS with its first look at the flags */
+        netx_sim_cell(sim, HIL_DPM_COM_CHANNEL_START_INDEX + c)->t16Bit.usNetxFlags = NCF_NETX_COS_CMD;
+    }
+
+    netx_sim_cell(sim, HIL_DPM_SYSTEM_CHANNEL_INDEX)->t8Bit.bNetxFlags = NSF_READY;
+
+    global->reserved6 = HBOOT_DPM_NETX90_COOKIE;
+    sim->events++;
+}
+
+/**
+ * @brief answers the packets the simulated firmware knows
+ * @return !=0 if cnf was filled in
+ */
+static int netx_sim_packet(netx_sim_t *sim, uint32_t channel, const HIL_PACKET_T *req, HIL_PACKET_T *cnf) {
+    switch (req->tHead.ulCmd) {
+    case HIL_DPM_GET_BLOCK_INFO_REQ: {
+        const HIL_DPM_GET_BLOCK_INFO_REQ_DATA_T *data = (const HIL_DPM_GET_BLOCK_INFO_REQ_DATA_T *) req->abData;
+        HIL_DPM_GET_BLOCK_INFO_CNF_DATA_T *info = (HIL_DPM_GET_BLOCK_INFO_CNF_DATA_T *) cnf->abData;
+        uint32_t c = data->ulAreaIndex - HIL_DPM_COM_CHANNEL_START_INDEX;
+        const netx_sim_block_t *block;
+
+        if (channel != CIFX_SYSTEM_DEVICE) {
+            return 0;
+        }
+        if (req->tHead.ulLen < sizeof(*data) || data->ulAreaIndex < HIL_DPM_COM_CHANNEL_START_INDEX ||
+            c >= sim->config.channels || data->ulSubblockIndex >= NETX_SIM_BLOCKS) {
+            cnf->tHead.ulSta = ERR_HIL_INVALID_PARAMETER;
+            return 1;
+        }
+        block = &netx_sim_blocks[data->ulSubblockIndex];
+        memset(info, 0, sizeof(*info));
+        info->ulAreaIndex = data->ulAreaIndex;
+        info->ulSubblockIndex = data->ulSubblockIndex;
+        info->ulType = block->type;
+        info->ulOffset = block->offset;
+        info->ulSize = block->size ? block->size : sim->config.io_size;
+        info->usFlags = block->flags;
+        info->usHandshakeMode = block->hsk_mode;
+        info->usHandshakeBit = block->hsk_bit;
+        cnf->tHead.ulLen = sizeof(*info);
+        return 1;
+    }
+
+    case HIL_FIRMWARE_IDENTIFY_REQ: {
+        HIL_FW_IDENTIFICATION_T *ident = &((HIL_FIRMWARE_IDENTIFY_CNF_DATA_T *) cnf->abData)->tFirmwareIdentification;
+
+        memset(ident, 0, sizeof(*ident));
+        ident->tFwVersion.usMajor = 1;
+        ident->tFwName.bNameLength = sizeof(NETX_SIM_FW_NAME) - 1;
+        memcpy(ident->tFwName.abName, NETX_SIM_FW_NAME, sizeof(NETX_SIM_FW_NAME) - 1);
+        ident->tFwDate.usYear = 2022;
+        ident->tFwDate.bMonth = 1;
+        ident->tFwDate.bDay = 1;
+        cnf->tHead.ulLen = sizeof(HIL_FIRMWARE_IDENTIFY_CNF_DATA_T);
+        return 1;
+    }
+
+    default:
+        break;
+    }
+
+    if (sim->config.packet != NULL) {
+        return sim->config.packet(sim->config.packet_arg, channel, req, cnf);
+    }
+    return 0;
+}
+
+/**
+ * @brief firmware side of a send/receive mailbox pair. A request is only taken while the receive mailbox is free,
+ * so the host sees at most one waiting answer
+ * @param sim simulator instance
+ * @param channel communication channel, CIFX_SYSTEM_DEVICE for the system channel
+ * @param cell handshake cell of the channel
+ * @param wide !=0 for a 16 bit handshake cell
+ * @param send DPM offset of the send mailbox (packages accepted counter)
+ * @param recv DPM offset of the receive mailbox (waiting packages counter)
+ * @param size size of the packet buffers
+ */
+static void netx_sim_mailbox(netx_sim_t *sim, uint32_t channel, HIL_DPM_HANDSHAKE_CELL_T *cell, int wide,
+                             uint32_t send, uint32_t recv, uint32_t size) {
+    HIL_PACKET_T req;
+    HIL_PACKET_T cnf;
+    uint32_t len;
+
+    /* host took the answer */
+    if (!netx_sim_pending(cell, wide, NCF_RECV_MBX_CMD) && netx_sim_get16(sim, recv) != 0) {
+        netx_sim_put16(sim, recv, 0);
+    }
+
+    if (!netx_sim_pending(cell, wide, NCF_SEND_MBX_ACK) || netx_sim_pending(cell, wide, NCF_RECV_MBX_CMD)) {
+        return;
+    }
+
+    memcpy(&req.tHead, &sim->dpm[send + NETX_SIM_MBX_HEADER], sizeof(req.tHead));
+    len = req.tHead.ulLen;
+    if (len > size - sizeof(req.tHead)) {
+        len = size - sizeof(req.tHead);
+        req.tHead.ulLen = len;
+    }
+    memcpy(req.abData, &sim->dpm[send + NETX_SIM_MBX_HEADER + sizeof(req.tHead)], len);
+    sim->stats.packets++;
+
+    /* the send mailbox is free again */
+    netx_sim_toggle(sim, cell, wide, NCF_SEND_MBX_ACK);
+
+    /* answers to indications of the firmware are not confirmed */
+    if (req.tHead.ulCmd & HIL_MSK_PACKET_ANSWER) {
+        return;
+    }
+
+    cnf.tHead = req.tHead;
+    cnf.tHead.ulCmd |= HIL_MSK_PACKET_ANSWER;
+    cnf.tHead.ulSta = SUCCESS_HIL_OK;
+    cnf.tHead.ulLen = 0;
+    if (!netx_sim_packet(sim, channel, &req, &cnf)) {
+        cnf.tHead.ulSta = ERR_HIL_UNKNOWN_COMMAND;
+        cnf.tHead.ulLen = 0;
+    }
+    if (cnf.tHead.ulLen > size - sizeof(cnf.tHead)) {
+        cnf.tHead.ulLen = size - sizeof(cnf.tHead);
+    }
+
+    memcpy(&sim->dpm[recv + NETX_SIM_MBX_HEADER], &cnf, sizeof(cnf.tHead) + cnf.tHead.ulLen);
+    netx_sim_put16(sim, recv, 1);
+    netx_sim_toggle(sim, cell, wide, NCF_RECV_MBX_CMD);
+}
+
+/**
+ * @brief system channel: reset, host COS and the system mailbox
+ * @return !=0 if a system reset was started
+ */
+static int netx_sim_system_step(netx_sim_t *sim, uint64_t now) {
+    HIL_DPM_SYSTEM_CHANNEL_T *sys = netx_sim_sys(sim);
+    HIL_DPM_HANDSHAKE_CELL_T *cell = netx_sim_cell(sim, HIL_DPM_SYSTEM_CHANNEL_INDEX);
+
+    if ((cell->t8Bit.bHostFlags & HSF_RESET) && sys->tSystemControl.ulSystemCommandCOS == HIL_SYS_RESET_COOKIE) {
+        NETX_GLOBAL_REG_BLOCK *global = (NETX_GLOBAL_REG_BLOCK *) (sim->dpm + NETX_SIM_DPM_SIZE -
+                                                                  sizeof(NETX_GLOBAL_REG_BLOCK));
+
+        /* the DPM is gone until the firmware has started again, the ROM loader identification stays */
+        memset(sim->dpm, 0, NETX_SIM_DPM_SIZE - sizeof(NETX_GLOBAL_REG_BLOCK));
+        global->reserved6 = HBOOT_DPM_NETX90_COOKIE;
+        sim->reset_ns = now + (uint64_t) sim->config.restart_ms * 1000000ULL;
+        if (sim->reset_ns == 0) {
+            sim->reset_ns = 1;
+        }
+        sim->stats.resets++;
+        sim->events++;
+        return 1;
+    }
+
+    if (netx_sim_pending(cell, 0, NSF_HOST_COS_ACK)) {
+        netx_sim_toggle(sim, cell, 0, NSF_HOST_COS_ACK);
+    }
+
+    netx_sim_mailbox(sim, CIFX_SYSTEM_DEVICE, cell, 0,
+                     offsetof(HIL_DPM_SYSTEM_CHANNEL_T, tSystemSendMailbox),
+                     offsetof(HIL_DPM_SYSTEM_CHANNEL_T, tSystemRecvMailbox),
+                     HIL_DPM_SYSTEM_MAILBOX_MIN_SIZE);
+    return 0;
+}
+
+/**
+ * @brief buffered host controlled process data of a channel, only exchanged while the firmware runs
+ */
+static void netx_sim_io_step(netx_sim_t *sim, uint32_t c, HIL_DPM_HANDSHAKE_CELL_T *cell, uint64_t now) {
+    netx_sim_channel_t *ch = &sim->channel[c];
+    HIL_DPM_DEFAULT_COMM_CHANNEL_T *comm = netx_sim_comm(sim, c);
+
+    if (netx_sim_pending(cell, 1, NCF_PD0_OUT_ACK)) {
+        memcpy(ch->pd0_image, comm->abPd0Output, sim->config.io_size);
+        netx_sim_toggle(sim, cell, 1, NCF_PD0_OUT_ACK);
+        sim->stats.output_updates++;
+    }
+
+    if (netx_sim_pending(cell, 1, NCF_PD1_OUT_ACK)) {
+        memcpy(ch->pd1_image, comm->abPd1Output, sizeof(ch->pd1_image));
+        netx_sim_toggle(sim, cell, 1, NCF_PD1_OUT_ACK);
+    }
+
+    if (netx_sim_pending(cell, 1, NCF_PD0_IN_CMD) && now >= ch->next_input_ns) {
+        ch->input_count++;
+        memcpy(comm->abPd0Input, ch->pd0_image, sim->config.io_size);
+        if (sim->config.io_model == NETX_SIM_IO_COUNTER) {
+            memcpy(comm->abPd0Input, &ch->input_count,
+                   sim->config.io_size < sizeof(ch->input_count) ? sim->config.io_size : sizeof(ch->input_count));
+        }
+        ch->next_input_ns = now + sim->config.io_cycle_ns;
+        netx_sim_toggle(sim, cell, 1, NCF_PD0_IN_CMD);
+        sim->stats.input_updates++;
+    }
+
+    if (netx_sim_pending(cell, 1, NCF_PD1_IN_CMD)) {
+        memcpy(comm->abPd1Input, ch->pd1_image, sizeof(ch->pd1_image));
+        netx_sim_toggle(sim, cell, 1, NCF_PD1_IN_CMD);
+    }
+}
+
+/**
+ * @brief communication channel: application COS, channel init, bus state, watchdog, mailbox and process data
+ */
+static void netx_sim_channel_step(netx_sim_t *sim, uint32_t c, uint64_t now) {
+    netx_sim_channel_t *ch = &sim->channel[c];
+    HIL_DPM_DEFAULT_COMM_CHANNEL_T *comm = netx_sim_comm(sim, c);
+    HIL_DPM_HANDSHAKE_CELL_T *cell = netx_sim_cell(sim, HIL_DPM_COM_CHANNEL_START_INDEX + c);
+    uint16_t flags;
+    int communicating;
+
+    if (ch->ready_ns != 0 && now >= ch->ready_ns) {
+        ch->ready_ns = 0;
+        ch->cos |= HIL_COMM_COS_READY | HIL_COMM_COS_RUN;
+    }
+
+    if (netx_sim_pending(cell, 1, NCF_HOST_COS_ACK)) {
+        uint32_t app_cos = comm->tControl.ulApplicationCOS;
+
+        if ((app_cos & (HIL_APP_COS_INITIALIZATION | HIL_APP_COS_INITIALIZATION_ENABLE)) ==
+            (HIL_APP_COS_INITIALIZATION | HIL_APP_COS_INITIALIZATION_ENABLE)) {
+            ch->cos &= ~(HIL_COMM_COS_READY | HIL_COMM_COS_RUN);
+            ch->ready_ns = now + (uint64_t) sim->config.restart_ms * 1000000ULL;
+            if (ch->ready_ns == 0) {
+                ch->ready_ns = 1;
+            }
+        }
+        if (app_cos & HIL_APP_COS_BUS_ON_ENABLE) {
+            ch->bus_on = (app_cos & HIL_APP_COS_BUS_ON) != 0;
+        }
+        if (app_cos & HIL_APP_COS_LOCK_CONFIGURATION_ENABLE) {
+            ch->config_locked = (app_cos & HIL_APP_COS_LOCK_CONFIGURATION) != 0;
+        }
+        netx_sim_toggle(sim, cell, 1, NCF_HOST_COS_ACK);
+    }
+
+    ch->cos &= ~(HIL_COMM_COS_BUS_ON | HIL_COMM_COS_CONFIG_LOCKED);
+    ch->cos |= (ch->bus_on ? HIL_COMM_COS_BUS_ON : 0) | (ch->config_locked ? HIL_COMM_COS_CONFIG_LOCKED : 0);
+
+    communicating = ch->bus_on && ch->ready_ns == 0;
+    comm->tCommonStatus.ulCommunicationState = communicating ? HIL_COMM_STATE_OPERATE : HIL_COMM_STATE_STOP;
+    flags = netx_sim_netx_flags(cell, 1);
+    netx_sim_set_netx_flags(sim, cell, 1,
+                            communicating ? (flags | NCF_COMMUNICATING) : (flags & ~NCF_COMMUNICATING));
+
+    /* a new COS is only signalled after the host acknowledged the previous one */
+    if (comm->tCommonStatus.ulCommunicationCOS != ch->cos && !netx_sim_pending(cell, 1, NCF_NETX_COS_CMD)) {
+        comm->tCommonStatus.ulCommunicationCOS = ch->cos;
+        netx_sim_toggle(sim, cell, 1, NCF_NETX_COS_CMD);
+        sim->stats.cos_changes++;
+    }
+
+    /* host copied the last watchdog value, next trigger */
+    if (comm->tControl.ulDeviceWatchdog == comm->tCommonStatus.ulHostWatchdog) {
+        comm->tCommonStatus.ulHostWatchdog++;
+    }
+
+    netx_sim_mailbox(sim, c, cell, 1,
+                     ch->offset + offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tSendMbx),
+                     ch->offset + offsetof(HIL_DPM_DEFAULT_COMM_CHANNEL_T, tRecvMbx),
+                     HIL_DPM_CHANNEL_MAILBOX_SIZE);
+
+    if (ch->ready_ns == 0 && (ch->cos & HIL_COMM_COS_RUN)) {
+        netx_sim_io_step(sim, c, cell, now);
+    }
+}
+
+static void netx_sim_step(netx_sim_t *sim, uint64_t now) {
+    uint32_t c;
+
+    if (sim->reset_ns != 0) {
+        if (now < sim->reset_ns) {
+            return;
+        }
+        sim->reset_ns = 0;
+        netx_sim_layout(sim);
+    }
+
+    if (netx_sim_system_step(sim, now)) {
+        return;
+    }
+
+    for (c = 0; c < sim->config.channels; c++) {
+        netx_sim_channel_step(sim, c, now);
+    }
+}
+
+static void *netx_sim_thread(void *arg) {
+    netx_sim_t *sim = (netx_sim_t *) arg;
+    struct timespec period = {.tv_sec = sim->config.fw_period_ns / 1000000000U,
+            .tv_nsec = sim->config.fw_period_ns % 1000000000U};
+
+    while (sim->running) {
+        uint32_t events;
+
+        if (sim->config.fw_period_ns == 0) {
+            sched_yield();
+        } else {
+            nanosleep(&period, NULL);
+        }
+
+        pthread_mutex_lock(&sim->lock);
+        sim->events = 0;
+        netx_sim_step(sim, netx_sim_now_ns());
+        events = sim->events;
+        pthread_mutex_unlock(&sim->lock);
+
+        /* DIRQ: one byte per firmware step that changed netX flags, a full pipe means the host is behind anyway */
+        if (events != 0 && sim->irq_fd[1] >= 0) {
+            uint8_t irq = 1;
+            if (write(sim->irq_fd[1], &irq, 1) == 1) {
+                __atomic_add_fetch(&sim->stats.irqs, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static netx_sim_t *netx_sim_from_dev(void *dev) {
+    return (netx_sim_t *) (((PDEVICEINSTANCE) dev)->pbDPM - offsetof(netx_sim_t, dpm));
+}
+
+/**
+ * @brief copies between the DPM and a host buffer, the simulator is locked
+ * @return 0 if the range is outside of the DPM
+ */
+static int netx_sim_access(netx_sim_t *sim, void *addr, void *data, uint32_t len, int write) {
+    uintptr_t offset = (uintptr_t) addr - (uintptr_t) sim->dpm;
+
+    if ((uintptr_t) addr < (uintptr_t) sim->dpm || offset > NETX_SIM_DPM_SIZE || len > NETX_SIM_DPM_SIZE - offset) {
+        if (!write) {
+            memset(data, 0, len);
+        }
+        return 0;
+    }
+
+    if (write) {
+        memcpy(&sim->dpm[offset], data, len);
+        sim->stats.writes++;
+        sim->stats.write_bytes += len;
+    } else {
+        memcpy(data, &sim->dpm[offset], len);
+        sim->stats.reads++;
+        sim->stats.read_bytes += len;
+    }
+    return 1;
+}
+
+static void *netx_sim_read(void *pvDevInstance, void *pvAddr, void *pvData, uint32_t ulLen) {
+    netx_sim_t *sim = netx_sim_from_dev(pvDevInstance);
+
+    pthread_mutex_lock(&sim->lock);
+    netx_sim_access(sim, pvAddr, pvData, ulLen, 0);
+    pthread_mutex_unlock(&sim->lock);
+
+    CIFX_STATS_HWIF_FRAME((PDEVICEINSTANCE) pvDevInstance, ulLen);
+    netx_sim_spin(sim->config.access_ns + (uint64_t) ulLen * sim->config.byte_ns);
+    return pvData;
+}
+
+static void *netx_sim_write(void *pvDevInstance, void *pvAddr, void *pvData, uint32_t ulLen) {
+    netx_sim_t *sim = netx_sim_from_dev(pvDevInstance);
+
+    pthread_mutex_lock(&sim->lock);
+    netx_sim_access(sim, pvAddr, pvData, ulLen, 1);
+    pthread_mutex_unlock(&sim->lock);
+
+    CIFX_STATS_HWIF_FRAME((PDEVICEINSTANCE) pvDevInstance, ulLen);
+    netx_sim_spin(sim->config.access_ns + (uint64_t) ulLen * sim->config.byte_ns);
+    return pvAddr;
+}
+
+/**
+ * @brief vectored access, entries are copied atomically with respect to the firmware. Frames are split as by the
+ * serial DPM (TransferV): a run of ascending entries costs one access, reads may skip up to SERDPM_READV_MAX_GAP
+ * bytes (clocked like data), writes only join adjacent entries
+ */
+static void netx_sim_transfer_v(void *pvDevInstance, HWIF_IOVEC_T *ptIoVec, uint32_t ulCount, int write) {
+    PDEVICEINSTANCE dev = (PDEVICEINSTANCE) pvDevInstance;
+    netx_sim_t *sim = netx_sim_from_dev(pvDevInstance);
+    uint64_t cost_ns = 0;
+    uintptr_t start = 0;
+    uintptr_t end = 0;
+    uint32_t i;
+
+    pthread_mutex_lock(&sim->lock);
+    for (i = 0; i < ulCount; i++) {
+        uintptr_t addr = (uintptr_t) ptIoVec[i].pvAddr;
+
+        if (ptIoVec[i].ulLen == 0) {
+            continue;
+        }
+        netx_sim_access(sim, ptIoVec[i].pvAddr, ptIoVec[i].pvData, ptIoVec[i].ulLen, write);
+
+        if (end == 0 || addr < end || (write && addr != end) || addr - end > SERDPM_READV_MAX_GAP) {
+            if (end != 0) {
+                CIFX_STATS_HWIF_FRAME(dev, (uint32_t) (end - start));
+            }
+            cost_ns += sim->config.access_ns;
+            start = addr;
+            end = addr;
+        }
+        cost_ns += (uint64_t) (addr + ptIoVec[i].ulLen - end) * sim->config.byte_ns;
+        end = addr + ptIoVec[i].ulLen;
+    }
+    pthread_mutex_unlock(&sim->lock);
+
+    if (end != 0) {
+        CIFX_STATS_HWIF_FRAME(dev, (uint32_t) (end - start));
+    }
+    netx_sim_spin(cost_ns);
+}
+
+static void netx_sim_read_v(void *pvDevInstance, HWIF_IOVEC_T *ptIoVec, uint32_t ulCount) {
+    netx_sim_transfer_v(pvDevInstance, ptIoVec, ulCount, 0);
+}
+
+static void netx_sim_write_v(void *pvDevInstance, HWIF_IOVEC_T *ptIoVec, uint32_t ulCount) {
+    netx_sim_transfer_v(pvDevInstance, ptIoVec, ulCount, 1);
+}
+
+/**
+ * @brief defaults from gbcifx_config.h, one channel with the application process image size
+ * @param config returned configuration
+ */
+void netx_sim_default_config(netx_sim_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->channels = 1;
+    config->io_size = NETX_SIM_IO_SIZE;
+    config->io_model = NETX_SIM_IO_LOOPBACK;
+    config->access_ns = NETX_SIM_ACCESS_NS;
+    config->byte_ns = NETX_SIM_BYTE_NS;
+    config->fw_period_ns = NETX_SIM_FW_PERIOD_NS;
+    config->io_cycle_ns = NETX_SIM_IO_CYCLE_NS;
+    config->restart_ms = NETX_SIM_RESTART_MS;
+}
+
+/**
+ * @brief creates the DPM of a running firmware, starts the firmware thread and attaches the device instance to it
+ * (pbDPM, ulDPMSize and the HWIF functions). Takes the place of SerialDPM_Init
+ * @param sim simulator instance, must stay valid until netx_sim_close
+ * @param config simulator configuration
+ * @param dev toolkit device instance, not yet added
+ * @return 0 on success, errno value otherwise
+ */
+int netx_sim_open(netx_sim_t *sim, const netx_sim_config_t *config, PDEVICEINSTANCE dev) {
+    int rc;
+
+    if (config == NULL || dev == NULL || config->channels == 0 || config->channels > NETX_SIM_MAX_CHANNELS ||
+        config->io_size > HIL_DPM_IO_DATA_SIZE) {
+        return EINVAL;
+    }
+
+    memset(sim, 0, sizeof(*sim));
+    sim->config = *config;
+    sim->irq_fd[0] = -1;
+    sim->irq_fd[1] = -1;
+
+    if (config->irq && pipe2(sim->irq_fd, O_NONBLOCK | O_CLOEXEC) != 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create the simulator DIRQ pipe [%s]", strerror(rc));
+        return rc;
+    }
+
+    pthread_mutex_init(&sim->lock, NULL);
+    netx_sim_layout(sim);
+
+    dev->pbDPM = sim->dpm;
+    dev->ulDPMSize = NETX_SIM_DPM_SIZE;
+    dev->pfnHwIfRead = netx_sim_read;
+    dev->pfnHwIfWrite = netx_sim_write;
+    dev->pfnHwIfReadV = netx_sim_read_v;
+    dev->pfnHwIfWriteV = netx_sim_write_v;
+
+    sim->running = 1;
+    rc = pthread_create(&sim->fw_thread, NULL, netx_sim_thread, sim);
+    if (rc != 0) {
+        sim->running = 0;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to create the simulator firmware thread [%s]", strerror(rc));
+        netx_sim_close(sim);
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief stops the firmware thread and closes the DIRQ pipe. The device instance must have been removed from the
+ * toolkit before
+ * @param sim simulator instance
+ */
+void netx_sim_close(netx_sim_t *sim) {
+    if (sim->running) {
+        sim->running = 0;
+        pthread_join(sim->fw_thread, NULL);
+    }
+    if (sim->irq_fd[0] >= 0) {
+        close(sim->irq_fd[0]);
+        sim->irq_fd[0] = -1;
+    }
+    if (sim->irq_fd[1] >= 0) {
+        close(sim->irq_fd[1]);
+        sim->irq_fd[1] = -1;
+    }
+    pthread_mutex_destroy(&sim->lock);
+}
+
+/**
+ * @brief read end of the DIRQ pipe, for an OS_Irq device with eOS_IRQ_SOURCE_FD
+ * @param sim simulator instance
+ * @return file descriptor, -1 if the simulator was opened without irq
+ */
+int netx_sim_irq_fd(const netx_sim_t *sim) {
+    return sim->irq_fd[0];
+}
+
+/**
+ * @brief copy of the simulator counters
+ * @param sim simulator instance
+ * @param stats returned counters
+ */
+void netx_sim_get_stats(netx_sim_t *sim, netx_sim_stats_t *stats) {
+    pthread_mutex_lock(&sim->lock);
+    *stats = sim->stats;
+    stats->irqs = __atomic_load_n(&sim->stats.irqs, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&sim->lock);
+}
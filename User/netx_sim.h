@@ -0,0 +1,122 @@
+/**
+ ******************************************************************************
+ * @file           :  netx_sim.h
+ * @brief          :  in-memory netX DPM with a simulated firmware, plugged in through the toolkit HWIF functions
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_NETX_SIM_H
+#define GBCIFX_NETX_SIM_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "cifXToolkit.h"
+#include "Hil_DualPortMemory.h"
+#include "Hil_Packet.h"
+
+/**
+ * The simulator presents itself as a flash based netX90 with a running firmware: a system channel, a handshake
+ * channel and NETX_SIM_MAX_CHANNELS default communication channels (HIL_DPM_DEFAULT_COMM_CHANNEL_T) with 16 bit
+ * handshake cells. The firmware thread answers the system and channel mailboxes (HIL_DPM_GET_BLOCK_INFO_REQ,
+ * HIL_FIRMWARE_IDENTIFY_REQ), the COS handshakes (application ready, bus on/off, channel init, lock configuration,
+ * watchdog, system reset) and the buffered host controlled process data handshakes of PD0 and PD1.
+ *
+ * Host accesses and the firmware are serialised by a mutex. The host side latency is charged after the access,
+ * outside the mutex, by spinning like a blocking SPI transfer does.
+ */
+
+/** size of the simulated DPM, the netX global register block is at its end */
+#define NETX_SIM_DPM_SIZE               0x10000
+
+/** communication channels that fit into the DPM in front of the global register block */
+#define NETX_SIM_MAX_CHANNELS           3
+
+/** subblocks reported per communication channel by HIL_DPM_GET_BLOCK_INFO_REQ */
+#define NETX_SIM_BLOCKS                 9
+
+/** what the firmware puts into the input areas */
+typedef enum {
+    NETX_SIM_IO_LOOPBACK,               /** inputs are the last outputs written by the host */
+    NETX_SIM_IO_COUNTER,                /** first 4 input bytes count the input updates, the rest is looped back */
+} netx_sim_io_model_t;
+
+/**
+ * @brief called by the firmware thread for mailbox packets the simulator does not know, with the simulator locked
+ * @param arg packet_arg of the configuration
+ * @param channel communication channel, CIFX_SYSTEM_DEVICE for the system channel
+ * @param req request, ulLen is already checked against the mailbox size
+ * @param cnf answer, header prefilled from the request with ulCmd | HIL_MSK_PACKET_ANSWER, ulLen 0
+ * @return !=0 if the callback filled in cnf, 0 to answer with ERR_HIL_UNKNOWN_COMMAND
+ */
+typedef int (*netx_sim_packet_fn)(void *arg, uint32_t channel, const HIL_PACKET_T *req, HIL_PACKET_T *cnf);
+
+typedef struct {
+    uint32_t channels;                  /** communication channels, 1..NETX_SIM_MAX_CHANNELS */
+    uint32_t io_size;                   /** size of the PD0 input and output areas, max. HIL_DPM_IO_DATA_SIZE */
+    netx_sim_io_model_t io_model;       /** content of the input areas */
+    uint32_t access_ns;                 /** host side latency of every DPM access (bus transaction) */
+    uint32_t byte_ns;                   /** host side latency per byte transferred */
+    uint32_t fw_period_ns;              /** poll period of the firmware thread, i.e. the handshake response time */
+    uint32_t io_cycle_ns;               /** bus cycle, new inputs are provided at most once per cycle, 0 = on every handshake */
+    uint32_t restart_ms;                /** time the firmware takes for a channel init or a system reset */
+    int irq;                            /** !=0 to signal netX flag changes on the DIRQ pipe, see netx_sim_irq_fd() */
+    netx_sim_packet_fn packet;          /** optional handler for unknown mailbox packets */
+    void *packet_arg;                   /** argument passed to packet */
+} netx_sim_config_t;
+
+typedef struct {
+    uint64_t reads;                     /** host read transactions */
+    uint64_t writes;                    /** host write transactions */
+    uint64_t read_bytes;                /** bytes read by the host */
+    uint64_t write_bytes;               /** bytes written by the host */
+    uint64_t packets;                   /** mailbox packets received by the firmware */
+    uint64_t input_updates;             /** input images handed to the host */
+    uint64_t output_updates;            /** output images taken from the host */
+    uint64_t irqs;                      /** DIRQ events raised */
+    uint32_t cos_changes;               /** communication COS changes signalled to the host */
+    uint32_t resets;                    /** system resets executed */
+} netx_sim_stats_t;
+
+/** firmware side state of a communication channel */
+typedef struct {
+    uint32_t offset;                    /** DPM offset of the channel */
+    uint32_t cos;                       /** COS flags the firmware wants the host to see */
+    int bus_on;                         /** host requested bus on */
+    int config_locked;                  /** host locked the configuration */
+    uint64_t ready_ns;                  /** channel init in progress until this time, 0 = running */
+    uint64_t next_input_ns;             /** earliest time of the next input update (io_cycle_ns) */
+    uint32_t input_count;               /** input updates, NETX_SIM_IO_COUNTER */
+    uint8_t pd0_image[HIL_DPM_IO_DATA_SIZE];    /** last PD0 outputs taken from the host */
+    uint8_t pd1_image[HIL_DPM_HP_IO_DATA_SIZE]; /** last PD1 outputs taken from the host */
+} netx_sim_channel_t;
+
+typedef struct {
+    /** DPM image, handed to the toolkit as pbDPM. The HWIF functions find the simulator through it */
+    uint8_t dpm[NETX_SIM_DPM_SIZE];
+    netx_sim_config_t config;
+    netx_sim_channel_t channel[NETX_SIM_MAX_CHANNELS];
+    pthread_mutex_t lock;               /** serialises host accesses and the firmware */
+    pthread_t fw_thread;
+    volatile int running;
+    uint64_t reset_ns;                  /** system reset in progress until this time, 0 = running */
+    uint32_t events;                    /** netX flag changes in the current firmware step */
+    int irq_fd[2];                      /** DIRQ pipe, one byte per event, [0] is the read end */
+    netx_sim_stats_t stats;
+} netx_sim_t;
+
+void netx_sim_default_config(netx_sim_config_t *config);
+
+int netx_sim_open(netx_sim_t *sim, const netx_sim_config_t *config, PDEVICEINSTANCE dev);
+
+void netx_sim_close(netx_sim_t *sim);
+
+int netx_sim_irq_fd(const netx_sim_t *sim);
+
+void netx_sim_get_stats(netx_sim_t *sim, netx_sim_stats_t *stats);
+
+#endif //GBCIFX_NETX_SIM_H
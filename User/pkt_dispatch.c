@@ -0,0 +1,153 @@
+/**
+ ******************************************************************************
+ * @file           :  pkt_dispatch.c
+ * @brief          :  constant time dispatch of received packets by command
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#include "pkt_dispatch.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#if PKT_DISPATCH_SLOTS < 4 * PKT_DISPATCH_MAX_CMDS || PKT_DISPATCH_MAX_CMDS > 255
+#error "PKT_DISPATCH_MAX_CMDS does not fit the dispatch hash table"
+#endif
+
+/* odd multipliers tried in turn, starting at the golden ratio */
+#define PKT_DISPATCH_MULT_FIRST         0x9E3779B1u
+#define PKT_DISPATCH_MULT_STEP          0x6A09E668u
+#define PKT_DISPATCH_MULT_TRIES         100000
+
+static inline uint32_t pkt_dispatch_slot(uint32_t mult, uint32_t cmd) {
+    return (cmd * mult) >> (32 - PKT_DISPATCH_SLOTS_BITS);
+}
+
+static uint64_t pkt_dispatch_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief fills the slots with the registered commands for a multiplier
+ * @return 0 if no two commands share a slot
+ */
+static int pkt_dispatch_build(pkt_dispatch_t *dispatch, uint32_t mult) {
+    memset(dispatch->slots, 0, sizeof(dispatch->slots));
+
+    for (uint32_t i = 0; i < dispatch->num_entries; i++) {
+        uint32_t slot = pkt_dispatch_slot(mult, dispatch->entries[i].cmd);
+
+        if (dispatch->slots[slot] != 0) {
+            return -1;
+        }
+        dispatch->slots[slot] = (uint8_t) (i + 1);
+    }
+    dispatch->mult = mult;
+    return 0;
+}
+
+/**
+ * @brief empty dispatch table
+ * @param dispatch dispatch instance
+ */
+void pkt_dispatch_init(pkt_dispatch_t *dispatch) {
+    memset(dispatch, 0, sizeof(*dispatch));
+    dispatch->mult = PKT_DISPATCH_MULT_FIRST;
+}
+
+/**
+ * @brief registers the handler of a command and rebuilds the hash table
+ * @param dispatch dispatch instance
+ * @param cmd ulCmd of the packets to handle
+ * @param fn handler
+ * @param arg argument passed to fn
+ * @return 0, EEXIST if cmd has a handler, ENOSPC if PKT_DISPATCH_MAX_CMDS are registered or no collision free
+ * multiplier was found
+ */
+int pkt_dispatch_register(pkt_dispatch_t *dispatch, uint32_t cmd, pkt_dispatch_fn fn, void *arg) {
+    pkt_dispatch_entry_t *entry;
+    uint32_t mult = PKT_DISPATCH_MULT_FIRST;
+
+    if (fn == NULL) {
+        return EINVAL;
+    }
+    if (pkt_dispatch_find(dispatch, cmd) != NULL) {
+        return EEXIST;
+    }
+    if (dispatch->num_entries == PKT_DISPATCH_MAX_CMDS) {
+        return ENOSPC;
+    }
+
+    entry = &dispatch->entries[dispatch->num_entries++];
+    memset(entry, 0, sizeof(*entry));
+    entry->cmd = cmd;
+    entry->fn = fn;
+    entry->arg = arg;
+
+    /* the current multiplier is usually still collision free */
+    if (pkt_dispatch_build(dispatch, dispatch->mult) == 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < PKT_DISPATCH_MULT_TRIES; i++, mult += PKT_DISPATCH_MULT_STEP) {
+        if (pkt_dispatch_build(dispatch, mult | 1) == 0) {
+            return 0;
+        }
+    }
+
+    /* back to the previous table, collision free without the new command */
+    dispatch->num_entries--;
+    pkt_dispatch_build(dispatch, dispatch->mult);
+    return ENOSPC;
+}
+
+/**
+ * @brief handler and statistics of a command
+ * @param dispatch dispatch instance
+ * @param cmd ulCmd
+ * @return entry, NULL if cmd has no handler
+ */
+const pkt_dispatch_entry_t *pkt_dispatch_find(const pkt_dispatch_t *dispatch, uint32_t cmd) {
+    uint8_t index = dispatch->slots[pkt_dispatch_slot(dispatch->mult, cmd)];
+
+    if (index == 0 || dispatch->entries[index - 1].cmd != cmd) {
+        return NULL;
+    }
+    return &dispatch->entries[index - 1];
+}
+
+/**
+ * @brief calls the handler registered for the command of a packet
+ * @param dispatch dispatch instance
+ * @param pkt received packet
+ * @param result return value of the handler
+ * @return 0 if a handler was called, ENOENT if the command has no handler (result untouched)
+ */
+int pkt_dispatch(pkt_dispatch_t *dispatch, CIFX_PACKET *pkt, int32_t *result) {
+    pkt_dispatch_entry_t *entry = (pkt_dispatch_entry_t *) pkt_dispatch_find(dispatch, pkt->tHeader.ulCmd);
+    uint64_t start;
+    uint64_t ns;
+
+    if (entry == NULL) {
+        dispatch->misses++;
+        return ENOENT;
+    }
+
+    start = pkt_dispatch_now_ns();
+    *result = entry->fn(pkt, entry->arg);
+    ns = pkt_dispatch_now_ns() - start;
+
+    entry->count++;
+    entry->total_ns += ns;
+    if (ns > entry->max_ns) {
+        entry->max_ns = ns;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @file           :  pkt_dispatch.h
+ * @brief          :  constant time dispatch of received packets by command
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_PKT_DISPATCH_H
+#define GBCIFX_PKT_DISPATCH_H
+
+#include <stdint.h>
+#include "cifXUser.h"
+#include "gbcifx_config.h"
+
+/**
+ * Handlers are registered per ulCmd at startup. Every registration rebuilds a perfect hash over the registered
+ * commands (multiplicative hash, the multiplier is searched until no two commands share a slot), so a dispatch is
+ * one multiplication, one table read and one compare whatever the number of handlers. Registration is not thread
+ * safe and must be finished before the first dispatch. Dispatch itself is meant for a single thread, the handler
+ * statistics are not atomic.
+ */
+
+/** slots of the hash table, power of 2 and at least 4 * PKT_DISPATCH_MAX_CMDS to keep the multiplier search short */
+#define PKT_DISPATCH_SLOTS_BITS         7
+#define PKT_DISPATCH_SLOTS              (1u << PKT_DISPATCH_SLOTS_BITS)
+
+/**
+ * handler of a received packet
+ * @return result of the handling, passed on by pkt_dispatch()
+ */
+typedef int32_t (*pkt_dispatch_fn)(CIFX_PACKET *pkt, void *arg);
+
+typedef struct {
+    uint32_t cmd;
+    pkt_dispatch_fn fn;
+    void *arg;
+    uint64_t count;                     /** packets handled */
+    uint64_t total_ns;                  /** time spent in the handler */
+    uint64_t max_ns;                    /** longest handler call */
+} pkt_dispatch_entry_t;
+
+typedef struct {
+    pkt_dispatch_entry_t entries[PKT_DISPATCH_MAX_CMDS];
+    uint32_t num_entries;
+    uint32_t mult;                      /** hash multiplier without collisions for the registered commands */
+    uint8_t slots[PKT_DISPATCH_SLOTS];  /** index + 1 into entries, 0 = no command */
+    uint64_t misses;                    /** packets without handler */
+} pkt_dispatch_t;
+
+void pkt_dispatch_init(pkt_dispatch_t *dispatch);
+
+int pkt_dispatch_register(pkt_dispatch_t *dispatch, uint32_t cmd, pkt_dispatch_fn fn, void *arg);
+
+const pkt_dispatch_entry_t *pkt_dispatch_find(const pkt_dispatch_t *dispatch, uint32_t cmd);
+
+int pkt_dispatch(pkt_dispatch_t *dispatch, CIFX_PACKET *pkt, int32_t *result);
+
+#endif //GBCIFX_PKT_DISPATCH_H
@@ -0,0 +1,149 @@
+/**
+ ******************************************************************************
+ * @file           :  pkt_pool.c
+ * @brief          :  lock-free pool of preallocated mailbox packets
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#include "pkt_pool.h"
+#include <stddef.h>
+
+#define PKT_POOL_INDEX(head) ((uint32_t) ((head) & 0xFFFFFFFFu))
+#define PKT_POOL_TAG(head) ((uint32_t) ((head) >> 32))
+#define PKT_POOL_HEAD(tag, index) (((uint64_t) (tag) << 32) | (uint64_t) (index))
+
+/* pkt is the first member of the entry, the entry keeps the alignment of the array */
+static pkt_pool_entry_t *pkt_pool_entry(CIFX_PACKET *pkt) {
+    uintptr_t addr = (uintptr_t) pkt - offsetof(pkt_pool_entry_t, pkt);
+
+    return (pkt_pool_entry_t *) addr;
+}
+
+/**
+ * @brief puts an entry back on the free list
+ * @param pool pool instance
+ * @param entry entry without references
+ */
+static void pkt_pool_push(pkt_pool_t *pool, pkt_pool_entry_t *entry) {
+    uint32_t index = (uint32_t) (entry - pool->entries) + 1;
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    uint64_t new_head;
+
+    do {
+        __atomic_store_n(&entry->next, PKT_POOL_INDEX(head), __ATOMIC_RELAXED);
+        new_head = PKT_POOL_HEAD(PKT_POOL_TAG(head) + 1, index);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+
+    __atomic_sub_fetch(&pool->stats.used, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief sets up the free list over the entries, not thread safe
+ * @param pool pool instance
+ * @param entries storage of the packets, e.g. a static array
+ * @param size number of entries
+ */
+void pkt_pool_init(pkt_pool_t *pool, pkt_pool_entry_t *entries, uint32_t size) {
+    pool->entries = entries;
+    pool->size = size;
+    pool->stats = (pkt_pool_stats_t) {0};
+
+    for (uint32_t i = 0; i < size; i++) {
+        entries[i].refs = 0;
+        entries[i].next = i + 1 < size ? i + 2 : 0;
+    }
+    pool->head = PKT_POOL_HEAD(0, size ? 1 : 0);
+}
+
+/**
+ * @brief takes a packet from the pool, its reference count is 1
+ * @param pool pool instance
+ * @return packet, NULL if all packets are in use
+ */
+CIFX_PACKET *pkt_pool_alloc(pkt_pool_t *pool) {
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    uint64_t new_head;
+    pkt_pool_entry_t *entry;
+    uint32_t used;
+    uint32_t max;
+
+    do {
+        if (PKT_POOL_INDEX(head) == 0) {
+            __atomic_add_fetch(&pool->stats.failures, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+        /* next may be stale if another thread took the entry meanwhile, the tag makes the exchange fail then */
+        entry = &pool->entries[PKT_POOL_INDEX(head) - 1];
+        new_head = PKT_POOL_HEAD(PKT_POOL_TAG(head) + 1, __atomic_load_n(&entry->next, __ATOMIC_RELAXED));
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    __atomic_store_n(&entry->refs, 1, __ATOMIC_RELAXED);
+
+    __atomic_add_fetch(&pool->stats.allocs, 1, __ATOMIC_RELAXED);
+    used = __atomic_add_fetch(&pool->stats.used, 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&pool->stats.high_watermark, __ATOMIC_RELAXED);
+    while (used > max &&
+           !__atomic_compare_exchange_n(&pool->stats.high_watermark, &max, used, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+    }
+
+    return &entry->pkt;
+}
+
+/**
+ * @brief takes an additional reference, e.g. to keep a received packet beyond the callback it was handed to
+ * @param pool pool instance
+ * @param pkt packet of the pool with at least one reference
+ */
+void pkt_pool_addref(pkt_pool_t *pool, CIFX_PACKET *pkt) {
+    (void) pool;
+    __atomic_add_fetch(&pkt_pool_entry(pkt)->refs, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief drops a reference, the packet returns to the pool with the last one. NULL is ignored
+ * @param pool pool instance
+ * @param pkt packet of the pool
+ */
+void pkt_pool_release(pkt_pool_t *pool, CIFX_PACKET *pkt) {
+    pkt_pool_entry_t *entry;
+
+    if (pkt == NULL) {
+        return;
+    }
+    entry = pkt_pool_entry(pkt);
+    if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pkt_pool_push(pool, entry);
+    }
+}
+
+/**
+ * @brief checks if a packet was handed out by the pool
+ * @param pool pool instance
+ * @param pkt any packet
+ * @return !=0 if pkt belongs to the pool
+ */
+int pkt_pool_owns(const pkt_pool_t *pool, const CIFX_PACKET *pkt) {
+    const uint8_t *p = (const uint8_t *) pkt;
+    const uint8_t *base = (const uint8_t *) pool->entries;
+
+    return p >= base && p < base + (size_t) pool->size * sizeof(pkt_pool_entry_t) &&
+           (size_t) (p - base) % sizeof(pkt_pool_entry_t) == offsetof(pkt_pool_entry_t, pkt);
+}
+
+/**
+ * @brief copy of the pool statistics
+ * @param pool pool instance
+ * @param stats returned statistics
+ */
+void pkt_pool_get_stats(pkt_pool_t *pool, pkt_pool_stats_t *stats) {
+    stats->allocs = __atomic_load_n(&pool->stats.allocs, __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&pool->stats.failures, __ATOMIC_RELAXED);
+    stats->used = __atomic_load_n(&pool->stats.used, __ATOMIC_RELAXED);
+    stats->high_watermark = __atomic_load_n(&pool->stats.high_watermark, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * @file           :  pkt_pool.h
+ * @brief          :  lock-free pool of preallocated mailbox packets
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_PKT_POOL_H
+#define GBCIFX_PKT_POOL_H
+
+#include <stdint.h>
+#include "cifXUser.h"
+
+/**
+ * Fixed number of CIFX_PACKET buffers handed out as reference counted handles. The handle is the packet pointer
+ * itself, so a pool packet can be passed to every function that takes a CIFX_PACKET. Allocation and release are
+ * lock-free (a tagged free list updated by compare-and-swap) and can be used from any thread, including the cyclic
+ * one. The pool never grows, an exhausted pool makes pkt_pool_alloc() fail.
+ */
+
+typedef struct {
+    CIFX_PACKET pkt;                    /** must be the first member, the handle points to it */
+    volatile uint32_t refs;
+    uint32_t next;                      /** free list link, index + 1, 0 = end */
+} pkt_pool_entry_t;
+
+typedef struct {
+    uint64_t allocs;                    /** successful allocations */
+    uint64_t failures;                  /** allocations that found the pool empty */
+    uint32_t used;                      /** packets currently allocated */
+    uint32_t high_watermark;            /** max. packets allocated at the same time */
+} pkt_pool_stats_t;
+
+typedef struct {
+    pkt_pool_entry_t *entries;
+    uint32_t size;
+    /** free list head, ABA tag in the upper 32 bits, index + 1 of the first free entry in the lower (0 = empty) */
+    volatile uint64_t head;
+    pkt_pool_stats_t stats;             /** updated atomically */
+} pkt_pool_t;
+
+void pkt_pool_init(pkt_pool_t *pool, pkt_pool_entry_t *entries, uint32_t size);
+
+CIFX_PACKET *pkt_pool_alloc(pkt_pool_t *pool);
+
+void pkt_pool_addref(pkt_pool_t *pool, CIFX_PACKET *pkt);
+
+void pkt_pool_release(pkt_pool_t *pool, CIFX_PACKET *pkt);
+
+int pkt_pool_owns(const pkt_pool_t *pool, const CIFX_PACKET *pkt);
+
+void pkt_pool_get_stats(pkt_pool_t *pool, pkt_pool_stats_t *stats);
+
+#endif //GBCIFX_PKT_POOL_H
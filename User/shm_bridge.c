@@ -0,0 +1,300 @@
+/**
+ ******************************************************************************
+ * @file           :  shm_bridge.c
+ * @brief          :  lock-free shared memory process image bridge to GBC
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "shm_bridge.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "user_message.h"
+
+#define SHM_BRIDGE_FRESH                0x80u
+#define SHM_BRIDGE_INDEX_MASK           0x03u
+
+static void tb_init(shm_bridge_tb_t *tb) {
+    tb->back = 0;
+    tb->middle = 1;
+    tb->front = 2;
+}
+
+static int tb_valid(const shm_bridge_tb_t *tb) {
+    uint32_t middle = tb->middle & ~SHM_BRIDGE_FRESH;
+
+    return tb->back < 3 && middle < 3 && tb->front < 3 &&
+           tb->back != middle && tb->back != tb->front && middle != tb->front;
+}
+
+/**
+ * @brief hand the back buffer over to the reader and take the middle one in exchange
+ * @return 1 if the previous image was never picked up by the reader
+ */
+static int tb_publish(shm_bridge_tb_t *tb) {
+    uint32_t prev = __atomic_exchange_n(&tb->middle, tb->back | SHM_BRIDGE_FRESH, __ATOMIC_ACQ_REL);
+
+    tb->back = prev & SHM_BRIDGE_INDEX_MASK;
+    return (prev & SHM_BRIDGE_FRESH) != 0;
+}
+
+/**
+ * @brief take the middle buffer over if it holds an image the reader has not seen yet
+ * @return 1 if front changed
+ */
+static int tb_fetch(shm_bridge_tb_t *tb) {
+    uint32_t prev;
+
+    if ((__atomic_load_n(&tb->middle, __ATOMIC_ACQUIRE) & SHM_BRIDGE_FRESH) == 0) {
+        return 0;
+    }
+    prev = __atomic_exchange_n(&tb->middle, tb->front, __ATOMIC_ACQ_REL);
+    tb->front = prev & SHM_BRIDGE_INDEX_MASK;
+    return 1;
+}
+
+uint64_t shm_bridge_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief creates the bridge segment (gbcifx side). An existing segment is only re-used if it is a bridge of the same
+ * layout, anything else under the name is left alone
+ * @param bridge bridge instance
+ * @param name POSIX shm name
+ * @return mapped segment, MAP_FAILED with errno set otherwise
+ */
+static shm_bridge_segment_t *bridge_create(shm_bridge_t *bridge, const char *name) {
+    shm_bridge_segment_t *seg;
+    struct stat st;
+    int created = 1;
+
+    bridge->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (bridge->fd < 0 && errno == EEXIST) {
+        created = 0;
+        bridge->fd = shm_open(name, O_RDWR, 0);
+    }
+    if (bridge->fd < 0) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open shared memory [%s] [%s]", name, strerror(errno));
+        return MAP_FAILED;
+    }
+
+    if (created) {
+        if (ftruncate(bridge->fd, sizeof(shm_bridge_segment_t)) != 0) {
+            UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to size shared memory [%s] [%s]", name, strerror(errno));
+            shm_unlink(name);
+            return MAP_FAILED;
+        }
+    } else if (fstat(bridge->fd, &st) != 0) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to stat shared memory [%s] [%s]", name, strerror(errno));
+        return MAP_FAILED;
+    } else if (st.st_size != (off_t) sizeof(shm_bridge_segment_t)) {
+        /* not ours (or another layout), mapping it could run past its end */
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Shared memory [%s] exists with size [%ld], not a gbcifx bridge, remove it first",
+                 name, (long) st.st_size);
+        errno = EEXIST;
+        return MAP_FAILED;
+    }
+
+    seg = mmap(NULL, sizeof(shm_bridge_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, bridge->fd, 0);
+    if (seg == MAP_FAILED) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to map shared memory [%s] [%s]", name, strerror(errno));
+        if (created) {
+            shm_unlink(name);
+        }
+        return MAP_FAILED;
+    }
+
+    if (created) {
+        /* fresh segment, zero filled by ftruncate */
+        seg->version = SHM_BRIDGE_VERSION;
+        seg->size = sizeof(shm_bridge_segment_t);
+        tb_init(&seg->to_gbc);
+        tb_init(&seg->from_gbc);
+        __atomic_store_n(&seg->magic, SHM_BRIDGE_MAGIC, __ATOMIC_RELEASE);
+        return seg;
+    }
+
+    if (__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != SHM_BRIDGE_MAGIC ||
+        seg->version != SHM_BRIDGE_VERSION || seg->size != sizeof(shm_bridge_segment_t)) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Shared memory [%s] is not a gbcifx bridge of version [%u], remove it first",
+                 name, SHM_BRIDGE_VERSION);
+        munmap(seg, sizeof(shm_bridge_segment_t));
+        errno = EEXIST;
+        return MAP_FAILED;
+    }
+
+    /* gbcifx restarted, GBC may still hold buffers so the segment is kept as it is */
+    if (!tb_valid(&seg->to_gbc) || !tb_valid(&seg->from_gbc)) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Shared memory [%s] has an invalid buffer state", name);
+        munmap(seg, sizeof(shm_bridge_segment_t));
+        errno = EPROTO;
+        return MAP_FAILED;
+    }
+    UM_INFO(GBCIFX_UM_EN, "GBNETX: Re-using shared memory [%s]", name);
+    return seg;
+}
+
+/**
+ * @brief maps the bridge segment. The gbcifx side creates the segment (or re-uses a bridge left by an earlier run),
+ * GBC attaches to an existing one. A segment under the name that is not a bridge is never re-initialised
+ * @param bridge bridge instance
+ * @param name POSIX shm name, normally "/" GBCIFX_BRIDGE_SHM_NAME
+ * @param side which end of the bridge this process is
+ * @return 0 on success, errno value otherwise
+ */
+int shm_bridge_open(shm_bridge_t *bridge, const char *name, shm_bridge_side_t side) {
+    shm_bridge_segment_t *seg;
+    int rc;
+
+    memset(bridge, 0, sizeof(*bridge));
+    bridge->fd = -1;
+    bridge->side = side;
+
+    if (side == SHM_BRIDGE_SIDE_CIFX) {
+        seg = bridge_create(bridge, name);
+        if (seg == MAP_FAILED) {
+            rc = errno;
+            if (bridge->fd >= 0) {
+                close(bridge->fd);
+                bridge->fd = -1;
+            }
+            return rc;
+        }
+        seg->cifx_pid = (int32_t) getpid();
+        bridge->seq = seg->to_gbc_image[seg->to_gbc.middle & SHM_BRIDGE_INDEX_MASK].seq;
+        bridge->seg = seg;
+        return 0;
+    }
+
+    bridge->fd = shm_open(name, O_RDWR, 0);
+    if (bridge->fd < 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open shared memory [%s] [%s]", name, strerror(rc));
+        return rc;
+    }
+
+    seg = mmap(NULL, sizeof(shm_bridge_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, bridge->fd, 0);
+    if (seg == MAP_FAILED) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to map shared memory [%s] [%s]", name, strerror(rc));
+        close(bridge->fd);
+        bridge->fd = -1;
+        return rc;
+    }
+
+    if (__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != SHM_BRIDGE_MAGIC ||
+        seg->version != SHM_BRIDGE_VERSION || seg->size != sizeof(shm_bridge_segment_t)) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Shared memory [%s] is not a gbcifx bridge (version [%u], size [%u])",
+                 name, seg->version, seg->size);
+        munmap(seg, sizeof(shm_bridge_segment_t));
+        close(bridge->fd);
+        bridge->fd = -1;
+        return EPROTO;
+    }
+
+    bridge->seg = seg;
+    return 0;
+}
+
+/**
+ * @brief unmaps the bridge segment
+ * @param bridge bridge instance
+ * @param unlink_name if not NULL the segment is removed as well
+ */
+void shm_bridge_close(shm_bridge_t *bridge, const char *unlink_name) {
+    if (bridge->seg != NULL) {
+        munmap(bridge->seg, sizeof(shm_bridge_segment_t));
+        bridge->seg = NULL;
+    }
+    if (bridge->fd >= 0) {
+        close(bridge->fd);
+        bridge->fd = -1;
+    }
+    if (unlink_name != NULL) {
+        shm_unlink(unlink_name);
+    }
+}
+
+/**
+ * @brief buffer the next image to GBC is read into, owned by the caller until shm_bridge_to_gbc_publish
+ * @param bridge bridge instance (gbcifx side)
+ */
+shm_bridge_to_gbc_image_t *shm_bridge_to_gbc_acquire(shm_bridge_t *bridge) {
+    return &bridge->seg->to_gbc_image[bridge->seg->to_gbc.back];
+}
+
+/**
+ * @brief makes the acquired image the latest one visible to GBC
+ * @param bridge bridge instance (gbcifx side)
+ * @param timestamp_ns CLOCK_MONOTONIC time the image was read from the DPM
+ */
+void shm_bridge_to_gbc_publish(shm_bridge_t *bridge, uint64_t timestamp_ns) {
+    shm_bridge_to_gbc_image_t *image = &bridge->seg->to_gbc_image[bridge->seg->to_gbc.back];
+
+    image->seq = ++bridge->seq;
+    image->timestamp_ns = timestamp_ns;
+    if (tb_publish(&bridge->seg->to_gbc)) {
+        bridge->stats.overwritten++;
+    }
+    bridge->stats.published++;
+}
+
+/**
+ * @brief latest image published by GBC, the previous one again if GBC has not published since
+ * @param bridge bridge instance (gbcifx side)
+ */
+const shm_bridge_from_gbc_image_t *shm_bridge_from_gbc_latest(shm_bridge_t *bridge) {
+    if (tb_fetch(&bridge->seg->from_gbc)) {
+        bridge->stats.gbc_images++;
+    } else {
+        bridge->stats.gbc_stale++;
+    }
+    return &bridge->seg->from_gbc_image[bridge->seg->from_gbc.front];
+}
+
+/**
+ * @brief latest image published by gbcifx
+ * @param bridge bridge instance (GBC side)
+ * @param fresh optional, set to 1 if the image was not returned before
+ */
+const shm_bridge_to_gbc_image_t *shm_bridge_gbc_latest(shm_bridge_t *bridge, int *fresh) {
+    int is_fresh = tb_fetch(&bridge->seg->to_gbc);
+
+    if (fresh != NULL) {
+        *fresh = is_fresh;
+    }
+    return &bridge->seg->to_gbc_image[bridge->seg->to_gbc.front];
+}
+
+/**
+ * @brief buffer for the next image to gbcifx, owned by the caller until shm_bridge_gbc_publish
+ * @param bridge bridge instance (GBC side)
+ */
+shm_bridge_from_gbc_image_t *shm_bridge_gbc_acquire(shm_bridge_t *bridge) {
+    return &bridge->seg->from_gbc_image[bridge->seg->from_gbc.back];
+}
+
+/**
+ * @brief makes the acquired image the one written to the network in the next exchange
+ * @param bridge bridge instance (GBC side)
+ */
+void shm_bridge_gbc_publish(shm_bridge_t *bridge) {
+    bridge->seg->from_gbc_image[bridge->seg->from_gbc.back].timestamp_ns = shm_bridge_now_ns();
+    tb_publish(&bridge->seg->from_gbc);
+}
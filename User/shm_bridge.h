@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @file           :  shm_bridge.h
+ * @brief          :  lock-free shared memory process image bridge to GBC
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_SHM_BRIDGE_H
+#define GBCIFX_SHM_BRIDGE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "app.h"
+#include "latency_hist.h"
+
+/** "GBCX", written last when a segment is initialised */
+#define SHM_BRIDGE_MAGIC                0x47424358
+/** bumped on any change of shm_bridge_segment_t */
+#define SHM_BRIDGE_VERSION              2
+
+#define SHM_BRIDGE_CACHE_LINE           64
+
+/**
+ * Triple buffer state. Each direction has exactly one writer and one reader, the writer owns buffer "back",
+ * the reader owns buffer "front" and "middle" is handed over with an atomic exchange, so neither side ever
+ * waits for the other. back is only written by the writer, front only by the reader, both live in the
+ * segment so that either process can be restarted and pick up where it left off.
+ */
+typedef struct {
+    uint32_t back __attribute__((aligned(SHM_BRIDGE_CACHE_LINE)));
+    uint32_t middle __attribute__((aligned(SHM_BRIDGE_CACHE_LINE))); /** buffer index | SHM_BRIDGE_FRESH */
+    uint32_t front __attribute__((aligned(SHM_BRIDGE_CACHE_LINE)));
+} shm_bridge_tb_t;
+
+/** process image from the network (xChannelIORead) to GBC */
+typedef struct {
+    uint64_t seq;               /** exchange counter of the cycle that read the image */
+    uint64_t timestamp_ns;      /** CLOCK_MONOTONIC time the DPM read completed */
+    APP_OUTPUT_DATA_T data;
+} __attribute__((aligned(SHM_BRIDGE_CACHE_LINE))) shm_bridge_to_gbc_image_t;
+
+/** process image from GBC to the network (xChannelIOWrite) */
+typedef struct {
+    uint64_t seq;               /** set by GBC, normally the seq of the to_gbc image it was computed from */
+    uint64_t timestamp_ns;      /** CLOCK_MONOTONIC time GBC published the image */
+    APP_INPUT_DATA_T data;
+} __attribute__((aligned(SHM_BRIDGE_CACHE_LINE))) shm_bridge_from_gbc_image_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              /** sizeof(shm_bridge_segment_t) of the creator */
+    int32_t cifx_pid;           /** pid of the gbcifx process that owns the segment */
+
+    /** futex word, incremented once per completed exchange */
+    uint32_t notify_seq __attribute__((aligned(SHM_BRIDGE_CACHE_LINE)));
+    /** number of GBC threads sleeping on notify_seq, the futex is only woken if this is non-zero */
+    uint32_t notify_waiters;
+    /** gbc_notify_backend_t + 1 chosen by gbcifx, 0 = notification not set up yet */
+    uint32_t notify_backend;
+    /** CLOCK_MONOTONIC time of the last notification */
+    uint64_t notify_ns;
+    /** notification to wake-up latency, recorded by the GBC side */
+    latency_hist_t wake_hist;
+
+    shm_bridge_tb_t to_gbc;
+    shm_bridge_to_gbc_image_t to_gbc_image[3];
+
+    shm_bridge_tb_t from_gbc;
+    shm_bridge_from_gbc_image_t from_gbc_image[3];
+} shm_bridge_segment_t;
+
+typedef enum {
+    SHM_BRIDGE_SIDE_CIFX,       /** gbcifx, creates the segment, writes to_gbc, reads from_gbc */
+    SHM_BRIDGE_SIDE_GBC,        /** GBC, attaches to the segment, reads to_gbc, writes from_gbc */
+} shm_bridge_side_t;
+
+/** counters of the gbcifx side, written by the cyclic thread only */
+typedef struct {
+    volatile uint32_t published;        /** images published to GBC */
+    volatile uint32_t overwritten;      /** published images GBC never picked up */
+    volatile uint32_t gbc_images;       /** new images taken over from GBC */
+    volatile uint32_t gbc_stale;        /** exchanges without a new image from GBC (previous one reused) */
+} shm_bridge_stats_t;
+
+typedef struct {
+    shm_bridge_segment_t *seg;
+    int fd;
+    shm_bridge_side_t side;
+    uint64_t seq;
+    shm_bridge_stats_t stats;
+} shm_bridge_t;
+
+uint64_t shm_bridge_now_ns(void);
+
+int shm_bridge_open(shm_bridge_t *bridge, const char *name, shm_bridge_side_t side);
+
+void shm_bridge_close(shm_bridge_t *bridge, const char *unlink_name);
+
+/* gbcifx side */
+shm_bridge_to_gbc_image_t *shm_bridge_to_gbc_acquire(shm_bridge_t *bridge);
+
+void shm_bridge_to_gbc_publish(shm_bridge_t *bridge, uint64_t timestamp_ns);
+
+const shm_bridge_from_gbc_image_t *shm_bridge_from_gbc_latest(shm_bridge_t *bridge);
+
+/* GBC side */
+const shm_bridge_to_gbc_image_t *shm_bridge_gbc_latest(shm_bridge_t *bridge, int *fresh);
+
+shm_bridge_from_gbc_image_t *shm_bridge_gbc_acquire(shm_bridge_t *bridge);
+
+void shm_bridge_gbc_publish(shm_bridge_t *bridge);
+
+#endif //GBCIFX_SHM_BRIDGE_H
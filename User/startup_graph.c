@@ -0,0 +1,254 @@
+/**
+ ******************************************************************************
+ * @file           :  startup_graph.c
+ * @brief          :  startup packet sequence as a dependency graph on the mailbox engine
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#include "startup_graph.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cifXErrors.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+static uint64_t startup_graph_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+}
+
+static const char *startup_step_state_name(startup_step_state_t state) {
+    switch (state) {
+    case STARTUP_STEP_WAITING:
+        return "waiting";
+    case STARTUP_STEP_RUNNING:
+        return "running";
+    case STARTUP_STEP_DONE:
+        return "done";
+    case STARTUP_STEP_FAILED:
+        return "failed";
+    case STARTUP_STEP_SKIPPED:
+        return "skipped";
+    }
+    return "?";
+}
+
+/**
+ * @brief completion callback of the engine, runs in the engine thread
+ */
+static void startup_graph_done(mbx_engine_req_t *req, void *arg) {
+    startup_graph_t *graph = arg;
+    startup_step_t *step = (startup_step_t *) ((uint8_t *) req - offsetof(startup_step_t, req));
+
+    pthread_mutex_lock(&graph->lock);
+    graph->completed |= 1u << (uint32_t) (step - graph->steps);
+    pthread_cond_signal(&graph->cond);
+    pthread_mutex_unlock(&graph->lock);
+}
+
+/**
+ * @brief builds the request of a step and hands it to the engine
+ * @return CIFX_NO_ERROR if the step is running
+ */
+static int32_t startup_graph_submit(startup_graph_t *graph, mbx_engine_t *engine, startup_step_t *step) {
+    int32_t ret;
+
+    if (step->req.req == NULL && (step->req.req = pkt_pool_alloc(engine->pool)) == NULL) {
+        return CIFX_BUFFER_TOO_SHORT;
+    }
+    memset(&step->req.req->tHeader, 0, sizeof(step->req.req->tHeader));
+    ret = step->build(step->req.req, graph->arg);
+    if (ret != CIFX_NO_ERROR) {
+        return ret;
+    }
+
+    step->req.timeout_ms = step->timeout_ms;
+    step->req.done = startup_graph_done;
+    step->req.arg = graph;
+    step->state = STARTUP_STEP_RUNNING;
+    step->attempts++;
+    if (mbx_engine_submit(engine, &step->req) != 0) {
+        step->state = STARTUP_STEP_FAILED;
+        return CIFX_DEV_NOT_RUNNING;
+    }
+    if (step->attempts == 1) {
+        step->start_ns = step->req.submit_ns - graph->start_ns;
+    }
+    return CIFX_NO_ERROR;
+}
+
+/**
+ * @brief empty graph
+ * @param graph graph instance
+ * @param arg passed to the build and check functions of the steps
+ */
+void startup_graph_init(startup_graph_t *graph, void *arg) {
+    memset(graph, 0, sizeof(*graph));
+    graph->arg = arg;
+    pthread_mutex_init(&graph->lock, NULL);
+    pthread_cond_init(&graph->cond, NULL);
+}
+
+/**
+ * @brief adds a step, dependencies can only name steps added before
+ * @param graph graph instance
+ * @param name name in the startup profile
+ * @param deps bit i set: step i must be done first
+ * @param build fills in the request
+ * @param check evaluates the confirmation, NULL to check ulState only
+ * @param timeout_ms time per attempt, must not be 0
+ * @param retries attempts after the first one
+ * @return index of the step, -1 if the graph is full or a parameter is invalid
+ */
+int startup_graph_add(startup_graph_t *graph, const char *name, uint32_t deps, startup_build_fn build,
+                      startup_check_fn check, uint32_t timeout_ms, uint32_t retries) {
+    startup_step_t *step;
+
+    if (graph->num_steps == STARTUP_GRAPH_MAX_STEPS || build == NULL || timeout_ms == 0 ||
+        (deps >> graph->num_steps) != 0) {
+        return -1;
+    }
+    step = &graph->steps[graph->num_steps];
+    memset(step, 0, sizeof(*step));
+    step->name = name;
+    step->deps = deps;
+    step->build = build;
+    step->check = check;
+    step->timeout_ms = timeout_ms;
+    step->retries = retries;
+    return (int) graph->num_steps++;
+}
+
+/**
+ * @brief runs all steps, each as soon as its dependencies are done. Blocks until every step is done, has failed or
+ * was skipped. The engine must be running and no other code may wait on the requests of the graph
+ * @param graph graph instance
+ * @param engine mailbox engine of the channel, the packets come from its pool
+ * @return CIFX_NO_ERROR if all steps are done, otherwise the result of the first step that failed
+ */
+int32_t startup_graph_run(startup_graph_t *graph, mbx_engine_t *engine) {
+    int32_t ret = CIFX_NO_ERROR;
+    uint32_t done = 0;
+    uint32_t running = 0;
+    uint32_t completed;
+
+    graph->start_ns = startup_graph_now_ns();
+    graph->completed = 0;
+    for (uint32_t i = 0; i < graph->num_steps; i++) {
+        startup_step_t *step = &graph->steps[i];
+
+        step->state = STARTUP_STEP_WAITING;
+        step->result = CIFX_NO_ERROR;
+        step->attempts = 0;
+        step->ready_ns = step->start_ns = step->end_ns = step->mbx_ns = 0;
+    }
+
+    for (;;) {
+        /* everything that became ready goes out together */
+        for (uint32_t i = 0; ret == CIFX_NO_ERROR && i < graph->num_steps; i++) {
+            startup_step_t *step = &graph->steps[i];
+
+            if (step->state != STARTUP_STEP_WAITING || (step->deps & ~done) != 0) {
+                continue;
+            }
+            step->ready_ns = startup_graph_now_ns() - graph->start_ns;
+            step->result = startup_graph_submit(graph, engine, step);
+            if (step->result != CIFX_NO_ERROR) {
+                step->state = STARTUP_STEP_FAILED;
+                ret = step->result;
+            } else {
+                running |= 1u << i;
+            }
+        }
+        if (running == 0) {
+            break;
+        }
+
+        /* every submitted request completes, with a timeout at the latest */
+        pthread_mutex_lock(&graph->lock);
+        while (graph->completed == 0) {
+            pthread_cond_wait(&graph->cond, &graph->lock);
+        }
+        completed = graph->completed;
+        graph->completed = 0;
+        pthread_mutex_unlock(&graph->lock);
+
+        for (uint32_t i = 0; i < graph->num_steps; i++) {
+            startup_step_t *step = &graph->steps[i];
+            int32_t result;
+
+            if (!(completed & (1u << i))) {
+                continue;
+            }
+            running &= ~(1u << i);
+            step->end_ns = step->req.done_ns - graph->start_ns;
+            step->mbx_ns += step->req.done_ns - step->req.submit_ns;
+
+            result = step->req.result;
+            if (result == CIFX_NO_ERROR) {
+                result = step->check ? step->check(step->req.cnf, graph->arg) : (int32_t) step->req.cnf->tHeader.ulState;
+            }
+            pkt_pool_release(engine->pool, step->req.cnf);
+            step->req.cnf = NULL;
+            step->result = result;
+
+            if (result == CIFX_NO_ERROR) {
+                step->state = STARTUP_STEP_DONE;
+                done |= 1u << i;
+            } else if (ret == CIFX_NO_ERROR && step->attempts <= step->retries &&
+                       startup_graph_submit(graph, engine, step) == CIFX_NO_ERROR) {
+                running |= 1u << i;
+            } else {
+                step->state = STARTUP_STEP_FAILED;
+                if (ret == CIFX_NO_ERROR) {
+                    ret = result;
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < graph->num_steps; i++) {
+        startup_step_t *step = &graph->steps[i];
+
+        if (step->state == STARTUP_STEP_WAITING) {
+            step->state = STARTUP_STEP_SKIPPED;
+        }
+        pkt_pool_release(engine->pool, step->req.req);
+        step->req.req = NULL;
+    }
+    graph->total_ns = startup_graph_now_ns() - graph->start_ns;
+    return ret;
+}
+
+/**
+ * @brief prints the startup profile of the last run, one line per step
+ * @param graph graph instance
+ */
+void startup_graph_print(const startup_graph_t *graph) {
+    for (uint32_t i = 0; i < graph->num_steps; i++) {
+        const startup_step_t *step = &graph->steps[i];
+
+        printf("startup %-20s %-7s attempts [%u] ready [%8.3f] sent [%8.3f] done [%8.3f] mailbox [%8.3f] ms result [0x%08x]\n",
+               step->name, startup_step_state_name(step->state), step->attempts, step->ready_ns / 1e6,
+               step->start_ns / 1e6, step->end_ns / 1e6, step->mbx_ns / 1e6, (unsigned int) step->result);
+    }
+    printf("startup total [%.3f] ms\n", graph->total_ns / 1e6);
+}
+
+/**
+ * @brief frees the synchronisation objects, the graph must not be running
+ * @param graph graph instance
+ */
+void startup_graph_destroy(startup_graph_t *graph) {
+    pthread_cond_destroy(&graph->cond);
+    pthread_mutex_destroy(&graph->lock);
+}
@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * @file           :  startup_graph.h
+ * @brief          :  startup packet sequence as a dependency graph on the mailbox engine
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_STARTUP_GRAPH_H
+#define GBCIFX_STARTUP_GRAPH_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "cifXUser.h"
+#include "mbx_engine.h"
+
+/**
+ * Each step is one request/confirmation pair with the steps it depends on. When the graph runs, every step whose
+ * dependencies are done is submitted to the mailbox engine at once, so independent requests are in flight together
+ * and a chain only waits for its own predecessors. A step that times out or fails is sent again up to its retry
+ * count; a step that still fails ends the run, the steps depending on it are skipped. The time at which each step
+ * became ready, was first sent and completed is kept for the startup profile.
+ */
+
+/** steps per graph, dependencies are a bit mask */
+#define STARTUP_GRAPH_MAX_STEPS         16
+
+/** fills in the request of a step, the engine sets ulId and ulSrc. @return CIFX_NO_ERROR to send it */
+typedef int32_t (*startup_build_fn)(CIFX_PACKET *req, void *arg);
+
+/** evaluates the confirmation of a step. @return CIFX_NO_ERROR if the step is done */
+typedef int32_t (*startup_check_fn)(CIFX_PACKET *cnf, void *arg);
+
+typedef enum {
+    STARTUP_STEP_WAITING,               /** dependencies not done */
+    STARTUP_STEP_RUNNING,               /** submitted to the engine */
+    STARTUP_STEP_DONE,
+    STARTUP_STEP_FAILED,                /** failed after all retries */
+    STARTUP_STEP_SKIPPED,               /** not run, a dependency failed or the run was aborted */
+} startup_step_state_t;
+
+typedef struct {
+    const char *name;
+    uint32_t deps;                      /** bit i set: step i must be done first */
+    startup_build_fn build;
+    startup_check_fn check;             /** NULL: the step is done if ulState of the confirmation is 0 */
+    uint32_t timeout_ms;                /** per attempt, from the submission to the confirmation */
+    uint32_t retries;                   /** attempts after the first one */
+
+    /* result of the run, times relative to its start */
+    startup_step_state_t state;
+    int32_t result;
+    uint32_t attempts;
+    uint64_t ready_ns;                  /** last dependency done */
+    uint64_t start_ns;                  /** first submission */
+    uint64_t end_ns;                    /** completion of the last attempt */
+    uint64_t mbx_ns;                    /** submission to completion summed over the attempts */
+    mbx_engine_req_t req;
+} startup_step_t;
+
+typedef struct {
+    startup_step_t steps[STARTUP_GRAPH_MAX_STEPS];
+    uint32_t num_steps;
+    void *arg;                          /** passed to build and check */
+    uint64_t start_ns;                  /** CLOCK_MONOTONIC time of the run */
+    uint64_t total_ns;                  /** duration of the run */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;                /** signalled by the engine on every completion of a step */
+    uint32_t completed;                 /** bit i set: step i completed, not yet evaluated */
+} startup_graph_t;
+
+void startup_graph_init(startup_graph_t *graph, void *arg);
+
+int startup_graph_add(startup_graph_t *graph, const char *name, uint32_t deps, startup_build_fn build,
+                      startup_check_fn check, uint32_t timeout_ms, uint32_t retries);
+
+int32_t startup_graph_run(startup_graph_t *graph, mbx_engine_t *engine);
+
+void startup_graph_print(const startup_graph_t *graph);
+
+void startup_graph_destroy(startup_graph_t *graph);
+
+#endif //GBCIFX_STARTUP_GRAPH_H
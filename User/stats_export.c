@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ * @file           :  stats_export.c
+ * @brief          :  cifX timing statistics in shared memory, JSON dump on signal
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "stats_export.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "gbcifx_config.h"
+#include "user_message.h"
+
+static uint64_t stats_export_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief blocks GBCIFX_STATS_SIGNAL in the calling thread. Call in main before any other thread is created, so
+ * all threads inherit the mask and only the dump thread ever receives the signal
+ */
+void stats_export_block_signal(void) {
+    sigset_t sigset;
+
+    sigemptyset(&sigset);
+    sigaddset(&sigset, GBCIFX_STATS_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+}
+
+/**
+ * @brief creates the statistics segment and attaches its blocks to the device and its channels. Recording starts
+ * immediately, so this is called after cifXTKitAddDevice and before the cyclic exchange is started
+ * @param export export instance
+ * @param name POSIX shm name, normally "/" GBCIFX_STATS_SHM_NAME
+ * @param dev device instance added to the toolkit
+ * @return 0 on success, errno value otherwise
+ */
+int stats_export_open(stats_export_t *export, const char *name, PDEVICEINSTANCE dev) {
+#ifdef CIFX_TOOLKIT_STATS
+    stats_export_segment_t *seg;
+    uint32_t num_channels = dev->ulCommChannelCount;
+    int rc;
+
+    memset(export, 0, sizeof(*export));
+    export->fd = -1;
+
+    export->fd = shm_open(name, O_RDWR | O_CREAT, 0664);
+    if (export->fd < 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open statistics shared memory [%s] [%s]", name, strerror(rc));
+        return rc;
+    }
+    if (ftruncate(export->fd, sizeof(stats_export_segment_t)) != 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to size statistics shared memory [%s] [%s]", name, strerror(rc));
+        close(export->fd);
+        export->fd = -1;
+        return rc;
+    }
+    seg = mmap(NULL, sizeof(stats_export_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, export->fd, 0);
+    if (seg == MAP_FAILED) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to map statistics shared memory [%s] [%s]", name, strerror(rc));
+        close(export->fd);
+        export->fd = -1;
+        return rc;
+    }
+
+    if (num_channels > CIFX_MAX_NUMBER_OF_CHANNELS) {
+        num_channels = CIFX_MAX_NUMBER_OF_CHANNELS;
+    }
+
+    /* statistics always start from zero, unlike the process image bridge nothing is kept over a restart */
+    __atomic_store_n(&seg->magic, 0, __ATOMIC_RELAXED);
+    memset(seg, 0, sizeof(*seg));
+    seg->version = STATS_EXPORT_VERSION;
+    seg->size = sizeof(stats_export_segment_t);
+    seg->cifx_pid = (int32_t) getpid();
+    seg->start_ns = stats_export_now_ns();
+    seg->num_channels = num_channels;
+    __atomic_store_n(&seg->magic, STATS_EXPORT_MAGIC, __ATOMIC_RELEASE);
+
+    dev->ptStats = &seg->device;
+    dev->tSystemDevice.ptStats = &seg->system;
+    for (uint32_t i = 0; i < num_channels; i++) {
+        dev->pptCommChannels[i]->ptStats = &seg->channel[i];
+    }
+
+    export->seg = seg;
+    export->dev = dev;
+    return 0;
+#else
+    (void) name;
+    (void) dev;
+    memset(export, 0, sizeof(*export));
+    export->fd = -1;
+    UM_ERROR(GBCIFX_UM_EN, "GBNETX: Statistics are not available, gbcifx was built without GBCIFX_STATS");
+    return ENOTSUP;
+#endif
+}
+
+/**
+ * @brief maps an existing statistics segment read only, for tools running next to gbcifx
+ * @param export export instance
+ * @param name POSIX shm name, normally "/" GBCIFX_STATS_SHM_NAME
+ * @return 0 on success, errno value otherwise
+ */
+int stats_export_attach(stats_export_t *export, const char *name) {
+    stats_export_segment_t *seg;
+    int rc;
+
+    memset(export, 0, sizeof(*export));
+    export->fd = -1;
+
+    export->fd = shm_open(name, O_RDONLY, 0);
+    if (export->fd < 0) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to open statistics shared memory [%s] [%s]", name, strerror(rc));
+        return rc;
+    }
+    seg = mmap(NULL, sizeof(stats_export_segment_t), PROT_READ, MAP_SHARED, export->fd, 0);
+    if (seg == MAP_FAILED) {
+        rc = errno;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to map statistics shared memory [%s] [%s]", name, strerror(rc));
+        close(export->fd);
+        export->fd = -1;
+        return rc;
+    }
+    if (__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != STATS_EXPORT_MAGIC ||
+        seg->version != STATS_EXPORT_VERSION || seg->size != sizeof(stats_export_segment_t)) {
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Shared memory [%s] is not a gbcifx statistics segment (version [%u], size [%u])",
+                 name, seg->version, seg->size);
+        munmap(seg, sizeof(stats_export_segment_t));
+        close(export->fd);
+        export->fd = -1;
+        return EPROTO;
+    }
+
+    export->seg = seg;
+    return 0;
+}
+
+static void write_hist(FILE *f, const char *name, const latency_hist_t *hist) {
+    uint32_t count = __atomic_load_n(&hist->count, __ATOMIC_ACQUIRE);
+
+    fprintf(f, "\"%s\":{\"count\":%u,\"min\":%u,\"mean\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%u}",
+            name, count, count ? hist->min_ns : 0,
+            (unsigned long long) (count ? hist->sum_ns / count : 0),
+            (unsigned long long) latency_hist_percentile(hist, 50),
+            (unsigned long long) latency_hist_percentile(hist, 90),
+            (unsigned long long) latency_hist_percentile(hist, 99),
+            hist->max_ns);
+}
+
+static void write_channel(FILE *f, const CIFX_CHANNEL_STATS_T *ch) {
+    int first = 1;
+
+    fprintf(f, "{\"io_read_calls\":%u,\"io_write_calls\":%u,\"io_exchange_calls\":%u,\"io_errors\":%u,"
+               "\"io_bytes\":%llu,\"put_packets\":%u,\"get_packets\":%u,\"mailbox_errors\":%u,\"cos_changes\":%u,",
+            ch->ulIOReadCalls, ch->ulIOWriteCalls, ch->ulIOExchangeCalls, ch->ulIOErrors,
+            (unsigned long long) ch->ullIOBytes, ch->ulPutPackets, ch->ulGetPackets, ch->ulMbxErrors,
+            ch->ulCOSChanges);
+    write_hist(f, "io_read_ns", &ch->tIORead);
+    fputc(',', f);
+    write_hist(f, "io_write_ns", &ch->tIOWrite);
+    fputc(',', f);
+    write_hist(f, "io_exchange_ns", &ch->tIOExchange);
+    fputc(',', f);
+    write_hist(f, "io_frames", &ch->tIOFrames);
+    fputc(',', f);
+    write_hist(f, "put_packet_ns", &ch->tPutPacket);
+    fputc(',', f);
+    write_hist(f, "get_packet_ns", &ch->tGetPacket);
+
+    /* only the handshake bits that were waited for */
+    fputs(",\"handshake_wait_ns\":[", f);
+    for (uint32_t bit = 0; bit < HIL_DPM_HANDSHAKE_PAIRS; bit++) {
+        if (ch->atHskWait[bit].count == 0 && ch->aulHskTimeouts[bit] == 0) {
+            continue;
+        }
+        fprintf(f, "%s{\"bit\":%u,\"timeouts\":%u,", first ? "" : ",", bit, ch->aulHskTimeouts[bit]);
+        write_hist(f, "wait", &ch->atHskWait[bit]);
+        fputc('}', f);
+        first = 0;
+    }
+    fputs("]}", f);
+}
+
+/**
+ * @brief writes the statistics as a single JSON object
+ * @param seg statistics segment, may be updated while it is written
+ * @param f output
+ * @return 0 on success, errno value otherwise
+ */
+int stats_export_write_json(const stats_export_segment_t *seg, FILE *f) {
+    uint32_t num_channels = seg->num_channels;
+
+    if (num_channels > CIFX_MAX_NUMBER_OF_CHANNELS) {
+        num_channels = CIFX_MAX_NUMBER_OF_CHANNELS;
+    }
+
+    fprintf(f, "{\"pid\":%d,\"uptime_ns\":%llu,\"hwif_frames\":%llu,\"hwif_bytes\":%llu,\"system\":",
+            (int) seg->cifx_pid,
+            (unsigned long long) (stats_export_now_ns() - seg->start_ns),
+            (unsigned long long) seg->device.ullHwIfFrames,
+            (unsigned long long) seg->device.ullHwIfBytes);
+    write_channel(f, &seg->system);
+    fputs(",\"channels\":[", f);
+    for (uint32_t i = 0; i < num_channels; i++) {
+        if (i > 0) {
+            fputc(',', f);
+        }
+        write_channel(f, &seg->channel[i]);
+    }
+    fputs("]}\n", f);
+
+    return ferror(f) ? EIO : 0;
+}
+
+/**
+ * @brief writes the JSON dump to a temporary file and renames it, readers never see a partial dump
+ * @param export export instance
+ * @param json_path file to (re)place
+ * @return 0 on success, errno value otherwise
+ */
+int stats_export_dump(const stats_export_t *export, const char *json_path) {
+    char tmp_path[PATH_MAX];
+    FILE *f;
+    int rc;
+
+    if (export->seg == NULL) {
+        return EINVAL;
+    }
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", json_path) >= (int) sizeof(tmp_path)) {
+        return ENAMETOOLONG;
+    }
+    f = fopen(tmp_path, "w");
+    if (f == NULL) {
+        return errno;
+    }
+    rc = stats_export_write_json(export->seg, f);
+    if (fclose(f) != 0 && rc == 0) {
+        rc = errno;
+    }
+    if (rc == 0 && rename(tmp_path, json_path) != 0) {
+        rc = errno;
+    }
+    if (rc != 0) {
+        unlink(tmp_path);
+    }
+    return rc;
+}
+
+static void *dump_thread(void *arg) {
+    stats_export_t *export = arg;
+    sigset_t sigset;
+    int signo;
+    int rc;
+
+    sigemptyset(&sigset);
+    sigaddset(&sigset, GBCIFX_STATS_SIGNAL);
+
+    while (export->dump_running) {
+        if (sigwait(&sigset, &signo) != 0 || !export->dump_running) {
+            continue;
+        }
+        if ((rc = stats_export_dump(export, export->json_path)) != 0) {
+            UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to write statistics to [%s] [%s]", export->json_path, strerror(rc));
+        } else {
+            UM_INFO(GBCIFX_UM_EN, "GBNETX: Statistics written to [%s]", export->json_path);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief starts the thread that writes the JSON dump whenever the process receives GBCIFX_STATS_SIGNAL. The signal
+ * must have been blocked with stats_export_block_signal before any other thread was created
+ * @param export export instance (gbcifx side)
+ * @param json_path file the dump is written to
+ * @return 0 on success, errno value otherwise
+ */
+int stats_export_start_dump_thread(stats_export_t *export, const char *json_path) {
+    int rc;
+
+    export->json_path = json_path;
+    export->dump_running = 1;
+    rc = pthread_create(&export->dump_thread, NULL, dump_thread, export);
+    if (rc != 0) {
+        export->dump_running = 0;
+        UM_ERROR(GBCIFX_UM_EN, "GBNETX: Failed to start the statistics dump thread [%s]", strerror(rc));
+    }
+    return rc;
+}
+
+/**
+ * @brief stops the dump thread, detaches the blocks from the toolkit and unmaps the segment. The cyclic exchange
+ * must have been stopped before
+ * @param export export instance
+ * @param unlink_name if not NULL the segment is removed as well
+ */
+void stats_export_close(stats_export_t *export, const char *unlink_name) {
+    if (export->dump_running) {
+        export->dump_running = 0;
+        pthread_kill(export->dump_thread, GBCIFX_STATS_SIGNAL);
+        pthread_join(export->dump_thread, NULL);
+    }
+#ifdef CIFX_TOOLKIT_STATS
+    if (export->dev != NULL) {
+        export->dev->ptStats = NULL;
+        export->dev->tSystemDevice.ptStats = NULL;
+        for (uint32_t i = 0; i < export->seg->num_channels; i++) {
+            export->dev->pptCommChannels[i]->ptStats = NULL;
+        }
+        export->dev = NULL;
+    }
+#endif
+    if (export->seg != NULL) {
+        munmap(export->seg, sizeof(stats_export_segment_t));
+        export->seg = NULL;
+    }
+    if (export->fd >= 0) {
+        close(export->fd);
+        export->fd = -1;
+    }
+    if (unlink_name != NULL) {
+        shm_unlink(unlink_name);
+    }
+}
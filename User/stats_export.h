@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file           :  stats_export.h
+ * @brief          :  cifX timing statistics in shared memory, JSON dump on signal
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef GBCIFX_STATS_EXPORT_H
+#define GBCIFX_STATS_EXPORT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "cifXToolkit.h"
+#include "cifXStats.h"
+
+/** "GBST", written last when a segment is initialised */
+#define STATS_EXPORT_MAGIC              0x47425354
+/** bumped on any change of stats_export_segment_t or the toolkit statistic blocks */
+#define STATS_EXPORT_VERSION            1
+
+/** layout shared with readers in other processes, all blocks are written by gbcifx only */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                      /** sizeof(stats_export_segment_t) of the creator */
+    int32_t cifx_pid;                   /** pid of the gbcifx process that owns the segment */
+    uint64_t start_ns;                  /** CLOCK_MONOTONIC time recording started */
+    uint32_t num_channels;              /** communication channels in use of channel[] */
+    CIFX_DEVICE_STATS_T device;
+    CIFX_CHANNEL_STATS_T system;        /** system channel, mailbox traffic only */
+    CIFX_CHANNEL_STATS_T channel[CIFX_MAX_NUMBER_OF_CHANNELS];
+} stats_export_segment_t;
+
+typedef struct {
+    stats_export_segment_t *seg;
+    int fd;
+    PDEVICEINSTANCE dev;                /** device the blocks are attached to, NULL for readers */
+    const char *json_path;
+    pthread_t dump_thread;
+    volatile int dump_running;
+} stats_export_t;
+
+/* gbcifx side */
+void stats_export_block_signal(void);
+
+int stats_export_open(stats_export_t *export, const char *name, PDEVICEINSTANCE dev);
+
+int stats_export_start_dump_thread(stats_export_t *export, const char *json_path);
+
+/* readers */
+int stats_export_attach(stats_export_t *export, const char *name);
+
+/* both */
+int stats_export_write_json(const stats_export_segment_t *seg, FILE *f);
+
+int stats_export_dump(const stats_export_t *export, const char *json_path);
+
+void stats_export_close(stats_export_t *export, const char *unlink_name);
+
+#endif //GBCIFX_STATS_EXPORT_H
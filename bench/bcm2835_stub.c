@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ * @file           :  bcm2835_stub.c
+ * @brief          :  stand-in for the bcm2835 library so the SPI path can be
+ *                    benchmarked without hardware
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "bcm2835.h"
+#include "bcm2835_stub.h"
+
+/* byte returned for every clocked byte */
+static uint8_t stub_rx_byte = 0xFF;
+
+/* if attached, the chip select edges and bytes go to the emulated netX instead */
+static SERDPM_EMU_T *stub_emu = NULL;
+
+/* keeps the compiler from dropping the reads of the transmit buffers */
+static volatile uint8_t stub_tx_sink;
+
+uint64_t bcm2835_stub_bytes = 0;
+uint64_t bcm2835_stub_cs_asserts = 0;
+
+void bcm2835_stub_set_rx_byte(uint8_t rx_byte) {
+    stub_rx_byte = rx_byte;
+}
+
+void bcm2835_stub_attach(SERDPM_EMU_T *emu) {
+    stub_emu = emu;
+}
+
+int bcm2835_init(void) {
+    return 1;
+}
+
+int bcm2835_spi_begin(void) {
+    return 1;
+}
+
+void bcm2835_spi_setBitOrder(uint8_t order) {
+    (void) order;
+}
+
+void bcm2835_spi_setDataMode(uint8_t mode) {
+    (void) mode;
+}
+
+void bcm2835_spi_setClockDivider(uint16_t divider) {
+    (void) divider;
+}
+
+void bcm2835_spi_chipSelect(uint8_t cs) {
+    (void) cs;
+}
+
+void bcm2835_gpio_fsel(uint8_t pin, uint8_t mode) {
+    (void) pin;
+    (void) mode;
+}
+
+void bcm2835_gpio_write(uint8_t pin, uint8_t on) {
+    (void) pin;
+    if (on == LOW) {
+        bcm2835_stub_cs_asserts++;
+    }
+    if (stub_emu != NULL) {
+        SerialDPMEmu_Select(stub_emu, on == LOW);
+    }
+}
+
+void bcm2835_spi_transfernb(char *tbuf, char *rbuf, uint32_t len) {
+    uint8_t sink = 0;
+    if (stub_emu != NULL) {
+        SerialDPMEmu_Clock(stub_emu, (const uint8_t *) tbuf, (uint8_t *) rbuf, len);
+        bcm2835_stub_bytes += len;
+        return;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        sink ^= (uint8_t) tbuf[i];
+    }
+    stub_tx_sink = sink;
+    memset(rbuf, stub_rx_byte, len);
+    bcm2835_stub_bytes += len;
+}
+
+void bcm2835_spi_writenb(const char *buf, uint32_t len) {
+    uint8_t sink = 0;
+    if (stub_emu != NULL) {
+        SerialDPMEmu_Clock(stub_emu, (const uint8_t *) buf, NULL, len);
+        bcm2835_stub_bytes += len;
+        return;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        sink ^= (uint8_t) buf[i];
+    }
+    stub_tx_sink = sink;
+    bcm2835_stub_bytes += len;
+}
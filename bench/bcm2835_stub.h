@@ -0,0 +1,29 @@
+/**
+ ******************************************************************************
+ * @file           :  bcm2835_stub.h
+ * @brief          :  controls for the bcm2835 library stand-in
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#ifndef GBCIFX_BCM2835_STUB_H
+#define GBCIFX_BCM2835_STUB_H
+
+#include <stdint.h>
+#include "SerialDPMEmu.h"
+
+/* total SPI bytes clocked and chip select assertions seen by the stub */
+extern uint64_t bcm2835_stub_bytes;
+extern uint64_t bcm2835_stub_cs_asserts;
+
+void bcm2835_stub_set_rx_byte(uint8_t rx_byte);
+
+/* NULL detaches the emulator, the stub then answers the rx byte again */
+void bcm2835_stub_attach(SERDPM_EMU_T *emu);
+
+#endif //GBCIFX_BCM2835_STUB_H
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file           :  bench.c
+ * @brief          :  gbcifx_bench entry point, statistics and JSON output
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench.h"
+
+volatile uint64_t bench_alloc_count = 0;
+
+/* provided by the linker through -Wl,--wrap */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    __atomic_add_fetch(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+static int first_case = 1;
+
+/* JSON document, stdout itself carries the console output of the code under test */
+static FILE *json_out;
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, uint32_t n, uint32_t pct) {
+    if (n == 0) {
+        return 0;
+    }
+    return sorted[((uint64_t) (n - 1) * pct) / 100];
+}
+
+/**
+ * @brief prepare a benchmark case, allocation counting starts here
+ * @param bc case to prepare
+ * @param name name reported in the JSON output
+ * @param iterations number of samples which will be recorded
+ * @return 0 on success
+ */
+int bench_case_begin(bench_case_t *bc, const char *name, uint32_t iterations) {
+    if (iterations > BENCH_MAX_SAMPLES) {
+        iterations = BENCH_MAX_SAMPLES;
+    }
+    bc->name = name;
+    bc->num_samples = 0;
+    bc->max_samples = iterations;
+    bc->bytes = 0;
+    bc->num_counters = 0;
+    bc->samples_ns = malloc(iterations * sizeof(uint64_t));
+    if (bc->samples_ns == NULL) {
+        return -1;
+    }
+    bc->allocs = bench_alloc_count;
+    return 0;
+}
+
+/**
+ * @brief add to a named counter of a case, printed divided by the number of samples
+ * @param bc case the counter belongs to
+ * @param name name reported in the JSON output, counters beyond BENCH_MAX_COUNTERS are dropped
+ * @param value count to add
+ */
+void bench_case_counter(bench_case_t *bc, const char *name, uint64_t value) {
+    uint32_t i;
+
+    for (i = 0; i < bc->num_counters; i++) {
+        if (strcmp(bc->counters[i].name, name) == 0) {
+            bc->counters[i].value += value;
+            return;
+        }
+    }
+    if (bc->num_counters < BENCH_MAX_COUNTERS) {
+        bc->counters[bc->num_counters].name = name;
+        bc->counters[bc->num_counters].value = value;
+        bc->num_counters++;
+    }
+}
+
+/**
+ * @brief finish a benchmark case and print its result as one JSON object
+ * @param bc case to finish
+ */
+void bench_case_end(bench_case_t *bc) {
+    uint64_t allocs = bench_alloc_count - bc->allocs;
+    uint64_t sum = 0;
+    uint32_t n = bc->num_samples;
+
+    qsort(bc->samples_ns, n, sizeof(uint64_t), cmp_u64);
+    for (uint32_t i = 0; i < n; i++) {
+        sum += bc->samples_ns[i];
+    }
+
+    fprintf(json_out, "%s\n    {\"name\": \"%s\", \"iterations\": %u, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f, ",
+           first_case ? "" : ",",
+           bc->name, n,
+           n ? (double) allocs / n : 0.0,
+           n ? (double) bc->bytes / n : 0.0);
+    if (bc->num_counters > 0) {
+        fprintf(json_out, "\"per_op\": {");
+        for (uint32_t i = 0; i < bc->num_counters; i++) {
+            fprintf(json_out, "%s\"%s\": %.1f", i ? ", " : "", bc->counters[i].name,
+                   n ? (double) bc->counters[i].value / n : 0.0);
+        }
+        fprintf(json_out, "}, ");
+    }
+    fprintf(json_out, "\"ns\": {\"min\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu, \"mean\": %.1f}}",
+           (unsigned long long) (n ? bc->samples_ns[0] : 0),
+           (unsigned long long) percentile(bc->samples_ns, n, 50),
+           (unsigned long long) percentile(bc->samples_ns, n, 90),
+           (unsigned long long) percentile(bc->samples_ns, n, 99),
+           (unsigned long long) (n ? bc->samples_ns[n - 1] : 0),
+           n ? (double) sum / n : 0.0);
+    first_case = 0;
+
+    free(bc->samples_ns);
+    bc->samples_ns = NULL;
+}
+
+/**
+ * @brief bus cost of an access between two snapshots of the emulator counters
+ * @param bc case the cost is added to, clocked bytes go to bytes_per_op
+ * @param before counters before the access
+ * @param after counters after the access
+ */
+void bench_case_serdpm(bench_case_t *bc, const SERDPM_EMU_STATS_T *before, const SERDPM_EMU_STATS_T *after) {
+    bc->bytes += after->ullClockBytes - before->ullClockBytes;
+    bench_case_counter(bc, "cs_asserts", after->ullCsAsserts - before->ullCsAsserts);
+    bench_case_counter(bc, "header_bytes", after->ullHeaderBytes - before->ullHeaderBytes);
+    bench_case_counter(bc, "dummy_bytes", after->ullDummyBytes - before->ullDummyBytes);
+    bench_case_counter(bc, "protocol_errors", after->ullErrors - before->ullErrors);
+}
+
+int main(void) {
+    int fd;
+
+    /* the JSON document keeps the original stdout, console output of the code under test goes to stderr */
+    fflush(stdout);
+    fd = dup(STDOUT_FILENO);
+    if (fd < 0 || (json_out = fdopen(fd, "w")) == NULL || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        perror("gbcifx_bench");
+        return 1;
+    }
+    fprintf(json_out, "{\n  \"benchmarks\": [");
+
+#ifdef GBCIFX_BENCH_SPIDEV
+    bench_spidev_run();
+#else
+    bench_spi_run();
+    bench_shm_run();
+    bench_cifx_run();
+#endif
+    fprintf(json_out, "\n  ]\n}\n");
+    fclose(json_out);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file           :  bench.h
+ * @brief          :  common helpers for the gbcifx_bench benchmark target
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#ifndef GBCIFX_BENCH_H
+#define GBCIFX_BENCH_H
+
+#include <stdint.h>
+#include "SerialDPMEmu.h"
+
+/** Upper limit of samples recorded per benchmark case */
+#define BENCH_MAX_SAMPLES               100000
+
+/** Upper limit of additional counters reported per benchmark case */
+#define BENCH_MAX_COUNTERS              12
+
+/** Event count of a case, reported per operation next to bytes_per_op */
+typedef struct {
+    const char *name;
+    uint64_t value;
+} bench_counter_t;
+
+/** Samples and allocation counts collected for one benchmark case */
+typedef struct {
+    const char *name;
+    uint64_t *samples_ns;
+    uint32_t num_samples;
+    uint32_t max_samples;
+    uint64_t allocs;
+    uint64_t bytes;
+    bench_counter_t counters[BENCH_MAX_COUNTERS];
+    uint32_t num_counters;
+} bench_case_t;
+
+/* heap allocations done since program start (counted by the linker wrapped malloc/calloc/realloc) */
+extern volatile uint64_t bench_alloc_count;
+
+uint64_t bench_now_ns(void);
+
+int bench_case_begin(bench_case_t *bc, const char *name, uint32_t iterations);
+void bench_case_counter(bench_case_t *bc, const char *name, uint64_t value);
+void bench_case_end(bench_case_t *bc);
+
+/* bus counters of the serial DPM emulator between two snapshots, clocked bytes go to bytes_per_op */
+void bench_case_serdpm(bench_case_t *bc, const SERDPM_EMU_STATS_T *before, const SERDPM_EMU_STATS_T *after);
+
+/** Record one sample, start_ns must come from bench_now_ns() */
+static inline void bench_case_sample(bench_case_t *bc, uint64_t start_ns) {
+    uint64_t end_ns = bench_now_ns();
+    if (bc->num_samples < bc->max_samples) {
+        bc->samples_ns[bc->num_samples++] = end_ns - start_ns;
+    }
+}
+
+/* benchmark groups */
+void bench_spi_run(void);
+void bench_shm_run(void);
+void bench_cifx_run(void);
+
+/* gbcifx_bench_spidev only, the spidev backend replaces the bcm2835 one */
+void bench_spidev_run(void);
+
+#endif //GBCIFX_BENCH_H
@@ -0,0 +1,1356 @@
+/**
+ ******************************************************************************
+ * @file           :  bench_cifx.c
+ * @brief          :  benchmarks of the cifX toolkit I/O, mailbox, handshake,
+ *                    startup and download paths against the netX simulator,
+ *                    directly and through the emulated serial DPM protocols
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "cifXToolkit.h"
+#include "cifXErrors.h"
+#include "cifXHWFunctions.h"
+#include "cifXHWShadow.h"
+#include "cifXCrc32.h"
+#include "cifXDigestCache.h"
+#include "cifXIODelta.h"
+#include "Hil_Results.h"
+#include "Hil_SystemCmd.h"
+#include "Hilmd5.h"
+#include "OS_Spi.h"
+#include "SerialDPMInterface.h"
+#include "SerialDPMEmu.h"
+#include "bcm2835_stub.h"
+#include "netx_sim.h"
+#include "mbx_engine.h"
+#include "pkt_pool.h"
+#include "pkt_dispatch.h"
+#include "startup_graph.h"
+
+#define CIFX_BENCH_IO_ITERATIONS        5000
+#define CIFX_BENCH_MBX_ITERATIONS       2000
+#define CIFX_BENCH_HSK_ITERATIONS       5000
+#define CIFX_BENCH_STARTUP_ITERATIONS   20
+#define CIFX_BENCH_DOWNLOAD_ITERATIONS  5
+#define CIFX_BENCH_SERDPM_ITERATIONS    1000
+#define CIFX_BENCH_DELTA_ITERATIONS     100000
+
+/** max. requests in flight in the mailbox engine cases */
+#define CIFX_BENCH_MBX_DEPTH_MAX        8
+
+#define CIFX_BENCH_POOL_ITERATIONS      100000
+
+#define CIFX_BENCH_DISPATCH_ITERATIONS  100000
+
+#define CIFX_BENCH_STARTUP_GRAPH_RUNS   200
+
+/** firmware sized file of the file load cases, written to /tmp once */
+#define CIFX_BENCH_FILE_PATH            "/tmp/gbcifx_bench.nxi"
+#define CIFX_BENCH_FILE_SIZE            (1024 * 1024)
+#define CIFX_BENCH_FILE_ITERATIONS      50
+
+/** digest cache of the check for download cases, replaces the default cache file while they run */
+#define CIFX_BENCH_DIGEST_CACHE_PATH    "/tmp/gbcifx_bench.digest"
+#define CIFX_BENCH_CHECK_ITERATIONS     50
+
+/** data checksummed per iteration by the CRC32 cases */
+#define CIFX_BENCH_CRC32_SIZE_MAX       (1024 * 1024)
+#define CIFX_BENCH_CRC32_BYTES          (64 * 1024 * 1024)
+
+/** size of the file downloaded per iteration */
+#define CIFX_BENCH_DOWNLOAD_SIZE        (64 * 1024)
+
+/** timeout of a single toolkit call in ms, a case is aborted on the first error */
+#define CIFX_BENCH_TIMEOUT_MS           1000
+
+/** command answered by the simulator with a copy of the request data */
+#define CIFX_BENCH_ECHO_REQ             0x0000BE00
+
+#define CIFX_BENCH_BOARD                "cifX0"
+
+/** devices brought up together by the multi device startup cases */
+#define CIFX_BENCH_STARTUP_DEVICES      2
+
+static netx_sim_t sim;
+static OS_SPI_DEVICE_T spi_device;      /* no DIRQ line, the simulated device always runs in polling mode */
+static DEVICEINSTANCE dev_instance;
+static uint8_t io_buf[HIL_DPM_IO_DATA_SIZE];
+static uint8_t download_buf[CIFX_BENCH_DOWNLOAD_SIZE];
+
+/* requests and confirmations of the mailbox engine cases, one receive buffer of the engine */
+static pkt_pool_entry_t pkt_pool_entries[2 * CIFX_BENCH_MBX_DEPTH_MAX + 1];
+static pkt_pool_t pkt_pool;
+
+/* serial DPM protocol in front of the simulated DPM, for the bus cost of the toolkit calls */
+static SERDPM_EMU_T emu;
+
+static const struct {
+    const char *name;
+    int chip;
+} serdpm_chips[] = {
+        {"nx10",  SERDPM_NETX10},
+        {"nx50",  SERDPM_NETX50},
+        {"nx51",  SERDPM_NETX51},
+        {"nx100", SERDPM_NETX100},
+};
+
+/** download bytes received by the simulated firmware */
+static uint64_t download_bytes;
+
+/** MD5 the simulated firmware reports for every file */
+static uint8_t file_md5[16];
+
+/**
+ * @brief firmware side of the echo command and of the file download, runs in the simulator thread
+ */
+static int cifx_bench_packet(void *arg, uint32_t channel, const HIL_PACKET_T *req, HIL_PACKET_T *cnf) {
+    (void) arg;
+    (void) channel;
+
+    switch (req->tHead.ulCmd) {
+    case CIFX_BENCH_ECHO_REQ:
+        memcpy(cnf->abData, req->abData, req->tHead.ulLen);
+        cnf->tHead.ulLen = req->tHead.ulLen;
+        return 1;
+
+    case HIL_FILE_DOWNLOAD_REQ:
+        ((HIL_FILE_DOWNLOAD_CNF_DATA_T *) cnf->abData)->ulMaxBlockSize =
+                ((const HIL_FILE_DOWNLOAD_REQ_DATA_T *) req->abData)->ulMaxBlockSize;
+        cnf->tHead.ulLen = sizeof(HIL_FILE_DOWNLOAD_CNF_DATA_T);
+        return 1;
+
+    case HIL_FILE_DOWNLOAD_DATA_REQ:
+        download_bytes += req->tHead.ulLen - sizeof(HIL_FILE_DOWNLOAD_DATA_REQ_DATA_T);
+        ((HIL_FILE_DOWNLOAD_DATA_CNF_DATA_T *) cnf->abData)->ulExpectedCrc32 =
+                ((const HIL_FILE_DOWNLOAD_DATA_REQ_DATA_T *) req->abData)->ulChksum;
+        cnf->tHead.ulLen = sizeof(HIL_FILE_DOWNLOAD_DATA_CNF_DATA_T);
+        return 1;
+
+    case HIL_FILE_DOWNLOAD_ABORT_REQ:
+        return 1;
+
+    case HIL_FILE_GET_MD5_REQ:
+        memcpy(((HIL_FILE_GET_MD5_CNF_DATA_T *) cnf->abData)->abMD5, file_md5, sizeof(file_md5));
+        cnf->tHead.ulLen = sizeof(HIL_FILE_GET_MD5_CNF_DATA_T);
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static void cifx_bench_sim_config(netx_sim_config_t *config) {
+    netx_sim_default_config(config);
+    config->io_size = HIL_DPM_IO_DATA_SIZE;
+    config->io_model = NETX_SIM_IO_COUNTER;
+    /* inputs on every handshake, the cases measure the host side and not the bus cycle */
+    config->io_cycle_ns = 0;
+    config->packet = cifx_bench_packet;
+}
+
+/**
+ * @brief start the simulated netX
+ * @param config simulator configuration
+ * @param chip SERDPM_UNKNOWN to access the simulated DPM directly, otherwise the serial DPM protocol of this chip
+ * @return 0 on success
+ */
+static int cifx_bench_open_device(const netx_sim_config_t *config, int chip) {
+    int rc;
+
+    memset(&dev_instance, 0, sizeof(dev_instance));
+    memset(&spi_device, 0, sizeof(spi_device));
+    dev_instance.pvOSDependent = &spi_device;
+    dev_instance.eDeviceType = eCIFX_DEVICE_AUTODETECT;
+    OS_Strncpy(dev_instance.szName, CIFX_BENCH_BOARD, sizeof(dev_instance.szName));
+
+    rc = netx_sim_open(&sim, config, &dev_instance);
+    if (rc != 0 || chip == SERDPM_UNKNOWN) {
+        return rc;
+    }
+
+    /* the SPI layer runs on the bcm2835 stand-in, which clocks the bytes into the emulator */
+    SerialDPMEmu_Init(&emu, chip, sim.dpm, sizeof(sim.dpm), &sim.lock);
+    bcm2835_stub_attach(&emu);
+    if (SerialDPM_Init(&dev_instance) != chip) {
+        bcm2835_stub_attach(NULL);
+        netx_sim_close(&sim);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief stop the simulated netX, the device must have been removed from the toolkit
+ */
+static void cifx_bench_close_device(void) {
+    netx_sim_close(&sim);
+    bcm2835_stub_attach(NULL);
+}
+
+/**
+ * @brief close the handles, remove the device from the toolkit and stop the simulated netX
+ */
+static void cifx_bench_stop(CIFXHANDLE driver, CIFXHANDLE sysdevice, CIFXHANDLE channel) {
+    if (channel != NULL) {
+        xChannelClose(channel);
+    }
+    if (sysdevice != NULL) {
+        xSysdeviceClose(sysdevice);
+    }
+    if (driver != NULL) {
+        xDriverClose(driver);
+    }
+    cifXTKitRemoveDevice(CIFX_BENCH_BOARD, 1);
+    cifx_bench_close_device();
+}
+
+/**
+ * @brief borrowed I/O image access, the toolkit image is used in place of io_buf
+ */
+static int32_t cifx_bench_io_borrow(CIFXHANDLE channel, int write, uint32_t len, uint8_t value) {
+    int32_t ret;
+
+    if (write) {
+        void *data;
+
+        if ((ret = xChannelIOWriteAcquire(channel, 0, 0, len, &data, CIFX_BENCH_TIMEOUT_MS)) != CIFX_NO_ERROR) {
+            return ret;
+        }
+        /* the application updates its outputs in place */
+        ((uint8_t *) data)[0] = value;
+        return xChannelIOWriteCommit(channel, 0, CIFX_BENCH_TIMEOUT_MS);
+    } else {
+        const void *data;
+
+        ret = xChannelIOReadAcquire(channel, 0, 0, len, &data, CIFX_BENCH_TIMEOUT_MS);
+        if (data != NULL) {
+            io_buf[0] = ((const uint8_t *) data)[0];
+            xChannelIOReadRelease(channel, 0);
+        }
+        return ret;
+    }
+}
+
+static void bench_cifx_io(CIFXHANDLE channel, int write, int borrow, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    netx_sim_stats_t before;
+    netx_sim_stats_t after;
+
+    snprintf(name, sizeof(name), "cifx_io_%s%s_%u", write ? "write" : "read", borrow ? "_borrow" : "", len);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_IO_ITERATIONS) != 0) {
+        return;
+    }
+    netx_sim_get_stats(&sim, &before);
+    for (uint32_t i = 0; i < CIFX_BENCH_IO_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        int32_t ret;
+
+        if (borrow) {
+            ret = cifx_bench_io_borrow(channel, write, len, (uint8_t) i);
+        } else {
+            ret = write ? xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS)
+                        : xChannelIORead(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+        }
+        if (ret != CIFX_NO_ERROR) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+    }
+    /* DPM bytes moved by the host, handshake and status accesses included */
+    netx_sim_get_stats(&sim, &after);
+    bc.bytes = (after.read_bytes + after.write_bytes) - (before.read_bytes + before.write_bytes);
+    bench_case_end(&bc);
+}
+
+/** I/O calls of the serial DPM cases */
+typedef enum {
+    CIFX_BENCH_SERDPM_READ,
+    CIFX_BENCH_SERDPM_WRITE,
+    CIFX_BENCH_SERDPM_EXCHANGE,         /** xChannelIOExchange, input and output of the same length */
+    CIFX_BENCH_SERDPM_READ_WRITE,       /** xChannelIORead followed by xChannelIOWrite, the calls it replaces */
+} cifx_bench_serdpm_op_t;
+
+static const char *const serdpm_op_names[] = {"read", "write", "exchange", "read_write"};
+
+static int32_t cifx_bench_serdpm_op(CIFXHANDLE channel, cifx_bench_serdpm_op_t op, uint32_t len) {
+    int32_t ret;
+
+    switch (op) {
+        case CIFX_BENCH_SERDPM_READ:
+            return xChannelIORead(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+        case CIFX_BENCH_SERDPM_WRITE:
+            return xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+        case CIFX_BENCH_SERDPM_EXCHANGE:
+            return xChannelIOExchange(channel, 0, 0, len, io_buf, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+        default:
+            ret = xChannelIORead(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+            return ret != CIFX_NO_ERROR ? ret : xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS);
+    }
+}
+
+/**
+ * @brief wait until the simulated firmware has handed both buffers of I/O area 0 back to the host
+ * @return 0 on success
+ */
+static int cifx_bench_serdpm_settle(CIFXHANDLE channel) {
+    PCHANNELINSTANCE ch = (PCHANNELINSTANCE) channel;
+    PDEVICEINSTANCE dev = (PDEVICEINSTANCE) ch->pvDeviceInstance;
+    PIOINSTANCE in = ch->pptIOInputAreas[0];
+    PIOINSTANCE out = ch->pptIOOutputAreas[0];
+    uint8_t in_state = DEV_GetIOBitstateFromMode(in, HWIF_READ8(dev, ch->ptCommonStatusBlock->bPDInHskMode));
+    uint8_t out_state = DEV_GetIOBitstateFromMode(out, HWIF_READ8(dev, ch->ptCommonStatusBlock->bPDOutHskMode));
+
+    if (in_state != HIL_FLAGS_NONE &&
+        !DEV_WaitForBitState(ch, in->bHandshakeBit, in_state, CIFX_BENCH_TIMEOUT_MS)) {
+        return -1;
+    }
+    if (out_state != HIL_FLAGS_NONE &&
+        !DEV_WaitForBitState(ch, out->bHandshakeBit, out_state, CIFX_BENCH_TIMEOUT_MS)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief I/O call over the emulated serial DPM, bytes_per_op are the bytes clocked on the bus and cs_asserts the
+ * chip select frames per call. Each call waits for the firmware first (not counted), so the cases compare the frames
+ * of the calls without the handshake polls of a device that is not ready yet
+ */
+static void bench_cifx_serdpm_io(CIFXHANDLE channel, const char *chip, cifx_bench_serdpm_op_t op, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    SERDPM_EMU_STATS_T before;
+    SERDPM_EMU_STATS_T after;
+
+    snprintf(name, sizeof(name), "cifx_serdpm_%s_io_%s_%u", chip, serdpm_op_names[op], len);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_SERDPM_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_SERDPM_ITERATIONS; i++) {
+        uint64_t start;
+
+        if (cifx_bench_serdpm_settle(channel) != 0) {
+            break;
+        }
+        SerialDPMEmu_GetStats(&emu, &before);
+        start = bench_now_ns();
+        if (cifx_bench_serdpm_op(channel, op, len) != CIFX_NO_ERROR) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+        SerialDPMEmu_GetStats(&emu, &after);
+        bench_case_serdpm(&bc, &before, &after);
+    }
+    bench_case_end(&bc);
+}
+
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+/**
+ * @brief put the shadow DPM layer in front of the hardware interface of the device, or remove it
+ * @return 0 on success
+ */
+static int cifx_bench_shadow(int install) {
+    if (!install) {
+        HwIfShadowDelete(&dev_instance);
+        return 0;
+    }
+    for (uint32_t c = 0; c < dev_instance.ulCommChannelCount; c++) {
+        if (HwIfShadowAddChannel(&dev_instance, dev_instance.pptCommChannels[c]) != CIFX_NO_ERROR) {
+            HwIfShadowDelete(&dev_instance);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief cyclic read and write of I/O area 0 with and without the shadow DPM layer (GBCIFX_HWIF_SHADOW builds only,
+ * the other cases run with the layer like gbcifx). Both cases wait for the firmware before each call pair (not
+ * counted), cs_asserts are the frames of xChannelIORead and xChannelIOWrite. The I/O handshake modes the calls read
+ * are shadow hits, the uncached case reads them from the DPM
+ */
+static void bench_cifx_serdpm_shadow(CIFXHANDLE channel, const char *chip, uint32_t len) {
+    static char name[64];
+    int installed = dev_instance.pvHwIfShadow != NULL;
+
+    for (int shadow = 1; shadow >= 0; shadow--) {
+        bench_case_t bc;
+        SERDPM_EMU_STATS_T before;
+        SERDPM_EMU_STATS_T after;
+        HWIF_SHADOW_STATS_T stats;
+
+        if ((dev_instance.pvHwIfShadow != NULL) != shadow && cifx_bench_shadow(shadow) != 0) {
+            break;
+        }
+        snprintf(name, sizeof(name), "cifx_serdpm_%s_io_read_write_%s_%u", chip, shadow ? "shadow" : "uncached", len);
+        if (bench_case_begin(&bc, name, CIFX_BENCH_SERDPM_ITERATIONS) != 0) {
+            continue;
+        }
+        for (uint32_t i = 0; i < CIFX_BENCH_SERDPM_ITERATIONS; i++) {
+            uint64_t start;
+
+            if (cifx_bench_serdpm_settle(channel) != 0) {
+                break;
+            }
+            /* the settle accesses go through the shadow as well, only the calls are counted */
+            if (shadow) {
+                HwIfShadowGetStats(&dev_instance, &stats, 1);
+            }
+            SerialDPMEmu_GetStats(&emu, &before);
+            start = bench_now_ns();
+            if (cifx_bench_serdpm_op(channel, CIFX_BENCH_SERDPM_READ_WRITE, len) != CIFX_NO_ERROR) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+            SerialDPMEmu_GetStats(&emu, &after);
+            bench_case_serdpm(&bc, &before, &after);
+            if (shadow) {
+                HwIfShadowGetStats(&dev_instance, &stats, 1);
+                bench_case_counter(&bc, "shadow_hits", stats.ulHits);
+                bench_case_counter(&bc, "shadow_misses", stats.ulMisses);
+                bench_case_counter(&bc, "shadow_pass_through", stats.ulPassThrough);
+                bench_case_counter(&bc, "shadow_write_back", stats.ulWriteBack);
+            }
+        }
+        bench_case_end(&bc);
+    }
+    if ((dev_instance.pvHwIfShadow != NULL) != installed) {
+        cifx_bench_shadow(installed);
+    }
+}
+#endif
+
+/**
+ * @brief changes a 4 byte drive setpoint every stride bytes of the output data, every byte if stride is below 4
+ */
+static void cifx_bench_setpoints(uint8_t *data, uint32_t len, uint32_t stride, uint32_t value) {
+    if (stride < sizeof(value)) {
+        memset(data, (int) value, len);
+        return;
+    }
+    for (uint32_t pos = 0; pos + sizeof(value) <= len; pos += stride) {
+        memcpy(&data[pos], &value, sizeof(value));
+    }
+}
+
+/**
+ * @brief output changes of the delta write cases, two setpoints (start and middle) is the GBC cyclic data
+ */
+static const struct {
+    const char *name;
+    uint32_t stride;                    /** 0: half the length */
+} serdpm_delta_patterns[] = {
+    {"", 0},
+    {"_stride64", 64},
+    {"_stride32", 32},
+    {"_stride24", 24},
+    {"_all", 1},
+};
+
+/**
+ * @brief delta output write over the emulated serial DPM, compare with cifx_serdpm_<chip>_io_write_<len>. Each write
+ * waits for the firmware first (not counted), full_writes are the writes sent complete as the spans cost more.
+ * costlier_than_full counts the writes that clocked more bytes or asserted chip select more often than a full write
+ * of the same length, it must stay 0
+ */
+static void bench_cifx_serdpm_io_delta(CIFXHANDLE channel, const char *chip, uint32_t len) {
+    static char name[64];
+    CIFX_IO_WRITE_STATS_T stats;
+    SERDPM_EMU_STATS_T full_before;
+    SERDPM_EMU_STATS_T full_after;
+    uint64_t full_bytes;
+    uint64_t full_cs;
+
+    /* the bus cost of a full write does not depend on the data, one write is the reference of all patterns */
+    if (cifx_bench_serdpm_settle(channel) != 0) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &full_before);
+    if (xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &full_after);
+    full_bytes = full_after.ullClockBytes - full_before.ullClockBytes;
+    full_cs = full_after.ullCsAsserts - full_before.ullCsAsserts;
+
+    if (xChannelIOWriteMode(channel, 0, CIFX_IO_WRITE_MODE_DELTA, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR) {
+        return;
+    }
+    /* the first write takes the reference from the DPM, it is not part of the cases */
+    if (xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR) {
+        xChannelIOWriteMode(channel, 0, CIFX_IO_WRITE_MODE_FULL, CIFX_BENCH_TIMEOUT_MS);
+        return;
+    }
+    for (uint32_t p = 0; p < sizeof(serdpm_delta_patterns) / sizeof(serdpm_delta_patterns[0]); p++) {
+        uint32_t stride = serdpm_delta_patterns[p].stride != 0 ? serdpm_delta_patterns[p].stride : len / 2;
+        bench_case_t bc;
+        SERDPM_EMU_STATS_T before;
+        SERDPM_EMU_STATS_T after;
+        uint64_t costlier = 0;
+
+        if (serdpm_delta_patterns[p].stride >= len / 2) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "cifx_serdpm_%s_io_write_delta%s_%u", chip, serdpm_delta_patterns[p].name, len);
+        if (bench_case_begin(&bc, name, CIFX_BENCH_SERDPM_ITERATIONS) != 0) {
+            continue;
+        }
+        xChannelIOWriteStats(channel, 0, &stats, 1, CIFX_BENCH_TIMEOUT_MS);
+        for (uint32_t i = 0; i < CIFX_BENCH_SERDPM_ITERATIONS; i++) {
+            uint64_t start;
+
+            cifx_bench_setpoints(io_buf, len, stride, i);
+            if (cifx_bench_serdpm_settle(channel) != 0) {
+                break;
+            }
+            SerialDPMEmu_GetStats(&emu, &before);
+            start = bench_now_ns();
+            if (xChannelIOWrite(channel, 0, 0, len, io_buf, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+            SerialDPMEmu_GetStats(&emu, &after);
+            bench_case_serdpm(&bc, &before, &after);
+            costlier += (after.ullClockBytes - before.ullClockBytes) > full_bytes ||
+                        (after.ullCsAsserts - before.ullCsAsserts) > full_cs;
+        }
+        xChannelIOWriteStats(channel, 0, &stats, 1, CIFX_BENCH_TIMEOUT_MS);
+        bench_case_counter(&bc, "spans", stats.ullSpans);
+        bench_case_counter(&bc, "bytes_saved", stats.ullBytesSaved);
+        bench_case_counter(&bc, "full_writes", stats.ullFullWrites);
+        bench_case_counter(&bc, "costlier_than_full", costlier);
+        if (costlier != 0) {
+            fprintf(stderr, "%s: %llu writes cost more than a full write (%llu bytes, %llu chip selects)\n", name,
+                    (unsigned long long) costlier, (unsigned long long) full_bytes, (unsigned long long) full_cs);
+        }
+        bench_case_end(&bc);
+    }
+    xChannelIOWriteMode(channel, 0, CIFX_IO_WRITE_MODE_FULL, CIFX_BENCH_TIMEOUT_MS);
+}
+
+/**
+ * @brief span search of a delta write alone, two setpoints changed against the last written data
+ */
+static void bench_cifx_io_delta_spans(uint32_t len) {
+    static char name[64];
+    static uint8_t data[HIL_DPM_IO_DATA_SIZE];
+    static uint8_t last[HIL_DPM_IO_DATA_SIZE];
+    CIFX_IO_DELTA_SPAN_T spans[CIFX_IO_DELTA_MAX_SPANS];
+    bench_case_t bc;
+    uint64_t num_spans = 0;
+
+    snprintf(name, sizeof(name), "cifx_io_delta_spans_%s_%u", cifXIODeltaImplName(), len);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_DELTA_ITERATIONS) != 0) {
+        return;
+    }
+    memset(data, 0x5A, sizeof(data));
+    memset(last, 0x5A, sizeof(last));
+    for (uint32_t i = 0; i < CIFX_BENCH_DELTA_ITERATIONS; i++) {
+        uint64_t start;
+
+        cifx_bench_setpoints(data, len, len / 2, i + 1);
+        start = bench_now_ns();
+        num_spans += cifXIODeltaSpans(data, last, len, CIFX_IO_DELTA_MERGE_GAP, spans, CIFX_IO_DELTA_MAX_SPANS);
+        bench_case_sample(&bc, start);
+        cifx_bench_setpoints(last, len, len / 2, i + 1);
+    }
+    bc.bytes = (uint64_t) len * bc.num_samples;
+    bench_case_counter(&bc, "spans", num_spans);
+    bench_case_end(&bc);
+}
+
+static void bench_cifx_mailbox(CIFXHANDLE channel, uint32_t len) {
+    static char name[64];
+    static CIFX_PACKET send;
+    static CIFX_PACKET recv;
+    bench_case_t bc;
+
+    snprintf(name, sizeof(name), "cifx_mbx_roundtrip_%u", len);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_MBX_ITERATIONS) != 0) {
+        return;
+    }
+    memset(&send, 0, sizeof(send));
+    send.tHeader.ulDest = HIL_PACKET_DEST_DEFAULT_CHANNEL;
+    send.tHeader.ulCmd = CIFX_BENCH_ECHO_REQ;
+    send.tHeader.ulLen = len;
+    memset(send.abData, 0x5A, len);
+
+    for (uint32_t i = 0; i < CIFX_BENCH_MBX_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+
+        send.tHeader.ulId = i;
+        if (xChannelPutPacket(channel, &send, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR ||
+            xChannelGetPacket(channel, sizeof(recv), &recv, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR ||
+            recv.tHeader.ulId != i || recv.tHeader.ulState != SUCCESS_HIL_OK) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+        bc.bytes += 2 * len;
+    }
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief batches of depth echo requests submitted at once to the mailbox engine, one sample per batch
+ */
+static void bench_cifx_mbx_engine(CIFXHANDLE channel, uint32_t len, uint32_t depth) {
+    static char name[64];
+    static mbx_engine_t engine;
+    static mbx_engine_req_t reqs[CIFX_BENCH_MBX_DEPTH_MAX];
+    const uint32_t batches = CIFX_BENCH_MBX_ITERATIONS / depth;
+    bench_case_t bc;
+
+    snprintf(name, sizeof(name), "cifx_mbx_engine_%u_x%u", len, depth);
+    memset(reqs, 0, sizeof(reqs));
+    for (uint32_t d = 0; d < depth; d++) {
+        if ((reqs[d].req = pkt_pool_alloc(&pkt_pool)) == NULL) {
+            goto release;
+        }
+        memset(&reqs[d].req->tHeader, 0, sizeof(reqs[d].req->tHeader));
+        reqs[d].req->tHeader.ulDest = HIL_PACKET_DEST_DEFAULT_CHANNEL;
+        reqs[d].req->tHeader.ulCmd = CIFX_BENCH_ECHO_REQ;
+        reqs[d].req->tHeader.ulSrcId = d;
+        reqs[d].req->tHeader.ulLen = len;
+        memset(reqs[d].req->abData, 0x5A, len);
+        reqs[d].timeout_ms = CIFX_BENCH_TIMEOUT_MS;
+    }
+
+    /* thread creation is not part of the case */
+    if (mbx_engine_start(&engine, channel, &pkt_pool, 1) != 0) {
+        goto release;
+    }
+    if (bench_case_begin(&bc, name, batches) == 0) {
+        for (uint32_t i = 0; i < batches; i++) {
+            uint64_t start = bench_now_ns();
+            uint32_t d;
+
+            for (d = 0; d < depth; d++) {
+                if (mbx_engine_submit(&engine, &reqs[d]) != 0) {
+                    break;
+                }
+            }
+            for (d = 0; d < depth; d++) {
+                if (mbx_engine_wait(&reqs[d], CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR ||
+                    reqs[d].cnf->tHeader.ulState != SUCCESS_HIL_OK || reqs[d].cnf->tHeader.ulLen != len) {
+                    break;
+                }
+            }
+            if (d != depth) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+            bc.bytes += 2 * len * depth;
+        }
+        bench_case_end(&bc);
+    }
+    mbx_engine_stop(&engine);
+
+release:
+    for (uint32_t d = 0; d < depth; d++) {
+        pkt_pool_release(&pkt_pool, reqs[d].req);
+        pkt_pool_release(&pkt_pool, reqs[d].cnf);
+    }
+}
+
+/**
+ * @brief allocation and release of a mailbox packet, uncontended
+ */
+static void bench_cifx_pkt_pool(void) {
+    bench_case_t bc;
+
+    if (bench_case_begin(&bc, "pkt_pool_alloc_release", CIFX_BENCH_POOL_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_POOL_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        CIFX_PACKET *pkt = pkt_pool_alloc(&pkt_pool);
+
+        if (pkt == NULL) {
+            break;
+        }
+        pkt_pool_release(&pkt_pool, pkt);
+        bench_case_sample(&bc, start);
+    }
+    bench_case_end(&bc);
+}
+
+static int32_t bench_cifx_dispatch_handler(CIFX_PACKET *pkt, void *arg) {
+    (void) arg;
+    return (int32_t) pkt->tHeader.ulLen;
+}
+
+/**
+ * @brief dispatch of a packet by command with num handlers registered, commands spread like the rcX/ECAT ones
+ */
+static void bench_cifx_dispatch(uint32_t num, int hit) {
+    static pkt_dispatch_t dispatch;
+    static char name[64];
+    CIFX_PACKET pkt;
+    bench_case_t bc;
+    int32_t result;
+
+    pkt_dispatch_init(&dispatch);
+    for (uint32_t i = 0; i < num; i++) {
+        if (pkt_dispatch_register(&dispatch, 0x1E00 + 0x10 * i + 1, bench_cifx_dispatch_handler, NULL) != 0) {
+            return;
+        }
+    }
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.tHeader.ulCmd = hit ? 0x1E00 + 0x10 * (num - 1) + 1 : 0x1E00;
+
+    snprintf(name, sizeof(name), "pkt_dispatch_%s_%u", hit ? "hit" : "miss", num);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_DISPATCH_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_DISPATCH_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+
+        if (pkt_dispatch(&dispatch, &pkt, &result) != (hit ? 0 : ENOENT)) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+    }
+    bench_case_end(&bc);
+}
+
+static int32_t bench_cifx_startup_step(CIFX_PACKET *req, void *arg) {
+    (void) arg;
+    req->tHeader.ulDest = HIL_PACKET_DEST_DEFAULT_CHANNEL;
+    req->tHeader.ulCmd = CIFX_BENCH_ECHO_REQ;
+    req->tHeader.ulLen = 16;
+    memset(req->abData, 0x5A, 16);
+    return CIFX_NO_ERROR;
+}
+
+/**
+ * @brief run of a 7 step startup graph of echo requests, one sample per run. Parallel is the shape of the ECS
+ * startup (3 independent steps, one of them heading a chain of 4), serial chains all 7
+ */
+static void bench_cifx_startup_graph(CIFXHANDLE channel, int parallel) {
+    static const uint32_t ecs_deps[] = {0, 0, 0, 1u << 0, 1u << 3, 1u << 4, 1u << 5};
+    static mbx_engine_t engine;
+    static startup_graph_t graph;
+    bench_case_t bc;
+
+    startup_graph_init(&graph, NULL);
+    for (uint32_t i = 0; i < sizeof(ecs_deps) / sizeof(ecs_deps[0]); i++) {
+        startup_graph_add(&graph, "echo", parallel ? ecs_deps[i] : (i ? 1u << (i - 1) : 0), bench_cifx_startup_step,
+                          NULL, CIFX_BENCH_TIMEOUT_MS, 0);
+    }
+    if (mbx_engine_start(&engine, channel, &pkt_pool, 1) != 0) {
+        startup_graph_destroy(&graph);
+        return;
+    }
+    if (bench_case_begin(&bc, parallel ? "startup_graph_7_parallel" : "startup_graph_7_serial",
+                         CIFX_BENCH_STARTUP_GRAPH_RUNS) == 0) {
+        for (uint32_t i = 0; i < CIFX_BENCH_STARTUP_GRAPH_RUNS; i++) {
+            uint64_t start = bench_now_ns();
+
+            if (startup_graph_run(&graph, &engine) != CIFX_NO_ERROR) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+        }
+        bench_case_end(&bc);
+    }
+    mbx_engine_stop(&engine);
+    startup_graph_destroy(&graph);
+}
+
+/**
+ * @brief writes the firmware sized file of the file cases
+ * @return 0 on success
+ */
+static int bench_cifx_write_file(void) {
+    static uint8_t chunk[64 * 1024];
+    FILE *fp;
+
+    if ((fp = fopen(CIFX_BENCH_FILE_PATH, "wb")) == NULL) {
+        return -1;
+    }
+    memset(chunk, 0xA5, sizeof(chunk));
+    for (uint32_t i = 0; i < CIFX_BENCH_FILE_SIZE / sizeof(chunk); i++) {
+        fwrite(chunk, 1, sizeof(chunk), fp);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief file made available for a download and hashed once, like DEV_CheckForDownload does before the transfer,
+ * through the toolkit's own cifXFileBufferCreate/Read/Free. With CIFX_TOOLKIT_FILE_MAP the file is mapped, otherwise
+ * a heap buffer of the file size is read, the case is named after the path taken. The file is in the page cache,
+ * the case shows the heap use and the copy, not the storage
+ */
+static void bench_cifx_file_load(void) {
+    static char name[64];
+    bench_case_t bc;
+    md5_state_t md5;
+    md5_byte_t digest[16];
+    uint32_t size = 0;
+    void *file;
+    int mapped = 0;
+    void *data;
+
+    if (bench_cifx_write_file() != 0) {
+        return;
+    }
+
+    /* a probe of the path the helpers take names the case */
+    if ((file = OS_FileOpen(CIFX_BENCH_FILE_PATH, &size)) == NULL) {
+        unlink(CIFX_BENCH_FILE_PATH);
+        return;
+    }
+    if ((data = cifXFileBufferCreate(file, size, &mapped)) != NULL) {
+        cifXFileBufferFree(data, size, mapped);
+    }
+    OS_FileClose(file);
+
+    snprintf(name, sizeof(name), "file_load_%s_%u", mapped ? "map" : "read", CIFX_BENCH_FILE_SIZE);
+    if (data != NULL && bench_case_begin(&bc, name, CIFX_BENCH_FILE_ITERATIONS) == 0) {
+        for (uint32_t i = 0; i < CIFX_BENCH_FILE_ITERATIONS; i++) {
+            uint64_t start = bench_now_ns();
+
+            if ((file = OS_FileOpen(CIFX_BENCH_FILE_PATH, &size)) == NULL) {
+                break;
+            }
+            if ((data = cifXFileBufferCreate(file, size, &mapped)) == NULL) {
+                OS_FileClose(file);
+                break;
+            }
+            if (cifXFileBufferRead(file, size, data, mapped) != size) {
+                cifXFileBufferFree(data, size, mapped);
+                OS_FileClose(file);
+                break;
+            }
+            md5_init(&md5);
+            md5_append(&md5, data, (long) size);
+            md5_finish(&md5, digest);
+            cifXFileBufferFree(data, size, mapped);
+            OS_FileClose(file);
+            bench_case_sample(&bc, start);
+            bc.bytes += size;
+        }
+        bench_case_end(&bc);
+    }
+    unlink(CIFX_BENCH_FILE_PATH);
+}
+
+/**
+ * @brief compares every CRC32 implementation of the CPU with the byte wise table over all short lengths and
+ * alignments, and over a large buffer split at random points
+ * @return 0 if all implementations agree
+ */
+static int bench_cifx_crc32_check(const CIFX_CRC32_IMPL_T *impls, uint32_t num, uint8_t *buf) {
+    uint32_t seed = 0x12345678;
+
+    for (uint32_t i = 0; i < CIFX_BENCH_CRC32_SIZE_MAX + 16; i++) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (uint8_t) (seed >> 16);
+    }
+    for (uint32_t n = 1; n < num; n++) {
+        uint32_t expected;
+        uint32_t crc;
+
+        for (uint32_t offset = 0; offset < 16; offset++) {
+            for (uint32_t len = 0; len <= 300; len++) {
+                if (cifXCrc32Impl(&impls[n], 0, buf + offset, len) != cifXCrc32Impl(&impls[0], 0, buf + offset, len)) {
+                    fprintf(stderr, "crc32 %s differs from %s at offset %u length %u\n", impls[n].szName,
+                            impls[0].szName, offset, len);
+                    return -1;
+                }
+            }
+        }
+
+        expected = cifXCrc32Impl(&impls[0], 0, buf, CIFX_BENCH_CRC32_SIZE_MAX);
+        crc = 0;
+        for (uint32_t pos = 0; pos < CIFX_BENCH_CRC32_SIZE_MAX;) {
+            uint32_t len;
+
+            seed = seed * 1103515245u + 12345u;
+            len = (seed >> 8) % 70000;
+            if (len > CIFX_BENCH_CRC32_SIZE_MAX - pos) {
+                len = CIFX_BENCH_CRC32_SIZE_MAX - pos;
+            }
+            crc = cifXCrc32Impl(&impls[n], crc, buf + pos, len);
+            pos += len;
+        }
+        if (crc != expected) {
+            fprintf(stderr, "crc32 %s differs from %s on split data\n", impls[n].szName, impls[0].szName);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief CRC32 throughput of one implementation, the same amount of data for every length
+ */
+static void bench_cifx_crc32(const CIFX_CRC32_IMPL_T *impl, const uint8_t *buf, uint32_t len) {
+    static char name[64];
+    uint32_t iterations = CIFX_BENCH_CRC32_BYTES / len;
+    volatile uint32_t crc = 0;
+    bench_case_t bc;
+
+    snprintf(name, sizeof(name), "crc32_%s_%u", impl->szName, len);
+    if (bench_case_begin(&bc, name, iterations) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t start = bench_now_ns();
+
+        crc = cifXCrc32Impl(impl, crc, buf, len);
+        bench_case_sample(&bc, start);
+        bc.bytes += len;
+    }
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief toggle of a handshake bit until the firmware answered, PD1 output is not used by anything else
+ */
+static void bench_cifx_handshake(PCHANNELINSTANCE channel) {
+    bench_case_t bc;
+
+    if (bench_case_begin(&bc, "cifx_wait_for_bit_state", CIFX_BENCH_HSK_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_HSK_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+
+        DEV_ToggleBit(channel, HCF_PD1_OUT_CMD);
+        if (!DEV_WaitForBitState(channel, HCF_PD1_OUT_CMD_BIT_NO, HIL_FLAGS_EQUAL, CIFX_BENCH_TIMEOUT_MS)) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+    }
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief open or close the PLC pointer of I/O area 0
+ */
+static int32_t cifx_bench_plc_ptr(CIFXHANDLE channel, uint32_t cmd, uint32_t area, PLC_MEMORY_INFORMATION *mem,
+                                  void **ptr, uint32_t *offset, uint32_t *size) {
+    if (cmd == CIFX_MEM_PTR_OPEN) {
+        memset(mem, 0, sizeof(*mem));
+        mem->ppvMemoryPtr = ptr;
+        mem->ulAreaDefinition = area;
+        mem->ulAreaNumber = 0;
+        mem->pulIOAreaStartOffset = offset;
+        mem->pulIOAreaSize = size;
+    }
+    return xChannelPLCMemoryPtr(channel, cmd, mem);
+}
+
+/**
+ * @brief wait until an I/O area of the PLC interface is ready
+ */
+static int32_t cifx_bench_plc_wait(CIFXHANDLE channel, int write) {
+    uint64_t deadline = bench_now_ns() + (uint64_t) CIFX_BENCH_TIMEOUT_MS * 1000000u;
+    uint32_t state = 0;
+    int32_t ret;
+
+    do {
+        ret = write ? xChannelPLCIsWriteReady(channel, 0, &state) : xChannelPLCIsReadReady(channel, 0, &state);
+    } while (ret == CIFX_NO_ERROR && state == 0 && bench_now_ns() < deadline);
+
+    return (ret == CIFX_NO_ERROR && state == 0) ? CIFX_DEV_EXCHANGE_FAILED : ret;
+}
+
+/**
+ * @brief PLC style cycle over the pointers of xChannelPLCMemoryPtr, on HWIF devices these are the host side images
+ * and the activate calls transfer the full I/O areas
+ */
+static void bench_cifx_plc(CIFXHANDLE channel) {
+    static char name[64];
+    PLC_MEMORY_INFORMATION in_mem;
+    PLC_MEMORY_INFORMATION out_mem;
+    void *in_ptr = NULL;
+    void *out_ptr = NULL;
+    uint32_t in_offset, in_size, out_offset, out_size;
+    bench_case_t bc;
+    netx_sim_stats_t before;
+    netx_sim_stats_t after;
+
+    if (cifx_bench_plc_ptr(channel, CIFX_MEM_PTR_OPEN, CIFX_IO_INPUT_AREA, &in_mem, &in_ptr, &in_offset, &in_size) !=
+        CIFX_NO_ERROR) {
+        return;
+    }
+    if (cifx_bench_plc_ptr(channel, CIFX_MEM_PTR_OPEN, CIFX_IO_OUTPUT_AREA, &out_mem, &out_ptr, &out_offset,
+                           &out_size) != CIFX_NO_ERROR) {
+        cifx_bench_plc_ptr(channel, CIFX_MEM_PTR_CLOSE, CIFX_IO_INPUT_AREA, &in_mem, &in_ptr, &in_offset, &in_size);
+        return;
+    }
+
+    snprintf(name, sizeof(name), "cifx_plc_cycle_%u", in_size);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_IO_ITERATIONS) == 0) {
+        netx_sim_get_stats(&sim, &before);
+        for (uint32_t i = 0; i < CIFX_BENCH_IO_ITERATIONS; i++) {
+            uint64_t start = bench_now_ns();
+
+            if (cifx_bench_plc_wait(channel, 0) != CIFX_NO_ERROR ||
+                xChannelPLCActivateRead(channel, 0) != CIFX_NO_ERROR) {
+                break;
+            }
+            /* outputs follow the inputs */
+            ((uint8_t *) out_ptr)[0] = ((const uint8_t *) in_ptr)[0];
+            if (cifx_bench_plc_wait(channel, 1) != CIFX_NO_ERROR ||
+                xChannelPLCActivateWrite(channel, 0) != CIFX_NO_ERROR) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+        }
+        netx_sim_get_stats(&sim, &after);
+        bc.bytes = (after.read_bytes + after.write_bytes) - (before.read_bytes + before.write_bytes);
+        bench_case_end(&bc);
+    }
+
+    cifx_bench_plc_ptr(channel, CIFX_MEM_PTR_CLOSE, CIFX_IO_OUTPUT_AREA, &out_mem, &out_ptr, &out_offset, &out_size);
+    cifx_bench_plc_ptr(channel, CIFX_MEM_PTR_CLOSE, CIFX_IO_INPUT_AREA, &in_mem, &in_ptr, &in_offset, &in_size);
+}
+
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+/**
+ * @brief startup check of a flash based device whether a firmware file has to be downloaded. Without the file
+ * handle the file is hashed and the MD5 is requested from the device every time, with it both come from the digest
+ * cache after the first check
+ */
+static void bench_cifx_check_download(CIFXHANDLE sysdevice, int cached) {
+    static char name[64];
+    PDEVICEINSTANCE dev = (PDEVICEINSTANCE) ((PCHANNELINSTANCE) sysdevice)->pvDeviceInstance;
+    CIFX_TOOLKIT_DEVICETYPE_E type = dev->eDeviceType;
+    CIFX_DIGEST_CACHE_STATS_T stats;
+    uint32_t size = 0;
+    bench_case_t bc;
+    md5_state_t md5;
+    uint8_t *data;
+    void *file;
+
+    if (bench_cifx_write_file() != 0) {
+        return;
+    }
+    if ((file = OS_FileOpen(CIFX_BENCH_FILE_PATH, &size)) == NULL) {
+        unlink(CIFX_BENCH_FILE_PATH);
+        return;
+    }
+#ifdef CIFX_TOOLKIT_FILE_MAP
+    data = OS_FileMap(file, size);
+#else
+    data = OS_Memalloc(size);
+    if (data != NULL && OS_FileRead(file, 0, size, data) != size) {
+        OS_Memfree(data);
+        data = NULL;
+    }
+#endif
+    if (data != NULL) {
+        md5_init(&md5);
+        md5_append(&md5, data, (long) size);
+        md5_finish(&md5, file_md5);
+
+        unlink(CIFX_BENCH_DIGEST_CACHE_PATH);
+        cifXDigestCacheInit(CIFX_BENCH_DIGEST_CACHE_PATH);
+        dev->eDeviceType = eCIFX_DEVICE_FLASH_BASED;
+
+        snprintf(name, sizeof(name), "check_download_%s_%u", cached ? "cached" : "uncached", size);
+        if (bench_case_begin(&bc, name, CIFX_BENCH_CHECK_ITERATIONS) == 0) {
+            for (uint32_t i = 0; i < CIFX_BENCH_CHECK_ITERATIONS; i++) {
+                uint64_t start = bench_now_ns();
+                int download = 1;
+
+                if (DEV_CheckForDownload(sysdevice, 0, &download, "bench.nxf", data, size, cached ? file : NULL,
+                                         DEV_TransferPacket, NULL, NULL) != CIFX_NO_ERROR || download) {
+                    break;
+                }
+                bench_case_sample(&bc, start);
+            }
+            cifXDigestCacheGetStats(&stats);
+            bench_case_counter(&bc, "file_hits", stats.ulFileHits);
+            bench_case_counter(&bc, "device_hits", stats.ulDeviceHits);
+            bench_case_end(&bc);
+        }
+
+        dev->eDeviceType = type;
+        cifXDigestCacheInit(CIFX_TOOLKIT_DIGEST_CACHE_FILE);
+        unlink(CIFX_BENCH_DIGEST_CACHE_PATH);
+#ifdef CIFX_TOOLKIT_FILE_MAP
+        OS_FileUnmap(data, size);
+#else
+        OS_Memfree(data);
+#endif
+    }
+    OS_FileClose(file);
+    unlink(CIFX_BENCH_FILE_PATH);
+}
+#endif
+
+static void bench_cifx_download(CIFXHANDLE handle, int sysdevice) {
+    static char name[64];
+    bench_case_t bc;
+
+    snprintf(name, sizeof(name), "cifx_download_%s_%u", sysdevice ? "sys" : "ch0", CIFX_BENCH_DOWNLOAD_SIZE);
+    if (bench_case_begin(&bc, name, CIFX_BENCH_DOWNLOAD_ITERATIONS) != 0) {
+        return;
+    }
+    download_bytes = 0;
+    for (uint32_t i = 0; i < CIFX_BENCH_DOWNLOAD_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        int32_t ret = sysdevice ? xSysdeviceDownload(handle, 0, DOWNLOAD_MODE_FILE, "bench.bin", download_buf,
+                                                     sizeof(download_buf), NULL, NULL, NULL)
+                                : xChannelDownload(handle, DOWNLOAD_MODE_FILE, "bench.bin", download_buf,
+                                                   sizeof(download_buf), NULL, NULL, NULL);
+        if (ret != CIFX_NO_ERROR) {
+            break;
+        }
+        bench_case_sample(&bc, start);
+    }
+    /* bytes per op = file data the firmware received, throughput is bytes_per_op / mean */
+    bc.bytes = download_bytes;
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief device creation (layout, mailbox queries, channel ready) on a firmware that is already running
+ */
+static void bench_cifx_startup(void) {
+    netx_sim_config_t config;
+    bench_case_t bc;
+
+    cifx_bench_sim_config(&config);
+    if (bench_case_begin(&bc, "cifx_add_device", CIFX_BENCH_STARTUP_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_STARTUP_ITERATIONS; i++) {
+        uint64_t start;
+        int32_t ret;
+
+        if (cifx_bench_open_device(&config, SERDPM_UNKNOWN) != 0) {
+            break;
+        }
+        start = bench_now_ns();
+        ret = cifXTKitAddDevice(&dev_instance);
+        if (ret == CIFX_NO_ERROR) {
+            bench_case_sample(&bc, start);
+            cifXTKitRemoveDevice(CIFX_BENCH_BOARD, 1);
+        }
+        cifx_bench_close_device();
+        if (ret != CIFX_NO_ERROR) {
+            break;
+        }
+    }
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief device creation of several simulated netX devices, one after another or in parallel
+ * @param parallel !=0 to add the devices with cifXTKitAddDeviceAsync
+ */
+static void bench_cifx_startup_multi(int parallel) {
+    static netx_sim_t sims[CIFX_BENCH_STARTUP_DEVICES];
+    static OS_SPI_DEVICE_T spi_devices[CIFX_BENCH_STARTUP_DEVICES];
+    static DEVICEINSTANCE dev_instances[CIFX_BENCH_STARTUP_DEVICES];
+    static char name[64];
+    netx_sim_config_t config;
+    bench_case_t bc;
+
+#ifndef CIFX_TOOLKIT_ASYNC_ADD
+    if (parallel) {
+        return;
+    }
+#endif
+    cifx_bench_sim_config(&config);
+    snprintf(name, sizeof(name), "cifx_add_device_%u_%s", CIFX_BENCH_STARTUP_DEVICES, parallel ? "parallel" : "serial");
+    if (bench_case_begin(&bc, name, CIFX_BENCH_STARTUP_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIFX_BENCH_STARTUP_ITERATIONS; i++) {
+        int32_t ret = CIFX_NO_ERROR;
+        uint32_t opened;
+        uint64_t start;
+
+        for (opened = 0; opened < CIFX_BENCH_STARTUP_DEVICES; opened++) {
+            memset(&dev_instances[opened], 0, sizeof(dev_instances[opened]));
+            memset(&spi_devices[opened], 0, sizeof(spi_devices[opened]));
+            dev_instances[opened].pvOSDependent = &spi_devices[opened];
+            dev_instances[opened].eDeviceType = eCIFX_DEVICE_AUTODETECT;
+            snprintf(dev_instances[opened].szName, sizeof(dev_instances[opened].szName), "cifX%u", opened);
+            if (netx_sim_open(&sims[opened], &config, &dev_instances[opened]) != 0) {
+                ret = CIFX_DEV_NOT_READY;
+                break;
+            }
+        }
+
+        start = bench_now_ns();
+        if (ret == CIFX_NO_ERROR && parallel) {
+#ifdef CIFX_TOOLKIT_ASYNC_ADD
+            CIFX_ADD_DEVICE_T adds[CIFX_BENCH_STARTUP_DEVICES];
+            uint32_t started;
+
+            for (started = 0; started < CIFX_BENCH_STARTUP_DEVICES; started++) {
+                if ((ret = cifXTKitAddDeviceAsync(&dev_instances[started], &adds[started])) != CIFX_NO_ERROR) {
+                    break;
+                }
+            }
+            /* every started request is waited for, even after an error */
+            for (uint32_t d = 0; d < started; d++) {
+                int32_t dev_ret = cifXTKitAddDeviceWait(&adds[d], CIFX_BENCH_TIMEOUT_MS * 10);
+
+                while (dev_ret == CIFX_DRV_CMD_ACTIVE) {
+                    dev_ret = cifXTKitAddDeviceWait(&adds[d], CIFX_BENCH_TIMEOUT_MS);
+                }
+                if (ret == CIFX_NO_ERROR) {
+                    ret = dev_ret;
+                }
+            }
+#endif
+        } else if (ret == CIFX_NO_ERROR) {
+            for (uint32_t d = 0; d < CIFX_BENCH_STARTUP_DEVICES && ret == CIFX_NO_ERROR; d++) {
+                ret = cifXTKitAddDevice(&dev_instances[d]);
+            }
+        }
+        if (ret == CIFX_NO_ERROR) {
+            bench_case_sample(&bc, start);
+        }
+
+        /* devices are listed in completion order, remove them by name */
+        for (uint32_t d = 0; d < CIFX_BENCH_STARTUP_DEVICES; d++) {
+            cifXTKitRemoveDevice(dev_instances[d].szName, 1);
+        }
+        for (uint32_t d = 0; d < opened; d++) {
+            netx_sim_close(&sims[d]);
+        }
+        if (ret != CIFX_NO_ERROR) {
+            break;
+        }
+    }
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief start the simulated netX, add it to the toolkit and switch channel 0 to bus on
+ * @param chip SERDPM_UNKNOWN or the serial DPM protocol, see cifx_bench_open_device()
+ * @return 0 on success, cifx_bench_stop() must be called then
+ */
+static int cifx_bench_start(int chip, CIFXHANDLE *driver, CIFXHANDLE *sysdevice, CIFXHANDLE *channel) {
+    netx_sim_config_t config;
+    uint32_t state = 0;
+
+    *driver = NULL;
+    *sysdevice = NULL;
+    *channel = NULL;
+
+    cifx_bench_sim_config(&config);
+    if (cifx_bench_open_device(&config, chip) != 0) {
+        return -1;
+    }
+    if (cifXTKitAddDevice(&dev_instance) != CIFX_NO_ERROR ||
+        xDriverOpen(driver) != CIFX_NO_ERROR ||
+        xSysdeviceOpen(*driver, CIFX_BENCH_BOARD, sysdevice) != CIFX_NO_ERROR ||
+        xChannelOpen(*driver, CIFX_BENCH_BOARD, 0, channel) != CIFX_NO_ERROR ||
+        xChannelHostState(*channel, CIFX_HOST_STATE_READY, &state, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR ||
+        xChannelBusState(*channel, CIFX_BUS_STATE_ON, &state, CIFX_BENCH_TIMEOUT_MS) != CIFX_NO_ERROR) {
+        cifx_bench_stop(*driver, *sysdevice, *channel);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief run all toolkit benchmark cases
+ */
+void bench_cifx_run(void) {
+    static const uint32_t io_lengths[] = {8, 64, 200, 1024, HIL_DPM_IO_DATA_SIZE};
+    static const uint32_t serdpm_io_lengths[] = {8, 200, 1024};
+    static const uint32_t mbx_lengths[] = {0, 64, 1024, HIL_DPM_CHANNEL_MAILBOX_SIZE - sizeof(HIL_PACKET_HEADER_T)};
+    static uint8_t crc32_buf[CIFX_BENCH_CRC32_SIZE_MAX + 16];
+    const CIFX_CRC32_IMPL_T *crc32_impls;
+    uint32_t num_crc32_impls;
+    CIFXHANDLE driver;
+    CIFXHANDLE sysdevice;
+    CIFXHANDLE channel;
+
+    if (cifXTKitInit() != CIFX_NO_ERROR) {
+        return;
+    }
+    g_ulTraceLevel = 0;
+
+    memset(download_buf, 0xA5, sizeof(download_buf));
+    pkt_pool_init(&pkt_pool, pkt_pool_entries, sizeof(pkt_pool_entries) / sizeof(pkt_pool_entries[0]));
+    bench_cifx_pkt_pool();
+    bench_cifx_dispatch(4, 1);
+    bench_cifx_dispatch(PKT_DISPATCH_MAX_CMDS, 1);
+    bench_cifx_dispatch(PKT_DISPATCH_MAX_CMDS, 0);
+    num_crc32_impls = cifXCrc32GetImpls(&crc32_impls);
+    if (bench_cifx_crc32_check(crc32_impls, num_crc32_impls, crc32_buf) == 0) {
+        for (uint32_t n = 0; n < num_crc32_impls; n++) {
+            bench_cifx_crc32(&crc32_impls[n], crc32_buf, 64 * 1024);
+            bench_cifx_crc32(&crc32_impls[n], crc32_buf, CIFX_BENCH_CRC32_SIZE_MAX);
+        }
+    }
+    bench_cifx_io_delta_spans(200);
+    bench_cifx_io_delta_spans(HIL_DPM_IO_DATA_SIZE);
+    bench_cifx_file_load();
+
+    if (cifx_bench_start(SERDPM_UNKNOWN, &driver, &sysdevice, &channel) == 0) {
+        for (uint32_t i = 0; i < sizeof(io_lengths) / sizeof(io_lengths[0]); i++) {
+            bench_cifx_io(channel, 1, 0, io_lengths[i]);
+            bench_cifx_io(channel, 0, 0, io_lengths[i]);
+            bench_cifx_io(channel, 1, 1, io_lengths[i]);
+            bench_cifx_io(channel, 0, 1, io_lengths[i]);
+        }
+        for (uint32_t i = 0; i < sizeof(mbx_lengths) / sizeof(mbx_lengths[0]); i++) {
+            bench_cifx_mailbox(channel, mbx_lengths[i]);
+        }
+        for (uint32_t depth = 1; depth <= CIFX_BENCH_MBX_DEPTH_MAX; depth *= 2) {
+            bench_cifx_mbx_engine(channel, 64, depth);
+        }
+        bench_cifx_startup_graph(channel, 0);
+        bench_cifx_startup_graph(channel, 1);
+        bench_cifx_handshake((PCHANNELINSTANCE) channel);
+        bench_cifx_plc(channel);
+#ifdef CIFX_TOOLKIT_DIGEST_CACHE
+        bench_cifx_check_download(sysdevice, 0);
+        bench_cifx_check_download(sysdevice, 1);
+#endif
+        bench_cifx_download(sysdevice, 1);
+        bench_cifx_download(channel, 0);
+        cifx_bench_stop(driver, sysdevice, channel);
+    }
+
+    bench_cifx_startup();
+    bench_cifx_startup_multi(0);
+    bench_cifx_startup_multi(1);
+
+    /* bus cost of the I/O calls with each serial DPM protocol */
+    for (uint32_t c = 0; c < sizeof(serdpm_chips) / sizeof(serdpm_chips[0]); c++) {
+        if (cifx_bench_start(serdpm_chips[c].chip, &driver, &sysdevice, &channel) != 0) {
+            continue;
+        }
+        for (uint32_t i = 0; i < sizeof(serdpm_io_lengths) / sizeof(serdpm_io_lengths[0]); i++) {
+            bench_cifx_serdpm_io(channel, serdpm_chips[c].name, CIFX_BENCH_SERDPM_WRITE, serdpm_io_lengths[i]);
+            bench_cifx_serdpm_io(channel, serdpm_chips[c].name, CIFX_BENCH_SERDPM_READ, serdpm_io_lengths[i]);
+            bench_cifx_serdpm_io(channel, serdpm_chips[c].name, CIFX_BENCH_SERDPM_EXCHANGE, serdpm_io_lengths[i]);
+            bench_cifx_serdpm_io(channel, serdpm_chips[c].name, CIFX_BENCH_SERDPM_READ_WRITE, serdpm_io_lengths[i]);
+#ifdef CIFX_TOOLKIT_HWIF_SHADOW
+            bench_cifx_serdpm_shadow(channel, serdpm_chips[c].name, serdpm_io_lengths[i]);
+#endif
+            bench_cifx_serdpm_io_delta(channel, serdpm_chips[c].name, serdpm_io_lengths[i]);
+        }
+        cifx_bench_stop(driver, sysdevice, channel);
+    }
+
+    cifXTKitDeinit();
+}
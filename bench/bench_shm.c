@@ -0,0 +1,225 @@
+/**
+ ******************************************************************************
+ * @file           :  bench_shm.c
+ * @brief          :  two process benchmark of the GBC shared memory bridge,
+ *                    latency from DPM read to GBC visibility
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "bench.h"
+#include "gbcifx_config.h"
+#include "shm_bridge.h"
+#include "gbc_notify.h"
+
+#define SHM_BENCH_ITERATIONS            20000
+
+/* a lost exchange aborts the case instead of hanging the benchmark */
+#define SHM_BENCH_TIMEOUT_NS            1000000000ULL
+
+/** how the GBC process learns about a new image, spinning on the bridge or one of the notification backends */
+#define SHM_WAKE_POLL                   GBC_NOTIFY_NUM_BACKENDS
+
+static const char *shm_wake_name(int wake) {
+    return wake == SHM_WAKE_POLL ? "poll" : gbc_notify_backend_name((gbc_notify_backend_t) wake);
+}
+
+/* with one CPU the spinning side has to yield, otherwise the other process only runs on the next tick */
+static int single_cpu;
+
+/** anonymous shared mapping, results of the GBC process */
+typedef struct {
+    volatile int ready;
+    volatile uint32_t num_samples;
+    uint64_t latency_ns[SHM_BENCH_ITERATIONS];
+} shm_bench_shared_t;
+
+/**
+ * @brief the GBC end, runs in the child. Waits for each image, records how long after the "DPM read" it became
+ * visible and echoes its seq back through the from_gbc direction
+ */
+static void shm_bench_gbc(const char *name, int wake, shm_bench_shared_t *shared) {
+    shm_bridge_t bridge;
+    gbc_notify_t notify;
+    int rc;
+
+    if (shm_bridge_open(&bridge, name, SHM_BRIDGE_SIDE_GBC) != 0) {
+        shared->ready = -1;
+        return;
+    }
+    if (wake != SHM_WAKE_POLL) {
+        while ((rc = gbc_notify_attach(&notify, &bridge)) == EAGAIN) {
+            sched_yield();
+        }
+        if (rc != 0) {
+            shared->ready = -1;
+            return;
+        }
+    }
+    shared->ready = 1;
+
+    while (shared->num_samples < SHM_BENCH_ITERATIONS) {
+        const shm_bridge_to_gbc_image_t *in;
+        shm_bridge_from_gbc_image_t *out;
+        int fresh;
+
+        if (wake != SHM_WAKE_POLL && gbc_notify_wait(&notify, (int64_t) SHM_BENCH_TIMEOUT_NS) != 0) {
+            break;
+        }
+
+        in = shm_bridge_gbc_latest(&bridge, &fresh);
+        if (!fresh) {
+            continue;
+        }
+        shared->latency_ns[shared->num_samples] = shm_bridge_now_ns() - in->timestamp_ns;
+        shared->num_samples++;
+
+        out = shm_bridge_gbc_acquire(&bridge);
+        out->seq = in->seq;
+        memcpy(out->data.abApp_Inputdata, in->data.abApp_Outputdata, sizeof(out->data.abApp_Inputdata));
+        shm_bridge_gbc_publish(&bridge);
+    }
+
+    if (wake != SHM_WAKE_POLL) {
+        gbc_notify_close(&notify);
+    }
+    shm_bridge_close(&bridge, NULL);
+}
+
+/**
+ * @brief one gbcifx/GBC process pair. The parent publishes an image, notifies and waits until the echo comes back
+ * (round trip case), the child reports the one way latency (visibility case)
+ */
+static void bench_shm_pair(int wake) {
+    static char name[64];
+    static char case_name[64];
+    shm_bench_shared_t *shared;
+    shm_bridge_t bridge;
+    gbc_notify_t notify;
+    bench_case_t bc;
+    sigset_t sigset;
+    sigset_t old_sigset;
+    pid_t child;
+
+    snprintf(name, sizeof(name), "/gbcifx_bench_%d", (int) getpid());
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        return;
+    }
+    memset(shared, 0, sizeof(*shared));
+
+    if (shm_bridge_open(&bridge, name, SHM_BRIDGE_SIDE_CIFX) != 0) {
+        munmap(shared, sizeof(*shared));
+        return;
+    }
+    if (wake != SHM_WAKE_POLL && gbc_notify_open(&notify, &bridge, (gbc_notify_backend_t) wake) != 0) {
+        shm_bridge_close(&bridge, name);
+        munmap(shared, sizeof(*shared));
+        return;
+    }
+
+    /* blocked before the fork so no signal can hit the child before it waits for it */
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGNAL_TO_SEND);
+    sigprocmask(SIG_BLOCK, &sigset, &old_sigset);
+
+    child = fork();
+    if (child == 0) {
+        shm_bench_gbc(name, wake, shared);
+        _exit(0);
+    }
+    sigprocmask(SIG_SETMASK, &old_sigset, NULL);
+    if (child < 0) {
+        if (wake != SHM_WAKE_POLL) {
+            gbc_notify_close(&notify);
+        }
+        shm_bridge_close(&bridge, name);
+        munmap(shared, sizeof(*shared));
+        return;
+    }
+
+    /* hands out the eventfd while the child is attaching */
+    while (shared->ready == 0) {
+        if (wake != SHM_WAKE_POLL) {
+            gbc_notify_service(&notify);
+        }
+        sched_yield();
+    }
+    if (wake == GBC_NOTIFY_SIGNAL) {
+        /* the child is not called GBC_PROCESS_NAME, so it is not searched for */
+        __atomic_store_n(&notify.gbc_pid, child, __ATOMIC_RELEASE);
+    }
+
+    snprintf(case_name, sizeof(case_name), "shm_bridge_roundtrip_%s", shm_wake_name(wake));
+    if (shared->ready > 0 && bench_case_begin(&bc, case_name, SHM_BENCH_ITERATIONS) == 0) {
+        for (uint32_t i = 0; i < SHM_BENCH_ITERATIONS; i++) {
+            uint64_t start = bench_now_ns();
+            shm_bridge_to_gbc_image_t *image = shm_bridge_to_gbc_acquire(&bridge);
+            const shm_bridge_from_gbc_image_t *echo;
+
+            image->data.abApp_Outputdata[0] = (uint8_t) i;
+            shm_bridge_to_gbc_publish(&bridge, start);
+            if (wake != SHM_WAKE_POLL) {
+                gbc_notify_post(&notify);
+            }
+
+            while ((echo = shm_bridge_from_gbc_latest(&bridge))->seq != bridge.seq &&
+                   bench_now_ns() - start < SHM_BENCH_TIMEOUT_NS) {
+                if (single_cpu) {
+                    sched_yield();
+                }
+            }
+            if (echo->seq != bridge.seq) {
+                break;
+            }
+            bench_case_sample(&bc, start);
+            bc.bytes += sizeof(APP_OUTPUT_DATA_T) + sizeof(APP_INPUT_DATA_T);
+        }
+        bench_case_end(&bc);
+    }
+
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+
+    snprintf(case_name, sizeof(case_name), "shm_bridge_latency_%s", shm_wake_name(wake));
+    if (bench_case_begin(&bc, case_name, shared->num_samples) == 0) {
+        memcpy(bc.samples_ns, shared->latency_ns, bc.max_samples * sizeof(uint64_t));
+        bc.num_samples = bc.max_samples;
+        bc.bytes = (uint64_t) bc.num_samples * sizeof(APP_OUTPUT_DATA_T);
+        bench_case_end(&bc);
+    }
+
+    if (wake != SHM_WAKE_POLL) {
+        gbc_notify_close(&notify);
+    }
+    shm_bridge_close(&bridge, name);
+    munmap(shared, sizeof(*shared));
+}
+
+void bench_shm_run(void) {
+    single_cpu = sysconf(_SC_NPROCESSORS_ONLN) < 2;
+
+    /* both processes spinning on one CPU measures the scheduler tick, not the bridge */
+    if (!single_cpu) {
+        bench_shm_pair(SHM_WAKE_POLL);
+    }
+    for (int backend = 0; backend < GBC_NOTIFY_NUM_BACKENDS; backend++) {
+        bench_shm_pair(backend);
+    }
+}
@@ -0,0 +1,263 @@
+/**
+ ******************************************************************************
+ * @file           :  bench_spi.c
+ * @brief          :  benchmarks of OS_SpiTransfer and the serial DPM read/write
+ *                    functions against the bcm2835 stub and the netX emulator
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "bcm2835_stub.h"
+#include "OS_Spi.h"
+#include "cifXHWFunctions.h"
+#include "SerialDPMInterface.h"
+#include "SerialDPMEmu.h"
+
+#define SPI_BENCH_ITERATIONS            20000
+
+/* the emulator runs the slave state machine for every byte, fewer iterations keep the run time down */
+#define SPI_BENCH_EMU_ITERATIONS        2000
+
+/* DPM offset used for the serial DPM cases, somewhere in the channel 0 area */
+#define SPI_BENCH_DPM_OFFSET            0x0300
+
+/* shared bus cases, mailbox sized reads of the second device keep the bus busy */
+#define SPI_BENCH_BUS_ITERATIONS        5000
+#define SPI_BENCH_BUS_LOAD_THREADS      3
+#define SPI_BENCH_BUS_LOAD_LEN          1024
+
+static DEVICEINSTANCE dev_instance;
+static OS_SPI_DEVICE_T spi_device = {.pvDevInstance = &dev_instance};
+static uint8_t tx_buf[4096];
+static uint8_t rx_buf[4096];
+
+/* second netX on CE1 of the same bus */
+static OS_SPI_BUS_T shared_bus;
+static DEVICEINSTANCE dev_instance_b;
+static OS_SPI_DEVICE_T spi_device_b = {.pvDevInstance = &dev_instance_b, .ulCsGpio = 7};
+static uint8_t load_buf[SPI_BENCH_BUS_LOAD_THREADS][SPI_BENCH_BUS_LOAD_LEN];
+static volatile int bus_load_running;
+
+/* netX side of the serial DPM protocols */
+static SERDPM_EMU_T emu;
+static uint8_t emu_dpm[0x10000];
+
+static const struct {
+    const char *name;
+    int chip;
+} emu_chips[] = {
+        {"nx10",  SERDPM_NETX10},
+        {"nx50",  SERDPM_NETX50},
+        {"nx51",  SERDPM_NETX51},
+        {"nx100", SERDPM_NETX100},
+};
+
+typedef enum {
+    SPI_MODE_TX_RX,
+    SPI_MODE_TX_ONLY,
+    SPI_MODE_RX_ONLY,
+    SPI_MODE_IDLE,
+} spi_mode_t;
+
+static const char *spi_mode_name[] = {"tx_rx", "tx_only", "rx_only", "idle"};
+
+static void bench_spi_transfer(spi_mode_t mode, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    uint8_t *send = (mode == SPI_MODE_TX_RX || mode == SPI_MODE_TX_ONLY) ? tx_buf : NULL;
+    uint8_t *recv = (mode == SPI_MODE_TX_RX || mode == SPI_MODE_RX_ONLY) ? rx_buf : NULL;
+
+    snprintf(name, sizeof(name), "spi_transfer_%s_%u", spi_mode_name[mode], len);
+    if (bench_case_begin(&bc, name, SPI_BENCH_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < SPI_BENCH_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        OS_SpiTransfer(&spi_device, send, recv, len);
+        bench_case_sample(&bc, start);
+        bc.bytes += len;
+    }
+    bench_case_end(&bc);
+}
+
+static void bench_serdpm_rw(const char *chip, int write, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    uint64_t bytes_before = bcm2835_stub_bytes;
+
+    snprintf(name, sizeof(name), "serdpm_%s_%s_%u", chip, write ? "write" : "read", len);
+    if (bench_case_begin(&bc, name, SPI_BENCH_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < SPI_BENCH_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        if (write) {
+            dev_instance.pfnHwIfWrite(&dev_instance, (void *) SPI_BENCH_DPM_OFFSET, tx_buf, len);
+        } else {
+            dev_instance.pfnHwIfRead(&dev_instance, (void *) SPI_BENCH_DPM_OFFSET, rx_buf, len);
+        }
+        bench_case_sample(&bc, start);
+    }
+    /* bytes clocked on the bus, including command header and idle bytes */
+    bc.bytes = bcm2835_stub_bytes - bytes_before;
+    bench_case_end(&bc);
+}
+
+static void bench_serdpm_emu_rw(const char *chip, int write, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    SERDPM_EMU_STATS_T before;
+    SERDPM_EMU_STATS_T after;
+
+    snprintf(name, sizeof(name), "serdpm_emu_%s_%s_%u", chip, write ? "write" : "read", len);
+    if (bench_case_begin(&bc, name, SPI_BENCH_EMU_ITERATIONS) != 0) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &before);
+    for (uint32_t i = 0; i < SPI_BENCH_EMU_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        if (write) {
+            dev_instance.pfnHwIfWrite(&dev_instance, (void *) SPI_BENCH_DPM_OFFSET, tx_buf, len);
+        } else {
+            dev_instance.pfnHwIfRead(&dev_instance, (void *) SPI_BENCH_DPM_OFFSET, rx_buf, len);
+        }
+        bench_case_sample(&bc, start);
+    }
+    SerialDPMEmu_GetStats(&emu, &after);
+    bench_case_serdpm(&bc, &before, &after);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief mailbox traffic of the second device, reads until bus_load_running is cleared
+ * @param arg index of the thread
+ * @return NULL
+ */
+static void *bench_spi_bus_load(void *arg) {
+    uint8_t *buf = load_buf[(uintptr_t) arg];
+
+    OS_SpiSetThreadClass(eOS_SPI_CLASS_MAILBOX);
+    while (__atomic_load_n(&bus_load_running, __ATOMIC_RELAXED)) {
+        dev_instance_b.pfnHwIfRead(&dev_instance_b, (void *) SPI_BENCH_DPM_OFFSET, buf, SPI_BENCH_BUS_LOAD_LEN);
+    }
+    return NULL;
+}
+
+/**
+ * @brief small reads of the first device while the second one saturates the bus with mailbox reads
+ * @param cls class of the measured reads, eOS_SPI_CLASS_MAILBOX queues them behind the load in request order
+ */
+static void bench_spi_bus_shared(OS_SPI_CLASS_E cls) {
+    static char name[64];
+    pthread_t threads[SPI_BENCH_BUS_LOAD_THREADS];
+    OS_SPI_BUS_STATS_T before[eOS_SPI_CLASS_COUNT];
+    OS_SPI_BUS_STATS_T after[eOS_SPI_CLASS_COUNT];
+    OS_SPI_BUS_STATS_T load_before[eOS_SPI_CLASS_COUNT];
+    OS_SPI_BUS_STATS_T load_after[eOS_SPI_CLASS_COUNT];
+    uint32_t started = 0;
+    bench_case_t bc;
+
+    snprintf(name, sizeof(name), "spi_bus_shared_%s_nx50_read_4",
+             cls == eOS_SPI_CLASS_CYCLIC ? "cyclic" : "mailbox");
+    if (bench_case_begin(&bc, name, SPI_BENCH_BUS_ITERATIONS) != 0) {
+        return;
+    }
+
+    OS_SpiGetBusStats(&spi_device_b, load_before);
+    bus_load_running = 1;
+    while (started < SPI_BENCH_BUS_LOAD_THREADS &&
+           pthread_create(&threads[started], NULL, bench_spi_bus_load, (void *) (uintptr_t) started) == 0) {
+        started++;
+    }
+
+    OS_SpiSetThreadClass(cls);
+    OS_SpiGetBusStats(&spi_device, before);
+    for (uint32_t i = 0; i < SPI_BENCH_BUS_ITERATIONS; i++) {
+        uint64_t start = bench_now_ns();
+        dev_instance.pfnHwIfRead(&dev_instance, (void *) SPI_BENCH_DPM_OFFSET, rx_buf, 4);
+        bench_case_sample(&bc, start);
+        bc.bytes += 4;
+    }
+    OS_SpiGetBusStats(&spi_device, after);
+    OS_SpiSetThreadClass(eOS_SPI_CLASS_MAILBOX);
+
+    __atomic_store_n(&bus_load_running, 0, __ATOMIC_RELAXED);
+    for (uint32_t t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    OS_SpiGetBusStats(&spi_device_b, load_after);
+
+    bench_case_counter(&bc, "wait_ns", after[cls].ullWaitTimeNs - before[cls].ullWaitTimeNs);
+    bench_case_counter(&bc, "contended", after[cls].ullContended - before[cls].ullContended);
+    bench_case_counter(&bc, "bus_ns", after[cls].ullBusTimeNs - before[cls].ullBusTimeNs);
+    /* progress of the other device in the meantime, must not drop to 0 */
+    bench_case_counter(&bc, "load_transactions", load_after[eOS_SPI_CLASS_MAILBOX].ullTransactions -
+                                                 load_before[eOS_SPI_CLASS_MAILBOX].ullTransactions);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief run all SPI benchmark cases
+ */
+void bench_spi_run(void) {
+    static const uint32_t lengths[] = {1, 4, 124, 1024, 4096};
+
+    memset(tx_buf, 0x5A, sizeof(tx_buf));
+
+    dev_instance.pvOSDependent = &spi_device;
+    dev_instance.ulDPMSize = 0x10000;
+
+    /* the stub answers 0xFF to the chip detection, which identifies a netX50 */
+    bcm2835_stub_set_rx_byte(0xFF);
+    if (SerialDPM_Init(&dev_instance) != SERDPM_NETX50) {
+        return;
+    }
+
+    for (spi_mode_t mode = SPI_MODE_TX_RX; mode <= SPI_MODE_IDLE; mode++) {
+        for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            bench_spi_transfer(mode, lengths[i]);
+        }
+    }
+
+    /* from now on every polled byte is the 0xA5 ready marker */
+    bcm2835_stub_set_rx_byte(0xA5);
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        bench_serdpm_rw("nx50", 0, lengths[i]);
+        bench_serdpm_rw("nx50", 1, lengths[i]);
+    }
+
+    /* the same accesses against the emulated netX, counts what each protocol puts on the bus */
+    for (uint32_t c = 0; c < sizeof(emu_chips) / sizeof(emu_chips[0]); c++) {
+        SerialDPMEmu_Init(&emu, emu_chips[c].chip, emu_dpm, sizeof(emu_dpm), NULL);
+        bcm2835_stub_attach(&emu);
+        if (SerialDPM_Init(&dev_instance) == emu_chips[c].chip) {
+            for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+                bench_serdpm_emu_rw(emu_chips[c].name, 0, lengths[i]);
+                bench_serdpm_emu_rw(emu_chips[c].name, 1, lengths[i]);
+            }
+        }
+        bcm2835_stub_attach(NULL);
+    }
+
+    /* two netX50 on one bus, the chip detection of both sees 0xFF */
+    spi_device.ptBus = &shared_bus;
+    spi_device_b.ptBus = &shared_bus;
+    dev_instance_b.pvOSDependent = &spi_device_b;
+    dev_instance_b.ulDPMSize = 0x10000;
+    bcm2835_stub_set_rx_byte(0xFF);
+    if (SerialDPM_Init(&dev_instance) == SERDPM_NETX50 && SerialDPM_Init(&dev_instance_b) == SERDPM_NETX50) {
+        bcm2835_stub_set_rx_byte(0xA5);
+        bench_spi_bus_shared(eOS_SPI_CLASS_MAILBOX);
+        bench_spi_bus_shared(eOS_SPI_CLASS_CYCLIC);
+    }
+}
@@ -0,0 +1,338 @@
+/**
+ ******************************************************************************
+ * @file           :  bench_spidev.c
+ * @brief          :  benchmarks of the spidev SPI backend (OS_SPIDev.c) against
+ *                    the spidev mock and the netX emulator
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "spidev_mock.h"
+#include "OS_Spi.h"
+#include "cifXHWFunctions.h"
+#include "SerialDPMInterface.h"
+#include "SerialDPMEmu.h"
+
+/* the emulator runs the slave state machine for every byte, as in bench_spi.c */
+#define SPIDEV_BENCH_ITERATIONS         2000
+
+/* every injected error is logged by the backend */
+#define SPIDEV_BENCH_ERROR_ITERATIONS   200
+
+/* DPM offset of the accesses, somewhere in the channel 0 area */
+#define SPIDEV_BENCH_DPM_OFFSET         0x0300
+
+/* spidev default bufsiz, and a small one which splits a 1024 byte frame into several messages */
+#define SPIDEV_BENCH_BUFSIZ             4096
+#define SPIDEV_BENCH_SPLIT_BUFSIZ       512
+
+/* vectored cases, entries of 16 bytes which are read with 8 bytes in between, written back to back */
+#define SPIDEV_BENCH_IOVEC_COUNT        4
+#define SPIDEV_BENCH_IOVEC_LEN          16
+#define SPIDEV_BENCH_IOVEC_GAP          8
+
+static DEVICEINSTANCE dev_instance;
+static OS_SPI_DEVICE_T spi_device = {
+        .pvDevInstance = &dev_instance,
+        .szDevice = SPIDEV_MOCK_DEVICE,
+        .ulSpeedHz = 10000000,
+        .iFd = -1,
+};
+static uint8_t tx_buf[4096];
+static uint8_t rx_buf[4096];
+
+/* netX side of the serial DPM protocols */
+static SERDPM_EMU_T emu;
+static uint8_t emu_dpm[0x10000];
+
+static const struct {
+    const char *name;
+    int chip;
+} spidev_chips[] = {
+        {"nx10",  SERDPM_NETX10},
+        {"nx50",  SERDPM_NETX50},
+        {"nx51",  SERDPM_NETX51},
+        {"nx100", SERDPM_NETX100},
+};
+
+/**
+ * @brief spidev calls between two snapshots of the mock counters
+ */
+static void bench_case_spidev(bench_case_t *bc, const spidev_mock_stats_t *before, const spidev_mock_stats_t *after) {
+    bench_case_counter(bc, "messages", after->messages - before->messages);
+    bench_case_counter(bc, "transfers", after->transfers - before->transfers);
+    bench_case_counter(bc, "failed", after->failed - before->failed);
+    bench_case_counter(bc, "misuse", after->misuse - before->misuse);
+}
+
+/**
+ * @brief (re)open the spidev node in front of a freshly emulated netX, the OS_Spi interface has no deinit
+ * @return 0 if the serial DPM detection found the chip
+ */
+static int bench_spidev_init(int chip, uint32_t bufsiz) {
+    if (spi_device.iFd >= 0) {
+        close(spi_device.iFd);
+        spi_device.iFd = -1;
+    }
+    spidev_mock_set_bufsiz(bufsiz);
+    SerialDPMEmu_Init(&emu, chip, emu_dpm, sizeof(emu_dpm), NULL);
+    spidev_mock_attach(&emu);
+    return SerialDPM_Init(&dev_instance) == chip ? 0 : -1;
+}
+
+/**
+ * @brief fill the source of an access with a pattern of the iteration
+ */
+static void bench_spidev_pattern(int write, uint32_t len, uint32_t i) {
+    uint8_t *data = write ? tx_buf : &emu_dpm[SPIDEV_BENCH_DPM_OFFSET];
+
+    for (uint32_t pos = 0; pos < len; pos++) {
+        data[pos] = (uint8_t) (pos + i);
+    }
+}
+
+/**
+ * @brief check that the access moved the pattern
+ * @return 1 if the destination differs from the source
+ */
+static int bench_spidev_mismatch(int write, uint32_t len) {
+    return memcmp(&emu_dpm[SPIDEV_BENCH_DPM_OFFSET], write ? tx_buf : rx_buf, len) != 0;
+}
+
+static void bench_spidev_access(int write, uint32_t len) {
+    if (write) {
+        dev_instance.pfnHwIfWrite(&dev_instance, (void *) SPIDEV_BENCH_DPM_OFFSET, tx_buf, len);
+    } else {
+        dev_instance.pfnHwIfRead(&dev_instance, (void *) SPIDEV_BENCH_DPM_OFFSET, rx_buf, len);
+    }
+}
+
+/**
+ * @brief serial DPM read or write through spidev. messages are the SPI_IOC_MESSAGE calls per access, a frame larger
+ * than bufsiz takes several. data_errors count accesses which did not move the data, failed and misuse must stay 0
+ */
+static void bench_spidev_rw(const char *chip, const char *variant, int write, uint32_t len) {
+    static char name[64];
+    bench_case_t bc;
+    SERDPM_EMU_STATS_T before;
+    SERDPM_EMU_STATS_T after;
+    spidev_mock_stats_t mock_before;
+    spidev_mock_stats_t mock_after;
+    uint64_t data_errors = 0;
+
+    snprintf(name, sizeof(name), "spidev_%s_%s%s_%u", chip, write ? "write" : "read", variant, len);
+    if (bench_case_begin(&bc, name, SPIDEV_BENCH_ITERATIONS) != 0) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &before);
+    spidev_mock_get_stats(&mock_before);
+    for (uint32_t i = 0; i < SPIDEV_BENCH_ITERATIONS; i++) {
+        uint64_t start;
+
+        bench_spidev_pattern(write, len, i);
+        start = bench_now_ns();
+        bench_spidev_access(write, len);
+        bench_case_sample(&bc, start);
+        data_errors += bench_spidev_mismatch(write, len);
+    }
+    SerialDPMEmu_GetStats(&emu, &after);
+    spidev_mock_get_stats(&mock_after);
+    bench_case_serdpm(&bc, &before, &after);
+    bench_case_spidev(&bc, &mock_before, &mock_after);
+    bench_case_counter(&bc, "data_errors", data_errors);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief vectored access, the entries go out as one frame and so as one SPI_IOC_MESSAGE. The read skips the bytes
+ * between the entries in the same frame (an idle transfer each)
+ */
+static void bench_spidev_iovec(const char *chip, int write) {
+    static char name[64];
+    HWIF_IOVEC_T iovec[SPIDEV_BENCH_IOVEC_COUNT];
+    uint32_t stride = SPIDEV_BENCH_IOVEC_LEN + (write ? 0 : SPIDEV_BENCH_IOVEC_GAP);
+    uint32_t len = SPIDEV_BENCH_IOVEC_COUNT * stride;
+    bench_case_t bc;
+    SERDPM_EMU_STATS_T before;
+    SERDPM_EMU_STATS_T after;
+    spidev_mock_stats_t mock_before;
+    spidev_mock_stats_t mock_after;
+    uint64_t data_errors = 0;
+
+    for (uint32_t e = 0; e < SPIDEV_BENCH_IOVEC_COUNT; e++) {
+        iovec[e].pvAddr = (void *) (uintptr_t) (SPIDEV_BENCH_DPM_OFFSET + e * stride);
+        iovec[e].pvData = (write ? tx_buf : rx_buf) + e * stride;
+        iovec[e].ulLen = SPIDEV_BENCH_IOVEC_LEN;
+    }
+    snprintf(name, sizeof(name), "spidev_%s_%s_%ux%u", chip, write ? "writev" : "readv",
+             SPIDEV_BENCH_IOVEC_COUNT, SPIDEV_BENCH_IOVEC_LEN);
+    if (bench_case_begin(&bc, name, SPIDEV_BENCH_ITERATIONS) != 0) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &before);
+    spidev_mock_get_stats(&mock_before);
+    for (uint32_t i = 0; i < SPIDEV_BENCH_ITERATIONS; i++) {
+        uint64_t start;
+
+        bench_spidev_pattern(write, len, i);
+        memset(rx_buf, 0, len);
+        start = bench_now_ns();
+        if (write) {
+            dev_instance.pfnHwIfWriteV(&dev_instance, iovec, SPIDEV_BENCH_IOVEC_COUNT);
+        } else {
+            dev_instance.pfnHwIfReadV(&dev_instance, iovec, SPIDEV_BENCH_IOVEC_COUNT);
+        }
+        bench_case_sample(&bc, start);
+        for (uint32_t e = 0; e < SPIDEV_BENCH_IOVEC_COUNT; e++) {
+            data_errors += memcmp(&emu_dpm[SPIDEV_BENCH_DPM_OFFSET + e * stride],
+                                  (uint8_t *) iovec[e].pvData, SPIDEV_BENCH_IOVEC_LEN) != 0;
+        }
+    }
+    SerialDPMEmu_GetStats(&emu, &after);
+    spidev_mock_get_stats(&mock_after);
+    bench_case_serdpm(&bc, &before, &after);
+    bench_case_spidev(&bc, &mock_before, &mock_after);
+    bench_case_counter(&bc, "data_errors", data_errors);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief an SPI_IOC_MESSAGE of a read fails after skip messages went through. The rest of the frame must be dropped,
+ * a continuation clocked in as a new frame would be taken as a command by the netX (protocol_errors, or a write to
+ * wherever the data points). data_errors count reads done right after the failure which do not return the DPM content
+ */
+static void bench_spidev_message_error(const char *chip, const char *variant, uint32_t len, uint32_t skip) {
+    static char name[64];
+    bench_case_t bc;
+    SERDPM_EMU_STATS_T before;
+    SERDPM_EMU_STATS_T after;
+    spidev_mock_stats_t mock_before;
+    spidev_mock_stats_t mock_after;
+    uint64_t data_errors = 0;
+
+    snprintf(name, sizeof(name), "spidev_%s_read%s_error_%u", chip, variant, len);
+    if (bench_case_begin(&bc, name, SPIDEV_BENCH_ERROR_ITERATIONS) != 0) {
+        return;
+    }
+    SerialDPMEmu_GetStats(&emu, &before);
+    spidev_mock_get_stats(&mock_before);
+    for (uint32_t i = 0; i < SPIDEV_BENCH_ERROR_ITERATIONS; i++) {
+        uint64_t start;
+
+        spidev_mock_fail(SPIDEV_MOCK_FAIL_MESSAGE, EIO, skip);
+        start = bench_now_ns();
+        bench_spidev_access(0, len);
+        bench_case_sample(&bc, start);
+        spidev_mock_fail(SPIDEV_MOCK_FAIL_NONE, 0, 0);
+
+        bench_spidev_pattern(0, len, i);
+        bench_spidev_access(0, len);
+        data_errors += bench_spidev_mismatch(0, len);
+    }
+    SerialDPMEmu_GetStats(&emu, &after);
+    spidev_mock_get_stats(&mock_after);
+    bench_case_serdpm(&bc, &before, &after);
+    bench_case_spidev(&bc, &mock_before, &mock_after);
+    bench_case_counter(&bc, "data_errors", data_errors);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief OS_SpiInit with the open or the configuration of the node failing, leaked_fds must stay 0
+ */
+static void bench_spidev_init_error(spidev_mock_fail_t call, const char *what) {
+    static char name[64];
+    static DEVICEINSTANCE err_instance;
+    static OS_SPI_DEVICE_T err_device = {
+            .pvDevInstance = &err_instance,
+            .szDevice = SPIDEV_MOCK_DEVICE,
+            .ulSpeedHz = 10000000,
+            .iFd = -1,
+    };
+    bench_case_t bc;
+    uint32_t open_fds = spidev_mock_open_fds();
+    uint64_t init_errors = 0;
+    uint64_t leaked_fds = 0;
+
+    snprintf(name, sizeof(name), "spidev_init_%s_error", what);
+    if (bench_case_begin(&bc, name, SPIDEV_BENCH_ERROR_ITERATIONS) != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < SPIDEV_BENCH_ERROR_ITERATIONS; i++) {
+        uint64_t start;
+
+        spidev_mock_fail(call, call == SPIDEV_MOCK_FAIL_OPEN ? ENOENT : EINVAL, 0);
+        start = bench_now_ns();
+        init_errors += OS_SpiInit(&err_device) != CIFX_NO_ERROR;
+        bench_case_sample(&bc, start);
+        leaked_fds += spidev_mock_open_fds() - open_fds;
+        if (err_device.iFd >= 0) {
+            close(err_device.iFd);
+            err_device.iFd = -1;
+        }
+    }
+    spidev_mock_fail(SPIDEV_MOCK_FAIL_NONE, 0, 0);
+    bench_case_counter(&bc, "init_errors", init_errors);
+    bench_case_counter(&bc, "leaked_fds", leaked_fds);
+    bench_case_end(&bc);
+}
+
+/**
+ * @brief run all spidev benchmark cases
+ */
+void bench_spidev_run(void) {
+    static const uint32_t lengths[] = {4, 1024, 4096};
+
+    dev_instance.pvOSDependent = &spi_device;
+    dev_instance.ulDPMSize = sizeof(emu_dpm);
+
+    for (uint32_t c = 0; c < sizeof(spidev_chips) / sizeof(spidev_chips[0]); c++) {
+        int chip = spidev_chips[c].chip;
+        const char *chip_name = spidev_chips[c].name;
+
+        if (bench_spidev_init(chip, SPIDEV_BENCH_BUFSIZ) != 0) {
+            continue;
+        }
+        for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            bench_spidev_rw(chip_name, "", 0, lengths[i]);
+            bench_spidev_rw(chip_name, "", 1, lengths[i]);
+        }
+        if (dev_instance.pfnHwIfReadV != NULL) {
+            bench_spidev_iovec(chip_name, 0);
+            bench_spidev_iovec(chip_name, 1);
+        }
+
+        /* netX10/51 hand a frame over as a whole, netX50/100 as one message per call inside the frame */
+        if (dev_instance.pfnHwIfReadV != NULL) {
+            bench_spidev_message_error(chip_name, "", 1024, 0);
+            if (bench_spidev_init(chip, SPIDEV_BENCH_SPLIT_BUFSIZ) != 0) {
+                continue;
+            }
+            bench_spidev_rw(chip_name, "_split", 0, 1024);
+            bench_spidev_rw(chip_name, "_split", 1, 1024);
+            bench_spidev_message_error(chip_name, "_split", 1024, 1);
+        } else {
+            bench_spidev_message_error(chip_name, "", 16, 4);
+        }
+    }
+
+    bench_spidev_init_error(SPIDEV_MOCK_FAIL_OPEN, "open");
+    bench_spidev_init_error(SPIDEV_MOCK_FAIL_CONFIG, "config");
+
+    if (spi_device.iFd >= 0) {
+        close(spi_device.iFd);
+        spi_device.iFd = -1;
+    }
+    spidev_mock_attach(NULL);
+}
@@ -0,0 +1,270 @@
+/**
+ ******************************************************************************
+ * @file           :  spidev_mock.c
+ * @brief          :  stand-in for the Linux spidev driver, wraps open, ioctl,
+ *                    close and fopen so OS_SPIDev.c runs without hardware
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "spidev_mock.h"
+
+/* module parameter read by OS_SPIDev.c for the message length limit */
+#define SPIDEV_MOCK_BUFSIZ_PARAM        "/sys/module/spidev/parameters/bufsiz"
+
+/* spidev rounds every transfer up to ARCH_DMA_MINALIGN when checking a message against bufsiz (128 on arm64) */
+#define SPIDEV_MOCK_DMA_MINALIGN        128
+#define SPIDEV_MOCK_ALIGN(len)          (((len) + SPIDEV_MOCK_DMA_MINALIGN - 1) & ~(SPIDEV_MOCK_DMA_MINALIGN - 1))
+
+#define SPIDEV_MOCK_MAX_FDS             4
+
+/* provided by the linker through -Wl,--wrap */
+int __real_open(const char *path, int flags, ...);
+int __real_ioctl(int fd, unsigned long request, ...);
+int __real_close(int fd);
+FILE *__real_fopen(const char *path, const char *mode);
+
+static SERDPM_EMU_T *mock_emu = NULL;
+static uint32_t mock_bufsiz = 4096;
+static char mock_bufsiz_text[16];
+static int mock_fds[SPIDEV_MOCK_MAX_FDS] = {-1, -1, -1, -1};
+static int mock_cs_active = 0;
+static spidev_mock_stats_t mock_stats;
+
+static spidev_mock_fail_t mock_fail_call = SPIDEV_MOCK_FAIL_NONE;
+static int mock_fail_err = 0;
+static uint32_t mock_fail_skip = 0;
+
+void spidev_mock_attach(SERDPM_EMU_T *emu) {
+    mock_emu = emu;
+}
+
+void spidev_mock_set_bufsiz(uint32_t bufsiz) {
+    mock_bufsiz = bufsiz;
+}
+
+void spidev_mock_fail(spidev_mock_fail_t call, int err, uint32_t skip) {
+    mock_fail_call = call;
+    mock_fail_err = err;
+    mock_fail_skip = skip;
+}
+
+void spidev_mock_get_stats(spidev_mock_stats_t *stats) {
+    *stats = mock_stats;
+}
+
+uint32_t spidev_mock_open_fds(void) {
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < SPIDEV_MOCK_MAX_FDS; i++) {
+        count += mock_fds[i] >= 0;
+    }
+    return count;
+}
+
+/**
+ * @brief consume an armed error injection
+ * @return errno to answer the call with, 0 if the call goes through
+ */
+static int spidev_mock_injected(spidev_mock_fail_t call) {
+    int err;
+
+    if (mock_fail_call != call) {
+        return 0;
+    }
+    if (mock_fail_skip > 0) {
+        mock_fail_skip--;
+        return 0;
+    }
+    err = mock_fail_err;
+    mock_fail_call = SPIDEV_MOCK_FAIL_NONE;
+    mock_stats.failed++;
+    return err;
+}
+
+static int *spidev_mock_slot(int fd) {
+    for (uint32_t i = 0; i < SPIDEV_MOCK_MAX_FDS; i++) {
+        if (fd >= 0 && mock_fds[i] == fd) {
+            return &mock_fds[i];
+        }
+    }
+    return NULL;
+}
+
+static void spidev_mock_select(int select) {
+    mock_cs_active = select;
+    if (mock_emu != NULL) {
+        SerialDPMEmu_Select(mock_emu, select);
+    }
+}
+
+static void spidev_mock_clock(const struct spi_ioc_transfer *xfer) {
+    const uint8_t *tx = (const uint8_t *) (uintptr_t) xfer->tx_buf;
+    uint8_t *rx = (uint8_t *) (uintptr_t) xfer->rx_buf;
+
+    if (mock_emu != NULL) {
+        SerialDPMEmu_Clock(mock_emu, tx, rx, xfer->len);
+    } else if (rx != NULL) {
+        memset(rx, 0xFF, xfer->len);
+    }
+}
+
+/**
+ * @brief SPI_IOC_MESSAGE as spidev_message() handles it: the message is checked against bufsiz first, chip select
+ * is asserted for the first transfer and released after a transfer with cs_change, or after the last one unless it
+ * has cs_change set. A failing message leaves chip select released
+ */
+static int spidev_mock_message(const struct spi_ioc_transfer *xfers, uint32_t count) {
+    uint32_t tx_total = 0;
+    uint32_t rx_total = 0;
+    int err;
+
+    mock_stats.messages++;
+    mock_stats.transfers += count;
+    for (uint32_t i = 0; i < count; i++) {
+        if (xfers[i].rx_buf != 0) {
+            rx_total += SPIDEV_MOCK_ALIGN(xfers[i].len);
+        }
+        if (xfers[i].tx_buf != 0) {
+            tx_total += SPIDEV_MOCK_ALIGN(xfers[i].len);
+        }
+        /* the backend never relies on the controller to make up the transmit data */
+        if (xfers[i].len > 0 && xfers[i].rx_buf == 0 && xfers[i].tx_buf == 0) {
+            mock_stats.misuse++;
+        }
+    }
+    if (tx_total > mock_bufsiz || rx_total > mock_bufsiz) {
+        mock_stats.misuse++;
+        mock_stats.failed++;
+        err = EMSGSIZE;
+    } else {
+        err = spidev_mock_injected(SPIDEV_MOCK_FAIL_MESSAGE);
+    }
+    if (err != 0) {
+        spidev_mock_select(0);
+        errno = err;
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!mock_cs_active) {
+            spidev_mock_select(1);
+        }
+        spidev_mock_clock(&xfers[i]);
+        if ((xfers[i].cs_change != 0) != (i == count - 1)) {
+            spidev_mock_select(0);
+        }
+    }
+    return (int) (tx_total > rx_total ? tx_total : rx_total);
+}
+
+int __wrap_open(const char *path, int flags, ...) {
+    int *slot;
+    int err;
+
+    if (strcmp(path, SPIDEV_MOCK_DEVICE) != 0) {
+        va_list ap;
+        mode_t mode;
+
+        va_start(ap, flags);
+        mode = (flags & O_CREAT) ? va_arg(ap, mode_t) : 0;
+        va_end(ap);
+        return __real_open(path, flags, mode);
+    }
+    if ((err = spidev_mock_injected(SPIDEV_MOCK_FAIL_OPEN)) != 0) {
+        errno = err;
+        return -1;
+    }
+    slot = NULL;
+    for (uint32_t i = 0; i < SPIDEV_MOCK_MAX_FDS && slot == NULL; i++) {
+        slot = mock_fds[i] < 0 ? &mock_fds[i] : NULL;
+    }
+    /* a real descriptor keeps the number unique */
+    if (slot == NULL || (*slot = __real_open("/dev/null", O_RDWR)) < 0) {
+        errno = EMFILE;
+        return -1;
+    }
+    mock_stats.opens++;
+    mock_cs_active = 0;
+    return *slot;
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...) {
+    va_list ap;
+    void *arg;
+    int err;
+
+    va_start(ap, request);
+    arg = va_arg(ap, void *);
+    va_end(ap);
+
+    if (spidev_mock_slot(fd) == NULL) {
+        return __real_ioctl(fd, request, arg);
+    }
+
+    switch (request) {
+        case SPI_IOC_WR_MODE:
+            if (*(const uint8_t *) arg != SPI_MODE_0) {
+                mock_stats.misuse++;
+            }
+            return 0;
+        case SPI_IOC_WR_BITS_PER_WORD:
+            if (*(const uint8_t *) arg != 8) {
+                mock_stats.misuse++;
+            }
+            return 0;
+        case SPI_IOC_WR_MAX_SPEED_HZ:
+            if ((err = spidev_mock_injected(SPIDEV_MOCK_FAIL_CONFIG)) != 0) {
+                errno = err;
+                return -1;
+            }
+            return 0;
+        default:
+            break;
+    }
+
+    if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0 && _IOC_DIR(request) == _IOC_WRITE &&
+        _IOC_SIZE(request) % sizeof(struct spi_ioc_transfer) == 0) {
+        return spidev_mock_message((const struct spi_ioc_transfer *) arg,
+                                   _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer));
+    }
+    mock_stats.misuse++;
+    errno = ENOTTY;
+    return -1;
+}
+
+int __wrap_close(int fd) {
+    int *slot = spidev_mock_slot(fd);
+
+    if (slot != NULL) {
+        /* closing with chip select held leaves the netX in the middle of a frame */
+        if (mock_cs_active) {
+            mock_stats.misuse++;
+            spidev_mock_select(0);
+        }
+        *slot = -1;
+        mock_stats.closes++;
+    }
+    return __real_close(fd);
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode) {
+    if (strcmp(path, SPIDEV_MOCK_BUFSIZ_PARAM) != 0) {
+        return __real_fopen(path, mode);
+    }
+    snprintf(mock_bufsiz_text, sizeof(mock_bufsiz_text), "%u\n", mock_bufsiz);
+    return fmemopen(mock_bufsiz_text, strlen(mock_bufsiz_text), mode);
+}
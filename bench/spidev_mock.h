@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file           :  spidev_mock.h
+ * @brief          :  controls for the spidev stand-in of gbcifx_bench_spidev
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2022 Glowbuzzer.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+
+#ifndef GBCIFX_SPIDEV_MOCK_H
+#define GBCIFX_SPIDEV_MOCK_H
+
+#include <stdint.h>
+#include "SerialDPMEmu.h"
+
+/* device node answered by the mock, open() of any other path goes to the real call */
+#define SPIDEV_MOCK_DEVICE              "/dev/spidev-mock0.0"
+
+/** Call of the spidev interface an error can be injected into */
+typedef enum {
+    SPIDEV_MOCK_FAIL_NONE,
+    SPIDEV_MOCK_FAIL_OPEN,
+    SPIDEV_MOCK_FAIL_CONFIG,            /** SPI_IOC_WR_MAX_SPEED_HZ */
+    SPIDEV_MOCK_FAIL_MESSAGE,           /** SPI_IOC_MESSAGE */
+} spidev_mock_fail_t;
+
+/** Calls seen by the mock since program start */
+typedef struct {
+    uint64_t opens;
+    uint64_t closes;
+    uint64_t messages;                  /** SPI_IOC_MESSAGE calls, including failed ones */
+    uint64_t transfers;                 /** spi_ioc_transfer entries of the messages */
+    uint64_t failed;                    /** calls answered with an injected error or EMSGSIZE */
+    uint64_t misuse;                    /** requests the driver would reject or handle other than intended */
+} spidev_mock_stats_t;
+
+/* emulated netX the transfers are clocked into, NULL answers 0xFF to every byte */
+void spidev_mock_attach(SERDPM_EMU_T *emu);
+
+/* module parameter bufsiz reported by /sys/module/spidev/parameters/bufsiz, the message length limit */
+void spidev_mock_set_bufsiz(uint32_t bufsiz);
+
+/* the call fails with err once, after skip calls of the same kind went through */
+void spidev_mock_fail(spidev_mock_fail_t call, int err, uint32_t skip);
+
+void spidev_mock_get_stats(spidev_mock_stats_t *stats);
+
+/* device nodes currently open */
+uint32_t spidev_mock_open_fds(void);
+
+#endif //GBCIFX_SPIDEV_MOCK_H
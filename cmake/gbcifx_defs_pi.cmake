@@ -15,3 +15,22 @@ SET(SIGNAL_TO_SEND SIGIO)
 
 SET(GBC_SHARED_MEMORY_NAME "gbc_shared_memory")
 
+#how GBC is woken up after each exchange - SIGNAL (SIGNAL_TO_SEND), FUTEX (futex word in the shared memory) or EVENTFD
+SET(GBC_NOTIFY_BACKEND SIGNAL)
+#SET(GBC_NOTIFY_BACKEND FUTEX)
+#SET(GBC_NOTIFY_BACKEND EVENTFD)
+
+#unix socket GBC connects to for the eventfd, only used if GBC_NOTIFY_BACKEND is EVENTFD
+SET(GBC_NOTIFY_SOCKET "/tmp/gbcifx_notify.sock")
+
+
+#spidev device node and max. SPI clock, only used if SPI_BACKEND is SPIDEV
+SET(SPIDEV_DEVICE "/dev/spidev0.0")
+SET(SPIDEV_SPEED_HZ 15600000)
+
+#GPIO driven as chip select of the netX, only used if SPI_BACKEND is BCM2835 (CE0 = 8, CE1 = 7)
+SET(SPI_CS_GPIO 8)
+
+#gpio-cdev chip and line offset of the netX DIRQ signal, only used if GBCIFX_IRQ is ON
+SET(IRQ_GPIO_CHIP "/dev/gpiochip0")
+SET(IRQ_GPIO_LINE 25)
@@ -22,6 +22,92 @@
 #define STACK64K                                        (64 * 1024)
 
 
+/*** *** CYCLIC EXCHANGE CONFIGURATION *** ***/
+
+/** Cycle time of the process data exchange in ns */
+#define CYCLIC_EXEC_PERIOD_NS                           1000000
+
+/** SCHED_FIFO priority of the cyclic exchange thread */
+#define CYCLIC_EXEC_PRIORITY                            80
+
+/** CPU the cyclic exchange thread is pinned to (-1 for no pinning) */
+#define CYCLIC_EXEC_CPU                                 3
+
+/** Interval in which the main thread reports the cycle statistics in ms */
+#define CYCLIC_EXEC_REPORT_MS                           1000
+
+/** Write only the changed parts of the outputs each cycle (xChannelIOWriteMode delta), 0 writes the complete outputs.
+    Pays off if few setpoints change per cycle, the bus time is never above a full write but the compare costs host time */
+#define CYCLIC_EXEC_WRITE_DELTA                         0
+
+
+/*** *** INTERRUPT CONFIGURATION *** ***/
+
+/** SCHED_FIFO priority of the DSR thread (GBCIFX_IRQ builds only), above the cyclic exchange it wakes up */
+#define IRQ_THREAD_PRIORITY                             (CYCLIC_EXEC_PRIORITY + 1)
+
+/** CPU the DSR thread is pinned to (-1 for no pinning) */
+#define IRQ_THREAD_CPU                                  CYCLIC_EXEC_CPU
+
+
+/*** *** MAILBOX CONFIGURATION *** ***/
+
+/** Poll period of the receive mailbox in the mailbox engine thread in ms, the max. delay of an indication */
+#define MBX_ENGINE_POLL_MS                              1
+
+/** Mailbox packets preallocated at startup (requests, confirmations and indications that are held at the same time) */
+#define PKT_POOL_SIZE                                   32
+
+/** Commands with a handler in the packet dispatch table of the protocol (max. 32, see pkt_dispatch.h) */
+#define PKT_DISPATCH_MAX_CMDS                           32
+
+/** Configure the EtherCAT slave from the application at startup (Protocol_Startup) instead of a configuration database */
+#define ECS_APP_STARTUP                                 0
+
+
+/*** *** SIMULATOR CONFIGURATION *** ***/
+
+/** Size of the simulated PD0 areas (GBCIFX_SIM builds only), covers the application process images */
+#define NETX_SIM_IO_SIZE                                200
+
+/** Host side latency of every simulated DPM access in ns, roughly a serial DPM frame header */
+#define NETX_SIM_ACCESS_NS                              2000
+
+/** Host side latency per byte in ns, 8 clocks at 25 MHz SPI */
+#define NETX_SIM_BYTE_NS                                320
+
+/** Poll period of the simulated firmware in ns (0 = yield only) */
+#define NETX_SIM_FW_PERIOD_NS                           20000
+
+/** Bus cycle of the simulated firmware in ns, new inputs are provided at most once per cycle */
+#define NETX_SIM_IO_CYCLE_NS                            CYCLIC_EXEC_PERIOD_NS
+
+/** Time the simulated firmware takes for a channel init or a system reset in ms */
+#define NETX_SIM_RESTART_MS                             100
+
+/** netX whose serial DPM protocol is put in front of the simulated DPM (SPI_BACKEND EMU builds only) - SERDPM_NETX10, SERDPM_NETX50, SERDPM_NETX51 or SERDPM_NETX100 */
+#define SERDPM_EMU_CHIP                                 SERDPM_NETX51
+
+
+/*** *** GBC BRIDGE CONFIGURATION *** ***/
+
+/** Name of the shared memory segment holding the process images exchanged with GBC, created by gbcifx and attached
+ * to by GBC. Must not be GBC_SHARED_MEMORY_NAME, that segment belongs to GBC */
+#define GBCIFX_BRIDGE_SHM_NAME                          "gbcifx_bridge"
+
+
+/*** *** STATISTICS CONFIGURATION *** ***/
+
+/** Name of the shared memory segment holding the cifX timing statistics (GBCIFX_STATS builds only) */
+#define GBCIFX_STATS_SHM_NAME                           "gbcifx_stats"
+
+/** Signal that makes gbcifx write the statistics to GBCIFX_STATS_JSON_PATH, e.g. kill -USR1 <pid> */
+#define GBCIFX_STATS_SIGNAL                             SIGUSR1
+
+/** File the statistics are written to as JSON */
+#define GBCIFX_STATS_JSON_PATH                          "/tmp/gbcifx_stats.json"
+
+
 /*** *** SIZES & LENGTHS CONFIGURATION *** ***/
 
 /* Defines for length of strings, buffers etc. */
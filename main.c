@@ -19,9 +19,51 @@
 #include "cifXUser.h"               /** Include cifX driver API definition       */
 #include "SystemPackets.h"
 #include "SerialDPMInterface.h"
+#include "OS_Spi.h"
+#include "gbcifx_config.h"
+#include "cyclic_exec.h"
+#include "shm_bridge.h"
+#include "gbc_notify.h"
+#include "stats_export.h"
+#ifdef GBCIFX_IRQ
+#include "OS_Irq.h"
+#endif
+#ifdef GBCIFX_SIM
+#include "netx_sim.h"
+#endif
+#if SPI_BACKEND == SPI_BACKEND_EMU
+#include "SerialDPMEmu.h"
+#endif
+
+static DEVICEINSTANCE s_tDevInstance;
+
+/* SPI bus of the netX, a second netX on another chip select refers to the same bus */
+static OS_SPI_BUS_T s_tSpiBus;
+
+/* SPI context of the device, holds the preallocated transfer buffers */
+static OS_SPI_DEVICE_T s_tSpiDevice = {.pvDevInstance = &s_tDevInstance,
+        .ptBus = &s_tSpiBus,
+        .szDevice = SPIDEV_DEVICE,
+        .ulSpeedHz = SPIDEV_SPEED_HZ,
+        .ulCsGpio = SPI_CS_GPIO,
+        .iFd = -1,
+        };
+
+#ifdef GBCIFX_IRQ
+/* DIRQ line of the netX, handed to the toolkit through pvIrq of the SPI context */
+static OS_IRQ_DEVICE_T s_tIrq = {.pvDevInstance = &s_tDevInstance,
+        .eSource = eOS_IRQ_SOURCE_GPIO,
+        .szChip = IRQ_GPIO_CHIP,
+        .ulLine = IRQ_GPIO_LINE,
+        .iFd = -1,
+        .iStopFd = -1,
+        .iPriority = IRQ_THREAD_PRIORITY,
+        .iCpu = IRQ_THREAD_CPU,
+        };
+#endif
 
 /* Toolkit device instance */
-static DEVICEINSTANCE s_tDevInstance = {.pvOSDependent = &s_tDevInstance,
+static DEVICEINSTANCE s_tDevInstance = {.pvOSDependent = &s_tSpiDevice,
         .ulDPMSize = 0x10000,
         .szName = "cifX0",
         .eDeviceType = eCIFX_DEVICE_AUTODETECT,
@@ -29,6 +71,16 @@ static DEVICEINSTANCE s_tDevInstance = {.pvOSDependent = &s_tDevInstance,
         .fIrqEnabled = 0,
         };
 
+#ifdef GBCIFX_SIM
+/* Simulated netX, replaces the serial DPM */
+static netx_sim_t s_tSim;
+#endif
+
+#if SPI_BACKEND == SPI_BACKEND_EMU
+/* netX side of the serial DPM protocol, on top of the simulated DPM */
+static SERDPM_EMU_T s_tSerDpmEmu;
+#endif
+
 #define COM_CHANNEL  0
 
 
@@ -86,44 +138,64 @@ APP_DATA_T tAppData = {0};
 
 
 
-void IODemo(PCHANNELINSTANCE hChannel){
-int32_t lRet = 0;
+/* Exchange errors other than "no communication", counted by the cyclic thread */
+static volatile uint32_t s_ulIOErrors = 0;
 
-//tAppData.tOutputData.abApp_Outputdata[0]=7;
+/* Process images shared with GBC */
+static shm_bridge_t s_tBridge;
 
-    if(CIFX_NO_ERROR != (lRet = xChannelIORead(hChannel, 0, 0, sizeof(APP_OUTPUT_DATA_T), tAppData.tOutputData.abApp_Outputdata, 10)))
-    {
-        if(CIFX_DEV_NO_COM_FLAG != lRet)
-        {
-            printf("Error reading output data values received from network!\r\n");
-        }
-    } else
-    {
-        printf("Read Data:");
-        DumpData(tAppData.tOutputData.abApp_Outputdata, sizeof(APP_OUTPUT_DATA_T));
+/* Wakes GBC after each exchange */
+static gbc_notify_t s_tNotify;
 
-        /* copy inputs to outputs, as most simplest application*/
-        memcpy(tAppData.tInputData.abApp_Inputdata,tAppData.tOutputData.abApp_Outputdata, sizeof(APP_OUTPUT_DATA_T));
+/* cifX timing statistics, readable by other processes and dumped on GBCIFX_STATS_SIGNAL */
+static stats_export_t s_tStats;
 
-        /* write data to network */
-        if(CIFX_NO_ERROR != (lRet = xChannelIOWrite(hChannel, 0, 0, sizeof(APP_INPUT_DATA_T), tAppData.tInputData.abApp_Inputdata, 10)))
-        {
-            if(CIFX_DEV_NO_COM_FLAG != lRet)
-            {
+/*****************************************************************************/
+/*! Called once in the real-time thread before the first cycle. The bus
+*   transactions of the exchange go ahead of mailbox traffic.
+*   \param pvArg  Channel instance                                           */
+/*****************************************************************************/
+static void IOThreadInit(void* pvArg)
+{
+    (void) pvArg;
+    (void) OS_SpiSetThreadClass(eOS_SPI_CLASS_CYCLIC);
+}
 
-                printf("Error writing input data values that shall be transferred to the network!\r\n");
-            }
-        } else
+/*****************************************************************************/
+/*! Process data exchange, called once per cycle in the real-time thread.
+*   Inputs are read straight into the image handed to GBC, outputs are
+*   written from the latest image GBC published. Nothing in here may block
+*   or print.
+*   \param pvArg  Channel instance                                           */
+/*****************************************************************************/
+static void IOCycle(void* pvArg)
+{
+    PCHANNELINSTANCE hChannel = (PCHANNELINSTANCE) pvArg;
+    shm_bridge_to_gbc_image_t* ptToGbc = shm_bridge_to_gbc_acquire(&s_tBridge);
+    const shm_bridge_from_gbc_image_t* ptFromGbc;
+    int32_t lRet;
+
+    if (CIFX_NO_ERROR != (lRet = xChannelIORead(hChannel, 0, 0, sizeof(APP_OUTPUT_DATA_T), ptToGbc->data.abApp_Outputdata, 0)))
+    {
+        if (CIFX_DEV_NO_COM_FLAG != lRet)
         {
-//#ifdef DEBUG
-            printf("Write Data:");
-              DumpData(tAppData.tInputData.abApp_Inputdata, sizeof(APP_INPUT_DATA_T));
-//#endif
+            s_ulIOErrors++;
         }
+        return;
     }
+    shm_bridge_to_gbc_publish(&s_tBridge, shm_bridge_now_ns());
 
+    /* write data to network */
+    ptFromGbc = shm_bridge_from_gbc_latest(&s_tBridge);
+    if (CIFX_NO_ERROR != (lRet = xChannelIOWrite(hChannel, 0, 0, sizeof(APP_INPUT_DATA_T), (void*) ptFromGbc->data.abApp_Inputdata, 0)))
+    {
+        if (CIFX_DEV_NO_COM_FLAG != lRet)
+        {
+            s_ulIOErrors++;
+        }
+    }
 
-
+    gbc_notify_post(&s_tNotify);
 }
 
 
@@ -133,11 +205,20 @@ int main(void) {
 
     int32_t lTkRet = CIFX_NO_ERROR;
 
+    /* before any thread is created, so only the statistics dump thread receives it */
+    stats_export_block_signal();
+
+    /* all mailbox packets come from the pool, nothing is allocated on the mailbox path */
+    Pkt_PoolInit();
+
+#if SPI_BACKEND == SPI_BACKEND_BCM2835 && !defined(GBCIFX_SIM)
+    /* the bcm2835 library maps the peripherals through /dev/mem, spidev only needs access to the device node */
     if(geteuid() != 0)
     {
         printf("Program did not run as root. Exiting now.\n");
         return(-1);
     }
+#endif
 
     /* First of all initialize toolkit */
     lTkRet = cifXTKitInit();
@@ -149,11 +230,45 @@ int main(void) {
                          TRACE_LEVEL_INFO    |
                          TRACE_LEVEL_DEBUG;
 
+#ifdef GBCIFX_SIM
+        netx_sim_config_t tSimConfig;
+        netx_sim_default_config(&tSimConfig);
+#ifdef GBCIFX_IRQ
+        tSimConfig.irq = 1;
+#endif
+#if SPI_BACKEND == SPI_BACKEND_EMU
+        SerialDPMEmu_Init(&s_tSerDpmEmu, SERDPM_EMU_CHIP, s_tSim.dpm, sizeof(s_tSim.dpm), &s_tSim.lock);
+        s_tSpiDevice.pvEmu = &s_tSerDpmEmu;
+#endif
+        if (0 != netx_sim_open(&s_tSim, &tSimConfig, &s_tDevInstance)) {
+            printf("Failed to start the netX simulator\n");
+#if SPI_BACKEND == SPI_BACKEND_EMU
+/* the serial DPM functions replace the direct access to the simulated DPM */
+        } else if (SERDPM_UNKNOWN == SerialDPM_Init(&s_tDevInstance)) {
+            printf("Serial DPM emulator not recognized\n");
+            netx_sim_close(&s_tSim);
+#endif
+        } else {
+#ifdef GBCIFX_IRQ
+/* the simulator raises DIRQ through a pipe */
+            s_tIrq.eSource = eOS_IRQ_SOURCE_FD;
+            s_tIrq.iFd = netx_sim_irq_fd(&s_tSim);
+#endif
+#else
         int iSerDPMType;
         if (SERDPM_UNKNOWN == (iSerDPMType = SerialDPM_Init(&s_tDevInstance))) {
 /* Serial DPM protocol could not be recognized! */
         } else {
 /* iSerDPMType contains connected netX chip type */
+#endif
+#ifdef GBCIFX_IRQ
+/* the toolkit starts the DSR thread when the device is added, polling is used if the line is not available */
+            if (CIFX_NO_ERROR == OS_IrqInit(&s_tIrq)) {
+                s_tSpiDevice.pvIrq = &s_tIrq;
+            } else {
+                printf("DIRQ line not available, using polling mode\n");
+            }
+#endif
 /* Add the device to the toolkits handled device list */
             lTkRet = cifXTKitAddDevice(&s_tDevInstance);
 /* If it succeeded do device tests */
@@ -176,27 +291,142 @@ deallocate the device instance */
 
                 printf("lret [0x%x]\n", lRet);
 
-                /* Start cyclic demo with I/O Data-Transfer and packet data transfer */
-                unsigned long ulCycCnt = 0;
-//uint32_t ulTriggerCount = 0;
-/* Cyclic I/O and packet handling for 'ulCycCnt'times */
-                while( ulCycCnt < DEMO_CYCLES)
+#if CYCLIC_EXEC_WRITE_DELTA
+                /* GBC outputs are mostly static between cycles, only changed spans go over the bus */
+                if (CIFX_NO_ERROR != (lRet = xChannelIOWriteMode(ptChannel, 0, CIFX_IO_WRITE_MODE_DELTA, 1000)))
+                {
+                    printf("Failed to enable delta output writes [0x%08x]\n", (unsigned int) lRet);
+                }
+#endif
+
+                /* mailbox requests and indications are handled in their own thread, next to the cyclic exchange */
+                tAppData.hChannel[0] = ptChannel;
+                if (0 != mbx_engine_start(&tAppData.tMbx, ptChannel, &g_tPktPool, MBX_ENGINE_POLL_MS) ||
+                    0 != Protocol_RegisterIndications(&tAppData))
+                {
+                    printf("Failed to start the mailbox engine\n");
+                }
+#if ECS_APP_STARTUP
+                /* identification and configuration requests, independent ones in flight together */
+                else if (CIFX_NO_ERROR != (lRet = Protocol_Startup(&tAppData)))
+                {
+                    printf("Startup sequence failed [0x%08x]\n", (unsigned int) lRet);
+                }
+#endif
+
+                /* Start cyclic I/O data transfer in the real-time thread, this thread only reports */
+                static cyclic_exec_t tCyclicExec;
+                cyclic_exec_config_t tCyclicConfig = {.period_ns = CYCLIC_EXEC_PERIOD_NS,
+                        .priority = CYCLIC_EXEC_PRIORITY,
+                        .cpu = CYCLIC_EXEC_CPU,
+                        .stack_size = STACK64K,
+                        .thread_init = IOThreadInit,
+                        .cycle = IOCycle,
+                        .arg = ptChannel,
+                        };
+
+                /* statistics are optional, the exchange runs without them */
+                if (0 == stats_export_open(&s_tStats, "/" GBCIFX_STATS_SHM_NAME, &s_tDevInstance))
                 {
-/* Start and trigger watchdog function, if necessary */
-//DEV_TriggerWatchdog(ptChannel, CIFX_WATCHDOG_START, &ulTriggerCount);
-/* Handle I/O data transfer */
-                    IODemo (ptChannel);
-/* Handle rcX packet transfer */
-//#ifdef FIELDBUS_INDICATION_HANDLING
-//                    Fieldbus_HandleIndications( ptChannel);
-//#else
-//                    PacketDemo ( ptChannel);
-//#endif
-                    ulCycCnt++;
+                    stats_export_start_dump_thread(&s_tStats, GBCIFX_STATS_JSON_PATH);
                 }
 
+                /* map the process images before the cyclic thread locks memory */
+                if (0 != shm_bridge_open(&s_tBridge, "/" GBCIFX_BRIDGE_SHM_NAME, SHM_BRIDGE_SIDE_CIFX))
+                {
+                    printf("Failed to open the GBC bridge shared memory\n");
+                }
+                else if (0 != gbc_notify_open(&s_tNotify, &s_tBridge, (gbc_notify_backend_t) GBC_NOTIFY_BACKEND))
+                {
+                    printf("Failed to set up the GBC notification\n");
+                }
+                else if (0 == cyclic_exec_start(&tCyclicExec, &tCyclicConfig))
+                {
+                    cyclic_exec_stats_t tStats = {0};
+
+                    while (tStats.cycles < DEMO_CYCLES)
+                    {
+                        usleep(CYCLIC_EXEC_REPORT_MS * 1000);
+                        cyclic_exec_get_stats(&tCyclicExec, &tStats);
+
+                        /* GBC is searched for (or handed the eventfd) here, never in the cyclic thread */
+                        gbc_notify_service(&s_tNotify);
+
+                        printf("cycles [%llu] overruns [%llu] jitter min/avg/max [%lld/%lld/%lld] ns exec max [%lld] ns io errors [%u]\n",
+                               (unsigned long long) tStats.cycles,
+                               (unsigned long long) tStats.overruns,
+                               (long long) tStats.jitter_min_ns,
+                               (long long) (tStats.cycles ? tStats.jitter_sum_ns / (int64_t) tStats.cycles : 0),
+                               (long long) tStats.jitter_max_ns,
+                               (long long) tStats.exec_max_ns,
+                               s_ulIOErrors);
+                        printf("published [%u] overwritten [%u] gbc images [%u] stale [%u] %s notifications [%u] errors [%u]\n",
+                               s_tBridge.stats.published,
+                               s_tBridge.stats.overwritten,
+                               s_tBridge.stats.gbc_images,
+                               s_tBridge.stats.gbc_stale,
+                               gbc_notify_backend_name(s_tNotify.backend),
+                               s_tNotify.stats.posted,
+                               s_tNotify.stats.errors);
+                        printf("gbc wake-up latency p50/p90/p99/max [%llu/%llu/%llu/%llu] ns\n",
+                               (unsigned long long) latency_hist_percentile(&s_tBridge.seg->wake_hist, 50),
+                               (unsigned long long) latency_hist_percentile(&s_tBridge.seg->wake_hist, 90),
+                               (unsigned long long) latency_hist_percentile(&s_tBridge.seg->wake_hist, 99),
+                               (unsigned long long) latency_hist_percentile(&s_tBridge.seg->wake_hist, 100));
+                        if (NULL != s_tStats.seg)
+                        {
+                            const CIFX_CHANNEL_STATS_T* ptChStats = &s_tStats.seg->channel[COM_CHANNEL];
+
+                            printf("io read/write p99 [%llu/%llu] ns frames per call p99 [%llu] spi frames [%llu] cos changes [%u]\n",
+                                   (unsigned long long) latency_hist_percentile(&ptChStats->tIORead, 99),
+                                   (unsigned long long) latency_hist_percentile(&ptChStats->tIOWrite, 99),
+                                   (unsigned long long) latency_hist_percentile(&ptChStats->tIOFrames, 99),
+                                   (unsigned long long) s_tStats.seg->device.ullHwIfFrames,
+                                   ptChStats->ulCOSChanges);
+                        }
+                        mbx_engine_stats_t tMbxStats;
+                        pkt_pool_stats_t tPoolStats;
+                        mbx_engine_get_stats(&tAppData.tMbx, &tMbxStats);
+                        pkt_pool_get_stats(&g_tPktPool, &tPoolStats);
+                        printf("mailbox requests [%llu] timeouts [%llu] errors [%llu] in flight max [%u] indications [%llu] unhandled [%llu] unmatched [%llu]\n",
+                               (unsigned long long) tMbxStats.completed,
+                               (unsigned long long) tMbxStats.timeouts,
+                               (unsigned long long) tMbxStats.errors,
+                               tMbxStats.in_flight_max,
+                               (unsigned long long) tMbxStats.indications,
+                               (unsigned long long) tMbxStats.unhandled,
+                               (unsigned long long) tMbxStats.unmatched);
+                        printf("packet pool used [%u/%u] high watermark [%u] exhausted [%llu]\n",
+                               tPoolStats.used,
+                               PKT_POOL_SIZE,
+                               tPoolStats.high_watermark,
+                               (unsigned long long) tPoolStats.failures);
+#ifdef GBCIFX_IRQ
+                        if (NULL != s_tSpiDevice.pvIrq)
+                        {
+                            printf("irq events [%u] dsr calls [%u] other device [%u] dsr thread %s\n",
+                                   s_tIrq.ulEvents,
+                                   s_tIrq.ulDsrCalls,
+                                   s_tIrq.ulOtherDevice,
+                                   s_tIrq.fRunning ? "running" : "stopped");
+                        }
+#endif
+                    }
+
+                    cyclic_exec_stop(&tCyclicExec);
+                    gbc_notify_close(&s_tNotify);
+                    shm_bridge_close(&s_tBridge, NULL);
+                    stats_export_close(&s_tStats, NULL);
+                }
 
+                mbx_engine_stop(&tAppData.tMbx);
             }
+#ifdef GBCIFX_IRQ
+            OS_IrqDeinit(&s_tIrq);
+#endif
+#ifdef GBCIFX_SIM
+            netx_sim_close(&s_tSim);
+#endif
         }
     } else {
         printf("cifXTKitInit NOT successful\n");